@@ -6,13 +6,16 @@
 //
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
+#include "td/actor/MultiTimeout.h"
 #include "td/actor/PromiseFuture.h"
 
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/Poll.h"
 #include "td/utils/Promise.h"
+#include "td/utils/Random.h"
 #include "td/utils/SliceBuilder.h"
 
 #if TD_MSVC
@@ -324,9 +327,51 @@ class QueryBench final : public td::Benchmark {
   td::ActorOwn<ServerActor> server_;
 };
 
-int main() {
-  td::init_openssl_threads();
+template <int key_count>
+class MultiTimeoutBench final : public td::Benchmark {
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  td::unique_ptr<td::MultiTimeout> multi_timeout_;
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(0, 0);
+    scheduler_->start();
+    auto guard = scheduler_->get_main_guard();
+    multi_timeout_ = td::make_unique<td::MultiTimeout>("MultiTimeoutBench");
+    multi_timeout_->set_callback([](void *, td::int64) {});
+    multi_timeout_->set_callback_data(nullptr);
+  }
+
+  void tear_down() final {
+    {
+      auto guard = scheduler_->get_main_guard();
+      multi_timeout_.reset();
+    }
+    scheduler_->finish();
+    scheduler_.reset();
+  }
 
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "MultiTimeout: set or cancel timeouts of " << key_count << " keys";
+  }
+
+  void run(int n) final {
+    auto guard = scheduler_->get_main_guard();
+    for (int i = 0; i < n; i++) {
+      td::int64 key = td::Random::fast(0, key_count - 1);
+      if (td::Random::fast(0, 1) == 0) {
+        multi_timeout_->set_timeout_in(key, td::Random::fast(1, 1000000) * 1e-4);
+      } else {
+        multi_timeout_->cancel_timeout(key);
+      }
+    }
+    multi_timeout_->run_all();
+  }
+};
+
+static void run_benchmarks() {
+  bench(MultiTimeoutBench<1000>());
+  bench(MultiTimeoutBench<1000000>());
   bench(CreateActorBench());
   bench(RingBench<4>(504, 0));
   bench(RingBench<3>(504, 0));
@@ -347,3 +392,17 @@ int main() {
   bench(RingBench<1>(504, 2));
   bench(RingBench<2>(504, 2));
 }
+
+int main() {
+  td::init_openssl_threads();
+
+#if TD_POLL_IO_URING
+  for (auto use_io_uring : {false, true}) {
+    td::detail::IoUring::set_enabled(use_io_uring);
+    LOG(ERROR) << "Use " << (use_io_uring ? "io_uring" : "epoll");
+    run_benchmarks();
+  }
+#else
+  run_benchmarks();
+#endif
+}
@@ -0,0 +1,180 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/Client.h"
+#include "td/telegram/td_api.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/TsCerr.h"
+
+#include <cstdlib>
+#include <iostream>
+
+static void usage() {
+  td::TsCerr() << "Creates a lot of idle TDLib instances and reports memory and threads used per instance.\n";
+  td::TsCerr() << "Usage: bench_clients [options]\n";
+  td::TsCerr() << "Options:\n";
+  td::TsCerr() << "  -v<N>\tSet verbosity level to N\n";
+  td::TsCerr() << "  -h/--help\tDisplay this information\n";
+  td::TsCerr() << "  -c/--client-count\tNumber of TDLib instances to create (default is 100)\n";
+  td::TsCerr() << "  -t/--thread-count\tMaximum number of threads running TDLib instances (default is 0)\n";
+  td::TsCerr() << "  -d/--database-directory\tDirectory for databases of the instances (default is bench_clients_db)\n";
+  std::exit(2);
+}
+
+struct ProcessStat {
+  td::uint64 resident_size = 0;
+  td::int32 thread_count = 0;
+};
+
+static ProcessStat get_process_stat() {
+  ProcessStat result;
+  auto r_mem_stat = td::mem_stat();
+  if (r_mem_stat.is_ok()) {
+    result.resident_size = r_mem_stat.ok().resident_size_;
+  }
+  // size of files in /proc is 0, so read_file can't be used
+  auto r_fd = td::FileFd::open("/proc/self/status", td::FileFd::Read);
+  if (r_fd.is_error()) {
+    return result;
+  }
+  auto fd = r_fd.move_as_ok();
+  char buf[10000];
+  auto r_size = fd.read(td::MutableSlice(buf, sizeof(buf)));
+  fd.close();
+  if (r_size.is_error()) {
+    return result;
+  }
+  for (auto line : td::full_split(td::Slice(buf, r_size.ok()), '\n')) {
+    if (td::begins_with(line, "Threads:")) {
+      result.thread_count = td::to_integer<td::int32>(td::trim(line.substr(8)));
+    }
+  }
+  return result;
+}
+
+static void print_stat(td::Slice name, const ProcessStat &stat, const ProcessStat &base_stat, int client_count) {
+  auto resident_size = stat.resident_size - td::min(stat.resident_size, base_stat.resident_size);
+  auto thread_count = stat.thread_count - base_stat.thread_count;
+  std::cout << name.str() << ": " << client_count << " instances, RSS " << (resident_size >> 10) << " KB, "
+            << thread_count << " threads; per instance RSS " << (resident_size >> 10) / td::max(client_count, 1)
+            << " KB, " << static_cast<double>(thread_count) / td::max(client_count, 1) << " threads" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  int new_verbosity_level = VERBOSITY_NAME(FATAL);
+  int client_count = 100;
+  int max_thread_count = 0;
+  td::string database_directory = "bench_clients_db";
+
+  for (int i = 1; i < argc; i++) {
+    td::string arg(argv[i]);
+
+    auto get_next_arg = [&i, &arg, argc, argv](bool is_optional = false) {
+      CHECK(arg.size() >= 2);
+      if (arg.size() == 2 || arg[1] == '-') {
+        if (i + 1 < argc && argv[i + 1][0] != '-') {
+          return td::string(argv[++i]);
+        }
+      } else {
+        if (arg.size() > 2) {
+          return arg.substr(2);
+        }
+      }
+      if (!is_optional) {
+        td::TsCerr() << "Error: value is required after " << arg << "\n";
+        usage();
+      }
+      return td::string();
+    };
+
+    if (td::begins_with(arg, "-v")) {
+      arg = get_next_arg(true);
+      int new_verbosity = 1;
+      while (arg[0] == 'v') {
+        new_verbosity++;
+        arg = arg.substr(1);
+      }
+      if (!arg.empty()) {
+        new_verbosity += td::to_integer<int>(arg) - (new_verbosity == 1);
+      }
+      new_verbosity_level = VERBOSITY_NAME(FATAL) + new_verbosity;
+    } else if (td::begins_with(arg, "-c") || arg == "--client-count") {
+      client_count = td::to_integer<int>(get_next_arg());
+    } else if (td::begins_with(arg, "-t") || arg == "--thread-count") {
+      max_thread_count = td::to_integer<int>(get_next_arg());
+    } else if (td::begins_with(arg, "-d") || arg == "--database-directory") {
+      database_directory = get_next_arg();
+    } else {
+      usage();
+    }
+  }
+  if (client_count <= 0) {
+    td::TsCerr() << "Error: wrong number of instances specified\n";
+    usage();
+  }
+
+  SET_VERBOSITY_LEVEL(new_verbosity_level);
+
+  td::ClientManager::set_max_thread_count(max_thread_count);
+  td::ClientManager client_manager;
+  auto base_stat = get_process_stat();
+
+  // all instances stay in authorizationStateWaitPhoneNumber after the parameters are set
+  td::vector<td::ClientManager::ClientId> client_ids;
+  for (int i = 0; i < client_count; i++) {
+    auto client_id = client_manager.create_client_id();
+    client_ids.push_back(client_id);
+    auto request = td::td_api::make_object<td::td_api::setTdlibParameters>();
+    request->use_test_dc_ = true;
+    request->database_directory_ = PSTRING() << database_directory << TD_DIR_SLASH << client_id << TD_DIR_SLASH;
+    request->use_message_database_ = true;
+    request->api_id_ = 94575;
+    request->api_hash_ = "a3406de8d171bb422bb6ddf3bbd800e2";
+    request->system_language_code_ = "en";
+    request->device_model_ = "Desktop";
+    request->application_version_ = "bench-clients";
+    client_manager.send(client_id, 1, std::move(request));
+  }
+
+  int initialized_client_count = 0;
+  while (initialized_client_count != client_count) {
+    auto response = client_manager.receive(100.0);
+    if (response.request_id == 1) {
+      LOG_CHECK(response.object->get_id() == td::td_api::ok::ID) << to_string(response.object);
+      initialized_client_count++;
+    }
+  }
+  print_stat("Initialized", get_process_stat(), base_stat, client_count);
+
+  // let the instances settle down and drain pending updates
+  for (int i = 0; i < 300; i++) {
+    client_manager.receive(0.1);
+  }
+  print_stat("Idle", get_process_stat(), base_stat, client_count);
+
+  for (auto client_id : client_ids) {
+    client_manager.send(client_id, 2, td::td_api::make_object<td::td_api::close>());
+  }
+  int closed_client_count = 0;
+  while (closed_client_count != client_count) {
+    auto response = client_manager.receive(100.0);
+    if (response.object != nullptr && response.request_id == 0 &&
+        response.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+        static_cast<const td::td_api::updateAuthorizationState *>(response.object.get())
+                ->authorization_state_->get_id() == td::td_api::authorizationStateClosed::ID) {
+      closed_client_count++;
+    }
+  }
+  td::rmrf(database_directory).ignore();
+}
@@ -19,8 +19,11 @@
 
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Random.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
@@ -199,6 +202,81 @@ class SqliteKeyValueAsyncBench final : public td::Benchmark {
   }
 };
 
+// loads random users from a database with 50000 users like UserManager does during cold start
+template <bool use_batch>
+class SqliteKeyValueAsyncGetBench final : public td::Benchmark {
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "SqliteKeyValueAsync get " << td::tag("use_batch", use_batch);
+  }
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(1, 0);
+    scheduler_->start();
+
+    auto guard = scheduler_->get_main_guard();
+
+    td::string sql_db_name = "testdb.sqlite";
+    td::SqliteDb::destroy(sql_db_name).ignore();
+    td::SqliteDb::open_with_key(sql_db_name, true, td::DbKey::empty()).move_as_ok();
+
+    sql_connection_ = std::make_shared<td::SqliteConnectionSafe>(sql_db_name, td::DbKey::empty());
+    init_db(sql_connection_->get()).ensure();
+
+    sqlite_kv_safe_ = std::make_shared<td::SqliteKeyValueSafe>("common", sql_connection_);
+    td::FlatHashMap<td::string, td::string> key_values;
+    for (int i = 1; i <= USER_COUNT; i++) {
+      key_values.emplace(PSTRING() << "us" << i, td::string(200, static_cast<char>('a' + i % 26)));
+    }
+    sqlite_kv_safe_->get().set_all(key_values);
+    sqlite_kv_async_ = create_sqlite_key_value_async(sqlite_kv_safe_, 0);
+  }
+  void run(int n) final {
+    size_t loaded_count = 0;
+    {
+      auto guard = scheduler_->get_main_guard();
+      td::vector<td::string> keys;
+      for (int i = 0; i < n; i++) {
+        td::string key = PSTRING() << "us" << td::Random::fast(1, USER_COUNT);
+        if (use_batch) {
+          keys.push_back(std::move(key));
+        } else {
+          sqlite_kv_async_->get(std::move(key), td::PromiseCreator::lambda([&loaded_count](td::string value) {
+            CHECK(!value.empty());
+            loaded_count++;
+          }));
+        }
+      }
+      if (use_batch) {
+        sqlite_kv_async_->get_batch(std::move(keys),
+                                    td::PromiseCreator::lambda([&loaded_count](td::vector<td::string> values) {
+                                      loaded_count += values.size();
+                                    }));
+      }
+    }
+    while (loaded_count != static_cast<size_t>(n)) {
+      scheduler_->run_main(0);
+    }
+  }
+  void tear_down() final {
+    {
+      auto guard = scheduler_->get_main_guard();
+      sqlite_kv_async_.reset();
+      sqlite_kv_safe_.reset();
+      sql_connection_->close_and_destroy();
+    }
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+
+ private:
+  static constexpr int USER_COUNT = 50000;
+
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+  std::shared_ptr<td::SqliteKeyValueSafe> sqlite_kv_safe_;
+  td::unique_ptr<td::SqliteKeyValueAsyncInterface> sqlite_kv_async_;
+};
+
 class SeqKvBench final : public td::Benchmark {
   td::string get_description() const final {
     return "SeqKvBench";
@@ -240,5 +318,7 @@ int main() {
   bench(SqliteKVBench<false>());
   bench(SqliteKVBench<true>());
   bench(SqliteKeyValueAsyncBench());
+  bench(SqliteKeyValueAsyncGetBench<false>());
+  bench(SqliteKeyValueAsyncGetBench<true>());
   bench(SeqKvBench());
 }
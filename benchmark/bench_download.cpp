@@ -0,0 +1,97 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/DownloadSpeedEstimator.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+
+#include <functional>
+#include <queue>
+#include <utility>
+
+// simulated download server, which serves part queries one by one with the given throughput
+class SimulatedServer {
+ public:
+  SimulatedServer(double rtt, double speed, double query_overhead)
+      : rtt_(rtt), speed_(speed), query_overhead_(query_overhead) {
+  }
+
+  // returns time when the part will be received
+  double query_part(double now, size_t part_size) {
+    auto start_time = td::max(now + rtt_ / 2, link_free_time_) + query_overhead_;
+    link_free_time_ = start_time + static_cast<double>(part_size) / speed_;
+    return link_free_time_ + rtt_ / 2;
+  }
+
+ private:
+  double rtt_;
+  double speed_;
+  double query_overhead_;
+  double link_free_time_ = 0.0;
+};
+
+static constexpr size_t DEFAULT_PART_SIZE = 64 << 10;
+static constexpr td::int64 DEFAULT_RESOURCE_LIMIT = 1 << 21;
+static constexpr td::int64 MAX_RESOURCE_LIMIT = DEFAULT_RESOURCE_LIMIT * 4;
+
+// returns time when the file is downloaded
+static double download_file(SimulatedServer &server, double now, td::int64 size,
+                            td::DownloadSpeedEstimator *estimator) {
+  size_t part_size = DEFAULT_PART_SIZE;
+  auto resource_limit = DEFAULT_RESOURCE_LIMIT;
+  if (estimator != nullptr && estimator->has_estimate()) {
+    part_size = estimator->get_preferred_part_size();
+    resource_limit = estimator->get_resource_limit(DEFAULT_RESOURCE_LIMIT, MAX_RESOURCE_LIMIT);
+  }
+
+  using Query = std::pair<double, std::pair<double, size_t>>;  // finish time, start time, size
+  std::priority_queue<Query, td::vector<Query>, std::greater<Query>> queries;
+  td::int64 offset = 0;
+  td::int64 in_flight_size = 0;
+  while (offset < size || !queries.empty()) {
+    while (offset < size && (queries.empty() || in_flight_size + static_cast<td::int64>(part_size) <= resource_limit)) {
+      auto query_size = static_cast<size_t>(td::min(static_cast<td::int64>(part_size), size - offset));
+      queries.emplace(server.query_part(now, query_size), std::make_pair(now, query_size));
+      offset += query_size;
+      in_flight_size += query_size;
+    }
+
+    auto query = queries.top();
+    queries.pop();
+    now = query.first;
+    in_flight_size -= query.second.second;
+    if (estimator != nullptr) {
+      estimator->on_part_downloaded(query.second.second, now - query.second.first, now);
+      resource_limit = estimator->get_resource_limit(DEFAULT_RESOURCE_LIMIT, MAX_RESOURCE_LIMIT);
+    }
+  }
+  return now;
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(INFO));
+  const double speed = 50e6;
+  const double query_overhead = 0.002;
+  const int file_count = 10;
+  for (auto file_size : {static_cast<td::int64>(100) << 10, static_cast<td::int64>(100) << 20}) {
+    for (auto rtt : {0.01, 0.05, 0.15, 0.3}) {
+      double times[2];
+      for (int is_adaptive = 0; is_adaptive < 2; is_adaptive++) {
+        SimulatedServer server(rtt, speed, query_overhead);
+        td::DownloadSpeedEstimator estimator;
+        double now = 0.0;
+        for (int i = 0; i < file_count; i++) {
+          now = download_file(server, now, file_size, is_adaptive ? &estimator : nullptr);
+        }
+        times[is_adaptive] = now / file_count;
+      }
+      LOG(PLAIN) << "Download " << file_count << " files of size " << file_size << " with RTT " << rtt * 1000
+                 << "ms: fixed " << times[0] << "s, adaptive " << times[1] << "s per file";
+    }
+  }
+}
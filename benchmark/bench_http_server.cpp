@@ -15,9 +15,12 @@
 #include "td/utils/buffer.h"
 #include "td/utils/BufferedFd.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/Poll.h"
 #include "td/utils/port/SocketFd.h"
 #include "td/utils/Slice.h"
 
+#include <cstring>
+
 static int cnt = 0;
 
 class HelloWorld final : public td::HttpInboundConnection::Callback {
@@ -72,8 +75,12 @@ class Server final : public td::TcpListener::Callback {
   int pos_{0};
 };
 
-int main() {
+int main(int argc, char *argv[]) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+#if TD_POLL_IO_URING
+  // run with "--epoll" to compare with the io_uring-based Poll
+  td::detail::IoUring::set_enabled(!(argc > 1 && std::strcmp(argv[1], "--epoll") == 0));
+#endif
   auto scheduler = td::make_unique<td::ConcurrentScheduler>(N, 0);
   scheduler->create_actor_unsafe<Server>(0, "Server").release();
   scheduler->start();
@@ -0,0 +1,223 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/td_api.h"
+#include "td/telegram/td_api_json.h"
+
+#include "td/utils/benchmark.h"
+#include "td/utils/common.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/StackAllocator.h"
+#include "td/utils/StringBuilder.h"
+
+static td::td_api::object_ptr<td::td_api::message> get_message(td::int64 chat_id) {
+  auto message = td::td_api::make_object<td::td_api::message>();
+  message->id_ = static_cast<td::int64>(123456789) << 20;
+  message->sender_id_ = td::td_api::make_object<td::td_api::messageSenderUser>(987654321);
+  message->chat_id_ = chat_id;
+  message->can_be_forwarded_ = true;
+  message->can_be_saved_ = true;
+  message->can_be_deleted_only_for_self_ = true;
+  message->can_get_added_reactions_ = true;
+  message->date_ = 1700000000;
+  message->media_album_id_ = 1234567890123456789;
+  message->author_signature_ = "Author";
+
+  auto interaction_info = td::td_api::make_object<td::td_api::messageInteractionInfo>();
+  interaction_info->view_count_ = 12345;
+  interaction_info->forward_count_ = 67;
+  message->interaction_info_ = std::move(interaction_info);
+
+  td::vector<td::td_api::object_ptr<td::td_api::textEntity>> entities;
+  entities.push_back(
+      td::td_api::make_object<td::td_api::textEntity>(0, 5, td::td_api::make_object<td::td_api::textEntityTypeBold>()));
+  entities.push_back(
+      td::td_api::make_object<td::td_api::textEntity>(60, 19, td::td_api::make_object<td::td_api::textEntityTypeUrl>()));
+  auto text = td::td_api::make_object<td::td_api::formattedText>(
+      "Hello, \"world\"! This is a typical message with a link: https://telegram.org and a\nsecond line. "
+      "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xF0\x9F\x91\x8B",
+      std::move(entities));
+  auto content = td::td_api::make_object<td::td_api::messageText>();
+  content->text_ = std::move(text);
+  message->content_ = std::move(content);
+  return message;
+}
+
+static td::td_api::object_ptr<td::td_api::file> get_file(td::int32 file_id) {
+  auto file = td::td_api::make_object<td::td_api::file>();
+  file->id_ = file_id;
+  file->size_ = 12345;
+  file->local_ = td::td_api::make_object<td::td_api::localFile>();
+  file->local_->can_be_downloaded_ = true;
+  file->remote_ = td::td_api::make_object<td::td_api::remoteFile>();
+  file->remote_->id_ = "AQADAgADsKcxG0Ff0Ej-zFz8AAgMAA3kAAx4E";
+  file->remote_->unique_id_ = "AQADsKcxG0Ff0Ej-";
+  file->remote_->is_uploading_completed_ = true;
+  return file;
+}
+
+static td::td_api::object_ptr<td::td_api::chat> get_chat() {
+  auto chat = td::td_api::make_object<td::td_api::chat>();
+  chat->id_ = -1001234567890;
+  chat->type_ = td::td_api::make_object<td::td_api::chatTypeSupergroup>(1234567890, true);
+  chat->title_ = "Some channel title";
+  chat->photo_ = td::td_api::make_object<td::td_api::chatPhotoInfo>();
+  chat->photo_->small_ = get_file(1);
+  chat->photo_->big_ = get_file(2);
+  chat->photo_->minithumbnail_ = td::td_api::make_object<td::td_api::minithumbnail>(40, 40, td::string(700, 'a'));
+  chat->accent_color_id_ = 5;
+  chat->background_custom_emoji_id_ = 5368324170671202286;
+  chat->permissions_ = td::td_api::make_object<td::td_api::chatPermissions>();
+  chat->last_message_ = get_message(chat->id_);
+  chat->positions_.push_back(td::td_api::make_object<td::td_api::chatPosition>(
+      td::td_api::make_object<td::td_api::chatListMain>(), 7290462398711939072, false, nullptr));
+  chat->chat_lists_.push_back(td::td_api::make_object<td::td_api::chatListMain>());
+  chat->can_be_reported_ = true;
+  chat->unread_count_ = 17;
+  chat->last_read_inbox_message_id_ = static_cast<td::int64>(123456) << 20;
+  chat->last_read_outbox_message_id_ = static_cast<td::int64>(123456) << 20;
+  chat->notification_settings_ = td::td_api::make_object<td::td_api::chatNotificationSettings>();
+  chat->notification_settings_->use_default_mute_for_ = true;
+  chat->notification_settings_->sound_id_ = 6004986233423216640;
+  return chat;
+}
+
+// converts an object to JSON like ClientJson does
+template <bool use_compact_json>
+static td::string object_to_json(const td::td_api::Object &object) {
+  auto buf = td::StackAllocator::alloc(1 << 18);
+  if (use_compact_json) {
+    td::StringBuilder sb(buf.as_slice(), true);
+    td::td_api::to_compact_json(sb, object);
+    return sb.as_cslice().str();
+  }
+  td::JsonBuilder jb(td::StringBuilder(buf.as_slice(), true), -1);
+  jb.enter_value() << td::ToJson(object);
+  return jb.string_builder().as_cslice().str();
+}
+
+template <bool use_compact_json>
+class UpdateToJsonBench final : public td::Benchmark {
+  td::string name_;
+  td::td_api::object_ptr<td::td_api::Object> update_;
+
+ public:
+  UpdateToJsonBench(td::string name, td::td_api::object_ptr<td::td_api::Object> update)
+      : name_(std::move(name)), update_(std::move(update)) {
+    // both serializers must produce the same bytes
+    LOG_CHECK(object_to_json<true>(*update_) == object_to_json<false>(*update_)) << name_;
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << name_ << (use_compact_json ? " to_compact_json" : " JsonBuilder");
+  }
+
+  void run(int n) final {
+    std::size_t total_size = 0;
+    for (int i = 0; i < n; i++) {
+      total_size += object_to_json<use_compact_json>(*update_).size();
+    }
+    CHECK(total_size > 0);
+  }
+};
+
+template <bool use_compact_json>
+static void bench_updates() {
+  td::bench(UpdateToJsonBench<use_compact_json>(
+      "updateNewMessage", td::td_api::make_object<td::td_api::updateNewMessage>(get_message(-1001234567890))));
+  td::bench(UpdateToJsonBench<use_compact_json>("updateNewChat",
+                                                td::td_api::make_object<td::td_api::updateNewChat>(get_chat())));
+}
+
+// parses a request like ClientJson does
+template <bool need_from_json>
+static bool parse_request(td::Slice request) {
+  auto request_str = request.str();
+  auto r_json_value = td::json_decode(request_str);
+  if (r_json_value.is_error()) {
+    return false;
+  }
+  auto json_value = r_json_value.move_as_ok();
+  if (json_value.type() != td::JsonValue::Type::Object) {
+    return false;
+  }
+  td::string extra;
+  if (json_value.get_object().has_field("@extra")) {
+    extra = td::json_encode<td::string>(json_value.get_object().extract_field("@extra"));
+  }
+  if (!need_from_json) {
+    return true;
+  }
+  td::td_api::object_ptr<td::td_api::Function> function;
+  return td::td_api::from_json(function, std::move(json_value)).is_ok() && function != nullptr;
+}
+
+template <bool need_from_json>
+class RequestFromJsonBench final : public td::Benchmark {
+  td::string name_;
+  td::string request_;
+
+ public:
+  RequestFromJsonBench(td::string name, td::string request) : name_(std::move(name)), request_(std::move(request)) {
+    LOG_CHECK(parse_request<true>(request_)) << name_;
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << name_ << (need_from_json ? " json_decode + from_json" : " json_decode");
+  }
+
+  void run(int n) final {
+    int parsed_count = 0;
+    for (int i = 0; i < n; i++) {
+      parsed_count += static_cast<int>(parse_request<need_from_json>(request_));
+    }
+    CHECK(parsed_count == n);
+  }
+};
+
+template <bool need_from_json>
+static void bench_requests() {
+  td::bench(RequestFromJsonBench<need_from_json>(
+      "sendMessage",
+      "{\"@type\":\"sendMessage\",\"chat_id\":-1001234567890,\"message_thread_id\":0,\"reply_to\":{\"@type\":"
+      "\"inputMessageReplyToMessage\",\"message_id\":129453825024},\"options\":{\"@type\":\"messageSendOptions\","
+      "\"disable_notification\":false,\"from_background\":false,\"protect_content\":false,\"effect_id\":\"0\","
+      "\"sending_id\":0},\"input_message_content\":{\"@type\":\"inputMessageText\",\"text\":{\"@type\":"
+      "\"formattedText\",\"text\":\"Hello, \\\"world\\\"! This is a typical message with a link: "
+      "https://telegram.org and a\\nsecond line. \\u041f\\u0440\\u0438\\u0432\\u0435\\u0442 \\ud83d\\udc4b\","
+      "\"entities\":[{\"@type\":\"textEntity\",\"offset\":0,\"length\":5,\"type\":{\"@type\":\"textEntityTypeBold\"}},"
+      "{\"@type\":\"textEntity\",\"offset\":60,\"length\":19,\"type\":{\"@type\":\"textEntityTypeUrl\"}}]},"
+      "\"link_preview_options\":{\"@type\":\"linkPreviewOptions\",\"is_disabled\":false,\"url\":\"\","
+      "\"force_small_media\":false,\"force_large_media\":false,\"show_above_text\":false},\"clear_draft\":true},"
+      "\"@extra\":{\"request_id\":12345}}"));
+  td::bench(RequestFromJsonBench<need_from_json>(
+      "getChatHistory",
+      "{\"@type\":\"getChatHistory\",\"chat_id\":-1001234567890,\"from_message_id\":0,\"offset\":0,\"limit\":50,"
+      "\"only_local\":false,\"@extra\":12346}"));
+  td::bench(RequestFromJsonBench<need_from_json>(
+      "viewMessages",
+      "{\"@type\":\"viewMessages\",\"chat_id\":-1001234567890,\"message_ids\":[129453825024,129454873600,"
+      "129455922176,129456970752,129458019328],\"source\":{\"@type\":\"messageSourceChatHistory\"},"
+      "\"force_read\":false,\"@extra\":\"abc\"}"));
+  td::bench(RequestFromJsonBench<need_from_json>(
+      "setTdlibParameters",
+      "{\"@type\":\"setTdlibParameters\",\"use_test_dc\":false,\"database_directory\":\"tdlib\","
+      "\"files_directory\":\"\",\"database_encryption_key\":\"\",\"use_file_database\":true,"
+      "\"use_chat_info_database\":true,\"use_message_database\":true,\"use_secret_chats\":true,\"api_id\":94575,"
+      "\"api_hash\":\"a3406de8d171bb422bb6ddf3bbd800e2\",\"system_language_code\":\"en\",\"device_model\":\"Desktop\","
+      "\"system_version\":\"\",\"application_version\":\"1.0\"}"));
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+  bench_updates<false>();
+  bench_updates<true>();
+  bench_requests<false>();
+  bench_requests<true>();
+}
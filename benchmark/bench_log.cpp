@@ -4,13 +4,22 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/utils/AsyncBinaryLog.h"
+#include "td/utils/AsyncFileLog.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
+#include "td/utils/FileLog.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
+#include "td/utils/TsLog.h"
 
 #include <cstdio>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <ostream>
 #include <streambuf>
 #include <string>
@@ -150,7 +159,125 @@ class LogWriteBench final : public td::Benchmark {
   }
 };
 
+#if !TD_THREAD_UNSUPPORTED
+enum class LogType : td::int32 { TsLog, AsyncFileLog, AsyncBinaryLog };
+
+static td::Slice get_log_type_name(LogType log_type) {
+  switch (log_type) {
+    case LogType::TsLog:
+      return td::Slice("LOG + FileLog + TsLog");
+    case LogType::AsyncFileLog:
+      return td::Slice("LOG + AsyncFileLog");
+    case LogType::AsyncBinaryLog:
+      return td::Slice("LOG_DEFERRED + AsyncBinaryLog");
+    default:
+      UNREACHABLE();
+      return td::Slice();
+  }
+}
+
+// writes log messages to a file from many threads simultaneously
+class MultiThreadLogWriteBench final : public td::Benchmark {
+ public:
+  MultiThreadLogWriteBench(LogType log_type, int threads_n) : log_type_(log_type), threads_n_(threads_n) {
+  }
+
+  std::string get_description() const final {
+    return PSTRING() << get_log_type_name(log_type_) << " with " << threads_n_ << " threads (ns/message per thread)";
+  }
+
+  void start_up() final {
+    file_name_ = create_tmp_file();
+    file_log_ = td::make_unique<td::FileLog>();
+    file_log_->init(file_name_, std::numeric_limits<td::int64>::max(), false).ensure();
+    switch (log_type_) {
+      case LogType::TsLog:
+        ts_log_ = td::make_unique<td::TsLog>(file_log_.get());
+        log_ = ts_log_.get();
+        break;
+      case LogType::AsyncFileLog:
+        async_file_log_ = td::make_unique<td::AsyncFileLog>();
+        async_file_log_->init(file_name_, std::numeric_limits<td::int64>::max(), false).ensure();
+        log_ = async_file_log_.get();
+        break;
+      case LogType::AsyncBinaryLog:
+        async_binary_log_ = td::make_unique<td::AsyncBinaryLog>();
+        async_binary_log_->init(file_log_.get());
+        log_ = async_binary_log_.get();
+        break;
+      default:
+        UNREACHABLE();
+    }
+    old_log_interface_ = td::log_interface;
+    td::log_interface = log_;
+  }
+
+  void run(int n) final {
+    td::vector<td::thread> threads(threads_n_);
+    for (int i = 0; i < threads_n_; i++) {
+      threads[i] = td::thread([this, n, i] {
+        for (int j = 0; j < n; j++) {
+          if (log_type_ == LogType::AsyncBinaryLog) {
+            LOG_DEFERRED(INFO) << "Receive " << j << " bytes from DC " << i << " in " << j * 1e-6 << " seconds";
+          } else {
+            LOG(INFO) << "Receive " << j << " bytes from DC " << i << " in " << j * 1e-6 << " seconds";
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  void tear_down() final {
+    td::log_interface = old_log_interface_;
+    // wait until all messages are written
+    async_binary_log_.reset();
+    async_file_log_.reset();
+    ts_log_.reset();
+    file_log_.reset();
+    unlink(file_name_.c_str());
+  }
+
+ private:
+  LogType log_type_;
+  int threads_n_;
+  std::string file_name_;
+  td::unique_ptr<td::FileLog> file_log_;
+  td::unique_ptr<td::TsLog> ts_log_;
+  td::unique_ptr<td::AsyncFileLog> async_file_log_;
+  td::unique_ptr<td::AsyncBinaryLog> async_binary_log_;
+  td::LogInterface *log_ = nullptr;
+  td::LogInterface *old_log_interface_ = nullptr;
+};
+
+// measures total throughput including the time needed to write all messages to the file
+static void bench_log_throughput(LogType log_type, int threads_n) {
+  const int n = 200000;
+  MultiThreadLogWriteBench bench(log_type, threads_n);
+  bench.start_up();
+  auto start_time = td::Time::now();
+  bench.run(n);
+  bench.tear_down();
+  auto total_time = td::Time::now() - start_time;
+  LOG(PLAIN) << get_log_type_name(log_type) << " with " << threads_n << " threads: "
+             << static_cast<td::int64>(n * threads_n / total_time) << " messages/sec";
+}
+#endif
+
 int main() {
+#if !TD_THREAD_UNSUPPORTED
+  for (auto threads_n : {1, 4, 16}) {
+    for (auto log_type : {LogType::TsLog, LogType::AsyncFileLog, LogType::AsyncBinaryLog}) {
+      td::bench(MultiThreadLogWriteBench(log_type, threads_n));
+    }
+    for (auto log_type : {LogType::TsLog, LogType::AsyncFileLog, LogType::AsyncBinaryLog}) {
+      bench_log_throughput(log_type, threads_n);
+    }
+  }
+#endif
+
   td::bench(LogWriteBench());
 #if TD_ANDROID
   td::bench(ALogWriteBench());
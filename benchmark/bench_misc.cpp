@@ -4,14 +4,32 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/telegram/EmojiKeywordIndex.h"
+#include "td/telegram/LanguagePackStringTable.h"
+#include "td/telegram/LazyUpdates.h"
+#include "td/telegram/net/QueryResultDecoder.h"
+#include "td/telegram/QueryResultCache.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/telegram_api.hpp"
 
+#include "td/db/SqliteDb.h"
+#include "td/db/SqliteKeyValue.h"
+
+#include "td/tl/TlObjectArena.h"
+
+#include "td/actor/actor.h"
+#include "td/actor/ConcurrentScheduler.h"
+
 #include "td/utils/algorithm.h"
 #include "td/utils/benchmark.h"
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
+#include "td/utils/crypto.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/EventFd.h"
 #include "td/utils/port/FileFd.h"
@@ -24,8 +42,11 @@
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StackAllocator.h"
 #include "td/utils/Status.h"
+#include "td/utils/Storer.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/ThreadSafeCounter.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/UInt.h"
 
 #if !TD_WINDOWS
 #include <unistd.h>
@@ -40,6 +61,10 @@
 #include <array>
 #include <atomic>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
 #include <set>
 
 class F {
@@ -126,6 +151,452 @@ BENCH(TlToStringMessage, "TL to_string message") {
   td::do_not_optimize_away(res);
 }
 
+// counts all allocations made by the benchmarks
+static std::atomic<std::size_t> allocation_count{0};
+
+void *operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  auto *ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+template <bool use_arena>
+class TlParseContactsBench final : public td::Benchmark {
+  static constexpr td::int32 CONTACT_COUNT = 1000;
+
+  td::BufferSlice buffer_;
+  std::size_t allocation_count_ = 0;
+  std::size_t iteration_count_ = 0;
+
+  static void store_string(td::string &data, td::Slice str) {
+    CHECK(str.size() < 254);
+    data += static_cast<char>(str.size());
+    data.append(str.data(), str.size());
+    while (data.size() % 4 != 0) {
+      data += '\0';
+    }
+  }
+
+  template <class T>
+  static void store_int(td::string &data, T value) {
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "TL parse and convert contacts.contacts " << (use_arena ? "with" : "without") << " arena, "
+                     << allocation_count_ / td::max(iteration_count_, static_cast<std::size_t>(1)) << " allocations";
+  }
+
+  void start_up() final {
+    const td::int32 VECTOR_ID = 0x1cb5c415;
+    const td::int32 BOOL_TRUE_ID = -1720552011;
+    td::string data;
+    store_int(data, td::telegram_api::contacts_contacts::ID);
+    store_int(data, VECTOR_ID);
+    store_int(data, CONTACT_COUNT);
+    for (td::int32 i = 0; i < CONTACT_COUNT; i++) {
+      store_int(data, td::telegram_api::contact::ID);
+      store_int(data, static_cast<td::int64>(i + 1000000));  // user_id
+      store_int(data, BOOL_TRUE_ID);                         // mutual
+    }
+    store_int(data, static_cast<td::int32>(0));  // saved_count
+    store_int(data, VECTOR_ID);
+    store_int(data, CONTACT_COUNT);
+    for (td::int32 i = 0; i < CONTACT_COUNT; i++) {
+      // access_hash, first_name, last_name, phone, status; contact, mutual_contact
+      store_int(data, td::telegram_api::user::ID);
+      store_int(data, static_cast<td::int32>(1 | 2 | 4 | 16 | 64 | 2048 | 4096));
+      store_int(data, static_cast<td::int32>(0));
+      store_int(data, static_cast<td::int64>(i + 1000000));
+      store_int(data, static_cast<td::int64>(i) * 1234567891);
+      store_string(data, PSLICE() << "First name " << i);
+      store_string(data, PSLICE() << "Last name " << i);
+      store_string(data, PSLICE() << (79000000000ll + i));
+      store_int(data, td::telegram_api::userStatusOffline::ID);
+      store_int(data, 1700000000 + i);
+    }
+    buffer_ = td::BufferSlice(data);
+  }
+
+  void run(int n) final {
+    auto begin_allocation_count = allocation_count.load(std::memory_order_relaxed);
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      td::TlBufferParser parser(&buffer_);
+      td::TlObjectArena::Guard arena_guard(use_arena);
+      auto result = td::telegram_api::contacts_getContacts::fetch_result(parser);
+      parser.fetch_end();
+      CHECK(parser.get_error() == nullptr);
+
+      // convert the users like UserManager does it, and drop the response
+      auto contacts = td::telegram_api::move_object_as<td::telegram_api::contacts_contacts>(result);
+      CHECK(contacts->users_.size() == static_cast<std::size_t>(CONTACT_COUNT));
+      td::vector<td::td_api::object_ptr<td::td_api::user>> users;
+      for (auto &user_ptr : contacts->users_) {
+        CHECK(user_ptr->get_id() == td::telegram_api::user::ID);
+        auto *user = static_cast<td::telegram_api::user *>(user_ptr.get());
+        auto user_object = td::td_api::make_object<td::td_api::user>();
+        user_object->id_ = user->id_;
+        user_object->first_name_ = std::move(user->first_name_);
+        user_object->last_name_ = std::move(user->last_name_);
+        user_object->phone_number_ = std::move(user->phone_);
+        user_object->is_contact_ = user->contact_;
+        user_object->is_mutual_contact_ = user->mutual_contact_;
+        CHECK(user->status_->get_id() == td::telegram_api::userStatusOffline::ID);
+        user_object->status_ = td::td_api::make_object<td::td_api::userStatusOffline>(
+            static_cast<const td::telegram_api::userStatusOffline *>(user->status_.get())->was_online_);
+        users.push_back(std::move(user_object));
+      }
+      res += users.size();
+    }
+    td::do_not_optimize_away(res);
+    allocation_count_ += allocation_count.load(std::memory_order_relaxed) - begin_allocation_count;
+    iteration_count_ += n;
+  }
+};
+
+template <bool need_parse>
+class LazyShortUpdateBench final : public td::Benchmark {
+  td::BufferSlice buffer_;
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "updateShort with updateUserTyping " << (need_parse ? "parsed" : "not parsed");
+  }
+
+  void start_up() final {
+    td::int32 words[] = {td::telegram_api::updateShort::ID,
+                         td::telegram_api::updateUserTyping::ID,
+                         123456789,  // user_id
+                         0,
+                         td::telegram_api::sendMessageTypingAction::ID,
+                         1700000000};  // date
+    buffer_ = td::BufferSlice(td::Slice(reinterpret_cast<const char *>(words), sizeof(words)));
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      td::LazyUpdates updates(buffer_.clone());
+      res += updates.get_short_update_id();
+      if (need_parse) {
+        res += updates.get_updates()->get_id();
+      }
+    }
+    td::do_not_optimize_away(res);
+  }
+};
+
+// searches emoji keywords by prefix like StickersManager::search_emojis does for each input language
+template <bool use_index>
+class EmojiKeywordSearchBench final : public td::Benchmark {
+  static constexpr int KEYWORD_COUNT = 20000;
+
+  size_t prefix_length_;
+  td::vector<td::string> keywords_;
+  td::EmojiKeywordIndex index_;
+  td::SqliteKeyValue kv_;
+
+ public:
+  explicit EmojiKeywordSearchBench(size_t prefix_length) : prefix_length_(prefix_length) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Search " << KEYWORD_COUNT << " emoji keywords by prefix of length " << prefix_length_
+                     << (use_index ? " in EmojiKeywordIndex" : " in SqliteKeyValue");
+  }
+
+  void start_up() final {
+    keywords_.clear();
+    td::vector<std::pair<td::string, td::string>> keyword_emojis;
+    td::FlatHashMap<td::string, td::string> key_values;
+    for (int i = 0; i < KEYWORD_COUNT; i++) {
+      td::string keyword;
+      auto length = td::Random::fast(5, 12);
+      for (int j = 0; j < length; j++) {
+        keyword += static_cast<char>(td::Random::fast('a', 'z'));
+      }
+      td::string emojis = "\xF0\x9F\x98\x80$\xF0\x9F\x98\x81";
+      key_values[PSTRING() << "emoji$en$" << keyword] = emojis;
+      keyword_emojis.emplace_back(keyword, std::move(emojis));
+      keywords_.push_back(std::move(keyword));
+    }
+    if (use_index) {
+      index_ = td::EmojiKeywordIndex(1, std::move(keyword_emojis));
+    } else {
+      td::string db_name = "testdb.sqlite";
+      td::SqliteDb::destroy(db_name).ignore();
+      auto db = td::SqliteDb::open_with_key(db_name, true, td::DbKey::empty()).move_as_ok();
+      kv_.init_with_connection(std::move(db), "common").ensure();
+      kv_.set_all(key_values);
+    }
+  }
+
+  void run(int n) final {
+    size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      td::Slice prefix = keywords_[td::Random::fast(0, KEYWORD_COUNT - 1)];
+      prefix.truncate(prefix_length_);
+      if (use_index) {
+        res += index_.search(prefix).size();
+      } else {
+        kv_.get_by_prefix(PSLICE() << "emoji$en$" << prefix, [&res](td::Slice key, td::Slice value) {
+          res += td::full_split(value, '$').size();
+          return true;
+        });
+      }
+    }
+    td::do_not_optimize_away(res);
+  }
+
+  void tear_down() final {
+    if (!use_index) {
+      kv_.close();
+      td::SqliteDb::destroy("testdb.sqlite").ignore();
+    }
+  }
+};
+
+// gets language pack strings by key like LanguagePackManager::get_language_pack_strings does
+template <bool use_string_table>
+class LanguagePackStringsBench final : public td::Benchmark {
+  static constexpr int KEY_COUNT = 10000;
+
+  td::vector<td::string> keys_;
+  td::FlatHashMap<td::string, td::string> ordinary_strings_;
+  std::shared_ptr<const td::LanguagePackStringTable> string_table_;
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "Get one of " << KEY_COUNT << " language pack strings from "
+                     << (use_string_table ? "LanguagePackStringTable" : "FlatHashMap");
+  }
+
+  void start_up() final {
+    keys_.clear();
+    ordinary_strings_.clear();
+    td::vector<std::pair<td::string, td::string>> strings;
+    for (int i = 0; i < KEY_COUNT; i++) {
+      td::string key = PSTRING() << "lng_key_" << td::Random::fast_uint32();
+      td::string value(td::Random::fast(10, 60), 'a');
+      if (!ordinary_strings_.emplace(key, value).second) {
+        continue;
+      }
+      strings.emplace_back(key, '1' + value);
+      keys_.push_back(std::move(key));
+    }
+    if (use_string_table) {
+      string_table_ = td::LanguagePackStringTable::create(td::LanguagePackStringTable::serialize(std::move(strings)))
+                          .move_as_ok();
+      ordinary_strings_.clear();
+    }
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      const auto &key = keys_[td::Random::fast(0, static_cast<int>(keys_.size()) - 1)];
+      td::td_api::object_ptr<td::td_api::languagePackStringValueOrdinary> value;
+      if (use_string_table) {
+        value = td::td_api::make_object<td::td_api::languagePackStringValueOrdinary>(
+            string_table_->get(key).substr(1).str());
+      } else {
+        value = td::td_api::make_object<td::td_api::languagePackStringValueOrdinary>(ordinary_strings_[key]);
+      }
+      res += value->value_.size();
+    }
+    td::do_not_optimize_away(res);
+  }
+};
+
+// requests link previews for a small set of messages like worker threads do;
+// the network is replaced with a local stand-in, which only spins for the duration of a round trip
+template <bool use_cache>
+class QueryResultCacheBench final : public td::Benchmark {
+  static constexpr int MESSAGE_COUNT = 100;
+  static constexpr double ROUND_TRIP_TIME = 20e-6;
+
+  td::vector<td::string> messages_;
+  td::BufferSlice response_;
+  td::QueryResultCache cache_;
+  std::size_t round_trip_count_ = 0;
+
+  td::BufferSlice send_to_server(td::Slice query) {
+    round_trip_count_++;
+    auto end_time = td::Clocks::monotonic() + ROUND_TRIP_TIME;
+    while (td::Clocks::monotonic() < end_time) {
+      // wait for the response
+    }
+    td::do_not_optimize_away(query.size());
+    return response_.clone();
+  }
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "messages.getWebPagePreview for one of " << MESSAGE_COUNT << " messages "
+                     << (use_cache ? "with" : "without") << " QueryResultCache";
+  }
+
+  void start_up() final {
+    messages_.clear();
+    for (int i = 0; i < MESSAGE_COUNT; i++) {
+      messages_.push_back(PSTRING() << "https://example.com/article/" << td::Random::fast_uint32());
+    }
+    response_ = td::BufferSlice(td::string(2000, 'a'));
+    cache_ = td::QueryResultCache();
+    round_trip_count_ = 0;
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      const auto &message = messages_[td::Random::fast(0, MESSAGE_COUNT - 1)];
+      td::telegram_api::messages_getWebPagePreview function(0, message, {});
+      auto storer = td::DefaultStorer<td::telegram_api::Function>(function);
+      td::BufferSlice query(storer.size());
+      storer.store(query.as_mutable_slice().ubegin());
+
+      td::BufferSlice result;
+      if (use_cache) {
+        result = cache_.get(td::telegram_api::messages_getWebPagePreview::ID, query.as_slice());
+      }
+      if (result.empty()) {
+        result = send_to_server(query.as_slice());
+        if (use_cache) {
+          cache_.add(td::telegram_api::messages_getWebPagePreview::ID, query.as_slice(), result.as_slice());
+        }
+      }
+      res += result.size();
+    }
+    td::do_not_optimize_away(res);
+  }
+
+  void tear_down() final {
+    auto statistics = cache_.get_statistics(td::telegram_api::messages_getWebPagePreview::ID);
+    LOG(INFO) << "Made " << round_trip_count_ << " round trips; cache hits: " << statistics.hit_count
+              << ", misses: " << statistics.miss_count;
+  }
+};
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED && !TD_WINDOWS
+// receives gzipped query results like Session does: each packet is decrypted on the receiving scheduler,
+// and then decompressed either inline or by QueryResultDecoder
+template <bool use_decoder>
+class QueryResultDecodeBench final : public td::Benchmark {
+  static constexpr int RESULT_COUNT = 16;
+  static constexpr int RESULT_SIZE = 256 << 10;
+
+  td::vector<td::BufferSlice> packed_results_;
+  size_t packed_size_ = 0;
+
+  class Receiver final : public td::Actor {
+   public:
+    Receiver(const td::vector<td::BufferSlice> &packed_results, int n) : packed_results_(packed_results), n_(n) {
+    }
+
+   private:
+    const td::vector<td::BufferSlice> &packed_results_;
+    int n_;
+    int received_count_ = 0;
+    int decoded_count_ = 0;
+    size_t decoded_size_ = 0;
+    std::shared_ptr<td::QueryResultDecoder::ResultQueue> decoded_results_;
+
+    void start_up() final {
+      if (use_decoder) {
+        decoded_results_ = std::make_shared<td::QueryResultDecoder::ResultQueue>();
+        decoded_results_->init();
+        td::Scheduler::subscribe(decoded_results_->reader_get_event_fd().get_poll_info().extract_pollable_fd(this),
+                                 td::PollFlags::Read());
+      }
+      yield();
+    }
+
+    void loop() final {
+      if (use_decoder) {
+        int ready_count;
+        while ((ready_count = decoded_results_->reader_wait_nonblock()) > 0) {
+          while (ready_count-- > 0) {
+            on_decoded(decoded_results_->reader_get_unsafe().packet_);
+          }
+        }
+      }
+
+      // receive packets in portions to let decoded results be processed in between
+      for (int i = 0; i < 4 && received_count_ < n_; i++, received_count_++) {
+        const auto &packed_data = packed_results_[received_count_ % RESULT_COUNT];
+        // the packet is decrypted like SessionConnection does with incoming packets
+        td::UInt256 key;
+        td::UInt256 iv;
+        td::BufferSlice decrypted_data(packed_data.size() & ~static_cast<size_t>(15));
+        td::aes_ige_decrypt(td::as_slice(key), td::as_mutable_slice(iv),
+                            packed_data.as_slice().truncate(decrypted_data.size()), decrypted_data.as_mutable_slice());
+        if (use_decoder) {
+          td::QueryResultDecoder::decode(decoded_results_, received_count_, packed_data.clone());
+        } else {
+          on_decoded(td::gzdecode(packed_data.as_slice()));
+        }
+      }
+      if (received_count_ < n_) {
+        yield();
+      }
+    }
+
+    void on_decoded(td::BufferSlice packet) {
+      CHECK(packet.size() == static_cast<size_t>(RESULT_SIZE));
+      decoded_size_ += packet.size();
+      if (++decoded_count_ == n_) {
+        if (use_decoder) {
+          td::Scheduler::unsubscribe(decoded_results_->reader_get_event_fd().get_poll_info().get_pollable_fd_ref());
+        }
+        td::Scheduler::instance()->finish();
+        stop();
+      }
+    }
+  };
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "Receive " << (RESULT_SIZE >> 10) << " KB query results gzipped to " << (packed_size_ >> 10)
+                     << " KB, decompressed " << (use_decoder ? "by QueryResultDecoder" : "inline");
+  }
+
+  void start_up() final {
+    for (int i = 0; i < RESULT_COUNT; i++) {
+      td::string result;
+      while (result.size() < static_cast<size_t>(RESULT_SIZE)) {
+        result += PSTRING() << "message " << td::Random::fast(0, 1000000000) << " from user "
+                            << td::Random::fast(0, 1000000) << ' ';
+      }
+      result.resize(RESULT_SIZE);
+      packed_results_.push_back(td::gzencode(result, 1.0));
+      packed_size_ = packed_results_.back().size();
+    }
+  }
+
+  void run(int n) final {
+    td::ConcurrentScheduler scheduler(0, 0);
+    scheduler.create_actor_unsafe<Receiver>(0, "Receiver", packed_results_, n).release();
+    scheduler.start();
+    while (scheduler.run_main(10)) {
+    }
+    scheduler.finish();
+  }
+};
+#endif
+
 #if !TD_EVENTFD_UNSUPPORTED
 BENCH(EventFd, "EventFd") {
   td::EventFd fd;
@@ -752,6 +1223,61 @@ BENCH(AnyOfTd, "any_of td") {
   td::do_not_optimize_away(res);
 }
 
+#if !TD_THREAD_UNSUPPORTED
+// keeps a window of live buffers of random sizes, similar to network packets or binlog events
+class BufferAllocatorBenchmark final : public td::Benchmark {
+ public:
+  BufferAllocatorBenchmark(td::string name, int min_size, int max_size, size_t window_size, int thread_count)
+      : name_(std::move(name))
+      , min_size_(min_size)
+      , max_size_(max_size)
+      , window_size_(window_size)
+      , thread_count_(thread_count) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "BufferAllocator " << name_ << " with " << thread_count_ << " threads";
+  }
+
+  void run(int n) final {
+    td::vector<td::thread> threads;
+    for (int i = 0; i < thread_count_; i++) {
+      threads.emplace_back([&] {
+        td::vector<td::BufferSlice> window(window_size_);
+        for (int j = 0; j < n; j++) {
+          auto &slice = window[td::Random::fast(0, static_cast<int>(window_size_) - 1)];
+          slice = td::BufferSlice(td::Random::fast(min_size_, max_size_));
+          slice.as_mutable_slice()[0] = 'a';
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+ private:
+  td::string name_;
+  int min_size_;
+  int max_size_;
+  size_t window_size_;
+  int thread_count_;
+};
+
+static void bench_buffer_allocator(BufferAllocatorBenchmark &&benchmark) {
+  td::bench(benchmark);
+  auto r_mem_stat = td::mem_stat();
+  if (r_mem_stat.is_ok()) {
+    LOG(INFO) << "RSS = " << r_mem_stat.ok().resident_size_ << ", cached buffer blocks:";
+    for (auto &stats : td::BufferAllocator::get_size_class_stats()) {
+      if (stats.cached_count != 0) {
+        LOG(INFO) << "    " << stats.block_size << ": " << stats.cached_count;
+      }
+    }
+  }
+}
+#endif
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(DEBUG));
 
@@ -767,6 +1293,28 @@ int main() {
   td::bench(TlToStringUpdateFileBench());
   td::bench(TlToStringMessageBench());
 
+  td::bench(TlParseContactsBench<false>());
+  td::bench(TlParseContactsBench<true>());
+
+  td::bench(LazyShortUpdateBench<true>());
+  td::bench(LazyShortUpdateBench<false>());
+
+  td::bench(LanguagePackStringsBench<false>());
+  td::bench(LanguagePackStringsBench<true>());
+
+  td::bench(QueryResultCacheBench<false>());
+  td::bench(QueryResultCacheBench<true>());
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED && !TD_WINDOWS
+  td::bench(QueryResultDecodeBench<false>());
+  td::bench(QueryResultDecodeBench<true>());
+#endif
+
+  for (size_t prefix_length : {1, 2, 5}) {
+    td::bench(EmojiKeywordSearchBench<true>(prefix_length));
+    td::bench(EmojiKeywordSearchBench<false>(prefix_length));
+  }
+
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerNew<1000>>());
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerNew<300>>());
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerArray<1000>>());
@@ -815,6 +1363,12 @@ int main() {
   td::bench(RwMutexReadBench<1>());
   td::bench(RwMutexWriteBench<2>());
   td::bench(RwMutexReadBench<2>());
+
+  for (int thread_count : {1, 4}) {
+    bench_buffer_allocator(BufferAllocatorBenchmark("session", 100, 16000, 256, thread_count));
+    bench_buffer_allocator(BufferAllocatorBenchmark("binlog", 64, 4096, 1024, thread_count));
+    bench_buffer_allocator(BufferAllocatorBenchmark("file parts", 32768, 65000, 16, thread_count));
+  }
 #endif
 #if !TD_WINDOWS
   td::bench(UtimeBench());
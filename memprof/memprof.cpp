@@ -9,14 +9,19 @@
 #include "td/utils/port/platform.h"
 
 #if (TD_DARWIN || TD_LINUX) && defined(USE_MEMPROF)
+#include "td/utils/MemoryProfiler.h"
+
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <new>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -121,12 +126,50 @@ static Backtrace get_backtrace() {
   return res;
 }
 
+#if USE_MEMPROF_SAMPLING
+static std::atomic<std::size_t> sampling_interval{0};
+static std::atomic<std::size_t> last_sampling_interval{0};
+
+static std::size_t get_next_sample_distance(std::size_t interval) {
+  // distances between samples are distributed exponentially, so an allocation of size S is sampled
+  // with probability 1 - exp(-S / interval) independently of other allocations, as pprof expects
+  static __thread std::uint64_t random_state;  // static zero-initialized
+  if (random_state == 0) {
+    random_state = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&random_state)) | 1;
+  }
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 7;
+  random_state ^= random_state << 17;
+  auto u = static_cast<double>((random_state >> 11) + 1) / static_cast<double>(std::uint64_t(1) << 53);  // (0, 1]
+  return static_cast<std::size_t>(-std::log(u) * static_cast<double>(interval)) + 1;
+}
+#endif
+
+// returns whether a backtrace must be saved for the allocation
+static bool need_sample(std::size_t size) {
+#if USE_MEMPROF_SAMPLING
+  static __thread std::size_t bytes_until_sample;  // static zero-initialized
+  auto interval = sampling_interval.load(std::memory_order_relaxed);
+  if (interval == 0) {
+    return false;
+  }
+  if (bytes_until_sample > size) {
+    bytes_until_sample -= size;
+    return false;
+  }
+  bytes_until_sample = get_next_sample_distance(interval);
+  return true;
+#else
+  return true;
+#endif
+}
+
 static constexpr std::size_t RESERVED_SIZE = 16;
 static constexpr std::int32_t MALLOC_INFO_MAGIC = 0x27138373;
 struct malloc_info {
   std::int32_t magic;
   std::int32_t size;
-  std::int32_t ht_pos;
+  std::int32_t ht_pos;  // -1 if the allocation isn't sampled
 };
 
 static std::uint64_t get_hash(const Backtrace &bt) {
@@ -141,9 +184,16 @@ struct HashtableNode {
   std::atomic<std::uint64_t> hash;
   Backtrace backtrace;
   std::atomic<std::size_t> size;
+  std::atomic<std::size_t> count;
+  std::atomic<std::size_t> total_size;
+  std::atomic<std::size_t> total_count;
 };
 
+#if USE_MEMPROF_SAMPLING
+static constexpr std::size_t HT_MAX_SIZE = 1000000;
+#else
 static constexpr std::size_t HT_MAX_SIZE = 10000000;
+#endif
 static std::atomic<std::size_t> ht_size{0};
 static std::array<HashtableNode, HT_MAX_SIZE> ht;
 
@@ -202,17 +252,114 @@ void dump_alloc(const std::function<void(const AllocInfo &)> &func) {
 
 void register_xalloc(malloc_info *info, std::int32_t diff) {
   my_assert(info->size >= 0);
+  if (info->ht_pos < 0) {
+    return;
+  }
+  auto &node = ht[info->ht_pos];
   if (diff > 0) {
-    ht[info->ht_pos].size.fetch_add(info->size, std::memory_order_relaxed);
+    node.size.fetch_add(info->size, std::memory_order_relaxed);
+    node.count.fetch_add(1, std::memory_order_relaxed);
+    node.total_size.fetch_add(info->size, std::memory_order_relaxed);
+    node.total_count.fetch_add(1, std::memory_order_relaxed);
   } else {
-    auto old_value = ht[info->ht_pos].size.fetch_sub(info->size, std::memory_order_relaxed);
+    auto old_value = node.size.fetch_sub(info->size, std::memory_order_relaxed);
     my_assert(old_value >= static_cast<std::size_t>(info->size));
+    node.count.fetch_sub(1, std::memory_order_relaxed);
   }
 }
 
+static std::string get_heap_profile() {
+  std::size_t total_size = 0;
+  std::size_t total_count = 0;
+  std::size_t total_allocated_size = 0;
+  std::size_t total_allocated_count = 0;
+  std::string samples;
+  char buf[64];
+  for (auto &node : ht) {
+    auto allocated_count = node.total_count.load(std::memory_order_relaxed);
+    if (allocated_count == 0) {
+      continue;
+    }
+    auto size = node.size.load(std::memory_order_relaxed);
+    auto count = node.count.load(std::memory_order_relaxed);
+    auto allocated_size = node.total_size.load(std::memory_order_relaxed);
+    total_size += size;
+    total_count += count;
+    total_allocated_size += allocated_size;
+    total_allocated_count += allocated_count;
+
+    std::snprintf(buf, sizeof(buf), "%zu: %zu [%zu: %zu] @", count, size, allocated_count, allocated_size);
+    samples += buf;
+    for (auto *ip : node.backtrace) {
+      if (ip == nullptr) {
+        break;
+      }
+      std::snprintf(buf, sizeof(buf), " %p", ip);
+      samples += buf;
+    }
+    samples += '\n';
+  }
+
+#if USE_MEMPROF_SAMPLING
+  auto interval = std::max(std::size_t(1), last_sampling_interval.load(std::memory_order_relaxed));
+#else
+  std::size_t interval = 1;
+#endif
+  char header[128];
+  std::snprintf(header, sizeof(header), "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n", total_count, total_size,
+                total_allocated_count, total_allocated_size, interval);
+
+  std::string result = header;
+  result += samples;
+#if TD_LINUX
+  // pprof needs the memory map to symbolize addresses
+  result += "\nMAPPED_LIBRARIES:\n";
+  auto *maps = std::fopen("/proc/self/maps", "r");
+  if (maps != nullptr) {
+    std::size_t read_size;
+    char maps_buf[4096];
+    while ((read_size = std::fread(maps_buf, 1, sizeof(maps_buf), maps)) > 0) {
+      result.append(maps_buf, read_size);
+    }
+    std::fclose(maps);
+  }
+#endif
+  return result;
+}
+
+class MemprofHeapProfiler final : public td::MemoryProfiler {
+ public:
+  MemprofHeapProfiler() {
+    td::set_memory_profiler(this);
+  }
+
+  void set_sampling_interval(std::size_t new_sampling_interval) final {
+#if USE_MEMPROF_SAMPLING
+    if (new_sampling_interval != 0) {
+      last_sampling_interval.store(new_sampling_interval, std::memory_order_relaxed);
+    }
+    sampling_interval.store(new_sampling_interval, std::memory_order_relaxed);
+#endif
+  }
+
+  std::size_t get_sampling_interval() const final {
+#if USE_MEMPROF_SAMPLING
+    return sampling_interval.load(std::memory_order_relaxed);
+#else
+    return 1;  // all allocations are tracked
+#endif
+  }
+
+  std::string get_heap_profile() const final {
+    return ::get_heap_profile();
+  }
+};
+
+static MemprofHeapProfiler memprof_heap_profiler;
+
 extern "C" {
 
-static void *malloc_with_frame(std::size_t size, const Backtrace &frame) {
+static malloc_info *malloc_with_info(std::size_t size) {
   static_assert(RESERVED_SIZE % alignof(std::max_align_t) == 0, "fail");
   static_assert(RESERVED_SIZE >= sizeof(malloc_info), "fail");
 #if TD_DARWIN
@@ -223,17 +370,24 @@ static void *malloc_with_frame(std::size_t size, const Backtrace &frame) {
   static auto malloc_old = __libc_malloc;
 #endif
   auto *info = static_cast<malloc_info *>(malloc_old(size + RESERVED_SIZE));
-  auto *buf = reinterpret_cast<char *>(info);
 
   info->magic = MALLOC_INFO_MAGIC;
   info->size = static_cast<std::int32_t>(size);
+  info->ht_pos = -1;
+  return info;
+}
+
+static void *malloc_with_frame(std::size_t size, const Backtrace &frame) {
+  auto *info = malloc_with_info(size);
   info->ht_pos = get_ht_pos(frame);
 
   register_xalloc(info, +1);
 
-  void *data = buf + RESERVED_SIZE;
+  return reinterpret_cast<char *>(info) + RESERVED_SIZE;
+}
 
-  return data;
+static void *malloc_without_frame(std::size_t size) {
+  return reinterpret_cast<char *>(malloc_with_info(size)) + RESERVED_SIZE;
 }
 
 static malloc_info *get_info(void *data_void) {
@@ -246,7 +400,7 @@ static malloc_info *get_info(void *data_void) {
 }
 
 void *malloc(std::size_t size) {
-  return malloc_with_frame(size, get_backtrace());
+  return need_sample(size) ? malloc_with_frame(size, get_backtrace()) : malloc_without_frame(size);
 }
 
 void free(void *data_void) {
@@ -268,17 +422,17 @@ void free(void *data_void) {
 
 void *calloc(std::size_t size_a, std::size_t size_b) {
   auto size = size_a * size_b;
-  void *res = malloc_with_frame(size, get_backtrace());
+  void *res = need_sample(size) ? malloc_with_frame(size, get_backtrace()) : malloc_without_frame(size);
   std::memset(res, 0, size);
   return res;
 }
 
 void *realloc(void *ptr, std::size_t size) {
   if (ptr == nullptr) {
-    return malloc_with_frame(size, get_backtrace());
+    return need_sample(size) ? malloc_with_frame(size, get_backtrace()) : malloc_without_frame(size);
   }
   auto *info = get_info(ptr);
-  auto *new_ptr = malloc_with_frame(size, get_backtrace());
+  auto *new_ptr = need_sample(size) ? malloc_with_frame(size, get_backtrace()) : malloc_without_frame(size);
   auto to_copy = std::min(static_cast<std::int32_t>(size), info->size);
   std::memcpy(new_ptr, ptr, to_copy);
   free(ptr);
@@ -293,7 +447,7 @@ void *memalign(std::size_t aligment, std::size_t size) {
 
 // c++14 guarantees that it is enough to override these two operators.
 void *operator new(std::size_t count) {
-  return malloc_with_frame(count, get_backtrace());
+  return need_sample(count) ? malloc_with_frame(count, get_backtrace()) : malloc_without_frame(count);
 }
 void operator delete(void *ptr) noexcept(true) {
   free(ptr);
@@ -11,11 +11,14 @@
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/filesystem.h"
+#include "td/utils/JsonBuilder.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
 
+#include <string>
 #include <utility>
+#include <vector>
 
 namespace td {
 
@@ -94,21 +97,188 @@ void gen_to_json(StringBuilder &sb, const tl::simple::Schema &schema, bool is_he
   }
 }
 
+// generates a serializer, which writes compact JSON directly to a StringBuilder without JsonBuilder scopes
+// the output must be byte-for-byte identical to the output of to_json with a non-pretty JsonBuilder
+template <class T>
+void gen_to_compact_json_constructor(StringBuilder &sb, const T *constructor, bool is_header) {
+  sb << "void to_compact_json(StringBuilder &sb, "
+     << "const td_api::" << tl::simple::gen_cpp_name(constructor->name) << " &object)";
+  if (is_header) {
+    sb << ";\n\n";
+    return;
+  }
+  sb << " {\n";
+  sb << "  sb << \"{\\\"@type\\\":\\\"" << tl::simple::gen_cpp_name(constructor->name) << "\\\"\";\n";
+  for (auto &arg : constructor->args) {
+    auto field_name = tl::simple::gen_cpp_field_name(arg.name);
+    auto object = PSTRING() << "object." << field_name;
+    auto key = PSTRING() << "\",\\\"" << arg.name << "\\\":";
+    switch (arg.type->type) {
+      case tl::simple::Type::Int32:
+      case tl::simple::Type::Int53:
+      case tl::simple::Type::Double:
+        sb << "  sb << " << key << "\" << " << object << ";\n";
+        break;
+      case tl::simple::Type::Int64:
+        sb << "  sb << " << key << "\\\"\" << " << object << " << '\"';\n";
+        break;
+      case tl::simple::Type::Bool:
+        sb << "  sb << " << key << "\" << JsonBool{" << object << "};\n";
+        break;
+      case tl::simple::Type::String:
+        sb << "  sb << " << key << "\" << JsonString(" << object << ");\n";
+        break;
+      case tl::simple::Type::Bytes:
+        sb << "  sb << " << key << "\" << JsonString(base64_encode(" << object << "));\n";
+        break;
+      case tl::simple::Type::Vector:
+        sb << "  sb << " << key << "\";\n";
+        if (arg.type->vector_value_type->type == tl::simple::Type::Int64) {
+          sb << "  td::to_compact_json(sb, JsonVectorInt64{" << object << "});\n";
+        } else {
+          sb << "  td::to_compact_json(sb, " << object << ");\n";
+        }
+        break;
+      case tl::simple::Type::Custom:
+        sb << "  if (" << object << ") {\n";
+        sb << "    sb << " << key << "\";\n";
+        sb << "    to_compact_json(sb, *" << object << ");\n";
+        sb << "  }\n";
+        break;
+      default:
+        UNREACHABLE();
+    }
+  }
+  sb << "  sb << '}';\n";
+  sb << "}\n\n";
+}
+
+void gen_to_compact_json(StringBuilder &sb, const tl::simple::Schema &schema, bool is_header, Mode mode) {
+  for (auto *custom_type : schema.custom_types) {
+    if (!((custom_type->is_query_ && mode != Mode::Server) || (custom_type->is_result_ && mode != Mode::Client))) {
+      continue;
+    }
+    if (custom_type->constructors.size() > 1) {
+      auto type_name = tl::simple::gen_cpp_name(custom_type->name);
+      sb << "void to_compact_json(StringBuilder &sb, const td_api::" << type_name << " &object)";
+      if (is_header) {
+        sb << ";\n\n";
+      } else {
+        sb << " {\n"
+           << "  td_api::downcast_call(const_cast<td_api::" << type_name
+           << " &>(object), [&sb](const auto &object) { "
+              "to_compact_json(sb, object); });\n"
+           << "}\n\n";
+      }
+    }
+    for (auto *constructor : custom_type->constructors) {
+      gen_to_compact_json_constructor(sb, constructor, is_header);
+    }
+  }
+  if (mode == Mode::Server) {
+    return;
+  }
+  for (auto *function : schema.functions) {
+    gen_to_compact_json_constructor(sb, function, is_header);
+  }
+}
+
+struct FieldNameHash {
+  uint32 multiplier = 31;
+  uint32 modulo = 1;
+};
+
+// finds parameters of a perfect hash function for the field names; falls back to a hash with few collisions
+static FieldNameHash find_field_name_hash(const std::vector<std::string> &names) {
+  auto count = static_cast<uint32>(names.size());
+  for (uint32 modulo = count; modulo <= 2 * count; modulo++) {
+    for (uint32 multiplier = 31; multiplier < 10000; multiplier += 2) {
+      std::vector<bool> is_used(modulo);
+      bool is_perfect = true;
+      for (auto &name : names) {
+        auto hash = get_json_field_name_hash(name, multiplier) % modulo;
+        if (is_used[hash]) {
+          is_perfect = false;
+          break;
+        }
+        is_used[hash] = true;
+      }
+      if (is_perfect) {
+        return FieldNameHash{multiplier, modulo};
+      }
+    }
+  }
+  return FieldNameHash{31, 2 * count};
+}
+
 template <class T>
 void gen_from_json_constructor(StringBuilder &sb, const T *constructor, bool is_header) {
   sb << "Status from_json(td_api::" << tl::simple::gen_cpp_name(constructor->name) << " &to, JsonObject &from)";
   if (is_header) {
     sb << ";\n\n";
-  } else {
-    sb << " {\n";
+    return;
+  }
+  sb << " {\n";
+  auto field_count = constructor->args.size();
+  if (field_count <= 2) {
     for (auto &arg : constructor->args) {
       sb << "  TRY_STATUS(from_json" << (arg.type->type == tl::simple::Type::Bytes ? "_bytes" : "") << "(to."
          << tl::simple::gen_cpp_field_name(arg.name) << ", from.extract_field(\"" << tl::simple::gen_cpp_name(arg.name)
          << "\")));\n";
     }
-    sb << "  return Status::OK();\n";
-    sb << "}\n\n";
+  } else {
+    // extract all fields in one pass over the object, dispatching them by a hash of their name
+    std::vector<std::string> names;
+    for (auto &arg : constructor->args) {
+      names.push_back(tl::simple::gen_cpp_name(arg.name));
+    }
+    auto hash = find_field_name_hash(names);
+    std::vector<std::vector<size_t>> buckets(hash.modulo);
+    for (size_t i = 0; i < field_count; i++) {
+      buckets[get_json_field_name_hash(names[i], hash.multiplier) % hash.modulo].push_back(i);
+    }
+
+    sb << "  td::JsonValue values[" << field_count << "];\n";
+    sb << "  bool is_found[" << field_count << "] = {};\n";
+    sb << "  for (auto &field_value : from.field_values_) {\n";
+    sb << "    Slice name = field_value.first;\n";
+    sb << "    size_t i = " << field_count << ";\n";
+    sb << "    switch (get_json_field_name_hash(name, " << hash.multiplier << ") % " << hash.modulo << ") {\n";
+    for (uint32 hash_value = 0; hash_value < hash.modulo; hash_value++) {
+      auto &bucket = buckets[hash_value];
+      if (bucket.empty()) {
+        continue;
+      }
+      sb << "      case " << hash_value << ":\n";
+      sb << "        ";
+      for (auto i : bucket) {
+        sb << "if (name == \"" << names[i] << "\") {\n";
+        sb << "          i = " << i << ";\n";
+        sb << "        }";
+        if (i == bucket.back()) {
+          sb << "\n";
+        } else {
+          sb << " else ";
+        }
+      }
+      sb << "        break;\n";
+    }
+    sb << "      default:\n";
+    sb << "        break;\n";
+    sb << "    }\n";
+    sb << "    if (i < " << field_count << " && !is_found[i]) {\n";
+    sb << "      is_found[i] = true;\n";
+    sb << "      values[i] = std::move(field_value.second);\n";
+    sb << "    }\n";
+    sb << "  }\n";
+    for (size_t i = 0; i < field_count; i++) {
+      auto &arg = constructor->args[i];
+      sb << "  TRY_STATUS(from_json" << (arg.type->type == tl::simple::Type::Bytes ? "_bytes" : "") << "(to."
+         << tl::simple::gen_cpp_field_name(arg.name) << ", std::move(values[" << i << "])));\n";
+    }
   }
+  sb << "  return Status::OK();\n";
+  sb << "}\n\n";
 }
 
 void gen_from_json(StringBuilder &sb, const tl::simple::Schema &schema, bool is_header, Mode mode) {
@@ -195,7 +365,7 @@ void gen_json_converter_file(const tl::simple::Schema &schema, const std::string
     return r_content.move_as_ok();
   }();
 
-  std::string buf(2000000, ' ');
+  std::string buf(4000000, ' ');
   StringBuilder sb(buf);
 
   if (is_header) {
@@ -204,7 +374,8 @@ void gen_json_converter_file(const tl::simple::Schema &schema, const std::string
     sb << "#include \"td/telegram/td_api.h\"\n\n";
 
     sb << "#include \"td/utils/JsonBuilder.h\"\n";
-    sb << "#include \"td/utils/Status.h\"\n\n";
+    sb << "#include \"td/utils/Status.h\"\n";
+    sb << "#include \"td/utils/StringBuilder.h\"\n\n";
   } else {
     sb << "#include \"" << file_name_base << ".h\"\n\n";
 
@@ -226,7 +397,9 @@ void gen_json_converter_file(const tl::simple::Schema &schema, const std::string
     sb << "\nvoid to_json(JsonValueScope &jv, const tl_object_ptr<Object> &value);\n";
     sb << "\nStatus from_json(tl_object_ptr<Function> &to, td::JsonValue from);\n";
     sb << "\nvoid to_json(JsonValueScope &jv, const Object &object);\n";
-    sb << "\nvoid to_json(JsonValueScope &jv, const Function &object);\n\n";
+    sb << "\nvoid to_json(JsonValueScope &jv, const Function &object);\n";
+    sb << "\nvoid to_compact_json(StringBuilder &sb, const Object &object);\n";
+    sb << "\nvoid to_compact_json(StringBuilder &sb, const Function &object);\n\n";
   } else {
     sb << R"ABCD(
 void to_json(JsonValueScope &jv, const tl_object_ptr<Object> &value) {
@@ -255,11 +428,30 @@ void to_json(JsonValueScope &jv, const Function &object) {
   downcast_call(const_cast<Function &>(object), [&jv](const auto &object) { lazy_to_json(jv, object); });
 }
 
+template <class T>
+auto lazy_to_compact_json(StringBuilder &sb, const T &t) -> decltype(td_api::to_compact_json(sb, t)) {
+  return td_api::to_compact_json(sb, t);
+}
+
+template <class T>
+void lazy_to_compact_json(std::reference_wrapper<StringBuilder>, const T &t) {
+  UNREACHABLE();
+}
+
+void to_compact_json(StringBuilder &sb, const Object &object) {
+  downcast_call(const_cast<Object &>(object), [&sb](const auto &object) { lazy_to_compact_json(sb, object); });
+}
+
+void to_compact_json(StringBuilder &sb, const Function &object) {
+  downcast_call(const_cast<Function &>(object), [&sb](const auto &object) { lazy_to_compact_json(sb, object); });
+}
+
 )ABCD";
   }
   gen_tl_constructor_from_string(sb, schema, is_header, mode);
   gen_from_json(sb, schema, is_header, mode);
   gen_to_json(sb, schema, is_header, mode);
+  gen_to_compact_json(sb, schema, is_header, mode);
   sb << "}  // namespace td_api\n";
   sb << "}  // namespace td\n";
 
@@ -6,10 +6,104 @@
 //
 #include "tl_writer_hpp.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
 
 namespace td {
 
+namespace {
+
+const std::uint32_t FUNCTION_BUCKET_MULTIPLIER = 2654435769u;
+
+struct FunctionTableHash {
+  int bucket_bits = 0;
+  int table_bits = 0;
+  std::uint32_t slot_multiplier = 0;
+  std::vector<std::uint32_t> displacements;
+};
+
+// tries to find a perfect hash function of the form (h1(id) ^ displacements[h2(id)]) for the given identifiers
+bool try_find_function_table_hash(const std::vector<std::int32_t> &ids, FunctionTableHash &result) {
+  auto get_bucket = [&result](std::int32_t id) -> std::size_t {
+    if (result.bucket_bits == 0) {
+      return 0;
+    }
+    return (static_cast<std::uint32_t>(id) * FUNCTION_BUCKET_MULTIPLIER) >> (32 - result.bucket_bits);
+  };
+  auto get_slot = [&result](std::int32_t id) -> std::uint32_t {
+    return (static_cast<std::uint32_t>(id) * result.slot_multiplier) >> (32 - result.table_bits);
+  };
+
+  std::vector<std::vector<std::int32_t>> buckets(static_cast<std::size_t>(1) << result.bucket_bits);
+  for (auto id : ids) {
+    buckets[get_bucket(id)].push_back(id);
+  }
+  std::vector<std::size_t> bucket_order(buckets.size());
+  for (std::size_t i = 0; i < bucket_order.size(); i++) {
+    bucket_order[i] = i;
+  }
+  std::stable_sort(bucket_order.begin(), bucket_order.end(),
+                   [&buckets](std::size_t lhs, std::size_t rhs) { return buckets[lhs].size() > buckets[rhs].size(); });
+
+  std::uint32_t table_size = static_cast<std::uint32_t>(1) << result.table_bits;
+  std::vector<bool> is_slot_used(table_size, false);
+  result.displacements.assign(buckets.size(), 0);
+  for (auto bucket_id : bucket_order) {
+    const auto &bucket = buckets[bucket_id];
+    if (bucket.empty()) {
+      break;
+    }
+    bool is_placed = false;
+    for (std::uint32_t displacement = 0; displacement < table_size && !is_placed; displacement++) {
+      std::vector<std::uint32_t> slots;
+      for (auto id : bucket) {
+        auto slot = get_slot(id) ^ displacement;
+        if (is_slot_used[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (slots.size() == bucket.size()) {
+        for (auto slot : slots) {
+          is_slot_used[slot] = true;
+        }
+        result.displacements[bucket_id] = displacement;
+        is_placed = true;
+      }
+    }
+    if (!is_placed) {
+      // identifiers from the bucket can't be separated by the displacement
+      return false;
+    }
+  }
+  return true;
+}
+
+FunctionTableHash find_function_table_hash(const std::vector<std::int32_t> &ids) {
+  FunctionTableHash result;
+  while ((static_cast<std::size_t>(4) << result.bucket_bits) < ids.size()) {
+    result.bucket_bits++;
+  }
+  for (result.table_bits = result.bucket_bits + 3; result.table_bits <= 16; result.table_bits++) {
+    std::uint32_t seed = 2246822507u;
+    for (int attempt = 0; attempt < 64; attempt++) {
+      result.slot_multiplier = seed | 1;
+      if (try_find_function_table_hash(ids, result)) {
+        return result;
+      }
+      seed = seed * 1664525u + 1013904223u;
+    }
+  }
+  std::fprintf(stderr, "Can't find a perfect hash function for %d function identifiers\n", static_cast<int>(ids.size()));
+  std::abort();
+}
+
+}  // namespace
+
 bool TD_TL_writer_hpp::is_documentation_generated() const {
 #ifdef DISABLE_HPP_DOCUMENTATION
   return false;
@@ -19,13 +113,14 @@ bool TD_TL_writer_hpp::is_documentation_generated() const {
 }
 
 int TD_TL_writer_hpp::get_additional_function_type(const std::string &additional_function_name) const {
-  assert(additional_function_name == "downcast_call");
+  assert(additional_function_name == "downcast_call" || additional_function_name == "get_function_table_index");
   return 2;
 }
 
 std::vector<std::string> TD_TL_writer_hpp::get_additional_functions() const {
   std::vector<std::string> additional_functions;
   additional_functions.push_back("downcast_call");
+  additional_functions.push_back("get_function_table_index");
   return additional_functions;
 }
 
@@ -197,7 +292,7 @@ std::string TD_TL_writer_hpp::gen_fetch_switch_end() const {
 
 std::string TD_TL_writer_hpp::gen_additional_function(const std::string &function_name, const tl::tl_combinator *t,
                                                       bool is_function) const {
-  assert(function_name == "downcast_call");
+  assert(function_name == "downcast_call" || function_name == "get_function_table_index");
   return "";
 }
 
@@ -205,6 +300,10 @@ std::string TD_TL_writer_hpp::gen_additional_proxy_function_begin(const std::str
                                                                   const tl::tl_type *type,
                                                                   const std::string &class_name, int arity,
                                                                   bool is_function) const {
+  if (function_name == "get_function_table_index") {
+    function_ids_.clear();
+    return "";
+  }
   assert(function_name == "downcast_call");
   return
 #ifndef DISABLE_HPP_DOCUMENTATION
@@ -225,7 +324,6 @@ std::string TD_TL_writer_hpp::gen_additional_proxy_function_begin(const std::str
 std::string TD_TL_writer_hpp::gen_additional_proxy_function_case(const std::string &function_name,
                                                                  const tl::tl_type *type, const std::string &class_name,
                                                                  int arity) const {
-  assert(function_name == "downcast_call");
   assert(false);
   return "";
 }
@@ -233,6 +331,12 @@ std::string TD_TL_writer_hpp::gen_additional_proxy_function_case(const std::stri
 std::string TD_TL_writer_hpp::gen_additional_proxy_function_case(const std::string &function_name,
                                                                  const tl::tl_type *type, const tl::tl_combinator *t,
                                                                  int arity, bool is_function) const {
+  if (function_name == "get_function_table_index") {
+    if (type == nullptr && is_function) {
+      function_ids_.push_back(t->id);
+    }
+    return "";
+  }
   assert(function_name == "downcast_call");
   return "    case " + gen_class_name(t->name) +
          "::ID:\n"
@@ -244,6 +348,47 @@ std::string TD_TL_writer_hpp::gen_additional_proxy_function_case(const std::stri
 
 std::string TD_TL_writer_hpp::gen_additional_proxy_function_end(const std::string &function_name,
                                                                 const tl::tl_type *type, bool is_function) const {
+  if (function_name == "get_function_table_index") {
+    if (type != nullptr || !is_function) {
+      return "";
+    }
+    auto hash = find_function_table_hash(function_ids_);
+    std::string displacements;
+    for (std::size_t i = 0; i < hash.displacements.size(); i++) {
+      displacements += (i % 16 == 0 ? "\n    " : " ") + std::to_string(hash.displacements[i]) + ",";
+    }
+    std::string bucket = "0";
+    if (hash.bucket_bits != 0) {
+      bucket = "(hash * " + std::to_string(FUNCTION_BUCKET_MULTIPLIER) + "u) >> " + std::to_string(32 - hash.bucket_bits);
+    }
+    return
+#ifndef DISABLE_HPP_DOCUMENTATION
+        "/**\n"
+        " * Size of a table indexed by get_function_table_index.\n"
+        " */\n"
+#endif
+        "constexpr std::size_t FUNCTION_TABLE_SIZE = " +
+        std::to_string(static_cast<std::uint32_t>(1) << hash.table_bits) +
+        ";\n\n"
+#ifndef DISABLE_HPP_DOCUMENTATION
+        "/**\n"
+        " * Returns index of a function with the given identifier in a table of size FUNCTION_TABLE_SIZE.\n"
+        " * Different functions always have different indices.\n"
+        " * \\param[in] id Identifier of the function.\n"
+        " * \\returns Index of the function in the table.\n"
+        " */\n"
+#endif
+        "inline std::size_t get_function_table_index(std::int32_t id) {\n"
+        "  static const std::uint16_t displacements[" +
+        std::to_string(hash.displacements.size()) + "] = {" + displacements +
+        "\n  };\n"
+        "  auto hash = static_cast<std::uint32_t>(id);\n"
+        "  return ((hash * " +
+        std::to_string(hash.slot_multiplier) + "u) >> " + std::to_string(32 - hash.table_bits) +
+        ") ^ displacements[" + bucket +
+        "];\n"
+        "}\n\n";
+  }
   assert(function_name == "downcast_call");
   return "    default:\n"
          "      return false;\n"
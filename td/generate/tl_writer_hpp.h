@@ -103,6 +103,9 @@ class TD_TL_writer_hpp final : public TD_TL_writer {
                                                  const tl::tl_combinator *t, int arity, bool is_function) const final;
   std::string gen_additional_proxy_function_end(const std::string &function_name, const tl::tl_type *type,
                                                 bool is_function) const final;
+
+ private:
+  mutable std::vector<std::int32_t> function_ids_;
 };
 
 }  // namespace td
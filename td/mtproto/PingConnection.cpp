@@ -157,6 +157,11 @@ class PingConnectionPingPong final
     return Status::OK();
   }
 
+  Status on_message_result_gzip(MessageId message_id, BufferSlice packed_data, size_t original_size) final {
+    LOG(ERROR) << "Unexpected message";
+    return Status::OK();
+  }
+
   void on_message_result_error(MessageId message_id, int code, string message) final {
   }
 
@@ -17,6 +17,7 @@
 
 #include "td/utils/algorithm.h"
 #include "td/utils/as.h"
+#include "td/utils/AsyncBinaryLog.h"
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/Gzip.h"
@@ -223,7 +224,7 @@ Status SessionConnection::on_packet_container(const MsgInfo &info, Slice packet)
   if (parser.get_error()) {
     return Status::Error(PSLICE() << "Failed to parse mtproto_api::rpc_container: " << parser.get_error());
   }
-  VLOG(mtproto) << "Receive container " << container_message_id_ << " of size " << size;
+  VLOG_DEFERRED(mtproto) << "Receive container " << container_message_id_ << " of size " << size;
   for (int i = 0; i < size; i++) {
     TRY_STATUS(parse_packet(parser));
   }
@@ -231,7 +232,7 @@ Status SessionConnection::on_packet_container(const MsgInfo &info, Slice packet)
 }
 
 void SessionConnection::reset_server_time_difference(MessageId message_id) {
-  VLOG(mtproto) << "Reset server time difference";
+  VLOG_DEFERRED(mtproto) << "Reset server time difference";
   auth_data_->reset_server_time_difference(static_cast<uint32>(message_id.get() >> 32) - Time::now());
   callback_->on_server_time_difference_updated(true);
 }
@@ -246,7 +247,7 @@ Status SessionConnection::on_packet_rpc_result(const MsgInfo &info, Slice packet
     LOG(ERROR) << "Receive an update in rpc_result " << info;
     return Status::Error("Receive an update in rpc_result");
   }
-  VLOG(mtproto) << "Receive result for request with " << MessageId(req_msg_id) << ' ' << info;
+  VLOG_DEFERRED(mtproto) << "Receive result for request with " << MessageId(req_msg_id) << ' ' << info;
 
   if (info.message_id.get() < req_msg_id - (static_cast<uint64>(15) << 32)) {
     reset_server_time_difference(info.message_id);
@@ -267,9 +268,8 @@ Status SessionConnection::on_packet_rpc_result(const MsgInfo &info, Slice packet
         return Status::Error(PSLICE() << "Failed to parse mtproto_api::gzip_packed: " << parser.get_error());
       }
       // yep, gzip in rpc_result
-      BufferSlice object = gzdecode(gzip.packed_data_);
-      // send header no more optimization
-      return callback_->on_message_result_ok(MessageId(req_msg_id), std::move(object), info.size);
+      // decompression is left to the callback, which may do it on another thread
+      return callback_->on_message_result_gzip(MessageId(req_msg_id), as_buffer_slice(gzip.packed_data_), info.size);
     }
     default:
       packet.remove_prefix(sizeof(req_msg_id));
@@ -284,17 +284,17 @@ Status SessionConnection::on_packet(const MsgInfo &info, const T &packet) {
 }
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::destroy_auth_key_ok &destroy_auth_key) {
-  VLOG(mtproto) << "Receive destroy_auth_key_ok " << info;
+  VLOG_DEFERRED(mtproto) << "Receive destroy_auth_key_ok " << info;
   return on_destroy_auth_key(destroy_auth_key);
 }
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::destroy_auth_key_none &destroy_auth_key) {
-  VLOG(mtproto) << "Receive destroy_auth_key_none " << info;
+  VLOG_DEFERRED(mtproto) << "Receive destroy_auth_key_none " << info;
   return on_destroy_auth_key(destroy_auth_key);
 }
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::destroy_auth_key_fail &destroy_auth_key) {
-  VLOG(mtproto) << "Receive destroy_auth_key_fail " << info;
+  VLOG_DEFERRED(mtproto) << "Receive destroy_auth_key_fail " << info;
   return on_destroy_auth_key(destroy_auth_key);
 }
 
@@ -308,7 +308,7 @@ Status SessionConnection::on_destroy_auth_key(const mtproto_api::DestroyAuthKeyR
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::new_session_created &new_session_created) {
   auto first_message_id = MessageId(static_cast<uint64>(new_session_created.first_msg_id_));
-  VLOG(mtproto) << "Receive new_session_created " << info << ": [first " << first_message_id
+  VLOG_DEFERRED(mtproto) << "Receive new_session_created " << info << ": [first " << first_message_id
                 << "] [unique_id:" << new_session_created.unique_id_ << ']';
 
   auto it = service_queries_.find(first_message_id);
@@ -388,7 +388,7 @@ Status SessionConnection::on_packet(const MsgInfo &info,
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::bad_server_salt &bad_server_salt) {
   MsgInfo bad_info{MessageId(static_cast<uint64>(bad_server_salt.bad_msg_id_)), bad_server_salt.bad_msg_seqno_, 0};
-  VLOG(mtproto) << "Receive bad_server_salt " << info << ": " << bad_info;
+  VLOG_DEFERRED(mtproto) << "Receive bad_server_salt " << info << ": " << bad_info;
   auth_data_->set_server_salt(bad_server_salt.new_server_salt_, Time::now_cached());
   callback_->on_server_salt_updated();
 
@@ -398,7 +398,7 @@ Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::bad_
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::msgs_ack &msgs_ack) {
   auto message_ids = transform(msgs_ack.msg_ids_, [](int64 msg_id) { return MessageId(static_cast<uint64>(msg_id)); });
-  VLOG(mtproto) << "Receive msgs_ack " << info << ": " << message_ids;
+  VLOG_DEFERRED(mtproto) << "Receive msgs_ack " << info << ": " << message_ids;
   for (auto message_id : message_ids) {
     callback_->on_message_ack(message_id);
   }
@@ -412,7 +412,7 @@ Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::gzip
 }
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::pong &pong) {
-  VLOG(mtproto) << "Receive pong " << info;
+  VLOG_DEFERRED(mtproto) << "Receive pong " << info;
   if (info.message_id.get() < static_cast<uint64>(pong.msg_id_) - (static_cast<uint64>(15) << 32)) {
     reset_server_time_difference(info.message_id);
   }
@@ -440,7 +440,7 @@ Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::futu
   }
   auto now = Time::now_cached();
   auth_data_->set_future_salts(new_salts, now);
-  VLOG(mtproto) << "Receive future_salts " << info << ": is_valid = " << auth_data_->is_server_salt_valid(now)
+  VLOG_DEFERRED(mtproto) << "Receive future_salts " << info << ": is_valid = " << auth_data_->is_server_salt_valid(now)
                 << ", has_salt = " << auth_data_->has_salt(now)
                 << ", need_future_salts = " << auth_data_->need_future_salts(now);
   callback_->on_server_salt_updated();
@@ -472,17 +472,17 @@ Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::msgs
   if (query.type_ != ServiceQuery::GetStateInfo) {
     return Status::Error("Receive msgs_state_info in response not to GetStateInfo");
   }
-  VLOG(mtproto) << "Receive msgs_state_info " << info;
+  VLOG_DEFERRED(mtproto) << "Receive msgs_state_info " << info;
   return on_msgs_state_info(query.msg_ids_, msgs_state_info.info_);
 }
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::msgs_all_info &msgs_all_info) {
-  VLOG(mtproto) << "Receive msgs_all_info " << info;
+  VLOG_DEFERRED(mtproto) << "Receive msgs_all_info " << info;
   return on_msgs_state_info(msgs_all_info.msg_ids_, msgs_all_info.info_);
 }
 
 Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::msg_detailed_info &msg_detailed_info) {
-  VLOG(mtproto) << "Receive msg_detailed_info " << info;
+  VLOG_DEFERRED(mtproto) << "Receive msg_detailed_info " << info;
   callback_->on_message_info(MessageId(static_cast<uint64>(msg_detailed_info.msg_id_)), msg_detailed_info.status_,
                              MessageId(static_cast<uint64>(msg_detailed_info.answer_msg_id_)), msg_detailed_info.bytes_,
                              2);
@@ -491,7 +491,7 @@ Status SessionConnection::on_packet(const MsgInfo &info, const mtproto_api::msg_
 
 Status SessionConnection::on_packet(const MsgInfo &info,
                                     const mtproto_api::msg_new_detailed_info &msg_new_detailed_info) {
-  VLOG(mtproto) << "Receive msg_new_detailed_info " << info;
+  VLOG_DEFERRED(mtproto) << "Receive msg_new_detailed_info " << info;
   callback_->on_message_info(MessageId(), 0, MessageId(static_cast<uint64>(msg_new_detailed_info.answer_msg_id_)),
                              msg_new_detailed_info.bytes_, 0);
   return Status::OK();
@@ -551,10 +551,10 @@ Status SessionConnection::on_slice_packet(const MsgInfo &info, Slice packet) {
       callback_->on_session_failed(Status::Error("Receive too old update"));
       return status;
     }
-    VLOG(mtproto) << "Skip " << get_update_description() << ": " << status;
+    VLOG_DEFERRED(mtproto) << "Skip " << get_update_description() << ": " << status;
     return Status::OK();
   } else {
-    VLOG(mtproto) << "Receive " << get_update_description();
+    VLOG_DEFERRED(mtproto) << "Receive " << get_update_description();
     return callback_->on_update(as_buffer_slice(packet));
   }
 }
@@ -577,7 +577,7 @@ Status SessionConnection::on_main_packet(const PacketInfo &packet_info, Slice pa
   }
 
   VLOG(raw_mtproto) << "Receive packet of size " << packet.size() << ':' << format::as_hex_dump<4>(packet);
-  VLOG(mtproto) << "Receive packet with " << packet_info.message_id << " and seq_no " << packet_info.seq_no
+  VLOG_DEFERRED(mtproto) << "Receive packet with " << packet_info.message_id << " and seq_no " << packet_info.seq_no
                 << " of size " << packet.size();
 
   if (packet_info.no_crypto_flag) {
@@ -821,7 +821,7 @@ Result<MessageId> SessionConnection::send_query(BufferSlice buffer, bool gzip_fl
   }
   to_send_.push_back(MtprotoQuery{message_id, seq_no, std::move(buffer), gzip_flag, std::move(invoke_after_message_ids),
                                   use_quick_ack});
-  VLOG(mtproto) << "Invoke query with " << message_id << " and seq_no " << seq_no << " of size "
+  VLOG_DEFERRED(mtproto) << "Invoke query with " << message_id << " and seq_no " << seq_no << " of size "
                 << to_send_.back().packet.size() << " after " << invoke_after_message_ids
                 << (use_quick_ack ? " with quick ack" : "");
 
@@ -885,7 +885,7 @@ void SessionConnection::force_ack() {
 }
 
 void SessionConnection::send_ack(MessageId message_id) {
-  VLOG(mtproto) << "Send ack for " << message_id;
+  VLOG_DEFERRED(mtproto) << "Send ack for " << message_id;
   if (to_ack_message_ids_.empty()) {
     send_before(Time::now_cached() + ACK_DELAY);
   }
@@ -978,7 +978,7 @@ void SessionConnection::flush_packet() {
     destroy_auth_key_send_time_ = Time::now();
   }
 
-  VLOG(mtproto) << "Sent packet: " << tag("query_count", queries.size()) << tag("ack_count", to_ack_message_ids_.size())
+  VLOG_DEFERRED(mtproto) << "Sent packet: " << tag("query_count", queries.size()) << tag("ack_count", to_ack_message_ids_.size())
                 << tag("ping", ping_id != 0) << tag("http_wait", max_delay >= 0)
                 << tag("future_salt", future_salt_n > 0) << tag("get_info", to_get_state_info_message_ids_.size())
                 << tag("resend", to_resend_answer_message_ids_.size())
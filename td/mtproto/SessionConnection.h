@@ -104,6 +104,8 @@ class SessionConnection final
 
     virtual void on_message_ack(MessageId message_id) = 0;
     virtual Status on_message_result_ok(MessageId message_id, BufferSlice packet, size_t original_size) = 0;
+    // packed_data must be decompressed with gzdecode to get the result
+    virtual Status on_message_result_gzip(MessageId message_id, BufferSlice packed_data, size_t original_size) = 0;
     virtual void on_message_result_error(MessageId message_id, int code, string message) = 0;
     virtual void on_message_failed(MessageId message_id, Status status) = 0;
     virtual void on_message_info(MessageId message_id, int32 state, MessageId answer_message_id, int32 answer_size,
@@ -22,6 +22,7 @@
 #include "td/telegram/InputGroupCallId.h"
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/logevent/LogEventHelper.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessageSender.h"
 #include "td/telegram/MessagesManager.h"
 #include "td/telegram/MessageTtl.h"
@@ -1600,6 +1601,10 @@ ChatManager::ChatManager(Td *td, ActorShared<> parent) : td_(td), parent_(std::m
   slow_mode_delay_timeout_.set_callback(on_slow_mode_delay_timeout_callback);
   slow_mode_delay_timeout_.set_callback_data(static_cast<void *>(this));
 
+  save_chat_merger_.set_save_function([this](vector<int64> chat_ids) { save_chats(std::move(chat_ids)); });
+  save_channel_merger_.set_save_function(
+      [this](vector<int64> channel_ids) { save_channels(std::move(channel_ids)); });
+
   get_chat_queries_.set_merge_function([this](vector<int64> query_ids, Promise<Unit> &&promise) {
     TRY_STATUS_PROMISE(promise, G()->close_status());
     td_->create_handler<GetChatsQuery>(std::move(promise))->send(std::move(query_ids));
@@ -4015,6 +4020,10 @@ void ChatManager::save_chat(Chat *c, ChatId chat_id, bool from_binlog) {
       } else {
         binlog_rewrite(G()->td_db()->get_binlog(), c->log_event_id, LogEvent::HandlerType::Chats, storer);
       }
+
+      // the chat is already saved to the binlog, so saves of the same chat to the database can be merged
+      save_chat_merger_.add_object(chat_id.get());
+      return;
     }
 
     save_chat_to_database(c, chat_id);
@@ -4022,6 +4031,19 @@ void ChatManager::save_chat(Chat *c, ChatId chat_id, bool from_binlog) {
   }
 }
 
+void ChatManager::save_chats(vector<int64> chat_ids) {
+  for (auto chat_id_int : chat_ids) {
+    ChatId chat_id(chat_id_int);
+    Chat *c = get_chat(chat_id);
+    CHECK(c != nullptr);
+    if (c->is_saved) {
+      continue;
+    }
+
+    save_chat_to_database(c, chat_id);
+  }
+}
+
 void ChatManager::on_binlog_chat_event(BinlogEvent &&event) {
   if (!G()->use_chat_info_database()) {
     binlog_erase(G()->td_db()->get_binlog(), event.id_);
@@ -4131,10 +4153,36 @@ void ChatManager::load_chat_from_database_impl(ChatId chat_id, Promise<Unit> pro
   auto &load_chat_queries = load_chat_from_database_queries_[chat_id];
   load_chat_queries.push_back(std::move(promise));
   if (load_chat_queries.size() == 1u) {
-    G()->td_db()->get_sqlite_pmc()->get(get_chat_database_key(chat_id), PromiseCreator::lambda([chat_id](string value) {
-                                          send_closure(G()->chat_manager(), &ChatManager::on_load_chat_from_database,
-                                                       chat_id, std::move(value), false);
-                                        }));
+    if (load_chat_from_database_chat_ids_.empty()) {
+      // all chats requested before the closure is processed will be loaded using a single database request
+      send_closure_later(actor_id(this), &ChatManager::load_chats_from_database);
+    }
+    load_chat_from_database_chat_ids_.push_back(chat_id);
+  }
+}
+
+void ChatManager::load_chats_from_database() {
+  auto chat_ids = std::move(load_chat_from_database_chat_ids_);
+  load_chat_from_database_chat_ids_.clear();
+  if (chat_ids.empty()) {
+    return;
+  }
+  LOG(INFO) << "Load " << chat_ids.size() << " basic groups from database";
+  auto keys = transform(chat_ids, get_chat_database_key);
+  G()->td_db()->get_sqlite_pmc()->get_batch(
+      std::move(keys), PromiseCreator::lambda([chat_ids = std::move(chat_ids)](vector<string> values) mutable {
+        send_closure(G()->chat_manager(), &ChatManager::on_load_chats_from_database, std::move(chat_ids),
+                     std::move(values));
+      }));
+}
+
+void ChatManager::on_load_chats_from_database(vector<ChatId> chat_ids, vector<string> values) {
+  if (G()->close_flag()) {
+    return;
+  }
+  CHECK(chat_ids.size() == values.size());
+  for (size_t i = 0; i < chat_ids.size(); i++) {
+    on_load_chat_from_database(chat_ids[i], std::move(values[i]), false);
   }
 }
 
@@ -4261,6 +4309,9 @@ void ChatManager::save_channel(Channel *c, ChannelId channel_id, bool from_binlo
       } else {
         binlog_rewrite(G()->td_db()->get_binlog(), c->log_event_id, LogEvent::HandlerType::Channels, storer);
       }
+
+      save_channel_merger_.add_object(channel_id.get());
+      return;
     }
 
     save_channel_to_database(c, channel_id);
@@ -4268,6 +4319,19 @@ void ChatManager::save_channel(Channel *c, ChannelId channel_id, bool from_binlo
   }
 }
 
+void ChatManager::save_channels(vector<int64> channel_ids) {
+  for (auto channel_id_int : channel_ids) {
+    ChannelId channel_id(channel_id_int);
+    Channel *c = get_channel(channel_id);
+    CHECK(c != nullptr);
+    if (c->is_saved) {
+      continue;
+    }
+
+    save_channel_to_database(c, channel_id);
+  }
+}
+
 void ChatManager::on_binlog_channel_event(BinlogEvent &&event) {
   if (!G()->use_chat_info_database()) {
     binlog_erase(G()->td_db()->get_binlog(), event.id_);
@@ -4377,11 +4441,36 @@ void ChatManager::load_channel_from_database_impl(ChannelId channel_id, Promise<
   auto &load_channel_queries = load_channel_from_database_queries_[channel_id];
   load_channel_queries.push_back(std::move(promise));
   if (load_channel_queries.size() == 1u) {
-    G()->td_db()->get_sqlite_pmc()->get(get_channel_database_key(channel_id),
-                                        PromiseCreator::lambda([channel_id](string value) {
-                                          send_closure(G()->chat_manager(), &ChatManager::on_load_channel_from_database,
-                                                       channel_id, std::move(value), false);
-                                        }));
+    if (load_channel_from_database_channel_ids_.empty()) {
+      // all channels requested before the closure is processed will be loaded using a single database request
+      send_closure_later(actor_id(this), &ChatManager::load_channels_from_database);
+    }
+    load_channel_from_database_channel_ids_.push_back(channel_id);
+  }
+}
+
+void ChatManager::load_channels_from_database() {
+  auto channel_ids = std::move(load_channel_from_database_channel_ids_);
+  load_channel_from_database_channel_ids_.clear();
+  if (channel_ids.empty()) {
+    return;
+  }
+  LOG(INFO) << "Load " << channel_ids.size() << " supergroups from database";
+  auto keys = transform(channel_ids, get_channel_database_key);
+  G()->td_db()->get_sqlite_pmc()->get_batch(
+      std::move(keys), PromiseCreator::lambda([channel_ids = std::move(channel_ids)](vector<string> values) mutable {
+        send_closure(G()->chat_manager(), &ChatManager::on_load_channels_from_database, std::move(channel_ids),
+                     std::move(values));
+      }));
+}
+
+void ChatManager::on_load_channels_from_database(vector<ChannelId> channel_ids, vector<string> values) {
+  if (G()->close_flag()) {
+    return;
+  }
+  CHECK(channel_ids.size() == values.size());
+  for (size_t i = 0; i < channel_ids.size(); i++) {
+    on_load_channel_from_database(channel_ids[i], std::move(values[i]), false);
   }
 }
 
@@ -8933,4 +9022,12 @@ void ChatManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &
   });
 }
 
+void ChatManager::get_memory_statistics(MemoryStatistics &statistics) const {
+  statistics.add("ChatManager", "chats", chats_);
+  statistics.add("ChatManager", "chats_full", chats_full_);
+  statistics.add("ChatManager", "min_channels", min_channels_);
+  statistics.add("ChatManager", "channels", channels_);
+  statistics.add("ChatManager", "channels_full", channels_full_);
+}
+
 }  // namespace td
@@ -29,6 +29,7 @@
 #include "td/telegram/QueryCombiner.h"
 #include "td/telegram/QueryMerger.h"
 #include "td/telegram/RestrictionReason.h"
+#include "td/telegram/SaveMerger.h"
 #include "td/telegram/StickerSetId.h"
 #include "td/telegram/StoryId.h"
 #include "td/telegram/td_api.h"
@@ -54,6 +55,7 @@
 namespace td {
 
 struct BinlogEvent;
+class MemoryStatistics;
 struct MinChannel;
 class Td;
 
@@ -383,6 +385,8 @@ class ChatManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void get_memory_statistics(MemoryStatistics &statistics) const;
+
  private:
   struct Chat {
     string title;
@@ -619,6 +623,8 @@ class ChatManager final : public Actor {
 
   static constexpr int32 MAX_ACTIVE_STORY_ID_RELOAD_TIME = 3600;  // some reasonable limit
 
+  static constexpr double MAX_SAVE_CHAT_DELAY = 1.0;  // seconds
+
   static constexpr int32 CHAT_FLAG_USER_IS_CREATOR = 1 << 0;
   static constexpr int32 CHAT_FLAG_USER_HAS_LEFT = 1 << 2;
   // static constexpr int32 CHAT_FLAG_ADMINISTRATORS_ENABLED = 1 << 3;
@@ -787,6 +793,7 @@ class ChatManager final : public Actor {
   void on_get_channel_forbidden(telegram_api::channelForbidden &channel, const char *source);
 
   void save_chat(Chat *c, ChatId chat_id, bool from_binlog);
+  void save_chats(vector<int64> chat_ids);
   static string get_chat_database_key(ChatId chat_id);
   static string get_chat_database_value(const Chat *c);
   void save_chat_to_database(Chat *c, ChatId chat_id);
@@ -794,9 +801,12 @@ class ChatManager final : public Actor {
   void on_save_chat_to_database(ChatId chat_id, bool success);
   void load_chat_from_database(Chat *c, ChatId chat_id, Promise<Unit> promise);
   void load_chat_from_database_impl(ChatId chat_id, Promise<Unit> promise);
+  void load_chats_from_database();
+  void on_load_chats_from_database(vector<ChatId> chat_ids, vector<string> values);
   void on_load_chat_from_database(ChatId chat_id, string value, bool force);
 
   void save_channel(Channel *c, ChannelId channel_id, bool from_binlog);
+  void save_channels(vector<int64> channel_ids);
   static string get_channel_database_key(ChannelId channel_id);
   static string get_channel_database_value(const Channel *c);
   void save_channel_to_database(Channel *c, ChannelId channel_id);
@@ -804,6 +814,8 @@ class ChatManager final : public Actor {
   void on_save_channel_to_database(ChannelId channel_id, bool success);
   void load_channel_from_database(Channel *c, ChannelId channel_id, Promise<Unit> promise);
   void load_channel_from_database_impl(ChannelId channel_id, Promise<Unit> promise);
+  void load_channels_from_database();
+  void on_load_channels_from_database(vector<ChannelId> channel_ids, vector<string> values);
   void on_load_channel_from_database(ChannelId channel_id, string value, bool force);
 
   static void save_chat_full(const ChatFull *chat_full, ChatId chat_id);
@@ -925,16 +937,21 @@ class ChatManager final : public Actor {
   vector<ChannelId> inactive_channel_ids_;
 
   FlatHashMap<ChatId, vector<Promise<Unit>>, ChatIdHash> load_chat_from_database_queries_;
+  vector<ChatId> load_chat_from_database_chat_ids_;
   FlatHashSet<ChatId, ChatIdHash> loaded_from_database_chats_;
   FlatHashSet<ChatId, ChatIdHash> unavailable_chat_fulls_;
 
   FlatHashMap<ChannelId, vector<Promise<Unit>>, ChannelIdHash> load_channel_from_database_queries_;
+  vector<ChannelId> load_channel_from_database_channel_ids_;
   FlatHashSet<ChannelId, ChannelIdHash> loaded_from_database_channels_;
   FlatHashSet<ChannelId, ChannelIdHash> unavailable_channel_fulls_;
 
   QueryMerger get_chat_queries_{"GetChatMerger", 3, 50};
   QueryMerger get_channel_queries_{"GetChannelMerger", 100, 1};  // can't merge getChannel queries without access hash
 
+  SaveMerger save_chat_merger_{"SaveChatMerger", MAX_SAVE_CHAT_DELAY};
+  SaveMerger save_channel_merger_{"SaveChannelMerger", MAX_SAVE_CHAT_DELAY};
+
   QueryCombiner get_chat_full_queries_{"GetChatFullCombiner", 2.0};
 
   FlatHashMap<ChannelId, FlatHashSet<MessageFullId, MessageFullIdHash>, ChannelIdHash> channel_messages_;
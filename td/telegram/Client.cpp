@@ -6,6 +6,7 @@
 //
 #include "td/telegram/Client.h"
 
+#include "td/telegram/net/QueryResultDecoder.h"
 #include "td/telegram/Td.h"
 #include "td/telegram/TdCallback.h"
 
@@ -37,6 +38,8 @@
 
 namespace td {
 
+static std::atomic<int32> max_client_thread_count{0};
+
 #if TD_THREAD_UNSUPPORTED || TD_EVENTFD_UNSUPPORTED
 class TdReceiver {
  public:
@@ -433,12 +436,17 @@ class MultiImplPool {
     if (impls_.empty()) {
       init_openssl_threads();
 
-      auto max_client_threads = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
+      auto max_client_threads = static_cast<uint32>(max_client_thread_count.load(std::memory_order_relaxed));
+      if (max_client_threads == 0) {
+        max_client_threads = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
+      }
 #if TD_OPENBSD
       max_client_threads = td::min(max_client_threads, 4u);
 #endif
       impls_.resize(max_client_threads);
-      CHECK(impls_.size() * (1 + MultiImpl::ADDITIONAL_THREAD_COUNT + 1 /* IOCP */) < 128);
+      CHECK(impls_.size() * (1 + MultiImpl::ADDITIONAL_THREAD_COUNT + 1 /* IOCP */) +
+                QueryResultDecoder::MAX_THREAD_COUNT <
+            128);
 
       net_query_stats_ = std::make_shared<NetQueryStats>();
     }
@@ -713,6 +721,10 @@ void ClientManager::set_log_message_callback(int max_verbosity_level, LogMessage
   }
 }
 
+void ClientManager::set_max_thread_count(int max_thread_count) {
+  max_client_thread_count = clamp(max_thread_count, 0, 25);
+}
+
 ClientManager::ClientManager(ClientManager &&) noexcept = default;
 ClientManager &ClientManager::operator=(ClientManager &&) noexcept = default;
 ClientManager::~ClientManager() = default;
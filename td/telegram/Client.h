@@ -144,6 +144,18 @@ class ClientManager final {
    */
   static void set_log_message_callback(int max_verbosity_level, LogMessageCallbackPtr callback);
 
+  /**
+   * Sets the maximum number of threads, which will be used to run TDLib client instances. TDLib instances running
+   * in the same thread also share 3 auxiliary threads for database access, garbage collection and slow network
+   * requests, so the total number of threads is about 4 times bigger. Allows to bound the number of threads
+   * if a lot of mostly idle TDLib instances are created. Memory used by each TDLib instance isn't reduced.
+   * By default, the number of threads depends on the number of CPU cores and is between 10 and 25.
+   * Must be called before the first TDLib instance is created; otherwise, the new value will be used only after all
+   * existing TDLib instances are closed.
+   * \param[in] max_thread_count The maximum number of threads from 1 up to 25; pass 0 to use the default value.
+   */
+  static void set_max_thread_count(int max_thread_count);
+
   /**
    * Destroys the client manager and all TDLib client instances managed by it.
    */
@@ -55,9 +55,8 @@ static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice
 
 static string from_response(const td_api::Object &object, const string &extra, int client_id) {
   auto buf = StackAllocator::alloc(1 << 18);
-  JsonBuilder jb(StringBuilder(buf.as_slice(), true), -1);
-  jb.enter_value() << ToJson(object);
-  auto &sb = jb.string_builder();
+  StringBuilder sb(buf.as_slice(), true);
+  td_api::to_compact_json(sb, object);
   auto slice = sb.as_cslice();
   CHECK(!slice.empty() && slice.back() == '}');
   sb.pop_back();
@@ -15,7 +15,9 @@
 #include "td/actor/actor.h"
 #include "td/actor/SchedulerLocalStorage.h"
 
+#include "td/utils/algorithm.h"
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
@@ -377,10 +379,35 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
 
     void add_dialog(DialogId dialog_id, FolderId folder_id, int64 order, BufferSlice data,
                     vector<NotificationGroupKey> notification_groups, Promise<Unit> promise) {
-      add_write_query([this, dialog_id, folder_id, order, promise = std::move(promise), data = std::move(data),
-                       notification_groups = std::move(notification_groups)](Unit) mutable {
-        sync_db_->add_dialog(dialog_id, folder_id, order, std::move(data), std::move(notification_groups));
-        on_write_result(std::move(promise));
+      auto it = pending_dialogs_.find(dialog_id);
+      if (it != pending_dialogs_.end()) {
+        // the chat wasn't written yet; write only its last state, but keep all changes of notification groups
+        auto &pending_dialog = it->second;
+        pending_dialog.folder_id_ = folder_id;
+        pending_dialog.order_ = order;
+        pending_dialog.data_ = std::move(data);
+        append(pending_dialog.notification_groups_, std::move(notification_groups));
+        pending_dialog.promises_.push_back(std::move(promise));
+        return;
+      }
+
+      auto &pending_dialog = pending_dialogs_[dialog_id];
+      pending_dialog.folder_id_ = folder_id;
+      pending_dialog.order_ = order;
+      pending_dialog.data_ = std::move(data);
+      pending_dialog.notification_groups_ = std::move(notification_groups);
+      pending_dialog.promises_.push_back(std::move(promise));
+      add_write_query([this, dialog_id](Unit) {
+        auto it = pending_dialogs_.find(dialog_id);
+        CHECK(it != pending_dialogs_.end());
+        auto pending_dialog = std::move(it->second);
+        pending_dialogs_.erase(it);
+
+        sync_db_->add_dialog(dialog_id, pending_dialog.folder_id_, pending_dialog.order_,
+                             std::move(pending_dialog.data_), std::move(pending_dialog.notification_groups_));
+        for (auto &promise : pending_dialog.promises_) {
+          on_write_result(std::move(promise));
+        }
       });
     }
 
@@ -436,6 +463,16 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
     static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
     static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
 
+    struct PendingDialog {
+      FolderId folder_id_;
+      int64 order_ = 0;
+      BufferSlice data_;
+      vector<NotificationGroupKey> notification_groups_;
+      vector<Promise<Unit>> promises_;
+    };
+    // must be destroyed after pending_writes_, which write the chats
+    FlatHashMap<DialogId, PendingDialog, DialogIdHash> pending_dialogs_;
+
     //NB: order is important, destructor of pending_writes_ will change finished_writes_
     vector<Promise<Unit>> finished_writes_;
     vector<Promise<Unit>> pending_writes_;  // TODO use Action
@@ -0,0 +1,126 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/EmojiKeywordIndex.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <algorithm>
+
+namespace td {
+
+EmojiKeywordIndex::EmojiKeywordIndex(int32 version, vector<std::pair<string, string>> &&keyword_emojis)
+    : version_(version) {
+  std::sort(keyword_emojis.begin(), keyword_emojis.end(),
+            [](const std::pair<string, string> &lhs, const std::pair<string, string> &rhs) {
+              return lhs.first < rhs.first;
+            });
+  keywords_.reserve(keyword_emojis.size());
+  for (auto &keyword_emoji : keyword_emojis) {
+    if (keyword_emoji.second.empty()) {
+      continue;
+    }
+    if (!keywords_.empty() && keywords_.back().keyword_ == keyword_emoji.first) {
+      keywords_.back().emojis_ = std::move(keyword_emoji.second);
+      continue;
+    }
+    keywords_.push_back({std::move(keyword_emoji.first), std::move(keyword_emoji.second)});
+  }
+}
+
+vector<EmojiKeywordIndex::Keyword>::const_iterator EmojiKeywordIndex::lower_bound(Slice keyword) const {
+  return std::lower_bound(keywords_.begin(), keywords_.end(), keyword,
+                          [](const Keyword &lhs, Slice rhs) { return Slice(lhs.keyword_) < rhs; });
+}
+
+size_t EmojiKeywordIndex::get_memory_size() const {
+  size_t result = keywords_.capacity() * sizeof(Keyword);
+  for (auto &keyword : keywords_) {
+    result += keyword.keyword_.capacity() + keyword.emojis_.capacity();
+  }
+  return result;
+}
+
+vector<string> EmojiKeywordIndex::get_keyword_emojis(Slice keyword) const {
+  auto it = lower_bound(keyword);
+  if (it == keywords_.end() || it->keyword_ != keyword) {
+    return {};
+  }
+  return full_split(it->emojis_, '$');
+}
+
+void EmojiKeywordIndex::set_keyword_emojis(string keyword, const vector<string> &emojis) {
+  auto it = keywords_.begin() + (lower_bound(keyword) - keywords_.begin());
+  bool is_found = it != keywords_.end() && it->keyword_ == keyword;
+  if (emojis.empty()) {
+    if (is_found) {
+      keywords_.erase(it);
+    }
+    return;
+  }
+  if (is_found) {
+    it->emojis_ = implode(emojis, '$');
+  } else {
+    keywords_.insert(it, {std::move(keyword), implode(emojis, '$')});
+  }
+}
+
+vector<std::pair<string, string>> EmojiKeywordIndex::search(Slice prefix) const {
+  vector<std::pair<string, string>> result;
+  for (auto it = lower_bound(prefix); it != keywords_.end() && begins_with(it->keyword_, prefix); ++it) {
+    for (auto emoji : full_split(Slice(it->emojis_), '$')) {
+      result.emplace_back(emoji.str(), it->keyword_);
+    }
+  }
+  return result;
+}
+
+std::mutex EmojiKeywordIndex::shared_indexes_mutex_;
+FlatHashMap<string, std::weak_ptr<const EmojiKeywordIndex>> EmojiKeywordIndex::shared_indexes_;
+
+std::shared_ptr<const EmojiKeywordIndex> EmojiKeywordIndex::get_shared(Slice language_code, int32 version) {
+  std::lock_guard<std::mutex> lock(shared_indexes_mutex_);
+  auto it = shared_indexes_.find(PSTRING() << language_code << '$' << version);
+  if (it == shared_indexes_.end()) {
+    return nullptr;
+  }
+  return it->second.lock();
+}
+
+std::shared_ptr<const EmojiKeywordIndex> EmojiKeywordIndex::add_shared(Slice language_code,
+                                                                       EmojiKeywordIndex &&index) {
+  CHECK(index.get_version() != 0);
+  std::lock_guard<std::mutex> lock(shared_indexes_mutex_);
+  table_remove_if(shared_indexes_, [](const auto &it) { return it.second.expired(); });
+  auto &shared_index = shared_indexes_[PSTRING() << language_code << '$' << index.get_version()];
+  auto result = shared_index.lock();
+  if (result == nullptr) {
+    result = std::make_shared<EmojiKeywordIndex>(std::move(index));
+    shared_index = result;
+  }
+  return result;
+}
+
+std::shared_ptr<const EmojiKeywordIndex> EmojiKeywordIndex::add_shared_changes(
+    Slice language_code, const EmojiKeywordIndex &old_index, int32 version,
+    const FlatHashMap<string, vector<string>> &changed_keywords) {
+  auto index = get_shared(language_code, version);
+  if (index != nullptr) {
+    return index;
+  }
+
+  EmojiKeywordIndex new_index = old_index;
+  for (auto &it : changed_keywords) {
+    new_index.set_keyword_emojis(it.first, it.second);
+  }
+  new_index.set_version(version);
+  return add_shared(language_code, std::move(new_index));
+}
+
+}  // namespace td
@@ -0,0 +1,87 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Slice.h"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace td {
+
+// in-memory index of emoji keywords of one language, which allows to search keywords by prefix
+class EmojiKeywordIndex {
+  struct Keyword {
+    string keyword_;
+    string emojis_;  // joined with '$'
+
+    template <class StorerT>
+    void store(StorerT &storer) const;
+
+    template <class ParserT>
+    void parse(ParserT &parser);
+  };
+
+  int32 version_ = 0;
+  vector<Keyword> keywords_;  // sorted by keyword_
+
+  vector<Keyword>::const_iterator lower_bound(Slice keyword) const;
+
+  static std::mutex shared_indexes_mutex_;
+  static FlatHashMap<string, std::weak_ptr<const EmojiKeywordIndex>> shared_indexes_;
+
+ public:
+  EmojiKeywordIndex() = default;
+
+  // keyword_emojis must contain pairs (keyword, emojis joined with '$')
+  EmojiKeywordIndex(int32 version, vector<std::pair<string, string>> &&keyword_emojis);
+
+  int32 get_version() const {
+    return version_;
+  }
+
+  void set_version(int32 version) {
+    version_ = version;
+  }
+
+  size_t size() const {
+    return keywords_.size();
+  }
+
+  size_t get_memory_size() const;
+
+  vector<string> get_keyword_emojis(Slice keyword) const;
+
+  // empty emojis remove the keyword
+  void set_keyword_emojis(string keyword, const vector<string> &emojis);
+
+  // returns pairs (emoji, keyword) for all keywords starting with the prefix
+  vector<std::pair<string, string>> search(Slice prefix) const;
+
+  template <class StorerT>
+  void store(StorerT &storer) const;
+
+  template <class ParserT>
+  void parse(ParserT &parser);
+
+  // emoji keywords don't depend on the account, so indexes of the same language and version are shared between
+  // Td instances; a shared index is never changed and is destroyed after the last instance stops using it
+  static std::shared_ptr<const EmojiKeywordIndex> get_shared(Slice language_code, int32 version);
+
+  static std::shared_ptr<const EmojiKeywordIndex> add_shared(Slice language_code, EmojiKeywordIndex &&index);
+
+  // returns the shared index of the new version; the changes are applied to a copy of the old index,
+  // unless another instance has already done this
+  static std::shared_ptr<const EmojiKeywordIndex> add_shared_changes(
+      Slice language_code, const EmojiKeywordIndex &old_index, int32 version,
+      const FlatHashMap<string, vector<string>> &changed_keywords);
+};
+
+}  // namespace td
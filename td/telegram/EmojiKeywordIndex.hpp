@@ -0,0 +1,44 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/EmojiKeywordIndex.h"
+
+#include "td/utils/tl_helpers.h"
+
+namespace td {
+
+template <class StorerT>
+void EmojiKeywordIndex::Keyword::store(StorerT &storer) const {
+  td::store(keyword_, storer);
+  td::store(emojis_, storer);
+}
+
+template <class ParserT>
+void EmojiKeywordIndex::Keyword::parse(ParserT &parser) {
+  td::parse(keyword_, parser);
+  td::parse(emojis_, parser);
+}
+
+template <class StorerT>
+void EmojiKeywordIndex::store(StorerT &storer) const {
+  td::store(version_, storer);
+  td::store(keywords_, storer);
+}
+
+template <class ParserT>
+void EmojiKeywordIndex::parse(ParserT &parser) {
+  td::parse(version_, parser);
+  td::parse(keywords_, parser);
+  for (size_t i = 1; i < keywords_.size(); i++) {
+    if (!(keywords_[i - 1].keyword_ < keywords_[i].keyword_)) {
+      return parser.set_error("Emoji keywords aren't sorted");
+    }
+  }
+}
+
+}  // namespace td
@@ -7,6 +7,7 @@
 #include "td/telegram/LanguagePackManager.h"
 
 #include "td/telegram/Global.h"
+#include "td/telegram/LanguagePackStringTable.h"
 #include "td/telegram/misc.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/Td.h"
@@ -18,9 +19,11 @@
 
 #include "td/utils/algorithm.h"
 #include "td/utils/ExitGuard.h"
+#include "td/utils/filesystem.h"
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/path.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 
@@ -62,7 +65,12 @@ struct LanguagePackManager::Language {
   FlatHashMap<string, string> ordinary_strings_;
   FlatHashMap<string, unique_ptr<PluralizedString>> pluralized_strings_;
   FlatHashSet<string> deleted_strings_;
-  SqliteKeyValue kv_;  // usages must be guarded by database_->mutex_
+  // immutable strings of the current version, which are shared between Td instances;
+  // the strings above override them with the changes received after the table was loaded
+  std::shared_ptr<const LanguagePackStringTable> string_table_;
+  string string_table_name_;  // language_pack$language_code; empty if the string table must not be used
+  string string_table_path_;  // path prefix of files with the string table
+  SqliteKeyValue kv_;         // usages must be guarded by database_->mutex_
 };
 
 struct LanguagePackManager::LanguageInfo {
@@ -664,6 +672,10 @@ LanguagePackManager::Language *LanguagePackManager::add_language(LanguageDatabas
       language->version_ = load_database_language_version(&language->kv_);
       language->key_count_ = load_database_language_key_count(&language->kv_);
       language->base_language_code_ = load_database_language_base_language_code(&language->kv_);
+      if (!is_custom_language_code(language_code)) {
+        language->string_table_name_ = PSTRING() << language_pack << '$' << language_code;
+        language->string_table_path_ = PSTRING() << database->path_ << '.' << language_pack << '.' << language_code;
+      }
       LOG(INFO) << "Loaded language " << language_code << " with version " << language->version_.load()
                 << ", key count " << language->key_count_.load() << " and base language "
                 << language->base_language_code_;
@@ -675,7 +687,19 @@ LanguagePackManager::Language *LanguagePackManager::add_language(LanguageDatabas
 
 bool LanguagePackManager::language_has_string_unsafe(const Language *language, const string &key) {
   return language->ordinary_strings_.count(key) != 0 || language->pluralized_strings_.count(key) != 0 ||
-         language->deleted_strings_.count(key) != 0;
+         language->deleted_strings_.count(key) != 0 ||
+         (language->string_table_ != nullptr && !language->string_table_->get(key).empty());
+}
+
+bool LanguagePackManager::language_has_value_unsafe(const Language *language, const string &key) {
+  if (language->ordinary_strings_.count(key) != 0 || language->pluralized_strings_.count(key) != 0) {
+    return true;
+  }
+  if (language->string_table_ == nullptr || language->deleted_strings_.count(key) != 0) {
+    return false;
+  }
+  auto value = language->string_table_->get(key);
+  return !value.empty() && (value[0] == '1' || value[0] == '2');
 }
 
 bool LanguagePackManager::language_has_strings(Language *language, const vector<string> &keys) {
@@ -737,6 +761,12 @@ bool LanguagePackManager::load_language_strings(LanguageDatabase *database, Lang
     LOG(DEBUG) << "The language pack has no database";
     return false;
   }
+  if (language->version_ != -1 && !language->string_table_name_.empty()) {
+    // the database contains the full language pack, so use the string table instead of loading the strings
+    load_language_string_table(language);
+    language->is_full_ = true;
+    return true;
+  }
   LOG(DEBUG) << "Begin to load a language pack from database";
   if (keys.empty()) {
     if (language->version_ == -1 && language->was_loaded_full_) {
@@ -786,6 +816,55 @@ bool LanguagePackManager::load_language_strings(LanguageDatabase *database, Lang
   return have_all;
 }
 
+string LanguagePackManager::get_language_string_table_path(const Language *language, int32 version) {
+  return PSTRING() << language->string_table_path_ << '.' << version;
+}
+
+void LanguagePackManager::load_language_string_table(Language *language) {
+  // mutexes are locked by the caller
+  if (language->string_table_ != nullptr) {
+    return;
+  }
+
+  auto version = language->version_.load();
+  CHECK(version != -1);
+  std::lock_guard<std::mutex> lock(string_table_mutex_);
+  auto &shared_string_table = string_tables_[PSTRING() << language->string_table_name_ << '$' << version];
+  language->string_table_ = shared_string_table.lock();
+  if (language->string_table_ != nullptr) {
+    LOG(INFO) << "Reuse string table of language pack " << language->string_table_name_ << " of version " << version;
+    return;
+  }
+
+  auto path = get_language_string_table_path(language, version);
+  auto r_string_table = LanguagePackStringTable::load(path);
+  if (r_string_table.is_error()) {
+    LOG(INFO) << "Create string table " << path << ", because failed to load it: " << r_string_table.error();
+    vector<std::pair<string, string>> strings;
+    language->kv_.get_by_prefix("", [&strings](Slice key, Slice value) {
+      if (key[0] != '!') {
+        strings.emplace_back(key.str(), value.str());
+      }
+      return true;
+    });
+    auto data = LanguagePackStringTable::serialize(std::move(strings));
+    auto status = atomic_write_file(path, data.as_slice());
+    if (status.is_ok()) {
+      r_string_table = LanguagePackStringTable::load(path);
+    } else {
+      r_string_table = status.move_as_error();
+    }
+    if (r_string_table.is_error()) {
+      LOG(ERROR) << "Failed to save string table to " << path << ": " << r_string_table.error();
+      r_string_table = LanguagePackStringTable::create(std::move(data));
+    }
+  }
+  language->string_table_ = r_string_table.move_as_ok();
+  shared_string_table = language->string_table_;
+  LOG(INFO) << "Loaded " << language->string_table_->size() << " strings of language pack "
+            << language->string_table_name_ << " of version " << version;
+}
+
 td_api::object_ptr<td_api::LanguagePackStringValue> LanguagePackManager::get_language_pack_string_value_object(
     const string &value) {
   return td_api::make_object<td_api::languagePackStringValueOrdinary>(value);
@@ -801,6 +880,21 @@ td_api::object_ptr<td_api::LanguagePackStringValue> LanguagePackManager::get_lan
   return td_api::make_object<td_api::languagePackStringValueDeleted>();
 }
 
+td_api::object_ptr<td_api::LanguagePackStringValue>
+LanguagePackManager::get_database_language_pack_string_value_object(Slice value) {
+  if (value[0] == '1') {
+    return td_api::make_object<td_api::languagePackStringValueOrdinary>(value.substr(1).str());
+  }
+  if (value[0] == '2') {
+    auto all = full_split(value.substr(1), '\x00');
+    if (all.size() == 6) {
+      return td_api::make_object<td_api::languagePackStringValuePluralized>(
+          all[0].str(), all[1].str(), all[2].str(), all[3].str(), all[4].str(), all[5].str());
+    }
+  }
+  return get_language_pack_string_value_object();
+}
+
 td_api::object_ptr<td_api::languagePackString> LanguagePackManager::get_language_pack_string_object(
     const string &key, const string &value) {
   return td_api::make_object<td_api::languagePackString>(key, get_language_pack_string_value_object(value));
@@ -826,6 +920,12 @@ td_api::object_ptr<td_api::LanguagePackStringValue> LanguagePackManager::get_lan
   if (pluralized_it != language->pluralized_strings_.end()) {
     return get_language_pack_string_value_object(*pluralized_it->second);
   }
+  if (language->string_table_ != nullptr && language->deleted_strings_.count(key) == 0) {
+    auto value = language->string_table_->get(key);
+    if (!value.empty()) {
+      return get_database_language_pack_string_value_object(value);
+    }
+  }
   LOG_IF(ERROR, !language->is_full_ && language->deleted_strings_.count(key) == 0) << "Have no string for key " << key;
   return get_language_pack_string_value_object();
 }
@@ -848,6 +948,22 @@ td_api::object_ptr<td_api::languagePackStrings> LanguagePackManager::get_languag
     for (auto &str : language->pluralized_strings_) {
       strings.push_back(get_language_pack_string_object(str.first, *str.second));
     }
+    if (language->string_table_ != nullptr) {
+      const auto &string_table = *language->string_table_;
+      for (size_t i = 0; i < string_table.size(); i++) {
+        auto value = string_table.get_value(i);
+        if (value.empty() || (value[0] != '1' && value[0] != '2')) {
+          continue;
+        }
+        auto key = string_table.get_key(i).str();
+        if (language->ordinary_strings_.count(key) != 0 || language->pluralized_strings_.count(key) != 0 ||
+            language->deleted_strings_.count(key) != 0) {
+          continue;
+        }
+        strings.push_back(td_api::make_object<td_api::languagePackString>(
+            std::move(key), get_database_language_pack_string_value_object(value)));
+      }
+    }
   } else {
     for (auto &key : keys) {
       strings.push_back(get_language_pack_string_object(language, key));
@@ -1299,7 +1415,7 @@ bool LanguagePackManager::is_valid_key(Slice key) {
   return !key.empty();
 }
 
-void LanguagePackManager::save_strings_to_database(SqliteKeyValue *kv, int32 new_version, bool new_is_full,
+void LanguagePackManager::save_strings_to_database(Language *language, int32 new_version, bool new_is_full,
                                                    int32 new_key_count, vector<std::pair<string, string>> &&strings) {
   LOG(DEBUG) << "Save to database a language pack with new version " << new_version << " and " << strings.size()
              << " new strings";
@@ -1308,7 +1424,8 @@ void LanguagePackManager::save_strings_to_database(SqliteKeyValue *kv, int32 new
   }
 
   std::lock_guard<std::mutex> lock(database_->mutex_);
-  CHECK(kv != nullptr);
+  CHECK(language != nullptr);
+  auto *kv = &language->kv_;
   if (kv->empty()) {
     LOG(DEBUG) << "There is no associated database key-value";
     return;
@@ -1336,6 +1453,10 @@ void LanguagePackManager::save_strings_to_database(SqliteKeyValue *kv, int32 new
   if (old_version != new_version) {
     LOG(DEBUG) << "Set language pack version in database to " << new_version;
     kv->set("!version", to_string(new_version));
+    if (old_version != -1 && !language->string_table_name_.empty()) {
+      // the string table for the old version isn't needed anymore; the file can be deleted even if it is mapped
+      unlink(get_language_string_table_path(language, old_version)).ignore();
+    }
   }
   if (new_key_count != -1) {
     LOG(DEBUG) << "Set language pack key count in database to " << new_key_count;
@@ -1382,14 +1503,16 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
+            if (!language_has_value_unsafe(language, str->key_)) {
+              key_count_delta++;
+            }
             auto it = language->ordinary_strings_.find(str->key_);
             if (it == language->ordinary_strings_.end()) {
-              key_count_delta++;
               it = language->ordinary_strings_.emplace(str->key_, std::move(str->value_)).first;
             } else {
               it->second = std::move(str->value_);
             }
-            key_count_delta -= static_cast<int32>(language->pluralized_strings_.erase(str->key_));
+            language->pluralized_strings_.erase(str->key_);
             language->deleted_strings_.erase(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(it->first, it->second));
@@ -1406,14 +1529,16 @@ void LanguagePackManager::on_get_language_pack_strings(
             auto value = td::make_unique<PluralizedString>(std::move(str->zero_value_), std::move(str->one_value_),
                                                            std::move(str->two_value_), std::move(str->few_value_),
                                                            std::move(str->many_value_), std::move(str->other_value_));
+            if (!language_has_value_unsafe(language, str->key_)) {
+              key_count_delta++;
+            }
             auto it = language->pluralized_strings_.find(str->key_);
             if (it == language->pluralized_strings_.end()) {
-              key_count_delta++;
               it = language->pluralized_strings_.emplace(str->key_, std::move(value)).first;
             } else {
               it->second = std::move(value);
             }
-            key_count_delta -= static_cast<int32>(language->ordinary_strings_.erase(str->key_));
+            language->ordinary_strings_.erase(str->key_);
             language->deleted_strings_.erase(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(it->first, *it->second));
@@ -1431,8 +1556,11 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
-            key_count_delta -= static_cast<int32>(language->ordinary_strings_.erase(str->key_));
-            key_count_delta -= static_cast<int32>(language->pluralized_strings_.erase(str->key_));
+            if (language_has_value_unsafe(language, str->key_)) {
+              key_count_delta--;
+            }
+            language->ordinary_strings_.erase(str->key_);
+            language->pluralized_strings_.erase(str->key_);
             language->deleted_strings_.insert(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(str->key_));
@@ -1467,6 +1595,7 @@ void LanguagePackManager::on_get_language_pack_strings(
         CHECK(new_database_version >= 0);
         language->is_full_ = true;
         language->deleted_strings_.clear();
+        language->string_table_ = nullptr;
       }
       new_is_full = language->is_full_;
 
@@ -1481,7 +1610,7 @@ void LanguagePackManager::on_get_language_pack_strings(
     new_database_version = 1;
   }
 
-  save_strings_to_database(&language->kv_, new_database_version, new_is_full, new_key_count,
+  save_strings_to_database(language, new_database_version, new_is_full, new_key_count,
                            std::move(database_strings));
 
   if (is_diff) {
@@ -1850,6 +1979,10 @@ Status LanguagePackManager::do_delete_language(const string &language_code) {
         .ensure();
   }
   std::lock_guard<std::mutex> language_lock(language->mutex_);
+  if (language->version_ != -1 && !language->string_table_name_.empty()) {
+    unlink(get_language_string_table_path(language, language->version_)).ignore();
+  }
+  language->string_table_ = nullptr;
   language->version_ = -1;
   language->key_count_ = load_database_language_key_count(&language->kv_);
   language->is_full_ = false;
@@ -1881,9 +2014,107 @@ void LanguagePackManager::hangup() {
   stop();
 }
 
+namespace {
+
+void on_get_localization_target_info_request(Td *td, uint64 id, td_api::getLocalizationTargetInfo &request) {
+  if (!td->check_is_user(id)) {
+    return;
+  }
+  auto promise = td->create_request_promise<td_api::getLocalizationTargetInfo::ReturnType>(id);
+  send_closure(td->language_pack_manager_, &LanguagePackManager::get_languages, request.only_local_,
+               std::move(promise));
+}
+
+void on_get_language_pack_info_request(Td *td, uint64 id, td_api::getLanguagePackInfo &request) {
+  if (!td->check_is_user(id) || !td->check_input_string(id, request.language_pack_id_)) {
+    return;
+  }
+  auto promise = td->create_request_promise<td_api::getLanguagePackInfo::ReturnType>(id);
+  send_closure(td->language_pack_manager_, &LanguagePackManager::search_language_info, request.language_pack_id_,
+               std::move(promise));
+}
+
+void on_get_language_pack_strings_request(Td *td, uint64 id, td_api::getLanguagePackStrings &request) {
+  if (!td->check_is_user(id) || !td->check_input_string(id, request.language_pack_id_)) {
+    return;
+  }
+  for (auto &key : request.keys_) {
+    if (!td->check_input_string(id, key)) {
+      return;
+    }
+  }
+  auto promise = td->create_request_promise<td_api::getLanguagePackStrings::ReturnType>(id);
+  send_closure(td->language_pack_manager_, &LanguagePackManager::get_language_pack_strings,
+               std::move(request.language_pack_id_), std::move(request.keys_), std::move(promise));
+}
+
+void on_synchronize_language_pack_request(Td *td, uint64 id, td_api::synchronizeLanguagePack &request) {
+  if (!td->check_is_user(id) || !td->check_input_string(id, request.language_pack_id_)) {
+    return;
+  }
+  send_closure(td->language_pack_manager_, &LanguagePackManager::synchronize_language_pack,
+               std::move(request.language_pack_id_), td->create_ok_request_promise(id));
+}
+
+void on_add_custom_server_language_pack_request(Td *td, uint64 id, td_api::addCustomServerLanguagePack &request) {
+  if (!td->check_is_user(id) || !td->check_input_string(id, request.language_pack_id_)) {
+    return;
+  }
+  send_closure(td->language_pack_manager_, &LanguagePackManager::add_custom_server_language,
+               std::move(request.language_pack_id_), td->create_ok_request_promise(id));
+}
+
+void on_set_custom_language_pack_request(Td *td, uint64 id, td_api::setCustomLanguagePack &request) {
+  if (!td->check_is_user(id)) {
+    return;
+  }
+  send_closure(td->language_pack_manager_, &LanguagePackManager::set_custom_language, std::move(request.info_),
+               std::move(request.strings_), td->create_ok_request_promise(id));
+}
+
+void on_edit_custom_language_pack_info_request(Td *td, uint64 id, td_api::editCustomLanguagePackInfo &request) {
+  if (!td->check_is_user(id)) {
+    return;
+  }
+  send_closure(td->language_pack_manager_, &LanguagePackManager::edit_custom_language_info, std::move(request.info_),
+               td->create_ok_request_promise(id));
+}
+
+void on_set_custom_language_pack_string_request(Td *td, uint64 id, td_api::setCustomLanguagePackString &request) {
+  if (!td->check_is_user(id) || !td->check_input_string(id, request.language_pack_id_)) {
+    return;
+  }
+  send_closure(td->language_pack_manager_, &LanguagePackManager::set_custom_language_string,
+               std::move(request.language_pack_id_), std::move(request.new_string_), td->create_ok_request_promise(id));
+}
+
+void on_delete_language_pack_request(Td *td, uint64 id, td_api::deleteLanguagePack &request) {
+  if (!td->check_is_user(id) || !td->check_input_string(id, request.language_pack_id_)) {
+    return;
+  }
+  send_closure(td->language_pack_manager_, &LanguagePackManager::delete_language, std::move(request.language_pack_id_),
+               td->create_ok_request_promise(id));
+}
+
+}  // namespace
+
+void LanguagePackManager::register_request_handlers() {
+  Td::register_request_handler<td_api::getLocalizationTargetInfo, on_get_localization_target_info_request>();
+  Td::register_request_handler<td_api::getLanguagePackInfo, on_get_language_pack_info_request>();
+  Td::register_request_handler<td_api::getLanguagePackStrings, on_get_language_pack_strings_request>();
+  Td::register_request_handler<td_api::synchronizeLanguagePack, on_synchronize_language_pack_request>();
+  Td::register_request_handler<td_api::addCustomServerLanguagePack, on_add_custom_server_language_pack_request>();
+  Td::register_request_handler<td_api::setCustomLanguagePack, on_set_custom_language_pack_request>();
+  Td::register_request_handler<td_api::editCustomLanguagePackInfo, on_edit_custom_language_pack_info_request>();
+  Td::register_request_handler<td_api::setCustomLanguagePackString, on_set_custom_language_pack_string_request>();
+  Td::register_request_handler<td_api::deleteLanguagePack, on_delete_language_pack_request>();
+}
+
 int32 LanguagePackManager::manager_count_ = 0;
 std::mutex LanguagePackManager::language_database_mutex_;
 std::unordered_map<string, unique_ptr<LanguagePackManager::LanguageDatabase>, Hash<string>>
     LanguagePackManager::language_databases_;
+std::mutex LanguagePackManager::string_table_mutex_;
+FlatHashMap<string, std::weak_ptr<const LanguagePackStringTable>> LanguagePackManager::string_tables_;
 
 }  // namespace td
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/RegisteredRequest.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/telegram_api.h"
 
@@ -20,13 +21,16 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
 
 namespace td {
 
+class LanguagePackStringTable;
 class SqliteKeyValue;
+class Td;
 
 class LanguagePackManager final : public NetQueryCallback {
  public:
@@ -37,6 +41,8 @@ class LanguagePackManager final : public NetQueryCallback {
   LanguagePackManager &operator=(LanguagePackManager &&) = delete;
   ~LanguagePackManager() final;
 
+  static void register_request_handlers();
+
   static bool check_language_pack_name(Slice name);
 
   static bool check_language_code_name(Slice name);
@@ -108,6 +114,9 @@ class LanguagePackManager final : public NetQueryCallback {
   static std::mutex language_database_mutex_;
   static std::unordered_map<string, unique_ptr<LanguageDatabase>, Hash<string>> language_databases_;
 
+  static std::mutex string_table_mutex_;
+  static FlatHashMap<string, std::weak_ptr<const LanguagePackStringTable>> string_tables_;
+
   static LanguageDatabase *add_language_database(string path);
 
   static Language *get_language(LanguageDatabase *database, const string &language_pack, const string &language_code);
@@ -116,15 +125,21 @@ class LanguagePackManager final : public NetQueryCallback {
   static Language *add_language(LanguageDatabase *database, const string &language_pack, const string &language_code);
 
   static bool language_has_string_unsafe(const Language *language, const string &key);
+  static bool language_has_value_unsafe(const Language *language, const string &key);
   static bool language_has_strings(Language *language, const vector<string> &keys);
 
   static void load_language_string_unsafe(Language *language, const string &key, const string &value);
   static bool load_language_strings(LanguageDatabase *database, Language *language, const vector<string> &keys);
 
+  static string get_language_string_table_path(const Language *language, int32 version);
+  static void load_language_string_table(Language *language);
+
   static td_api::object_ptr<td_api::LanguagePackStringValue> get_language_pack_string_value_object(const string &value);
   static td_api::object_ptr<td_api::LanguagePackStringValue> get_language_pack_string_value_object(
       const PluralizedString &value);
   static td_api::object_ptr<td_api::LanguagePackStringValue> get_language_pack_string_value_object();
+  static td_api::object_ptr<td_api::LanguagePackStringValue> get_database_language_pack_string_value_object(
+      Slice value);
 
   static td_api::object_ptr<td_api::languagePackString> get_language_pack_string_object(const string &key,
                                                                                         const string &value);
@@ -159,7 +174,7 @@ class LanguagePackManager final : public NetQueryCallback {
 
   static bool is_valid_key(Slice key);
 
-  void save_strings_to_database(SqliteKeyValue *kv, int32 new_version, bool new_is_full, int32 new_key_count,
+  void save_strings_to_database(Language *language, int32 new_version, bool new_is_full, int32 new_key_count,
                                 vector<std::pair<string, string>> &&strings);
 
   void load_empty_language_pack(const string &language_code);
@@ -198,4 +213,24 @@ class LanguagePackManager final : public NetQueryCallback {
   void send_with_promise(NetQueryPtr query, Promise<NetQueryPtr> promise);
 };
 
+// handlers are registered in LanguagePackManager::register_request_handlers
+template <>
+struct IsRegisteredRequest<td_api::getLocalizationTargetInfo> : std::true_type {};
+template <>
+struct IsRegisteredRequest<td_api::getLanguagePackInfo> : std::true_type {};
+template <>
+struct IsRegisteredRequest<td_api::getLanguagePackStrings> : std::true_type {};
+template <>
+struct IsRegisteredRequest<td_api::synchronizeLanguagePack> : std::true_type {};
+template <>
+struct IsRegisteredRequest<td_api::addCustomServerLanguagePack> : std::true_type {};
+template <>
+struct IsRegisteredRequest<td_api::setCustomLanguagePack> : std::true_type {};
+template <>
+struct IsRegisteredRequest<td_api::editCustomLanguagePackInfo> : std::true_type {};
+template <>
+struct IsRegisteredRequest<td_api::setCustomLanguagePackString> : std::true_type {};
+template <>
+struct IsRegisteredRequest<td_api::deleteLanguagePack> : std::true_type {};
+
 }  // namespace td
@@ -0,0 +1,160 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/LanguagePackStringTable.h"
+
+#include "td/utils/as.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace td {
+
+constexpr uint32 LanguagePackStringTable::MAGIC;
+constexpr size_t LanguagePackStringTable::HEADER_SIZE;
+
+LanguagePackStringTable::LanguagePackStringTable(unique_ptr<MemoryMapping> &&mapping, BufferSlice &&buffer)
+    : mapping_(std::move(mapping)), buffer_(std::move(buffer)) {
+  data_ = mapping_ != nullptr ? mapping_->as_slice() : buffer_.as_slice();
+}
+
+BufferSlice LanguagePackStringTable::serialize(vector<std::pair<string, string>> &&strings) {
+  std::sort(strings.begin(), strings.end(),
+            [](const std::pair<string, string> &lhs, const std::pair<string, string> &rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  size_t pool_size = 0;
+  for (auto &str : strings) {
+    pool_size += str.first.size() + str.second.size();
+  }
+  auto offsets_size = (2 * strings.size() + 1) * sizeof(uint32);
+  BufferSlice result(HEADER_SIZE + offsets_size + pool_size);
+  auto *header = result.as_mutable_slice().ubegin();
+  as<uint32>(header) = MAGIC;
+  as<uint32>(header + sizeof(uint32)) = narrow_cast<uint32>(strings.size());
+  as<uint32>(header + 2 * sizeof(uint32)) = narrow_cast<uint32>(pool_size);
+
+  auto *offsets = header + HEADER_SIZE;
+  auto *pool = reinterpret_cast<char *>(offsets + offsets_size);
+  uint32 offset = 0;
+  auto add_string = [&](Slice str) {
+    as<uint32>(offsets) = offset;
+    offsets += sizeof(uint32);
+    std::memcpy(pool + offset, str.data(), str.size());
+    offset += narrow_cast<uint32>(str.size());
+  };
+  for (auto &str : strings) {
+    add_string(str.first);
+    add_string(str.second);
+  }
+  as<uint32>(offsets) = offset;
+  CHECK(offset == pool_size);
+  return result;
+}
+
+Result<std::shared_ptr<const LanguagePackStringTable>> LanguagePackStringTable::create(BufferSlice &&data) {
+  std::shared_ptr<LanguagePackStringTable> result(new LanguagePackStringTable(nullptr, std::move(data)));
+  TRY_STATUS(result->init());
+  return std::move(result);
+}
+
+Result<std::shared_ptr<const LanguagePackStringTable>> LanguagePackStringTable::load(CSlice path) {
+  TRY_RESULT(fd, FileFd::open(path, FileFd::Read));
+  auto r_mapping = MemoryMapping::create_from_file(fd);
+  if (r_mapping.is_error()) {
+    LOG(INFO) << "Can't memory-map " << path << ": " << r_mapping.error();
+    fd.close();
+    TRY_RESULT(data, read_file(path));
+    return create(std::move(data));
+  }
+  fd.close();
+
+  std::shared_ptr<LanguagePackStringTable> result(
+      new LanguagePackStringTable(make_unique<MemoryMapping>(r_mapping.move_as_ok()), BufferSlice()));
+  TRY_STATUS(result->init());
+  return std::move(result);
+}
+
+Status LanguagePackStringTable::init() {
+  if (data_.size() < HEADER_SIZE) {
+    return Status::Error("Language pack string table is too small");
+  }
+  if (static_cast<uint32>(as<uint32>(data_.ubegin())) != MAGIC) {
+    return Status::Error("Wrong language pack string table format");
+  }
+  size_ = as<uint32>(data_.ubegin() + sizeof(uint32));
+  size_t pool_size = as<uint32>(data_.ubegin() + 2 * sizeof(uint32));
+  if (size_ > data_.size() / (2 * sizeof(uint32))) {
+    return Status::Error(PSLICE() << "Wrong language pack string table size " << size_);
+  }
+  pool_offset_ = HEADER_SIZE + (2 * size_ + 1) * sizeof(uint32);
+  if (data_.size() != pool_offset_ + pool_size) {
+    return Status::Error(PSLICE() << "Wrong language pack string table size " << data_.size());
+  }
+  if (get_offset(0) != 0 || get_offset(2 * size_) != pool_size) {
+    return Status::Error("Wrong language pack string table offsets");
+  }
+  for (size_t i = 0; i < 2 * size_; i++) {
+    if (get_offset(i) > get_offset(i + 1)) {
+      return Status::Error("Wrong language pack string table offsets");
+    }
+  }
+  for (size_t i = 1; i < size_; i++) {
+    if (!(get_key(i - 1) < get_key(i))) {
+      return Status::Error("Language pack string table isn't sorted");
+    }
+  }
+  return Status::OK();
+}
+
+uint32 LanguagePackStringTable::get_offset(size_t pos) const {
+  return as<uint32>(data_.ubegin() + HEADER_SIZE + pos * sizeof(uint32));
+}
+
+Slice LanguagePackStringTable::get_string(size_t pos) const {
+  auto begin = get_offset(pos);
+  auto end = get_offset(pos + 1);
+  return Slice(data_.begin() + pool_offset_ + begin, data_.begin() + pool_offset_ + end);
+}
+
+Slice LanguagePackStringTable::get_key(size_t pos) const {
+  CHECK(pos < size_);
+  return get_string(2 * pos);
+}
+
+Slice LanguagePackStringTable::get_value(size_t pos) const {
+  CHECK(pos < size_);
+  return get_string(2 * pos + 1);
+}
+
+Slice LanguagePackStringTable::get(Slice key) const {
+  size_t left = 0;
+  size_t right = size_;
+  while (left < right) {
+    auto middle = left + (right - left) / 2;
+    if (get_key(middle) < key) {
+      left = middle + 1;
+    } else {
+      right = middle;
+    }
+  }
+  if (left == size_ || get_key(left) != key) {
+    return Slice();
+  }
+  return get_value(left);
+}
+
+size_t LanguagePackStringTable::get_memory_size() const {
+  return mapping_ != nullptr ? 0 : data_.size();
+}
+
+}  // namespace td
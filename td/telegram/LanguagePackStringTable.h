@@ -0,0 +1,64 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/port/MemoryMapping.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <memory>
+#include <utility>
+
+namespace td {
+
+// Immutable table of language pack strings with values in the database format.
+// The table consists of a header, a sorted table of key and value offsets and a string pool.
+// It is memory-mapped from a file if possible, so it can be shared between all Td instances in the process.
+class LanguagePackStringTable {
+ public:
+  // strings must have unique keys
+  static BufferSlice serialize(vector<std::pair<string, string>> &&strings);
+
+  static Result<std::shared_ptr<const LanguagePackStringTable>> create(BufferSlice &&data);
+
+  static Result<std::shared_ptr<const LanguagePackStringTable>> load(CSlice path);
+
+  size_t size() const {
+    return size_;
+  }
+
+  Slice get_key(size_t pos) const;
+
+  Slice get_value(size_t pos) const;
+
+  // returns empty slice if there is no such key
+  Slice get(Slice key) const;
+
+  size_t get_memory_size() const;
+
+ private:
+  static constexpr uint32 MAGIC = 0x504c4454;  // "TDLP"
+  static constexpr size_t HEADER_SIZE = 3 * sizeof(uint32);
+
+  unique_ptr<MemoryMapping> mapping_;
+  BufferSlice buffer_;
+  Slice data_;
+  size_t size_ = 0;
+  size_t pool_offset_ = 0;
+
+  LanguagePackStringTable(unique_ptr<MemoryMapping> &&mapping, BufferSlice &&buffer);
+
+  Status init();
+
+  uint32 get_offset(size_t pos) const;
+
+  Slice get_string(size_t pos) const;
+};
+
+}  // namespace td
@@ -0,0 +1,48 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/LazyUpdates.h"
+
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/tl_parsers.h"
+
+namespace td {
+
+LazyUpdates::LazyUpdates(BufferSlice &&data) : data_(std::move(data)) {
+  TlParser parser(data_.as_slice());
+  id_ = parser.fetch_int();
+  if (id_ == telegram_api::updateShort::ID) {
+    short_update_id_ = parser.fetch_int();
+  }
+  if (parser.get_error() != nullptr) {
+    id_ = 0;
+    short_update_id_ = 0;
+  }
+}
+
+void LazyUpdates::parse() {
+  if (is_parsed_) {
+    return;
+  }
+  is_parsed_ = true;
+
+  TlBufferParser parser(&data_);
+  updates_ = telegram_api::Updates::fetch(parser);
+  parser.fetch_end();
+  if (parser.get_error()) {
+    LOG(ERROR) << "Failed to fetch update: " << parser.get_error() << format::as_hex_dump<4>(data_.as_slice());
+    updates_ = nullptr;
+  }
+  data_ = BufferSlice();
+}
+
+telegram_api::object_ptr<telegram_api::Updates> LazyUpdates::get_updates() {
+  parse();
+  return std::move(updates_);
+}
+
+}  // namespace td
@@ -0,0 +1,46 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/telegram_api.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+
+namespace td {
+
+// Updates object received from the server, which is parsed only when it is needed.
+// Constructor identifiers of the object and of the update in updateShort are known without parsing.
+class LazyUpdates {
+ public:
+  LazyUpdates() = default;
+
+  explicit LazyUpdates(BufferSlice &&data);
+
+  int32 get_id() const {
+    return id_;
+  }
+
+  // returns 0 if the object isn't an updateShort
+  int32 get_short_update_id() const {
+    return short_update_id_;
+  }
+
+  void parse();
+
+  // returns nullptr if the object can't be parsed
+  telegram_api::object_ptr<telegram_api::Updates> get_updates();
+
+ private:
+  BufferSlice data_;
+  telegram_api::object_ptr<telegram_api::Updates> updates_;
+  int32 id_ = 0;
+  int32 short_update_id_ = 0;
+  bool is_parsed_ = false;
+};
+
+}  // namespace td
@@ -37,7 +37,7 @@ bool Log::set_file_path(string file_path) {
     return Logging::set_current_stream(td_api::make_object<td_api::logStreamDefault>()).is_ok();
   }
 
-  if (Logging::set_current_stream(td_api::make_object<td_api::logStreamFile>(file_path, max_log_file_size, true))
+  if (Logging::set_current_stream(td_api::make_object<td_api::logStreamFile>(file_path, max_log_file_size, true, false))
           .is_ok()) {
     log_file_path = std::move(file_path);
     return true;
@@ -49,7 +49,7 @@ bool Log::set_file_path(string file_path) {
 void Log::set_max_file_size(int64 max_file_size) {
   std::lock_guard<std::mutex> lock(log_mutex);
   max_log_file_size = max(max_file_size, static_cast<int64>(1));
-  Logging::set_current_stream(td_api::make_object<td_api::logStreamFile>(log_file_path, max_log_file_size, true))
+  Logging::set_current_stream(td_api::make_object<td_api::logStreamFile>(log_file_path, max_log_file_size, true, false))
       .ignore();
 }
 
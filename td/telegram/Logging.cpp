@@ -30,6 +30,7 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/AsyncBinaryLog.h"
 #include "td/utils/ExitGuard.h"
 #include "td/utils/FileLog.h"
 #include "td/utils/logging.h"
@@ -48,6 +49,11 @@ static std::mutex logging_mutex;
 static FileLog file_log;
 static TsLog ts_log(&file_log);
 static NullLog null_log;
+#if !TD_THREAD_UNSUPPORTED
+// is destroyed after exit_guard, so it has time to write the remaining log messages
+static AsyncBinaryLog async_binary_log;
+static bool is_async_binary_log_inited = false;
+#endif
 static ExitGuard exit_guard;
 
 #define ADD_TAG(tag) \
@@ -77,9 +83,25 @@ Status Logging::set_current_stream(td_api::object_ptr<td_api::LogStream> stream)
         return Status::Error("Max log file size must be positive");
       }
       auto redirect_stderr = file_stream->redirect_stderr_;
+#if TD_THREAD_UNSUPPORTED
+      if (file_stream->is_asynchronous_) {
+        return Status::Error("Asynchronous logging isn't supported");
+      }
+#endif
 
       TRY_STATUS(file_log.init(file_stream->path_, max_log_file_size, redirect_stderr));
       std::atomic_thread_fence(std::memory_order_release);  // better than nothing
+#if !TD_THREAD_UNSUPPORTED
+      if (file_stream->is_asynchronous_) {
+        if (!is_async_binary_log_inited) {
+          // the log is never replaced, so log messages written after switching to another stream are still safe
+          async_binary_log.init(&ts_log);
+          is_async_binary_log_inited = true;
+        }
+        log_interface = &async_binary_log;
+        return Status::OK();
+      }
+#endif
       log_interface = &ts_log;
       return Status::OK();
     }
@@ -102,8 +124,14 @@ Result<td_api::object_ptr<td_api::LogStream>> Logging::get_current_stream() {
   }
   if (log_interface == &ts_log) {
     return td_api::make_object<td_api::logStreamFile>(file_log.get_path().str(), file_log.get_rotate_threshold(),
-                                                      file_log.get_redirect_stderr());
+                                                      file_log.get_redirect_stderr(), false);
+  }
+#if !TD_THREAD_UNSUPPORTED
+  if (log_interface == &async_binary_log) {
+    return td_api::make_object<td_api::logStreamFile>(file_log.get_path().str(), file_log.get_rotate_threshold(),
+                                                      file_log.get_redirect_stderr(), true);
   }
+#endif
   return Status::Error("Log stream is unrecognized");
 }
 
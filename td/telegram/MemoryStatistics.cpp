@@ -0,0 +1,33 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/MemoryStatistics.h"
+
+#include "td/utils/algorithm.h"
+
+namespace td {
+
+void MemoryStatistics::add(Slice manager_name, Slice container_name, size_t element_count, size_t size) {
+  Entry entry;
+  entry.manager_name_ = manager_name.str();
+  entry.container_name_ = container_name.str();
+  entry.element_count_ = element_count;
+  entry.size_ = size;
+  entries_.push_back(std::move(entry));
+}
+
+td_api::object_ptr<td_api::memoryStatistics> MemoryStatistics::get_memory_statistics_object() const {
+  int64 total_size = 0;
+  auto entries = transform(entries_, [&total_size](const Entry &entry) {
+    total_size += static_cast<int64>(entry.size_);
+    return td_api::make_object<td_api::memoryStatisticsEntry>(entry.manager_name_, entry.container_name_,
+                                                              static_cast<int64>(entry.element_count_),
+                                                              static_cast<int64>(entry.size_));
+  });
+  return td_api::make_object<td_api::memoryStatistics>(std::move(entries), total_size);
+}
+
+}  // namespace td
@@ -0,0 +1,151 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/td_api.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashTable.h"
+#include "td/utils/MapNode.h"
+#include "td/utils/SetNode.h"
+#include "td/utils/Slice.h"
+#include "td/utils/WaitFreeHashMap.h"
+#include "td/utils/WaitFreeVector.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <type_traits>
+#include <utility>
+
+namespace td {
+
+namespace detail {
+
+// approximate size of memory owned by a value outside of its container
+template <class T>
+struct OwnedMemorySize {
+  static constexpr size_t get() {
+    return 0;
+  }
+};
+
+template <class T>
+struct OwnedMemorySize<unique_ptr<T>> {
+  static constexpr size_t get() {
+    return sizeof(T);
+  }
+};
+
+template <class NodeT>
+constexpr size_t get_map_node_owned_memory_size() {
+  return (std::is_same<typename NodeT::public_type, NodeT>::value ? 0 : sizeof(typename NodeT::public_type)) +
+         OwnedMemorySize<typename NodeT::first_type>::get() + OwnedMemorySize<typename NodeT::second_type>::get();
+}
+
+}  // namespace detail
+
+// The functions return approximate memory usage of containers in constant time, or in time proportional
+// to the number of internal storages. Memory owned by the stored objects themselves isn't counted,
+// except for the objects owned through unique_ptr.
+
+template <class KeyT, class ValueT, class HashT, class EqT>
+size_t get_container_size(const FlatHashTable<MapNode<KeyT, ValueT, EqT>, HashT, EqT> &map) {
+  return map.size();
+}
+
+template <class KeyT, class ValueT, class HashT, class EqT>
+size_t get_container_memory(const FlatHashTable<MapNode<KeyT, ValueT, EqT>, HashT, EqT> &map) {
+  using NodeT = MapNode<KeyT, ValueT, EqT>;
+  return map.bucket_count() * sizeof(NodeT) + map.size() * detail::get_map_node_owned_memory_size<NodeT>();
+}
+
+template <class KeyT, class HashT, class EqT>
+size_t get_container_size(const FlatHashTable<SetNode<KeyT, EqT>, HashT, EqT> &set) {
+  return set.size();
+}
+
+template <class KeyT, class HashT, class EqT>
+size_t get_container_memory(const FlatHashTable<SetNode<KeyT, EqT>, HashT, EqT> &set) {
+  return set.bucket_count() * sizeof(SetNode<KeyT, EqT>) + set.size() * detail::OwnedMemorySize<KeyT>::get();
+}
+
+template <class KeyT, class ValueT, class HashT, class EqT>
+size_t get_container_size(const WaitFreeHashMap<KeyT, ValueT, HashT, EqT> &map) {
+  return map.calc_size();
+}
+
+template <class KeyT, class ValueT, class HashT, class EqT>
+size_t get_container_memory(const WaitFreeHashMap<KeyT, ValueT, HashT, EqT> &map) {
+  using NodeT = MapNode<KeyT, ValueT, EqT>;
+  return map.calc_bucket_count() * sizeof(NodeT) + map.calc_size() * detail::get_map_node_owned_memory_size<NodeT>();
+}
+
+template <class T>
+size_t get_container_size(const vector<T> &v) {
+  return v.size();
+}
+
+template <class T>
+size_t get_container_memory(const vector<T> &v) {
+  return v.capacity() * sizeof(T) + v.size() * detail::OwnedMemorySize<T>::get();
+}
+
+template <class T>
+size_t get_container_size(const WaitFreeVector<T> &v) {
+  return v.size();
+}
+
+template <class T>
+size_t get_container_memory(const WaitFreeVector<T> &v) {
+  return v.calc_capacity() * sizeof(T) + v.size() * detail::OwnedMemorySize<T>::get();
+}
+
+template <class KeyT, class ValueT, class CompareT>
+size_t get_container_size(const std::map<KeyT, ValueT, CompareT> &map) {
+  return map.size();
+}
+
+template <class KeyT, class ValueT, class CompareT>
+size_t get_container_memory(const std::map<KeyT, ValueT, CompareT> &map) {
+  // a tree node has 3 pointers and a color in addition to the value
+  return map.size() * (sizeof(std::pair<const KeyT, ValueT>) + 4 * sizeof(void *) +
+                       detail::OwnedMemorySize<KeyT>::get() + detail::OwnedMemorySize<ValueT>::get());
+}
+
+template <class KeyT, class CompareT>
+size_t get_container_size(const std::set<KeyT, CompareT> &set) {
+  return set.size();
+}
+
+template <class KeyT, class CompareT>
+size_t get_container_memory(const std::set<KeyT, CompareT> &set) {
+  return set.size() * (sizeof(KeyT) + 4 * sizeof(void *) + detail::OwnedMemorySize<KeyT>::get());
+}
+
+class MemoryStatistics {
+ public:
+  template <class T>
+  void add(Slice manager_name, Slice container_name, const T &container) {
+    add(manager_name, container_name, get_container_size(container), get_container_memory(container));
+  }
+
+  void add(Slice manager_name, Slice container_name, size_t element_count, size_t size);
+
+  td_api::object_ptr<td_api::memoryStatistics> get_memory_statistics_object() const;
+
+ private:
+  struct Entry {
+    string manager_name_;
+    string container_name_;
+    size_t element_count_ = 0;
+    size_t size_ = 0;
+  };
+  vector<Entry> entries_;
+};
+
+}  // namespace td
@@ -45,6 +45,7 @@
 #include "td/telegram/LinkManager.h"
 #include "td/telegram/Location.h"
 #include "td/telegram/logevent/LogEvent.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessageContent.h"
 #include "td/telegram/MessageDb.h"
 #include "td/telegram/MessageEntity.h"
@@ -272,7 +273,12 @@ class GetMessagesQuery final : public Td::ResultHandler {
   }
 
   void send(vector<tl_object_ptr<telegram_api::InputMessage>> &&message_ids) {
-    send_query(G()->net_query_creator().create(telegram_api::messages_getMessages(std::move(message_ids))));
+    bool is_bulk = message_ids.size() > 1;
+    auto query = G()->net_query_creator().create(telegram_api::messages_getMessages(std::move(message_ids)));
+    if (is_bulk) {
+      query->set_priority(NetQuery::PRIORITY_BULK);
+    }
+    send_query(std::move(query));
   }
 
   void on_result(BufferSlice packet) final {
@@ -312,8 +318,13 @@ class GetChannelMessagesQuery final : public Td::ResultHandler {
     last_new_message_id_ = last_new_message_id;
     can_be_inaccessible_ = message_ids.size() == 1 && message_ids[0]->get_id() != telegram_api::inputMessageID::ID;
     CHECK(input_channel != nullptr);
-    send_query(G()->net_query_creator().create(
-        telegram_api::channels_getMessages(std::move(input_channel), std::move(message_ids))));
+    bool is_bulk = message_ids.size() > 1;
+    auto query = G()->net_query_creator().create(
+        telegram_api::channels_getMessages(std::move(input_channel), std::move(message_ids)));
+    if (is_bulk) {
+      query->set_priority(NetQuery::PRIORITY_BULK);
+    }
+    send_query(std::move(query));
   }
 
   void on_result(BufferSlice packet) final {
@@ -2916,6 +2927,7 @@ class SendMessageQuery final : public Td::ResultHandler {
                                            std::move(as_input_peer), nullptr, effect_id.get()),
         {{dialog_id, MessageContentType::Text},
          {dialog_id, is_copy ? MessageContentType::Photo : MessageContentType::Text}});
+    query->set_priority(NetQuery::PRIORITY_INTERACTIVE);
     if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_id](Result<Unit> result) {
         if (result.is_ok()) {
@@ -3049,6 +3061,7 @@ class SendInlineBotResultQuery final : public Td::ResultHandler {
             flags, false /*ignored*/, false /*ignored*/, false /*ignored*/, false /*ignored*/, std::move(input_peer),
             std::move(reply_to), random_id, query_id, result_id, schedule_date, std::move(as_input_peer), nullptr),
         {{dialog_id, MessageContentType::Text}, {dialog_id, MessageContentType::Photo}});
+    query->set_priority(NetQuery::PRIORITY_INTERACTIVE);
     auto send_query_ref = query.get_weak();
     send_query(std::move(query));
     return send_query_ref;
@@ -3112,13 +3125,15 @@ class SendMultiMediaQuery final : public Td::ResultHandler {
     }
 
     // no quick ack, because file reference errors are very likely to happen
-    send_query(G()->net_query_creator().create(
+    auto query = G()->net_query_creator().create(
         telegram_api::messages_sendMultiMedia(flags, false /*ignored*/, false /*ignored*/, false /*ignored*/,
                                               false /*ignored*/, false /*ignored*/, false /*ignored*/,
                                               std::move(input_peer), std::move(reply_to), std::move(input_single_media),
                                               schedule_date, std::move(as_input_peer), nullptr, effect_id.get()),
         {{dialog_id, is_copy ? MessageContentType::Text : MessageContentType::Photo},
-         {dialog_id, MessageContentType::Photo}}));
+         {dialog_id, MessageContentType::Photo}});
+    query->set_priority(NetQuery::PRIORITY_INTERACTIVE);
+    send_query(std::move(query));
   }
 
   void on_result(BufferSlice packet) final {
@@ -3241,6 +3256,7 @@ class SendMediaQuery final : public Td::ResultHandler {
                                          std::move(reply_markup), std::move(entities), schedule_date,
                                          std::move(as_input_peer), nullptr, effect_id.get()),
         {{dialog_id, content_type}, {dialog_id, is_copy ? MessageContentType::Text : content_type}});
+    query->set_priority(NetQuery::PRIORITY_INTERACTIVE);
     if (td_->option_manager_->get_option_boolean("use_quick_ack") && was_uploaded_) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_id](Result<Unit> result) {
         if (result.is_ok()) {
@@ -15757,11 +15773,28 @@ vector<DialogId> MessagesManager::get_dialogs(DialogListId dialog_list_id, Dialo
   }
   update_list_last_pinned_dialog_date(list);
 
+  if (dialog_list_id.is_filter()) {
+    // the list has its own index, so there is no need to skip dialogs from the folders, which aren't in the list
+    for (auto it = list.ordered_dialogs_.upper_bound(offset);
+         limit > 0 && it != list.ordered_dialogs_.end() && *it <= list.list_last_dialog_date_; ++it) {
+      if (it->get_order() == DEFAULT_ORDER) {
+        break;
+      }
+      if (get_dialog_pinned_order(&list, it->get_dialog_id()) != DEFAULT_ORDER) {
+        continue;
+      }
+      limit--;
+      result.push_back(it->get_dialog_id());
+    }
+  }
+
   vector<const DialogFolder *> folders;
   vector<std::set<DialogDate>::const_iterator> folder_iterators;
-  for (auto folder_id : get_dialog_list_folder_ids(list)) {
-    folders.push_back(get_dialog_folder(folder_id));
-    folder_iterators.push_back(folders.back()->ordered_dialogs_.upper_bound(offset));
+  if (!dialog_list_id.is_filter()) {
+    for (auto folder_id : get_dialog_list_folder_ids(list)) {
+      folders.push_back(get_dialog_folder(folder_id));
+      folder_iterators.push_back(folders.back()->ordered_dialogs_.upper_bound(offset));
+    }
   }
   while (limit > 0) {
     size_t best_pos = 0;
@@ -31468,6 +31501,8 @@ void MessagesManager::edit_dialog_list_for_dialog_filter(unique_ptr<DialogFilter
         if (!was_in_list) {
           add_dialog_to_list(d, dialog_list_id);
         }
+        // add_dialog_to_list changes the old list, which will be replaced with the new one
+        new_list.ordered_dialogs_.insert(DialogDate(d->order, dialog_id));
 
         new_list.in_memory_dialog_total_count_++;
         if (dialog_id.get_type() == DialogType::SecretChat) {
@@ -35345,6 +35380,12 @@ void MessagesManager::update_dialog_lists(
     bool is_in_list = new_position.order != DEFAULT_ORDER && new_position.private_order != 0;
     CHECK(was_in_list == is_dialog_in_list(d, dialog_list_id));
 
+    if (was_in_list && old_position.order != d->order && dialog_list_id.is_filter()) {
+      bool is_erased = list.ordered_dialogs_.erase(DialogDate(old_position.order, dialog_id)) > 0;
+      CHECK(is_erased);
+      list.ordered_dialogs_.insert(DialogDate(d->order, dialog_id));
+    }
+
     LOG(DEBUG) << "Update position of " << dialog_id << " in " << dialog_list_id << " from " << old_position << " to "
                << new_position;
 
@@ -35765,6 +35806,12 @@ void MessagesManager::add_dialog_to_list(Dialog *d, DialogListId dialog_list_id)
   LOG(INFO) << "Add " << d->dialog_id << " to " << dialog_list_id;
   CHECK(!is_dialog_in_list(d, dialog_list_id));
   d->dialog_list_ids.push_back(dialog_list_id);
+  if (dialog_list_id.is_filter()) {
+    auto *list = get_dialog_list(dialog_list_id);
+    CHECK(list != nullptr);
+    bool is_inserted = list->ordered_dialogs_.insert(DialogDate(d->order, d->dialog_id)).second;
+    CHECK(is_inserted);
+  }
   CHECK(d->is_update_new_chat_sent);
   send_closure(G()->td(), &Td::send_update,
                td_api::make_object<td_api::updateChatAddedToList>(
@@ -35775,6 +35822,12 @@ void MessagesManager::remove_dialog_from_list(Dialog *d, DialogListId dialog_lis
   LOG(INFO) << "Remove " << d->dialog_id << " from " << dialog_list_id;
   bool is_removed = td::remove(d->dialog_list_ids, dialog_list_id);
   CHECK(is_removed);
+  if (dialog_list_id.is_filter()) {
+    auto *list = get_dialog_list(dialog_list_id);
+    CHECK(list != nullptr);
+    is_removed = list->ordered_dialogs_.erase(DialogDate(d->order, d->dialog_id)) > 0;
+    CHECK(is_removed);
+  }
   CHECK(d->is_update_new_chat_sent);
   send_closure(G()->td(), &Td::send_update,
                td_api::make_object<td_api::updateChatRemovedFromList>(
@@ -38519,6 +38572,37 @@ void MessagesManager::get_current_state(vector<td_api::object_ptr<td_api::Update
   append(updates, std::move(last_message_updates));
 }
 
+void MessagesManager::get_memory_statistics(MemoryStatistics &statistics) const {
+  statistics.add("MessagesManager", "dialogs", dialogs_);
+
+  size_t message_count = 0;
+  size_t message_size = 0;
+  dialogs_.foreach([&](const DialogId &dialog_id, const unique_ptr<Dialog> &dialog) {
+    message_count += get_container_size(dialog->messages);
+    message_size += get_container_memory(dialog->messages);
+  });
+  statistics.add("MessagesManager", "messages", message_count, message_size);
+
+  size_t folder_dialog_count = 0;
+  size_t folder_dialog_memory = 0;
+  for (auto &folder : dialog_folders_) {
+    folder_dialog_count += get_container_size(folder.second.ordered_dialogs_);
+    folder_dialog_memory += get_container_memory(folder.second.ordered_dialogs_);
+  }
+  statistics.add("MessagesManager", "folder_ordered_dialogs", folder_dialog_count, folder_dialog_memory);
+
+  size_t list_dialog_count = 0;
+  size_t list_dialog_memory = 0;
+  for (auto &list : dialog_lists_) {
+    list_dialog_count += get_container_size(list.second.ordered_dialogs_);
+    list_dialog_memory += get_container_memory(list.second.ordered_dialogs_);
+  }
+  statistics.add("MessagesManager", "list_ordered_dialogs", list_dialog_count, list_dialog_memory);
+
+  statistics.add("MessagesManager", "message_id_to_dialog_id", message_id_to_dialog_id_);
+  statistics.add("MessagesManager", "message_full_id_to_file_source_id", message_full_id_to_file_source_id_);
+}
+
 void MessagesManager::add_message_file_to_downloads(MessageFullId message_full_id, FileId file_id, int32 priority,
                                                     Promise<td_api::object_ptr<td_api::file>> promise) {
   auto m = get_message_force(message_full_id, "add_message_file_to_downloads");
@@ -115,6 +115,7 @@ class DraftMessage;
 class FactCheck;
 struct InputMessageContent;
 class MessageContent;
+class MemoryStatistics;
 class MessageForwardInfo;
 struct MessageReactions;
 struct MessageSearchOffset;
@@ -963,6 +964,8 @@ class MessagesManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void get_memory_statistics(MemoryStatistics &statistics) const;
+
   void add_message_file_to_downloads(MessageFullId message_full_id, FileId file_id, int32 priority,
                                      Promise<td_api::object_ptr<td_api::file>> promise);
 
@@ -1382,6 +1385,9 @@ class MessagesManager final : public Actor {
     vector<DialogDate> pinned_dialogs_;
     bool are_pinned_dialogs_inited_ = false;
 
+    // all dialogs from the list; maintained only for filters, which usually contain a small part of folder dialogs
+    std::set<DialogDate> ordered_dialogs_;
+
     DialogDate last_pinned_dialog_date_ = MIN_DIALOG_DATE;  // in memory
 
     // date of the last loaded dialog
@@ -0,0 +1,70 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/NotificationGroupId.h"
+
+#include "td/utils/common.h"
+#include "td/utils/optional.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace td {
+
+// keeps notification groups with expired flush timeouts, so groups expired together can be flushed in one batch
+class NotificationGroupFlushQueue {
+ public:
+  explicit NotificationGroupFlushQueue(size_t max_batch_size) : max_batch_size_(max_batch_size) {
+  }
+
+  bool empty() const {
+    return group_ids_.empty();
+  }
+
+  // returns true, if the queue was empty and flush of the batch must be scheduled
+  bool add_group(NotificationGroupId group_id) {
+    group_ids_.push_back(group_id);
+    return group_ids_.size() == 1;
+  }
+
+  // returns at most max_batch_size groups in order of their keys; groups without a key are dropped,
+  // other groups are left in the queue, so flush of the next batch must be scheduled unless the queue is empty
+  template <class KeyT, class GetKeyT, class CompareT = std::less<KeyT>>
+  vector<NotificationGroupId> get_batch(GetKeyT &&get_key, CompareT compare = CompareT()) {
+    vector<std::pair<KeyT, NotificationGroupId>> groups;
+    for (auto group_id : group_ids_) {
+      optional<KeyT> key = get_key(group_id);
+      if (key) {
+        groups.emplace_back(key.unwrap(), group_id);
+      }
+    }
+    group_ids_.clear();
+
+    std::stable_sort(groups.begin(), groups.end(),
+                     [&compare](const std::pair<KeyT, NotificationGroupId> &lhs,
+                                const std::pair<KeyT, NotificationGroupId> &rhs) {
+                       return compare(lhs.first, rhs.first);
+                     });
+    vector<NotificationGroupId> result;
+    for (auto &group : groups) {
+      if (result.size() < max_batch_size_) {
+        result.push_back(group.second);
+      } else {
+        group_ids_.push_back(group.second);
+      }
+    }
+    return result;
+  }
+
+ private:
+  size_t max_batch_size_;
+  vector<NotificationGroupId> group_ids_;
+};
+
+}  // namespace td
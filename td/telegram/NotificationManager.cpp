@@ -53,6 +53,7 @@
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/optional.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
@@ -61,6 +62,7 @@
 #include "td/utils/utf8.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <limits>
 
@@ -142,7 +144,7 @@ void NotificationManager::on_flush_pending_notifications_timeout_callback(void *
   VLOG(notifications) << "Ready to flush pending notifications for notification group " << group_id_int;
   if (group_id_int > 0) {
     send_closure_later(notification_manager->actor_id(notification_manager),
-                       &NotificationManager::flush_pending_notifications,
+                       &NotificationManager::on_pending_notifications_ready,
                        NotificationGroupId(narrow_cast<int32>(group_id_int)));
   } else if (group_id_int == 0) {
     send_closure_later(notification_manager->actor_id(notification_manager),
@@ -161,8 +163,9 @@ void NotificationManager::on_flush_pending_updates_timeout_callback(void *notifi
   }
 
   auto notification_manager = static_cast<NotificationManager *>(notification_manager_ptr);
-  send_closure_later(notification_manager->actor_id(notification_manager), &NotificationManager::flush_pending_updates,
-                     narrow_cast<int32>(group_id_int), "timeout");
+  send_closure_later(notification_manager->actor_id(notification_manager),
+                     &NotificationManager::on_pending_updates_ready,
+                     NotificationGroupId(narrow_cast<int32>(group_id_int)));
 }
 
 bool NotificationManager::is_disabled() const {
@@ -936,6 +939,11 @@ void NotificationManager::add_notification(NotificationGroupId group_id, Notific
   auto delay_ms = get_notification_delay_ms(dialog_id, notification, min_delay_ms);
   VLOG(notifications) << "Delay " << notification_id << " for " << delay_ms << " milliseconds";
   auto flush_time = delay_ms * 0.001 + Time::now();
+  if (delay_ms >= 10 * NOTIFICATION_FLUSH_GRANULARITY_MS) {
+    // the delay is increased by at most 10%, but notifications from many chats are flushed together
+    auto granularity = NOTIFICATION_FLUSH_GRANULARITY_MS * 0.001;
+    flush_time = std::ceil(flush_time / granularity) * granularity;
+  }
 
   if (group.pending_notifications_flush_time == 0 || flush_time < group.pending_notifications_flush_time) {
     group.pending_notifications_flush_time = flush_time;
@@ -1414,6 +1422,39 @@ void NotificationManager::flush_all_pending_updates(bool include_delayed_chats,
   }
 }
 
+void NotificationManager::on_pending_updates_ready(NotificationGroupId group_id) {
+  if (ready_pending_update_groups_.add_group(group_id)) {
+    send_closure_later(actor_id(this), &NotificationManager::flush_ready_pending_updates);
+  }
+}
+
+void NotificationManager::flush_ready_pending_updates() {
+  // flush groups in reverse order to not exceed max_notification_group_count_
+  auto group_ids = ready_pending_update_groups_.get_batch<NotificationGroupKey>(
+      [this](NotificationGroupId group_id) -> optional<NotificationGroupKey> {
+        if (!G()->close_flag() && flush_pending_updates_timeout_.has_timeout(group_id.get())) {
+          // the updates have already been flushed and there are new pending updates
+          return {};
+        }
+        if (pending_updates_.count(group_id.get()) == 0) {
+          return {};
+        }
+        auto group_it = get_group(group_id);
+        CHECK(group_it != groups_.end());
+        return group_it->first;
+      },
+      [](const NotificationGroupKey &lhs, const NotificationGroupKey &rhs) { return rhs < lhs; });
+  if (!ready_pending_update_groups_.empty()) {
+    // flush the remaining groups after other pending events are processed
+    send_closure_later(actor_id(this), &NotificationManager::flush_ready_pending_updates);
+  }
+
+  VLOG(notifications) << "Flush pending updates in " << group_ids.size() << " ready notification groups";
+  for (auto group_id : group_ids) {
+    flush_pending_updates(group_id.get(), "flush_ready_pending_updates");
+  }
+}
+
 bool NotificationManager::do_flush_pending_notifications(NotificationGroupKey &group_key, NotificationGroup &group,
                                                          vector<PendingNotification> &pending_notifications) {
   // no check for G()->close_flag() to flush pending notifications even while closing
@@ -1645,6 +1686,38 @@ void NotificationManager::flush_all_pending_notifications() {
   }
 }
 
+void NotificationManager::on_pending_notifications_ready(NotificationGroupId group_id) {
+  if (ready_pending_notification_groups_.add_group(group_id)) {
+    // groups with simultaneously expired timeouts are added before the batch is flushed
+    send_closure_later(actor_id(this), &NotificationManager::flush_ready_pending_notifications);
+  }
+}
+
+void NotificationManager::flush_ready_pending_notifications() {
+  // flush groups in order of last notification date
+  auto group_ids =
+      ready_pending_notification_groups_.get_batch<int32>([this](NotificationGroupId group_id) -> optional<int32> {
+        if (!G()->close_flag() && flush_pending_notifications_timeout_.has_timeout(group_id.get())) {
+          // the group has already been flushed and has new pending notifications
+          return {};
+        }
+        auto group_it = get_group(group_id);
+        if (group_it == groups_.end() || group_it->second.pending_notifications.empty()) {
+          return {};
+        }
+        return group_it->second.pending_notifications.back().date;
+      });
+  if (!ready_pending_notification_groups_.empty()) {
+    // flush the remaining groups after other pending events are processed
+    send_closure_later(actor_id(this), &NotificationManager::flush_ready_pending_notifications);
+  }
+
+  VLOG(notifications) << "Flush pending notifications in " << group_ids.size() << " ready notification groups";
+  for (auto group_id : group_ids) {
+    flush_pending_notifications(group_id);
+  }
+}
+
 void NotificationManager::edit_notification(NotificationGroupId group_id, NotificationId notification_id,
                                             unique_ptr<NotificationType> type) {
   if (is_disabled() || max_notification_group_count_ == 0) {
@@ -11,6 +11,7 @@
 #include "td/telegram/Document.h"
 #include "td/telegram/MessageId.h"
 #include "td/telegram/Notification.h"
+#include "td/telegram/NotificationGroupFlushQueue.h"
 #include "td/telegram/NotificationGroupId.h"
 #include "td/telegram/NotificationGroupKey.h"
 #include "td/telegram/NotificationGroupType.h"
@@ -148,6 +149,10 @@ class NotificationManager final : public Actor {
   static constexpr int32 DEFAULT_DEFAULT_DELAY_MS = 1500;
 
   static constexpr int32 MIN_NOTIFICATION_DELAY_MS = 1;
+  // delayed flushes of pending notifications are aligned to it to flush different groups together
+  static constexpr int32 NOTIFICATION_FLUSH_GRANULARITY_MS = 50;
+
+  static constexpr size_t MAX_FLUSHED_NOTIFICATION_GROUPS = 100;  // maximum number of groups flushed at once
 
   static constexpr int32 MIN_UPDATE_DELAY_MS = 50;
   static constexpr int32 MAX_UPDATE_DELAY_MS = 60000;
@@ -288,6 +293,10 @@ class NotificationManager final : public Actor {
 
   void flush_all_pending_notifications();
 
+  void on_pending_notifications_ready(NotificationGroupId group_id);
+
+  void flush_ready_pending_notifications();
+
   void on_notification_processed(NotificationId notification_id);
 
   void on_notification_removed(NotificationId notification_id);
@@ -306,6 +315,10 @@ class NotificationManager final : public Actor {
 
   void flush_all_pending_updates(bool include_delayed_chats, const char *source);
 
+  void on_pending_updates_ready(NotificationGroupId group_id);
+
+  void flush_ready_pending_updates();
+
   NotificationGroupId get_call_notification_group_id(DialogId dialog_id);
 
   static Result<string> decrypt_push_payload(int64 encryption_key_id, string encryption_key, string payload);
@@ -394,6 +407,10 @@ class NotificationManager final : public Actor {
   MultiTimeout flush_pending_notifications_timeout_{"FlushPendingNotificationsTimeout"};
   MultiTimeout flush_pending_updates_timeout_{"FlushPendingUpdatesTimeout"};
 
+  // groups with expired flush timeouts, which are flushed together in batches
+  NotificationGroupFlushQueue ready_pending_notification_groups_{MAX_FLUSHED_NOTIFICATION_GROUPS};
+  NotificationGroupFlushQueue ready_pending_update_groups_{MAX_FLUSHED_NOTIFICATION_GROUPS};
+
   vector<NotificationGroupId> call_notification_group_ids_;
   FlatHashSet<NotificationGroupId, NotificationGroupIdHash> available_call_notification_group_ids_;
   FlatHashMap<DialogId, NotificationGroupId, DialogIdHash> dialog_id_to_call_notification_group_id_;
@@ -41,6 +41,7 @@
 #include "td/utils/algorithm.h"
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
+#include "td/utils/MemoryProfiler.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/SliceBuilder.h"
@@ -159,6 +160,10 @@ OptionManager::OptionManager(Td *td)
     update_premium_options();
   }
 
+  if (options.isset("memory_profiler_sampling_interval")) {
+    update_memory_profiler_sampling_interval();
+  }
+
   set_option_empty("archive_and_mute_new_chats_from_unknown_users");
   set_option_empty("business_intro_title_length_max");
   set_option_empty("business_intro_message_length_max");
@@ -479,6 +484,14 @@ bool OptionManager::is_synchronous_option(Slice name) {
   return td::contains(get_synchronous_options(), name);
 }
 
+void OptionManager::update_memory_profiler_sampling_interval() const {
+  auto *memory_profiler = get_memory_profiler();
+  if (memory_profiler != nullptr) {
+    auto sampling_interval = get_option_integer("memory_profiler_sampling_interval");
+    memory_profiler->set_sampling_interval(static_cast<size_t>(sampling_interval));
+  }
+}
+
 void OptionManager::on_option_updated(Slice name) {
   switch (name[0]) {
     case 'a':
@@ -574,6 +587,9 @@ void OptionManager::on_option_updated(Slice name) {
       }
       break;
     case 'm':
+      if (name == "memory_profiler_sampling_interval") {
+        update_memory_profiler_sampling_interval();
+      }
       if (name == "my_phone_number") {
         send_closure(G()->config_manager(), &ConfigManager::reget_config, Promise<Unit>());
       }
@@ -802,6 +818,11 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       */
       break;
+    case 'b':
+      if (set_integer_option("bulk_query_inflight_count_max", 1, 1024)) {
+        return;
+      }
+      break;
     case 'c':
       if (!is_bot && set_string_option("connection_parameters", [](Slice value) {
             string value_copy = value.str();
@@ -896,6 +917,12 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 'm':
+      if (name == "memory_profiler_sampling_interval" && get_memory_profiler() == nullptr) {
+        return promise.set_error(Status::Error(400, "Memory profiler is unavailable"));
+      }
+      if (set_integer_option("memory_profiler_sampling_interval")) {
+        return;
+      }
       if (set_integer_option("message_unload_delay", 60, 86400)) {
         return;
       }
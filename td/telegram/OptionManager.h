@@ -70,6 +70,8 @@ class OptionManager {
 
   void on_option_updated(Slice name);
 
+  void update_memory_profiler_sampling_interval() const;
+
   string get_option(Slice name) const;
 
   static bool is_internal_option(Slice name);
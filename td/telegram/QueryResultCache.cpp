@@ -0,0 +1,167 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/QueryResultCache.h"
+
+#include "td/telegram/MemoryStatistics.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/Time.h"
+
+#include <utility>
+
+namespace td {
+
+QueryResultCache::QueryResultCache() {
+  // link previews can change only through updateWebPage, which invalidates cached previews of the changed web page
+  enable_function_cache(telegram_api::messages_getWebPagePreview::ID, "messages.getWebPagePreview", 60.0, 1 << 20);
+  enable_function_cache(telegram_api::help_getDeepLinkInfo::ID, "help.getDeepLinkInfo", 60.0, 100 << 10);
+  enable_function_cache(telegram_api::help_getRecentMeUrls::ID, "help.getRecentMeUrls", 60.0, 100 << 10);
+}
+
+void QueryResultCache::enable_function_cache(int32 function_id, Slice name, double ttl, size_t max_memory_size) {
+  CHECK(ttl > 0.0);
+  auto &cache = function_caches_[function_id];
+  if (cache == nullptr) {
+    cache = make_unique<FunctionCache>();
+  }
+  cache->name_ = name.str();
+  cache->ttl_ = ttl;
+  cache->max_memory_size_ = max_memory_size;
+  remove_results(*cache, Time::now());
+}
+
+size_t QueryResultCache::get_result_memory_size(Slice query, Slice result) {
+  // the query is stored twice: as the key and in the expiration queue
+  return 2 * query.size() + result.size();
+}
+
+void QueryResultCache::remove_results(FunctionCache &cache, double now) {
+  while (!cache.expiration_queue_.empty()) {
+    auto &expiration = cache.expiration_queue_.front();
+    if (expiration.first > now && cache.memory_size_ <= cache.max_memory_size_) {
+      break;
+    }
+    auto it = cache.results_.find(expiration.second);
+    CHECK(it != cache.results_.end());
+    auto memory_size = get_result_memory_size(expiration.second, it->second.result_.as_slice());
+    CHECK(cache.memory_size_ >= memory_size);
+    cache.memory_size_ -= memory_size;
+    cache.results_.erase(it);
+    cache.expiration_queue_.pop_front();
+  }
+}
+
+BufferSlice QueryResultCache::get(int32 function_id, Slice query) {
+  auto cache_it = function_caches_.find(function_id);
+  if (cache_it == function_caches_.end()) {
+    return BufferSlice();
+  }
+  auto &cache = *cache_it->second;
+  remove_results(cache, Time::now());
+
+  auto it = cache.results_.find(query.str());
+  if (it == cache.results_.end()) {
+    cache.miss_count_++;
+    return BufferSlice();
+  }
+  cache.hit_count_++;
+  LOG(DEBUG) << "Use cached result of " << cache.name_;
+  return it->second.result_.clone();
+}
+
+void QueryResultCache::add(int32 function_id, Slice query, Slice result) {
+  auto cache_it = function_caches_.find(function_id);
+  if (cache_it == function_caches_.end()) {
+    return;
+  }
+  auto &cache = *cache_it->second;
+  auto memory_size = get_result_memory_size(query, result);
+  if (result.empty() || memory_size > cache.max_memory_size_ / 4) {
+    return;
+  }
+  auto now = Time::now();
+  remove_results(cache, now);
+
+  auto key = query.str();
+  auto &cached_result = cache.results_[key];
+  if (!cached_result.result_.empty()) {
+    return;
+  }
+  // copy the result to not keep the whole received packet in memory
+  cached_result.result_ = BufferSlice(result);
+  cached_result.expires_at_ = now + cache.ttl_;
+  cache.memory_size_ += memory_size;
+  cache.expiration_queue_.emplace_back(cached_result.expires_at_, std::move(key));
+
+  // remove the oldest results if the memory limit is exceeded
+  remove_results(cache, now);
+}
+
+void QueryResultCache::invalidate(int32 function_id) {
+  auto cache_it = function_caches_.find(function_id);
+  if (cache_it == function_caches_.end()) {
+    return;
+  }
+  auto &cache = *cache_it->second;
+  if (!cache.results_.empty()) {
+    LOG(INFO) << "Invalidate " << cache.results_.size() << " cached results of " << cache.name_;
+  }
+  cache.results_.clear();
+  cache.expiration_queue_.clear();
+  cache.memory_size_ = 0;
+}
+
+void QueryResultCache::invalidate(int32 function_id, const std::function<bool(Slice result)> &is_invalid_result) {
+  auto cache_it = function_caches_.find(function_id);
+  if (cache_it == function_caches_.end()) {
+    return;
+  }
+  auto &cache = *cache_it->second;
+  size_t invalidated_count = 0;
+  std::deque<std::pair<double, string>> expiration_queue;
+  for (auto &expiration : cache.expiration_queue_) {
+    auto it = cache.results_.find(expiration.second);
+    CHECK(it != cache.results_.end());
+    if (is_invalid_result(it->second.result_.as_slice())) {
+      auto memory_size = get_result_memory_size(expiration.second, it->second.result_.as_slice());
+      CHECK(cache.memory_size_ >= memory_size);
+      cache.memory_size_ -= memory_size;
+      cache.results_.erase(it);
+      invalidated_count++;
+    } else {
+      expiration_queue.push_back(std::move(expiration));
+    }
+  }
+  cache.expiration_queue_ = std::move(expiration_queue);
+  if (invalidated_count > 0) {
+    LOG(INFO) << "Invalidate " << invalidated_count << " cached results of " << cache.name_;
+  }
+}
+
+QueryResultCache::Statistics QueryResultCache::get_statistics(int32 function_id) const {
+  Statistics result;
+  auto cache_it = function_caches_.find(function_id);
+  if (cache_it != function_caches_.end()) {
+    const auto &cache = *cache_it->second;
+    result.hit_count = cache.hit_count_;
+    result.miss_count = cache.miss_count_;
+    result.result_count = cache.results_.size();
+    result.memory_size = cache.memory_size_;
+  }
+  return result;
+}
+
+void QueryResultCache::get_memory_statistics(MemoryStatistics &statistics) const {
+  for (auto &it : function_caches_) {
+    const auto &cache = *it.second;
+    statistics.add("QueryResultCache", cache.name_, cache.results_.size(),
+                   get_container_memory(cache.results_) + cache.memory_size_);
+  }
+}
+
+}  // namespace td
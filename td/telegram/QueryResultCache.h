@@ -0,0 +1,78 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Slice.h"
+
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace td {
+
+class MemoryStatistics;
+
+// caches results of idempotent server queries by the serialized query
+// only results of explicitly enabled functions are cached, each with its own TTL and memory limit
+class QueryResultCache {
+ public:
+  struct Statistics {
+    uint64 hit_count = 0;
+    uint64 miss_count = 0;
+    size_t result_count = 0;
+    size_t memory_size = 0;
+  };
+
+  QueryResultCache();
+
+  void enable_function_cache(int32 function_id, Slice name, double ttl, size_t max_memory_size);
+
+  // returns an empty BufferSlice if there is no cached result
+  BufferSlice get(int32 function_id, Slice query);
+
+  // an already cached result isn't replaced and its TTL isn't extended
+  void add(int32 function_id, Slice query, Slice result);
+
+  void invalidate(int32 function_id);
+
+  // invalidates only the results, for which is_invalid_result returns true
+  void invalidate(int32 function_id, const std::function<bool(Slice result)> &is_invalid_result);
+
+  Statistics get_statistics(int32 function_id) const;
+
+  void get_memory_statistics(MemoryStatistics &statistics) const;
+
+ private:
+  struct CachedResult {
+    BufferSlice result_;
+    double expires_at_ = 0.0;
+  };
+
+  struct FunctionCache {
+    string name_;
+    double ttl_ = 0.0;
+    size_t max_memory_size_ = 0;
+
+    FlatHashMap<string, CachedResult> results_;
+    std::deque<std::pair<double, string>> expiration_queue_;  // expiration time and query in order of addition
+    size_t memory_size_ = 0;
+
+    uint64 hit_count_ = 0;
+    uint64 miss_count_ = 0;
+  };
+
+  FlatHashMap<int32, unique_ptr<FunctionCache>> function_caches_;
+
+  static size_t get_result_memory_size(Slice query, Slice result);
+
+  static void remove_results(FunctionCache &cache, double now);
+};
+
+}  // namespace td
@@ -0,0 +1,18 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include <type_traits>
+
+namespace td {
+
+// must be specialized as true for requests, which handlers are registered with Td::register_request_handler;
+// all other requests must be handled by a Td::on_request overload
+template <class T>
+struct IsRegisteredRequest : std::false_type {};
+
+}  // namespace td
@@ -0,0 +1,51 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/SaveMerger.h"
+
+#include "td/utils/logging.h"
+
+namespace td {
+
+SaveMerger::SaveMerger(Slice name, double max_delay) : max_delay_(max_delay) {
+  register_actor(name, this).release();
+}
+
+void SaveMerger::add_object(int64 object_id) {
+  CHECK(object_id != 0);
+  added_object_count_++;
+  if (!object_id_set_.insert(object_id).second) {
+    // the object is already waiting to be saved
+    return;
+  }
+  object_ids_.push_back(object_id);
+  if (object_ids_.size() == 1) {
+    set_timeout_in(max_delay_);
+  }
+}
+
+void SaveMerger::flush() {
+  if (object_ids_.empty()) {
+    return;
+  }
+  cancel_timeout();
+
+  auto object_ids = std::move(object_ids_);
+  object_ids_.clear();
+  object_id_set_.clear();
+  saved_object_count_ += object_ids.size();
+  LOG(INFO) << "Save " << object_ids.size() << " objects; saved " << saved_object_count_ << " out of "
+            << added_object_count_ << " added objects";
+
+  CHECK(save_function_ != nullptr);
+  save_function_(std::move(object_ids));
+}
+
+void SaveMerger::timeout_expired() {
+  flush();
+}
+
+}  // namespace td
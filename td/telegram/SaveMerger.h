@@ -0,0 +1,56 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/actor.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashSet.h"
+#include "td/utils/Slice.h"
+
+#include <functional>
+#include <utility>
+
+namespace td {
+
+// merges saves of the same objects and saves all changed objects together after a bounded delay
+class SaveMerger final : public Actor {
+ public:
+  SaveMerger(Slice name, double max_delay);
+
+  using SaveFunction = std::function<void(vector<int64> object_ids)>;
+  void set_save_function(SaveFunction save_function) {
+    save_function_ = std::move(save_function);
+  }
+
+  // the object will be saved in at most max_delay seconds
+  void add_object(int64 object_id);
+
+  bool has_object(int64 object_id) const {
+    return object_id_set_.count(object_id) != 0;
+  }
+
+  // immediately saves all pending objects
+  void flush();
+
+  // returns the number of added objects and the number of objects actually saved
+  std::pair<uint64, uint64> get_statistics() const {
+    return {added_object_count_, saved_object_count_};
+  }
+
+ private:
+  double max_delay_;
+  SaveFunction save_function_;
+  vector<int64> object_ids_;
+  FlatHashSet<int64> object_id_set_;
+  uint64 added_object_count_ = 0;
+  uint64 saved_object_count_ = 0;
+
+  void timeout_expired() final;
+};
+
+}  // namespace td
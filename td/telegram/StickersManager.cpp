@@ -14,6 +14,7 @@
 #include "td/telegram/Document.h"
 #include "td/telegram/DocumentsManager.h"
 #include "td/telegram/EmojiGroup.hpp"
+#include "td/telegram/EmojiKeywordIndex.hpp"
 #include "td/telegram/EmojiStatus.h"
 #include "td/telegram/FileReferenceManager.h"
 #include "td/telegram/files/FileLocation.h"
@@ -23,6 +24,7 @@
 #include "td/telegram/LanguagePackManager.h"
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/logevent/LogEventHelper.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessagesManager.h"
 #include "td/telegram/misc.h"
 #include "td/telegram/net/DcId.h"
@@ -9685,25 +9687,118 @@ string StickersManager::get_language_emojis_database_key(const string &language_
   return PSTRING() << "emoji$" << language_code << '$' << text;
 }
 
+string StickersManager::get_emoji_keyword_index_database_key(const string &language_code) {
+  return PSTRING() << "emojii$" << language_code;
+}
+
+string StickersManager::get_emoji_keyword_index_changes_database_key(const string &language_code) {
+  return PSTRING() << "emojiic$" << language_code;
+}
+
+template <class StorerT>
+void StickersManager::EmojiKeywordIndexChanges::store(StorerT &storer) const {
+  td::store(from_version_, storer);
+  td::store(to_version_, storer);
+  td::store(keywords_, storer);
+}
+
+template <class ParserT>
+void StickersManager::EmojiKeywordIndexChanges::parse(ParserT &parser) {
+  td::parse(from_version_, parser);
+  td::parse(to_version_, parser);
+  td::parse(keywords_, parser);
+}
+
+Status StickersManager::apply_emoji_keyword_index_changes(const string &language_code, int32 version,
+                                                          EmojiKeywordIndex &index) {
+  EmojiKeywordIndexChanges changes;
+  auto value = G()->td_db()->get_sqlite_sync_pmc()->get(get_emoji_keyword_index_changes_database_key(language_code));
+  TRY_STATUS(log_event_parse(changes, value));
+  if (changes.from_version_ != index.get_version() || changes.to_version_ != version) {
+    return Status::Error(PSLICE() << "Have changes from version " << changes.from_version_ << " to version "
+                                  << changes.to_version_);
+  }
+  for (auto &keyword : changes.keywords_) {
+    auto emojis = G()->td_db()->get_sqlite_sync_pmc()->get(get_language_emojis_database_key(language_code, keyword));
+    index.set_keyword_emojis(keyword, emojis.empty() ? vector<string>() : full_split(emojis, '$'));
+  }
+  index.set_version(version);
+  return Status::OK();
+}
+
+std::shared_ptr<const EmojiKeywordIndex> StickersManager::get_emoji_keyword_index(const string &language_code) {
+  auto &index = emoji_keyword_indexes_[language_code];
+  if (index == nullptr) {
+    index = load_emoji_keyword_index(language_code);
+  }
+  return index;
+}
+
+std::shared_ptr<const EmojiKeywordIndex> StickersManager::load_emoji_keyword_index(const string &language_code) {
+  CHECK(G()->use_sqlite_pmc());
+  auto version = get_emoji_language_code_version(language_code);
+  if (version == 0) {
+    return std::make_shared<EmojiKeywordIndex>();
+  }
+  auto shared_index = EmojiKeywordIndex::get_shared(language_code, version);
+  if (shared_index != nullptr) {
+    LOG(INFO) << "Reuse index of emoji keywords for language " << language_code << " of version " << version;
+    return shared_index;
+  }
+
+  EmojiKeywordIndex index;
+  auto value = G()->td_db()->get_sqlite_sync_pmc()->get(get_emoji_keyword_index_database_key(language_code));
+  if (!value.empty()) {
+    auto status = log_event_parse(index, value);
+    if (status.is_ok() && index.get_version() != version) {
+      status = apply_emoji_keyword_index_changes(language_code, version, index);
+      if (status.is_ok()) {
+        LOG(INFO) << "Applied changes of emoji keywords for language " << language_code << " to version " << version;
+      }
+    }
+    if (status.is_ok() && index.get_version() == version) {
+      LOG(INFO) << "Loaded " << index.size() << " emoji keywords for language " << language_code << " from database";
+      return EmojiKeywordIndex::add_shared(language_code, std::move(index));
+    }
+    LOG(INFO) << "Ignore emoji keyword index for language " << language_code << " of version " << index.get_version()
+              << " instead of " << version << ": " << status;
+  }
+
+  vector<std::pair<string, string>> keyword_emojis;
+  G()->td_db()->get_sqlite_sync_pmc()->get_by_prefix(
+      get_language_emojis_database_key(language_code, string()), [&keyword_emojis](Slice key, Slice value) {
+        keyword_emojis.emplace_back(key.str(), value.str());
+        return true;
+      });
+  index = EmojiKeywordIndex(version, std::move(keyword_emojis));
+  LOG(INFO) << "Built index of " << index.size() << " emoji keywords for language " << language_code;
+  if (!G()->close_flag()) {
+    save_emoji_keyword_index(language_code, index, Auto());
+  }
+  return EmojiKeywordIndex::add_shared(language_code, std::move(index));
+}
+
+void StickersManager::save_emoji_keyword_index(const string &language_code, const EmojiKeywordIndex &index,
+                                               Promise<Unit> &&promise) {
+  EmojiKeywordIndexChanges changes;
+  changes.from_version_ = index.get_version();
+  changes.to_version_ = index.get_version();
+  FlatHashMap<string, string> key_values;
+  key_values.emplace(get_emoji_keyword_index_database_key(language_code), log_event_store(index).as_slice().str());
+  key_values.emplace(get_emoji_keyword_index_changes_database_key(language_code),
+                     log_event_store(changes).as_slice().str());
+  G()->td_db()->get_sqlite_pmc()->set_all(std::move(key_values), std::move(promise));
+}
+
 vector<std::pair<string, string>> StickersManager::search_language_emojis(const string &language_code,
                                                                           const string &text) {
   LOG(INFO) << "Search emoji for \"" << text << "\" in language " << language_code;
-  auto key = get_language_emojis_database_key(language_code, text);
-  vector<std::pair<string, string>> result;
-  G()->td_db()->get_sqlite_sync_pmc()->get_by_prefix(key, [&text, &result](Slice key, Slice value) {
-    for (const auto &emoji : full_split(value, '$')) {
-      result.emplace_back(emoji.str(), PSTRING() << text << key);
-    }
-    return true;
-  });
-  return result;
+  return get_emoji_keyword_index(language_code)->search(text);
 }
 
 vector<string> StickersManager::get_keyword_language_emojis(const string &language_code, const string &text) {
   LOG(INFO) << "Get emoji for \"" << text << "\" in language " << language_code;
-  auto key = get_language_emojis_database_key(language_code, text);
-  string emojis = G()->td_db()->get_sqlite_sync_pmc()->get(key);
-  return full_split(emojis, '$');
+  return get_emoji_keyword_index(language_code)->get_keyword_emojis(text);
 }
 
 string StickersManager::get_emoji_language_codes_database_key(const vector<string> &language_codes) {
@@ -9898,6 +9993,7 @@ void StickersManager::on_get_emoji_keywords(
     LOG(ERROR) << "Receive keywords of version " << version;
     version = 1;
   }
+  vector<std::pair<string, string>> keyword_emojis;
   for (auto &keyword_ptr : keywords->keywords_) {
     switch (keyword_ptr->get_id()) {
       case telegram_api::emojiKeyword::ID: {
@@ -9912,8 +10008,10 @@ void StickersManager::on_get_emoji_keywords(
         }
         if (is_good && !G()->close_flag()) {
           CHECK(G()->use_sqlite_pmc());
-          G()->td_db()->get_sqlite_pmc()->set(get_language_emojis_database_key(language_code, text),
-                                              implode(keyword->emoticons_, '$'), mpas.get_promise());
+          auto emojis = implode(keyword->emoticons_, '$');
+          G()->td_db()->get_sqlite_pmc()->set(get_language_emojis_database_key(language_code, text), emojis,
+                                              mpas.get_promise());
+          keyword_emojis.emplace_back(std::move(text), std::move(emojis));
         }
         break;
       }
@@ -9924,8 +10022,10 @@ void StickersManager::on_get_emoji_keywords(
         UNREACHABLE();
     }
   }
+  auto index = EmojiKeywordIndex::add_shared(language_code, EmojiKeywordIndex(version, std::move(keyword_emojis)));
   if (!G()->close_flag()) {
     CHECK(G()->use_sqlite_pmc());
+    save_emoji_keyword_index(language_code, *index, mpas.get_promise());
     G()->td_db()->get_sqlite_pmc()->set(get_emoji_language_code_version_database_key(language_code), to_string(version),
                                         mpas.get_promise());
     G()->td_db()->get_sqlite_pmc()->set(get_emoji_language_code_last_difference_time_database_key(language_code),
@@ -9933,6 +10033,7 @@ void StickersManager::on_get_emoji_keywords(
   }
   emoji_language_code_versions_[language_code] = version;
   emoji_language_code_last_difference_times_[language_code] = static_cast<int32>(Time::now_cached());
+  emoji_keyword_indexes_[language_code] = std::move(index);
 
   lock.set_value(Unit());
 }
@@ -9978,6 +10079,15 @@ void StickersManager::on_get_emoji_keywords_difference(
     keywords->version_ = version;
   }
   version = keywords->version_;
+  auto old_index = get_emoji_keyword_index(language_code);
+  FlatHashMap<string, vector<string>> changed_keywords;
+  auto get_keyword_emojis = [&old_index, &changed_keywords](const string &text) {
+    auto it = changed_keywords.find(text);
+    if (it != changed_keywords.end()) {
+      return it->second;
+    }
+    return old_index->get_keyword_emojis(text);
+  };
   FlatHashMap<string, string> key_values;
   key_values.emplace(get_emoji_language_code_version_database_key(language_code), to_string(version));
   key_values.emplace(get_emoji_language_code_last_difference_time_database_key(language_code),
@@ -9995,7 +10105,7 @@ void StickersManager::on_get_emoji_keywords_difference(
           }
         }
         if (is_good) {
-          vector<string> emojis = get_keyword_language_emojis(language_code, text);
+          vector<string> emojis = get_keyword_emojis(text);
           bool is_changed = false;
           for (auto &emoji : keyword->emoticons_) {
             if (!td::contains(emojis, emoji)) {
@@ -10004,7 +10114,8 @@ void StickersManager::on_get_emoji_keywords_difference(
             }
           }
           if (is_changed) {
-            key_values.emplace(get_language_emojis_database_key(language_code, text), implode(emojis, '$'));
+            key_values[get_language_emojis_database_key(language_code, text)] = implode(emojis, '$');
+            changed_keywords[text] = std::move(emojis);
           } else {
             LOG(INFO) << "Emoji keywords not changed for \"" << text << "\" from version " << from_version
                       << " to version " << version;
@@ -10015,7 +10126,7 @@ void StickersManager::on_get_emoji_keywords_difference(
       case telegram_api::emojiKeywordDeleted::ID: {
         auto keyword = telegram_api::move_object_as<telegram_api::emojiKeywordDeleted>(keyword_ptr);
         auto text = utf8_to_lower(keyword->keyword_);
-        vector<string> emojis = get_keyword_language_emojis(language_code, text);
+        vector<string> emojis = get_keyword_emojis(text);
         bool is_changed = false;
         for (auto &emoji : keyword->emoticons_) {
           if (td::remove(emojis, emoji)) {
@@ -10023,7 +10134,8 @@ void StickersManager::on_get_emoji_keywords_difference(
           }
         }
         if (is_changed) {
-          key_values.emplace(get_language_emojis_database_key(language_code, text), implode(emojis, '$'));
+          key_values[get_language_emojis_database_key(language_code, text)] = implode(emojis, '$');
+          changed_keywords[text] = std::move(emojis);
         } else {
           LOG(INFO) << "Emoji keywords not changed for \"" << text << "\" from version " << from_version
                     << " to version " << version;
@@ -10034,6 +10146,31 @@ void StickersManager::on_get_emoji_keywords_difference(
         UNREACHABLE();
     }
   }
+  // the old index can be used by other Td instances, so it must not be changed
+  auto index = EmojiKeywordIndex::add_shared_changes(language_code, *old_index, version, changed_keywords);
+  emoji_keyword_indexes_[language_code] = index;
+
+  // the whole index is saved only after enough keywords are changed; till then, only the list of changed keywords is
+  // saved, and the changes are applied to the saved index when it is loaded
+  EmojiKeywordIndexChanges changes;
+  auto changes_key = get_emoji_keyword_index_changes_database_key(language_code);
+  auto changes_value = G()->td_db()->get_sqlite_sync_pmc()->get(changes_key);
+  bool need_save_index =
+      changes_value.empty() || log_event_parse(changes, changes_value).is_error() || changes.to_version_ != from_version;
+  if (!need_save_index) {
+    for (auto &it : changed_keywords) {
+      changes.keywords_.push_back(it.first);
+    }
+    td::unique(changes.keywords_);
+    need_save_index = changes.keywords_.size() * 10 > index->size();
+  }
+  if (need_save_index) {
+    key_values.emplace(get_emoji_keyword_index_database_key(language_code), log_event_store(*index).as_slice().str());
+    changes.from_version_ = version;
+    changes.keywords_.clear();
+  }
+  changes.to_version_ = version;
+  key_values.emplace(std::move(changes_key), log_event_store(changes).as_slice().str());
   CHECK(G()->use_sqlite_pmc());
   G()->td_db()->get_sqlite_pmc()->set_all(
       std::move(key_values), PromiseCreator::lambda([actor_id = actor_id(this), language_code, version](Unit) mutable {
@@ -10353,4 +10490,18 @@ void StickersManager::get_current_state(vector<td_api::object_ptr<td_api::Update
   }
 }
 
+void StickersManager::get_memory_statistics(MemoryStatistics &statistics) const {
+  statistics.add("StickersManager", "stickers", stickers_);
+  statistics.add("StickersManager", "sticker_sets", sticker_sets_);
+  statistics.add("StickersManager", "short_name_to_sticker_set_id", short_name_to_sticker_set_id_);
+  statistics.add("StickersManager", "custom_emoji_to_sticker_id", custom_emoji_to_sticker_id_);
+  size_t emoji_keyword_count = 0;
+  size_t emoji_keyword_memory = 0;
+  for (auto &it : emoji_keyword_indexes_) {
+    emoji_keyword_count += it.second->size();
+    emoji_keyword_memory += it.second->get_memory_size();
+  }
+  statistics.add("StickersManager", "emoji_keyword_indexes", emoji_keyword_count, emoji_keyword_memory);
+}
+
 }  // namespace td
@@ -11,6 +11,7 @@
 #include "td/telegram/Dimensions.h"
 #include "td/telegram/EmojiGroup.h"
 #include "td/telegram/EmojiGroupType.h"
+#include "td/telegram/EmojiKeywordIndex.h"
 #include "td/telegram/files/FileId.h"
 #include "td/telegram/files/FileSourceId.h"
 #include "td/telegram/MessageFullId.h"
@@ -52,6 +53,7 @@
 
 namespace td {
 
+class MemoryStatistics;
 class Td;
 
 class StickersManager final : public Actor {
@@ -438,6 +440,8 @@ class StickersManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void get_memory_statistics(MemoryStatistics &statistics) const;
+
   template <class StorerT>
   void store_sticker_set_id(StickerSetId sticker_set_id, StorerT &storer) const;
 
@@ -963,9 +967,35 @@ class StickersManager final : public Actor {
 
   void on_get_language_codes(const string &key, Result<vector<string>> &&result);
 
-  static vector<std::pair<string, string>> search_language_emojis(const string &language_code, const string &text);
+  static string get_emoji_keyword_index_database_key(const string &language_code);
+
+  static string get_emoji_keyword_index_changes_database_key(const string &language_code);
+
+  // keywords changed after the index of from_version_ was saved to the database
+  struct EmojiKeywordIndexChanges {
+    int32 from_version_ = 0;
+    int32 to_version_ = 0;
+    vector<string> keywords_;
+
+    template <class StorerT>
+    void store(StorerT &storer) const;
+
+    template <class ParserT>
+    void parse(ParserT &parser);
+  };
+
+  static Status apply_emoji_keyword_index_changes(const string &language_code, int32 version,
+                                                  EmojiKeywordIndex &index);
+
+  std::shared_ptr<const EmojiKeywordIndex> get_emoji_keyword_index(const string &language_code);
 
-  static vector<string> get_keyword_language_emojis(const string &language_code, const string &text);
+  std::shared_ptr<const EmojiKeywordIndex> load_emoji_keyword_index(const string &language_code);
+
+  void save_emoji_keyword_index(const string &language_code, const EmojiKeywordIndex &index, Promise<Unit> &&promise);
+
+  vector<std::pair<string, string>> search_language_emojis(const string &language_code, const string &text);
+
+  vector<string> get_keyword_language_emojis(const string &language_code, const string &text);
 
   void load_emoji_keywords(const string &language_code, Promise<Unit> &&promise);
 
@@ -1123,6 +1153,8 @@ class StickersManager final : public Actor {
   FlatHashMap<string, vector<string>> emoji_language_codes_;
   FlatHashMap<string, int32> emoji_language_code_versions_;
   FlatHashMap<string, double> emoji_language_code_last_difference_times_;
+  FlatHashMap<string, std::shared_ptr<const EmojiKeywordIndex>> emoji_keyword_indexes_;  // shared between Td instances
+
   FlatHashSet<string> reloaded_emoji_keywords_;
   FlatHashMap<string, vector<Promise<Unit>>> load_emoji_keywords_queries_;
   FlatHashMap<string, vector<Promise<Unit>>> load_language_codes_queries_;
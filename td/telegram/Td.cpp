@@ -83,9 +83,11 @@
 #include "td/telegram/InlineQueriesManager.h"
 #include "td/telegram/JsonValue.h"
 #include "td/telegram/LanguagePackManager.h"
+#include "td/telegram/LazyUpdates.h"
 #include "td/telegram/LinkManager.h"
 #include "td/telegram/Location.h"
 #include "td/telegram/Logging.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessageCopyOptions.h"
 #include "td/telegram/MessageEffectId.h"
 #include "td/telegram/MessageEntity.h"
@@ -128,6 +130,7 @@
 #include "td/telegram/Premium.h"
 #include "td/telegram/PrivacyManager.h"
 #include "td/telegram/PublicDialogType.h"
+#include "td/telegram/QueryResultCache.h"
 #include "td/telegram/QuickReplyManager.h"
 #include "td/telegram/ReactionManager.h"
 #include "td/telegram/ReactionNotificationSettings.h"
@@ -191,6 +194,7 @@
 #include "td/utils/buffer.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/format.h"
+#include "td/utils/MemoryProfiler.h"
 #include "td/utils/MimeType.h"
 #include "td/utils/misc.h"
 #include "td/utils/PathView.h"
@@ -204,6 +208,7 @@
 #include "td/utils/Timer.h"
 #include "td/utils/utf8.h"
 
+#include <atomic>
 #include <limits>
 #include <tuple>
 #include <type_traits>
@@ -222,6 +227,15 @@ void Td::ResultHandler::send_query(NetQueryPtr query) {
   CHECK(!is_query_sent_);
   is_query_sent_ = true;
   td_->add_handler(query->id(), shared_from_this());
+  if (td_->query_result_cache_ != nullptr) {
+    auto result = td_->query_result_cache_->get(query->tl_constructor(), query->query().as_slice());
+    if (!result.empty()) {
+      query->debug("Receive from QueryResultCache");
+      query->set_ok(std::move(result));
+      send_closure_later(td_->actor_id(td_), &Td::on_result, std::move(query));
+      return;
+    }
+  }
   query->debug("Send to NetQueryDispatcher");
   G()->net_query_dispatcher().dispatch(std::move(query));
 }
@@ -2389,6 +2403,7 @@ Td::Td(unique_ptr<TdCallback> callback, Options options)
   LOG(INFO) << "Create Td with layer " << MTPROTO_LAYER << ", database version " << current_db_version()
             << " and version " << static_cast<int32>(Version::Next) - 1 << " on "
             << Scheduler::instance()->sched_count() << " threads";
+  init_request_handlers();
 }
 
 Td::~Td() = default;
@@ -2660,6 +2675,7 @@ bool Td::is_synchronous_request(const td_api::Function *function) {
     case td_api::setLogTagVerbosityLevel::ID:
     case td_api::getLogTagVerbosityLevel::ID:
     case td_api::addLogMessage::ID:
+    case td_api::getMemoryProfile::ID:
     case td_api::testReturnError::ID:
       return true;
     case td_api::getOption::ID:
@@ -2708,6 +2724,7 @@ bool Td::is_preauthentication_request(int32 id) {
     case td_api::getStorageStatistics::ID:
     case td_api::getStorageStatisticsFast::ID:
     case td_api::getDatabaseStatistics::ID:
+    case td_api::getMemoryStatistics::ID:
     case td_api::setNetworkType::ID:
     case td_api::getNetworkStatistics::ID:
     case td_api::addNetworkStatistics::ID:
@@ -2869,7 +2886,44 @@ void Td::run_request(uint64 id, tl_object_ptr<td_api::Function> function) {
       !is_preinitialization_request(function_id) && !is_authentication_request(function_id)) {
     return send_error_impl(id, make_error(401, "Unauthorized"));
   }
-  downcast_call(*function, [this, id](auto &request) { this->on_request(id, request); });
+  run_request_handler(id, *function);
+}
+
+// shared by all Td instances and indexed by td_api::get_function_table_index;
+// entries for requests handled by Td::on_request are filled on first use by any instance
+static std::atomic<Td::RequestHandler> request_handlers[td_api::FUNCTION_TABLE_SIZE];
+
+void Td::init_request_handlers() {
+  static bool is_inited = [] {
+    LanguagePackManager::register_request_handlers();
+    return true;
+  }();
+  CHECK(is_inited);
+}
+
+void Td::set_request_handler(int32 function_id, RequestHandler handler) {
+  auto &request_handler = request_handlers[td_api::get_function_table_index(function_id)];
+  CHECK(request_handler.load(std::memory_order_relaxed) == nullptr);
+  request_handler.store(handler, std::memory_order_relaxed);
+}
+
+void Td::run_request_handler(uint64 id, td_api::Function &function) {
+  auto &request_handler = request_handlers[td_api::get_function_table_index(function.get_id())];
+  auto handler = request_handler.load(std::memory_order_relaxed);
+  if (handler == nullptr) {
+    // the request has no registered handler, so it must be handled by Td::on_request;
+    // concurrent instances can store the same handler simultaneously
+    downcast_call(function, [&handler](auto &request) {
+      using RequestT = std::decay_t<decltype(request)>;
+      handler = get_default_request_handler(&request, IsRegisteredRequest<RequestT>());
+    });
+    if (handler == nullptr) {
+      LOG(ERROR) << "Receive unsupported request " << function.get_id();
+      return send_error_raw(id, 400, "Method is not supported");
+    }
+    request_handler.store(handler, std::memory_order_relaxed);
+  }
+  handler(this, id, function);
 }
 
 td_api::object_ptr<td_api::Object> Td::static_request(td_api::object_ptr<td_api::Function> function) {
@@ -2928,25 +2982,21 @@ std::shared_ptr<Td::ResultHandler> Td::extract_handler(uint64 id) {
   return result;
 }
 
-void Td::on_update(telegram_api::object_ptr<telegram_api::Updates> updates, uint64 auth_key_id) {
+void Td::on_update(LazyUpdates updates, uint64 auth_key_id) {
   if (close_flag_ > 1) {
     return;
   }
 
-  if (updates == nullptr) {
-    if (auth_manager_->is_bot()) {
-      G()->net_query_dispatcher().update_mtproto_header();
-    } else {
-      // this could be a min-channel update
-      updates_manager_->schedule_get_difference("failed to fetch updates");
-    }
-  } else {
-    updates_manager_->on_update_from_auth_key_id(auth_key_id);
-    updates_manager_->on_get_updates(std::move(updates), Promise<Unit>());
-    if (auth_manager_->is_bot() && auth_manager_->is_authorized()) {
-      set_is_bot_online(true);
-    }
+  if (updates.get_short_update_id() != 0) {
+    return updates_manager_->on_get_short_update(std::move(updates), auth_key_id);
+  }
+
+  auto updates_ptr = updates.get_updates();
+  if (updates_ptr == nullptr) {
+    return updates_manager_->on_failed_to_parse_updates();
   }
+  updates_manager_->on_update_from_auth_key_id(auth_key_id);
+  updates_manager_->on_get_updates(std::move(updates_ptr), Promise<Unit>());
 }
 
 void Td::on_result(NetQueryPtr query) {
@@ -2960,6 +3010,9 @@ void Td::on_result(NetQueryPtr query) {
   if (handler != nullptr) {
     CHECK(query->is_ready());
     if (query->is_ok()) {
+      if (query_result_cache_ != nullptr) {
+        query_result_cache_->add(query->tl_constructor(), query->query().as_slice(), query->ok().as_slice());
+      }
       handler->on_result(query->move_as_ok());
     } else {
       handler->on_error(query->move_as_error());
@@ -3096,6 +3149,7 @@ void Td::dec_actor_refcnt() {
       reset_manager(phone_number_manager_, "PhoneNumberManager");
       reset_manager(poll_manager_, "PollManager");
       reset_manager(privacy_manager_, "PrivacyManager");
+      reset_manager(query_result_cache_, "QueryResultCache");
       reset_manager(quick_reply_manager_, "QuickReplyManager");
       reset_manager(reaction_manager_, "ReactionManager");
       reset_manager(saved_messages_manager_, "SavedMessagesManager");
@@ -3370,7 +3424,7 @@ template <class T>
 void Td::complete_pending_preauthentication_requests(const T &func) {
   for (auto &request : pending_preauthentication_requests_) {
     if (request.second != nullptr && func(request.second->get_id())) {
-      downcast_call(*request.second, [this, id = request.first](auto &request) { this->on_request(id, request); });
+      run_request_handler(request.first, *request.second);
       request.second = nullptr;
     }
   }
@@ -3720,6 +3774,7 @@ void Td::init_non_actor_managers() {
   audios_manager_ = make_unique<AudiosManager>(this);
   callback_queries_manager_ = make_unique<CallbackQueriesManager>(this);
   documents_manager_ = make_unique<DocumentsManager>(this);
+  query_result_cache_ = make_unique<QueryResultCache>();
   videos_manager_ = make_unique<VideosManager>(this);
 }
 
@@ -3966,6 +4021,22 @@ void Td::send_error_raw(uint64 id, int32 code, CSlice error) {
   send_closure(actor_id(this), &Td::send_error_impl, id, make_error(code, error));
 }
 
+bool Td::check_is_user(uint64 id) {
+  if (auth_manager_->is_bot()) {
+    send_error_raw(id, 400, "The method is not available to bots");
+    return false;
+  }
+  return true;
+}
+
+bool Td::check_input_string(uint64 id, string &str) {
+  if (!clean_input_string(str)) {
+    send_error_raw(id, 400, "Strings must be encoded in UTF-8");
+    return false;
+  }
+  return true;
+}
+
 void Td::answer_ok_query(uint64 id, Status status) {
   if (status.is_error()) {
     send_closure(actor_id(this), &Td::send_error, id, std::move(status));
@@ -3984,17 +4055,17 @@ Promise<Unit> Td::create_ok_request_promise(uint64 id) {
   });
 }
 
-#define CLEAN_INPUT_STRING(field_name)                                  \
-  if (!clean_input_string(field_name)) {                                \
-    return send_error_raw(id, 400, "Strings must be encoded in UTF-8"); \
+#define CLEAN_INPUT_STRING(field_name)     \
+  if (!check_input_string(id, field_name)) { \
+    return;                                  \
   }
 #define CHECK_IS_BOT()                                              \
   if (!auth_manager_->is_bot()) {                                   \
     return send_error_raw(id, 400, "Only bots can use the method"); \
   }
-#define CHECK_IS_USER()                                                    \
-  if (auth_manager_->is_bot()) {                                           \
-    return send_error_raw(id, 400, "The method is not available to bots"); \
+#define CHECK_IS_USER()   \
+  if (!check_is_user(id)) { \
+    return;                 \
   }
 
 #define CREATE_NO_ARGS_REQUEST(name)                                       \
@@ -4798,6 +4869,17 @@ void Td::on_request(uint64 id, const td_api::getDatabaseStatistics &request) {
   send_closure(storage_manager_, &StorageManager::get_database_stats, std::move(query_promise));
 }
 
+void Td::on_request(uint64 id, const td_api::getMemoryStatistics &request) {
+  MemoryStatistics statistics;
+  chat_manager_->get_memory_statistics(statistics);
+  file_manager_->get_memory_statistics(statistics);
+  messages_manager_->get_memory_statistics(statistics);
+  query_result_cache_->get_memory_statistics(statistics);
+  stickers_manager_->get_memory_statistics(statistics);
+  user_manager_->get_memory_statistics(statistics);
+  send_result(id, statistics.get_memory_statistics_object());
+}
+
 void Td::on_request(uint64 id, td_api::optimizeStorage &request) {
   std::vector<FileType> file_types;
   for (auto &file_type : request.file_types_) {
@@ -8839,77 +8921,6 @@ void Td::on_request(uint64 id, const td_api::getMapThumbnailFile &request) {
   }
 }
 
-void Td::on_request(uint64 id, const td_api::getLocalizationTargetInfo &request) {
-  CHECK_IS_USER();
-  CREATE_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::get_languages, request.only_local_, std::move(promise));
-}
-
-void Td::on_request(uint64 id, td_api::getLanguagePackInfo &request) {
-  CHECK_IS_USER();
-  CLEAN_INPUT_STRING(request.language_pack_id_);
-  CREATE_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::search_language_info, request.language_pack_id_,
-               std::move(promise));
-}
-
-void Td::on_request(uint64 id, td_api::getLanguagePackStrings &request) {
-  CHECK_IS_USER();
-  CLEAN_INPUT_STRING(request.language_pack_id_);
-  for (auto &key : request.keys_) {
-    CLEAN_INPUT_STRING(key);
-  }
-  CREATE_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::get_language_pack_strings,
-               std::move(request.language_pack_id_), std::move(request.keys_), std::move(promise));
-}
-
-void Td::on_request(uint64 id, td_api::synchronizeLanguagePack &request) {
-  CHECK_IS_USER();
-  CLEAN_INPUT_STRING(request.language_pack_id_);
-  CREATE_OK_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::synchronize_language_pack,
-               std::move(request.language_pack_id_), std::move(promise));
-}
-
-void Td::on_request(uint64 id, td_api::addCustomServerLanguagePack &request) {
-  CHECK_IS_USER();
-  CLEAN_INPUT_STRING(request.language_pack_id_);
-  CREATE_OK_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::add_custom_server_language,
-               std::move(request.language_pack_id_), std::move(promise));
-}
-
-void Td::on_request(uint64 id, td_api::setCustomLanguagePack &request) {
-  CHECK_IS_USER();
-  CREATE_OK_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::set_custom_language, std::move(request.info_),
-               std::move(request.strings_), std::move(promise));
-}
-
-void Td::on_request(uint64 id, td_api::editCustomLanguagePackInfo &request) {
-  CHECK_IS_USER();
-  CREATE_OK_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::edit_custom_language_info, std::move(request.info_),
-               std::move(promise));
-}
-
-void Td::on_request(uint64 id, td_api::setCustomLanguagePackString &request) {
-  CHECK_IS_USER();
-  CLEAN_INPUT_STRING(request.language_pack_id_);
-  CREATE_OK_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::set_custom_language_string,
-               std::move(request.language_pack_id_), std::move(request.new_string_), std::move(promise));
-}
-
-void Td::on_request(uint64 id, td_api::deleteLanguagePack &request) {
-  CHECK_IS_USER();
-  CLEAN_INPUT_STRING(request.language_pack_id_);
-  CREATE_OK_REQUEST_PROMISE();
-  send_closure(language_pack_manager_, &LanguagePackManager::delete_language, std::move(request.language_pack_id_),
-               std::move(promise));
-}
-
 void Td::on_request(uint64 id, td_api::getOption &request) {
   CLEAN_INPUT_STRING(request.name_);
   CREATE_REQUEST_PROMISE();
@@ -9817,6 +9828,10 @@ void Td::on_request(uint64 id, const td_api::addLogMessage &request) {
   UNREACHABLE();
 }
 
+void Td::on_request(uint64 id, const td_api::getMemoryProfile &request) {
+  UNREACHABLE();
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(td_api::searchQuote &request) {
   if (request.text_ == nullptr || request.quote_ == nullptr) {
     return make_error(400, "Text and quote must be non-empty");
@@ -10091,6 +10106,14 @@ td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::addLogMes
   return td_api::make_object<td_api::ok>();
 }
 
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getMemoryProfile &request) {
+  auto *memory_profiler = get_memory_profiler();
+  if (memory_profiler == nullptr) {
+    return make_error(400, "Memory profiler is unavailable");
+  }
+  return td_api::make_object<td_api::text>(memory_profiler->get_heap_profile());
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(td_api::testReturnError &request) {
   if (request.error_ == nullptr) {
     return td_api::make_object<td_api::error>(404, "Not Found");
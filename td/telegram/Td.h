@@ -11,6 +11,7 @@
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/net/NetQueryStats.h"
+#include "td/telegram/RegisteredRequest.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/TdCallback.h"
 #include "td/telegram/TdDb.h"
@@ -32,6 +33,7 @@
 #include "td/utils/Status.h"
 
 #include <memory>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 
@@ -72,6 +74,7 @@ class InlineMessageManager;
 class InlineQueriesManager;
 class HashtagHints;
 class LanguagePackManager;
+class LazyUpdates;
 class LinkManager;
 class MessageImportManager;
 class MessagesManager;
@@ -84,6 +87,7 @@ class PeopleNearbyManager;
 class PhoneNumberManager;
 class PollManager;
 class PrivacyManager;
+class QueryResultCache;
 class QuickReplyManager;
 class ReactionManager;
 class SavedMessagesManager;
@@ -142,7 +146,7 @@ class Td final : public Actor {
 
   void reload_promo_data();
 
-  void on_update(telegram_api::object_ptr<telegram_api::Updates> updates, uint64 auth_key_id);
+  void on_update(LazyUpdates updates, uint64 auth_key_id);
 
   void on_result(NetQueryPtr query);
 
@@ -162,10 +166,43 @@ class Td final : public Actor {
 
   bool ignore_background_updates() const;
 
+  using RequestHandler = void (*)(Td *td, uint64 id, td_api::Function &request);
+
+  // requests of the type T will be handled by the handler instead of Td::on_request
+  template <class T, void (*handler)(Td *td, uint64 id, T &request)>
+  static void register_request_handler() {
+    static_assert(IsRegisteredRequest<T>::value, "IsRegisteredRequest must be specialized for the request");
+    set_request_handler(T::ID, [](Td *td, uint64 id, td_api::Function &request) {
+      handler(td, id, static_cast<T &>(request));
+    });
+  }
+
+  template <class T>
+  Promise<T> create_request_promise(uint64 id) {
+    return PromiseCreator::lambda([actor_id = actor_id(this), id](Result<T> r_state) {
+      if (r_state.is_error()) {
+        send_closure(actor_id, &Td::send_error, id, r_state.move_as_error());
+      } else {
+        send_closure(actor_id, &Td::send_result, id, r_state.move_as_ok());
+      }
+    });
+  }
+
+  Promise<Unit> create_ok_request_promise(uint64 id);
+
+  void send_error_raw(uint64 id, int32 code, CSlice error);
+
+  // checks that the request isn't sent by a bot; otherwise, sends an error for the request
+  bool check_is_user(uint64 id);
+
+  // cleans the string; sends an error for the request if the string isn't encoded in UTF-8
+  bool check_input_string(uint64 id, string &str);
+
   unique_ptr<AudiosManager> audios_manager_;
   unique_ptr<CallbackQueriesManager> callback_queries_manager_;
   unique_ptr<DocumentsManager> documents_manager_;
   unique_ptr<OptionManager> option_manager_;
+  unique_ptr<QueryResultCache> query_result_cache_;
   unique_ptr<VideosManager> videos_manager_;
 
   unique_ptr<AccountManager> account_manager_;
@@ -348,7 +385,6 @@ class Td final : public Actor {
   void send_result(uint64 id, tl_object_ptr<td_api::Object> object);
   void send_error(uint64 id, Status error);
   void send_error_impl(uint64 id, tl_object_ptr<td_api::error> error);
-  void send_error_raw(uint64 id, int32 code, CSlice error);
   void answer_ok_query(uint64 id, Status status);
 
   ActorShared<Td> create_reference();
@@ -455,19 +491,6 @@ class Td final : public Actor {
 
   static int *get_log_verbosity_level(Slice name);
 
-  template <class T>
-  Promise<T> create_request_promise(uint64 id) {
-    return PromiseCreator::lambda([actor_id = actor_id(this), id](Result<T> r_state) {
-      if (r_state.is_error()) {
-        send_closure(actor_id, &Td::send_error, id, r_state.move_as_error());
-      } else {
-        send_closure(actor_id, &Td::send_result, id, r_state.move_as_ok());
-      }
-    });
-  }
-
-  Promise<Unit> create_ok_request_promise(uint64 id);
-
   static bool is_authentication_request(int32 id);
 
   static bool is_synchronous_request(const td_api::Function *function);
@@ -476,6 +499,12 @@ class Td final : public Actor {
 
   static bool is_preauthentication_request(int32 id);
 
+  static void init_request_handlers();
+
+  static void set_request_handler(int32 function_id, RequestHandler handler);
+
+  void run_request_handler(uint64 id, td_api::Function &function);
+
   template <class T>
   void on_request(uint64 id, const T &) = delete;
 
@@ -677,6 +706,8 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::getDatabaseStatistics &request);
 
+  void on_request(uint64 id, const td_api::getMemoryStatistics &request);
+
   void on_request(uint64 id, td_api::optimizeStorage &request);
 
   void on_request(uint64 id, td_api::getNetworkStatistics &request);
@@ -1711,24 +1742,6 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::getMapThumbnailFile &request);
 
-  void on_request(uint64 id, const td_api::getLocalizationTargetInfo &request);
-
-  void on_request(uint64 id, td_api::getLanguagePackInfo &request);
-
-  void on_request(uint64 id, td_api::getLanguagePackStrings &request);
-
-  void on_request(uint64 id, td_api::synchronizeLanguagePack &request);
-
-  void on_request(uint64 id, td_api::addCustomServerLanguagePack &request);
-
-  void on_request(uint64 id, td_api::setCustomLanguagePack &request);
-
-  void on_request(uint64 id, td_api::editCustomLanguagePackInfo &request);
-
-  void on_request(uint64 id, td_api::setCustomLanguagePackString &request);
-
-  void on_request(uint64 id, td_api::deleteLanguagePack &request);
-
   void on_request(uint64 id, td_api::getOption &request);
 
   void on_request(uint64 id, td_api::setOption &request);
@@ -1979,6 +1992,8 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::addLogMessage &request);
 
+  void on_request(uint64 id, const td_api::getMemoryProfile &request);
+
   // test
   void on_request(uint64 id, const td_api::testNetwork &request);
   void on_request(uint64 id, td_api::testProxy &request);
@@ -1994,6 +2009,23 @@ class Td final : public Actor {
   void on_request(uint64 id, td_api::testCallVectorString &request);
   void on_request(uint64 id, td_api::testCallVectorStringObject &request);
 
+  template <class T>
+  static void call_on_request(Td *td, uint64 id, td_api::Function &request) {
+    td->on_request(id, static_cast<T &>(request));
+  }
+
+  // fails to compile for requests, which are neither registered nor have a Td::on_request overload
+  template <class T>
+  static RequestHandler get_default_request_handler(T *request, std::false_type /*is_registered*/) {
+    return &call_on_request<T>;
+  }
+
+  // handlers of registered requests are set in init_request_handlers
+  template <class T>
+  static RequestHandler get_default_request_handler(T *request, std::true_type /*is_registered*/) {
+    return nullptr;
+  }
+
   template <class T>
   static td_api::object_ptr<td_api::Object> do_static_request(const T &request) {
     return td_api::make_object<td_api::error>(400, "The method can't be executed synchronously");
@@ -2025,6 +2057,7 @@ class Td final : public Actor {
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setLogTagVerbosityLevel &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogTagVerbosityLevel &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::addLogMessage &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getMemoryProfile &request);
   static td_api::object_ptr<td_api::Object> do_static_request(td_api::testReturnError &request);
 
   static DbKey as_db_key(string key);
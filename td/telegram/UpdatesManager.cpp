@@ -45,6 +45,7 @@
 #include "td/telegram/misc.h"
 #include "td/telegram/net/DcOptions.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/NotificationManager.h"
 #include "td/telegram/NotificationSettingsManager.h"
 #include "td/telegram/NotificationSettingsScope.h"
@@ -55,6 +56,7 @@
 #include "td/telegram/PollManager.h"
 #include "td/telegram/PrivacyManager.h"
 #include "td/telegram/PublicDialogType.h"
+#include "td/telegram/QueryResultCache.h"
 #include "td/telegram/QuickReplyManager.h"
 #include "td/telegram/QuickReplyShortcutId.h"
 #include "td/telegram/ReactionListType.h"
@@ -101,6 +103,7 @@
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/Time.h"
+#include "td/utils/tl_parsers.h"
 
 #include <limits>
 
@@ -1133,6 +1136,43 @@ bool UpdatesManager::is_acceptable_update(const telegram_api::Update *update) co
   return true;
 }
 
+bool UpdatesManager::is_ignored_short_update(int32 update_id) const {
+  if (!td_->auth_manager_->is_authorized()) {
+    switch (update_id) {
+      case telegram_api::updateLoginToken::ID:
+      case telegram_api::updateServiceNotification::ID:
+      case telegram_api::updateDcOptions::ID:
+      case telegram_api::updateConfig::ID:
+      case telegram_api::updateLangPackTooLong::ID:
+      case telegram_api::updateLangPack::ID:
+        return false;
+      default:
+        return true;
+    }
+  }
+  switch (update_id) {
+    case telegram_api::updateLoginToken::ID:
+    case telegram_api::updateNewStoryReaction::ID:
+      // the updates have no effect after authorization
+      return true;
+    default:
+      break;
+  }
+  if (td_->auth_manager_->is_bot()) {
+    switch (update_id) {
+      case telegram_api::updateUserTyping::ID:
+      case telegram_api::updateChatUserTyping::ID:
+      case telegram_api::updateChannelUserTyping::ID:
+      case telegram_api::updateEncryptedChatTyping::ID:
+      case telegram_api::updateUserStatus::ID:
+        return true;
+      default:
+        return false;
+    }
+  }
+  return false;
+}
+
 int32 UpdatesManager::fix_short_message_flags(int32 flags) {
   static constexpr int32 MESSAGE_FLAG_HAS_REPLY_MARKUP = 1 << 6;
   static constexpr int32 MESSAGE_FLAG_HAS_MEDIA = 1 << 9;
@@ -1152,6 +1192,37 @@ void UpdatesManager::on_get_updates(tl_object_ptr<telegram_api::Updates> &&updat
   send_closure_later(actor_id(this), &UpdatesManager::on_get_updates_impl, std::move(updates_ptr), std::move(promise));
 }
 
+void UpdatesManager::on_get_short_update(LazyUpdates &&updates, uint64 auth_key_id) {
+  CHECK(updates.get_short_update_id() != 0);
+  // authorization state can change before the update is processed, so it must be checked at the same place as before
+  send_closure_later(actor_id(this), &UpdatesManager::on_get_short_update_impl, std::move(updates), auth_key_id);
+}
+
+void UpdatesManager::on_get_short_update_impl(LazyUpdates updates, uint64 auth_key_id) {
+  auto short_update_id = updates.get_short_update_id();
+  if (is_ignored_short_update(short_update_id)) {
+    // the update has a known constructor and would have been parsed before, so it is still counted as received
+    LOG(DEBUG) << "Ignore short update " << short_update_id << " without parsing";
+    return on_update_from_auth_key_id(auth_key_id);
+  }
+
+  auto updates_ptr = updates.get_updates();
+  if (updates_ptr == nullptr) {
+    return on_failed_to_parse_updates();
+  }
+  on_update_from_auth_key_id(auth_key_id);
+  on_get_updates_impl(std::move(updates_ptr), Promise<Unit>());
+}
+
+void UpdatesManager::on_failed_to_parse_updates() {
+  if (td_->auth_manager_->is_bot()) {
+    G()->net_query_dispatcher().update_mtproto_header();
+  } else {
+    // this could be a min-channel update
+    schedule_get_difference("failed to fetch updates");
+  }
+}
+
 void UpdatesManager::on_get_updates_impl(tl_object_ptr<telegram_api::Updates> updates_ptr, Promise<Unit> promise) {
   CHECK(updates_ptr != nullptr);
   promise = PromiseCreator::lambda(
@@ -1757,6 +1828,9 @@ uint64 UpdatesManager::get_most_unused_auth_key_id() {
 }
 
 void UpdatesManager::on_update_from_auth_key_id(uint64 auth_key_id) {
+  if (td_->auth_manager_->is_bot() && td_->auth_manager_->is_authorized()) {
+    td_->set_is_bot_online(true);
+  }
   if (auth_key_id == 0) {
     return;
   }
@@ -3729,7 +3803,51 @@ void UpdatesManager::on_update(tl_object_ptr<telegram_api::updatePeerLocated> up
   promise.set_value(Unit());
 }
 
+int64 UpdatesManager::get_web_page_preview_web_page_id(Slice result) {
+  TlParser parser(result);
+  if (parser.fetch_int() != telegram_api::messageMediaWebPage::ID) {
+    return 0;
+  }
+  parser.fetch_int();  // flags
+  switch (parser.fetch_int()) {
+    case telegram_api::webPageEmpty::ID:
+    case telegram_api::webPagePending::ID:
+    case telegram_api::webPage::ID: {
+      parser.fetch_int();  // flags
+      auto web_page_id = parser.fetch_long();
+      return parser.get_error() == nullptr ? web_page_id : 0;
+    }
+    default:
+      return 0;
+  }
+}
+
+void UpdatesManager::invalidate_web_page_preview_cache(const telegram_api::WebPage *web_page) {
+  int64 web_page_id = 0;
+  switch (web_page == nullptr ? 0 : web_page->get_id()) {
+    case telegram_api::webPageEmpty::ID:
+      web_page_id = static_cast<const telegram_api::webPageEmpty *>(web_page)->id_;
+      break;
+    case telegram_api::webPagePending::ID:
+      web_page_id = static_cast<const telegram_api::webPagePending *>(web_page)->id_;
+      break;
+    case telegram_api::webPage::ID:
+      web_page_id = static_cast<const telegram_api::webPage *>(web_page)->id_;
+      break;
+    default:
+      break;
+  }
+  if (web_page_id == 0) {
+    // the changed web page is unknown
+    return td_->query_result_cache_->invalidate(telegram_api::messages_getWebPagePreview::ID);
+  }
+  td_->query_result_cache_->invalidate(telegram_api::messages_getWebPagePreview::ID, [web_page_id](Slice result) {
+    return get_web_page_preview_web_page_id(result) == web_page_id;
+  });
+}
+
 void UpdatesManager::on_update(tl_object_ptr<telegram_api::updateWebPage> update, Promise<Unit> &&promise) {
+  invalidate_web_page_preview_cache(update->webpage_.get());
   td_->web_pages_manager_->on_get_web_page(std::move(update->webpage_), DialogId());
   add_pending_pts_update(make_tl_object<dummyUpdate>(), update->pts_, update->pts_count_, Time::now(), Promise<Unit>(),
                          "updateWebPage");
@@ -3737,6 +3855,7 @@ void UpdatesManager::on_update(tl_object_ptr<telegram_api::updateWebPage> update
 }
 
 void UpdatesManager::on_update(tl_object_ptr<telegram_api::updateChannelWebPage> update, Promise<Unit> &&promise) {
+  invalidate_web_page_preview_cache(update->webpage_.get());
   td_->web_pages_manager_->on_get_web_page(std::move(update->webpage_), DialogId());
   DialogId dialog_id(ChannelId(update->channel_id_));
   td_->messages_manager_->add_pending_channel_update(dialog_id, make_tl_object<dummyUpdate>(), update->pts_,
@@ -10,6 +10,7 @@
 #include "td/telegram/ChatId.h"
 #include "td/telegram/DialogId.h"
 #include "td/telegram/InputGroupCallId.h"
+#include "td/telegram/LazyUpdates.h"
 #include "td/telegram/MessageFullId.h"
 #include "td/telegram/MessageId.h"
 #include "td/telegram/PtsManager.h"
@@ -99,6 +100,11 @@ class UpdatesManager final : public Actor {
 
   void on_get_updates(tl_object_ptr<telegram_api::Updates> &&updates_ptr, Promise<Unit> &&promise);
 
+  // updateShort is parsed only if it isn't ignored after all previously received updates are processed
+  void on_get_short_update(LazyUpdates &&updates, uint64 auth_key_id);
+
+  void on_failed_to_parse_updates();
+
   void add_pending_pts_update(tl_object_ptr<telegram_api::Update> &&update, int32 new_pts, int32 pts_count,
                               double receive_time, Promise<Unit> &&promise, const char *source);
 
@@ -127,6 +133,7 @@ class UpdatesManager final : public Actor {
 
   void schedule_get_difference(const char *source);
 
+  // must be called only for successfully parsed updates
   void on_update_from_auth_key_id(uint64 auth_key_id);
 
   void ping_server();
@@ -331,6 +338,11 @@ class UpdatesManager final : public Actor {
 
   void on_get_updates_impl(tl_object_ptr<telegram_api::Updates> updates_ptr, Promise<Unit> promise);
 
+  void on_get_short_update_impl(LazyUpdates updates, uint64 auth_key_id);
+
+  // returns true, if updateShort with an update of the given type would be ignored, so it doesn't need to be parsed
+  bool is_ignored_short_update(int32 update_id) const;
+
   void on_server_pong(tl_object_ptr<telegram_api::updates_state> &&state);
 
   void on_get_difference(tl_object_ptr<telegram_api::updates_Difference> &&difference_ptr);
@@ -468,6 +480,11 @@ class UpdatesManager final : public Actor {
 
   static int32 fix_short_message_flags(int32 flags);
 
+  // returns 0 if the cached result of messages.getWebPagePreview has no web page identifier
+  static int64 get_web_page_preview_web_page_id(Slice result);
+
+  void invalidate_web_page_preview_cache(const telegram_api::WebPage *web_page);
+
   void on_update(tl_object_ptr<telegram_api::updateNewMessage> update, Promise<Unit> &&promise);
   void on_update(tl_object_ptr<telegram_api::updateMessageID> update, Promise<Unit> &&promise);
   void on_update(tl_object_ptr<telegram_api::updateReadMessagesContents> update, Promise<Unit> &&promise);
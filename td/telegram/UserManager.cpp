@@ -37,6 +37,7 @@
 #include "td/telegram/LinkManager.h"
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/logevent/LogEventHelper.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessageId.h"
 #include "td/telegram/MessagesManager.h"
 #include "td/telegram/MessageTtl.h"
@@ -100,7 +101,7 @@ class GetContactsQuery final : public Td::ResultHandler {
   }
 
   void on_result(BufferSlice packet) final {
-    auto result_ptr = fetch_result<telegram_api::contacts_getContacts>(packet);
+    auto result_ptr = fetch_result<telegram_api::contacts_getContacts>(packet, true);
     if (result_ptr.is_error()) {
       return on_error(result_ptr.move_as_error());
     }
@@ -2023,6 +2024,8 @@ UserManager::UserManager(Td *td, ActorShared<> parent) : td_(td), parent_(std::m
   user_emoji_status_timeout_.set_callback(on_user_emoji_status_timeout_callback);
   user_emoji_status_timeout_.set_callback_data(static_cast<void *>(this));
 
+  save_user_merger_.set_save_function([this](vector<int64> user_ids) { save_users(std::move(user_ids)); });
+
   get_user_queries_.set_merge_function([this](vector<int64> query_ids, Promise<Unit> &&promise) {
     TRY_STATUS_PROMISE(promise, G()->close_status());
     auto input_users = transform(query_ids, [this](int64 query_id) { return get_input_user_force(UserId(query_id)); });
@@ -3607,6 +3610,23 @@ void UserManager::save_user(User *u, UserId user_id, bool from_binlog) {
       } else {
         binlog_rewrite(G()->td_db()->get_binlog(), u->log_event_id, LogEvent::HandlerType::Users, storer);
       }
+
+      // the user is already saved to the binlog, so saves of the same user to the database can be merged
+      save_user_merger_.add_object(user_id.get());
+      return;
+    }
+
+    save_user_to_database(u, user_id);
+  }
+}
+
+void UserManager::save_users(vector<int64> user_ids) {
+  for (auto user_id_int : user_ids) {
+    UserId user_id(user_id_int);
+    User *u = get_user(user_id);
+    CHECK(u != nullptr);
+    if (u->is_saved && u->is_status_saved) {
+      continue;
     }
 
     save_user_to_database(u, user_id);
@@ -3700,10 +3720,36 @@ void UserManager::load_user_from_database_impl(UserId user_id, Promise<Unit> pro
   auto &load_user_queries = load_user_from_database_queries_[user_id];
   load_user_queries.push_back(std::move(promise));
   if (load_user_queries.size() == 1u) {
-    G()->td_db()->get_sqlite_pmc()->get(get_user_database_key(user_id), PromiseCreator::lambda([user_id](string value) {
-                                          send_closure(G()->user_manager(), &UserManager::on_load_user_from_database,
-                                                       user_id, std::move(value), false);
-                                        }));
+    if (load_user_from_database_user_ids_.empty()) {
+      // all users requested before the closure is processed will be loaded using a single database request
+      send_closure_later(actor_id(this), &UserManager::load_users_from_database);
+    }
+    load_user_from_database_user_ids_.push_back(user_id);
+  }
+}
+
+void UserManager::load_users_from_database() {
+  auto user_ids = std::move(load_user_from_database_user_ids_);
+  load_user_from_database_user_ids_.clear();
+  if (user_ids.empty()) {
+    return;
+  }
+  LOG(INFO) << "Load " << user_ids.size() << " users from database";
+  auto keys = transform(user_ids, get_user_database_key);
+  G()->td_db()->get_sqlite_pmc()->get_batch(
+      std::move(keys), PromiseCreator::lambda([user_ids = std::move(user_ids)](vector<string> values) mutable {
+        send_closure(G()->user_manager(), &UserManager::on_load_users_from_database, std::move(user_ids),
+                     std::move(values));
+      }));
+}
+
+void UserManager::on_load_users_from_database(vector<UserId> user_ids, vector<string> values) {
+  if (G()->close_flag()) {
+    return;
+  }
+  CHECK(user_ids.size() == values.size());
+  for (size_t i = 0; i < user_ids.size(); i++) {
+    on_load_user_from_database(user_ids[i], std::move(values[i]), false);
   }
 }
 
@@ -8079,4 +8125,11 @@ void UserManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &
   }
 }
 
+void UserManager::get_memory_statistics(MemoryStatistics &statistics) const {
+  statistics.add("UserManager", "users", users_);
+  statistics.add("UserManager", "users_full", users_full_);
+  statistics.add("UserManager", "user_photos", user_photos_);
+  statistics.add("UserManager", "secret_chats", secret_chats_);
+}
+
 }  // namespace td
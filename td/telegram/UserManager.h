@@ -27,6 +27,7 @@
 #include "td/telegram/QueryCombiner.h"
 #include "td/telegram/QueryMerger.h"
 #include "td/telegram/RestrictionReason.h"
+#include "td/telegram/SaveMerger.h"
 #include "td/telegram/SecretChatId.h"
 #include "td/telegram/StoryId.h"
 #include "td/telegram/td_api.h"
@@ -62,6 +63,7 @@ class BusinessGreetingMessage;
 class BusinessInfo;
 class BusinessIntro;
 class BusinessWorkHours;
+class MemoryStatistics;
 class Td;
 
 class UserManager final : public Actor {
@@ -467,6 +469,8 @@ class UserManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void get_memory_statistics(MemoryStatistics &statistics) const;
+
  private:
   struct User {
     string first_name;
@@ -679,6 +683,8 @@ class UserManager final : public Actor {
 
   static constexpr int32 MAX_ACTIVE_STORY_ID_RELOAD_TIME = 3600;  // some reasonable limit
 
+  static constexpr double MAX_SAVE_USER_DELAY = 1.0;  // seconds
+
   // the True fields aren't set for manually created telegram_api::user objects, therefore the flags must be used
   static constexpr int32 USER_FLAG_HAS_ACCESS_HASH = 1 << 0;
   static constexpr int32 USER_FLAG_HAS_FIRST_NAME = 1 << 1;
@@ -739,6 +745,8 @@ class UserManager final : public Actor {
 
   void save_user(User *u, UserId user_id, bool from_binlog);
 
+  void save_users(vector<int64> user_ids);
+
   static string get_user_database_key(UserId user_id);
 
   static string get_user_database_value(const User *u);
@@ -753,6 +761,10 @@ class UserManager final : public Actor {
 
   void load_user_from_database_impl(UserId user_id, Promise<Unit> promise);
 
+  void load_users_from_database();
+
+  void on_load_users_from_database(vector<UserId> user_ids, vector<string> values);
+
   void on_load_user_from_database(UserId user_id, string value, bool force);
 
   User *get_user_force(UserId user_id, const char *source);
@@ -1028,6 +1040,7 @@ class UserManager final : public Actor {
   FlatHashMap<UserId, vector<SecretChatId>, UserIdHash> secret_chats_with_user_;
 
   FlatHashMap<UserId, vector<Promise<Unit>>, UserIdHash> load_user_from_database_queries_;
+  vector<UserId> load_user_from_database_user_ids_;
   FlatHashSet<UserId, UserIdHash> loaded_from_database_users_;
   FlatHashSet<UserId, UserIdHash> unavailable_user_fulls_;
 
@@ -1038,6 +1051,8 @@ class UserManager final : public Actor {
 
   QueryMerger get_is_premium_required_to_contact_queries_{"GetIsPremiumRequiredToContactMerger", 3, 100};
 
+  SaveMerger save_user_merger_{"SaveUserMerger", MAX_SAVE_USER_DELAY};
+
   QueryCombiner get_user_full_queries_{"GetUserFullCombiner", 2.0};
   class UploadProfilePhotoCallback;
   std::shared_ptr<UploadProfilePhotoCallback> upload_profile_photo_callback_;
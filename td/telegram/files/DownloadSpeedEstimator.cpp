@@ -0,0 +1,75 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/DownloadSpeedEstimator.h"
+
+#include "td/utils/format.h"
+#include "td/utils/misc.h"
+
+namespace td {
+
+void DownloadSpeedEstimator::on_part_downloaded(int64 size, double elapsed_time, double now) {
+  if (size <= 0 || elapsed_time <= 0.0) {
+    return;
+  }
+
+  if (last_part_time_ == 0.0 || now - last_part_time_ > MAX_SAMPLE_GAP) {
+    // the link was idle, so start a new sample at the beginning of the current part download
+    // the part wasn't queued behind other parts, so its download time is the best available round-trip time estimate
+    min_rtt_ = elapsed_time;
+    sample_start_time_ = now - elapsed_time;
+    sample_size_ = 0;
+  } else {
+    // all other downloads include time spent in queues and time needed to transfer the part,
+    // so the smallest observed part download time is the closest to the actual round-trip time
+    min_rtt_ = min(min_rtt_, elapsed_time);
+  }
+  last_part_time_ = now;
+  sample_size_ += size;
+
+  auto sample_duration = now - sample_start_time_;
+  if (sample_duration >= SPEED_SAMPLE_PERIOD) {
+    auto sample_speed = static_cast<double>(sample_size_) / sample_duration;
+    speed_ = speed_ == 0.0 ? sample_speed : 0.7 * speed_ + 0.3 * sample_speed;
+    sample_start_time_ = now;
+    sample_size_ = 0;
+  }
+}
+
+int64 DownloadSpeedEstimator::get_bandwidth_delay_product() const {
+  return static_cast<int64>(speed_ * min_rtt_);
+}
+
+size_t DownloadSpeedEstimator::get_preferred_part_size() const {
+  if (!has_estimate()) {
+    return 0;
+  }
+
+  // keep several parts in flight per round trip, but make each of them as large as possible
+  // to reduce per-request overhead on fast links with high latency
+  auto target_size = get_bandwidth_delay_product() / PARTS_PER_RTT;
+  size_t part_size = MIN_PART_SIZE;
+  while (part_size < MAX_PART_SIZE && static_cast<int64>(part_size) < target_size) {
+    part_size *= 2;
+  }
+  return part_size;
+}
+
+int64 DownloadSpeedEstimator::get_resource_limit(int64 min_limit, int64 max_limit) const {
+  if (!has_estimate()) {
+    return min_limit;
+  }
+
+  // twice the bandwidth-delay product is enough to saturate the link even if some parts are delayed
+  return clamp(2 * get_bandwidth_delay_product(), min_limit, max_limit);
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const DownloadSpeedEstimator &estimator) {
+  return string_builder << "DownloadSpeed[" << tag("rtt", estimator.min_rtt_) << tag("speed", estimator.speed_)
+                        << ']';
+}
+
+}  // namespace td
@@ -0,0 +1,61 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/StringBuilder.h"
+
+namespace td {
+
+// estimates round-trip time and throughput of file part downloads from a DC
+// and derives part size and total size of simultaneously downloaded parts from their product
+class DownloadSpeedEstimator {
+ public:
+  static constexpr size_t MIN_PART_SIZE = 64 << 10;
+  static constexpr size_t MAX_PART_SIZE = 512 << 10;
+
+  void on_part_downloaded(int64 size, double elapsed_time, double now);
+
+  bool has_estimate() const {
+    return speed_ > 0.0;
+  }
+
+  // seconds
+  double get_rtt() const {
+    return min_rtt_;
+  }
+
+  // bytes per second
+  double get_speed() const {
+    return speed_;
+  }
+
+  int64 get_bandwidth_delay_product() const;
+
+  // returns 0 if there is no estimate yet
+  size_t get_preferred_part_size() const;
+
+  int64 get_resource_limit(int64 min_limit, int64 max_limit) const;
+
+ private:
+  static constexpr double SPEED_SAMPLE_PERIOD = 0.5;  // seconds
+  static constexpr double MAX_SAMPLE_GAP = 2.0;       // seconds
+  static constexpr int32 PARTS_PER_RTT = 4;
+
+  double min_rtt_ = 0.0;
+
+  double speed_ = 0.0;
+  double sample_start_time_ = 0.0;
+  double last_part_time_ = 0.0;
+  int64 sample_size_ = 0;
+
+  friend StringBuilder &operator<<(StringBuilder &string_builder, const DownloadSpeedEstimator &estimator);
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const DownloadSpeedEstimator &estimator);
+
+}  // namespace td
@@ -16,6 +16,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 
 namespace td {
 
@@ -36,11 +37,21 @@ ActorOwn<ResourceManager> &FileDownloadManager::get_download_resource_manager(bo
   if (actor.empty()) {
     actor = create_actor<ResourceManager>(
         PSLICE() << "DownloadResourceManager " << tag("is_small", is_small) << tag("dc_id", dc_id),
-        max_download_resource_limit_, ResourceManager::Mode::Baseline);
+        get_download_resource_limit(is_small, dc_id), ResourceManager::Mode::Baseline);
   }
   return actor;
 }
 
+int64 FileDownloadManager::get_download_resource_limit(bool is_small, DcId dc_id) const {
+  if (!is_small) {
+    auto it = dc_download_speeds_.find(dc_id);
+    if (it != dc_download_speeds_.end() && it->second.resource_limit_ != 0) {
+      return it->second.resource_limit_;
+    }
+  }
+  return max_download_resource_limit_;
+}
+
 void FileDownloadManager::download(QueryId query_id, const FullRemoteFileLocation &remote_location,
                                    const LocalFileLocation &local, int64 size, string name,
                                    const FileEncryptionKey &encryption_key, bool need_search_file, int64 offset,
@@ -54,10 +65,19 @@ void FileDownloadManager::download(QueryId query_id, const FullRemoteFileLocatio
   node->query_id_ = query_id;
   auto callback = make_unique<FileDownloaderCallback>(actor_shared(this, node_id));
   bool is_small = size < 20 * 1024;
-  node->downloader_ =
-      create_actor<FileDownloader>("Downloader", remote_location, local, size, std::move(name), encryption_key,
-                                   is_small, need_search_file, offset, limit, std::move(callback));
   DcId dc_id = remote_location.is_web() ? G()->get_webfile_dc_id() : remote_location.get_dc_id();
+  node->dc_id_ = dc_id;
+  node->is_small_ = is_small;
+  size_t preferred_part_size = 0;
+  if (!is_small) {
+    auto it = dc_download_speeds_.find(dc_id);
+    if (it != dc_download_speeds_.end()) {
+      preferred_part_size = it->second.estimator_.get_preferred_part_size();
+    }
+  }
+  node->downloader_ = create_actor<FileDownloader>("Downloader", remote_location, local, size, std::move(name),
+                                                   encryption_key, is_small, need_search_file, offset, limit,
+                                                   preferred_part_size, std::move(callback));
   auto &resource_manager = get_download_resource_manager(is_small, dc_id);
   send_closure(resource_manager, &ResourceManager::register_worker,
                ActorShared<FileLoaderActor>(node->downloader_.get(), static_cast<uint64>(-1)), priority);
@@ -118,7 +138,8 @@ void FileDownloadManager::update_downloaded_part(QueryId query_id, int64 offset,
   if (node == nullptr || node->downloader_.empty()) {
     return;
   }
-  send_closure(node->downloader_, &FileDownloader::update_downloaded_part, offset, limit, max_download_resource_limit_);
+  send_closure(node->downloader_, &FileDownloader::update_downloaded_part, offset, limit,
+               get_download_resource_limit(node->is_small_, node->dc_id_));
 }
 
 void FileDownloadManager::hangup() {
@@ -152,6 +173,26 @@ void FileDownloadManager::on_partial_download(PartialLocalFileLocation partial_l
   }
 }
 
+void FileDownloadManager::on_part_downloaded(int64 size, double elapsed_time) {
+  auto node_id = get_link_token();
+  auto node = nodes_container_.get(node_id);
+  if (node == nullptr || node->is_small_ || stop_flag_) {
+    return;
+  }
+
+  auto &download_speed = dc_download_speeds_[node->dc_id_];
+  download_speed.estimator_.on_part_downloaded(size, elapsed_time, Time::now());
+  auto resource_limit = download_speed.estimator_.get_resource_limit(
+      max_download_resource_limit_, max_download_resource_limit_ * MAX_RESOURCE_LIMIT_MULTIPLIER);
+  if (resource_limit != get_download_resource_limit(false, node->dc_id_)) {
+    LOG(INFO) << "Change download resource limit for " << node->dc_id_ << " to " << resource_limit << " with "
+              << download_speed.estimator_;
+    download_speed.resource_limit_ = resource_limit;
+    send_closure(get_download_resource_manager(false, node->dc_id_), &ResourceManager::update_max_resource_limit,
+                 resource_limit);
+  }
+}
+
 void FileDownloadManager::on_ok_download(FullLocalFileLocation local, int64 size, bool is_new) {
   auto node_id = get_link_token();
   auto node = nodes_container_.get(node_id);
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/telegram/files/DownloadSpeedEstimator.h"
 #include "td/telegram/files/FileDownloader.h"
 #include "td/telegram/files/FileEncryptionKey.h"
 #include "td/telegram/files/FileFromBytes.h"
@@ -56,11 +57,18 @@ class FileDownloadManager final : public Actor {
  private:
   struct Node {
     QueryId query_id_;
+    DcId dc_id_;
+    bool is_small_ = false;
     ActorOwn<FileDownloader> downloader_;
     ActorOwn<FileFromBytes> from_bytes_;
   };
   using NodeId = uint64;
 
+  struct DcDownloadSpeed {
+    DownloadSpeedEstimator estimator_;
+    int64 resource_limit_ = 0;
+  };
+
   std::map<DcId, ActorOwn<ResourceManager>> download_resource_manager_map_;
   std::map<DcId, ActorOwn<ResourceManager>> download_small_resource_manager_map_;
 
@@ -68,6 +76,9 @@ class FileDownloadManager final : public Actor {
   unique_ptr<Callback> callback_;
   ActorShared<> parent_;
   std::map<QueryId, NodeId> query_id_to_node_id_;
+  std::map<DcId, DcDownloadSpeed> dc_download_speeds_;
+  static constexpr int64 MAX_RESOURCE_LIMIT_MULTIPLIER = 4;
+
   int64 max_download_resource_limit_ = 1 << 21;
   bool stop_flag_ = false;
 
@@ -81,8 +92,11 @@ class FileDownloadManager final : public Actor {
 
   ActorOwn<ResourceManager> &get_download_resource_manager(bool is_small, DcId dc_id);
 
+  int64 get_download_resource_limit(bool is_small, DcId dc_id) const;
+
   void on_start_download();
   void on_partial_download(PartialLocalFileLocation partial_local, int64 ready_size, int64 size);
+  void on_part_downloaded(int64 size, double elapsed_time);
   void on_ok_download(FullLocalFileLocation local, int64 size, bool is_new);
   void on_error(Status status);
   void on_error_impl(NodeId node_id, Status status);
@@ -101,6 +115,9 @@ class FileDownloadManager final : public Actor {
     void on_partial_download(PartialLocalFileLocation partial_local, int64 ready_size, int64 size) final {
       send_closure(actor_id_, &FileDownloadManager::on_partial_download, std::move(partial_local), ready_size, size);
     }
+    void on_part_downloaded(int64 size, double elapsed_time) final {
+      send_closure(actor_id_, &FileDownloadManager::on_part_downloaded, size, elapsed_time);
+    }
     void on_ok(FullLocalFileLocation full_local, int64 size, bool is_new) final {
       send_closure(std::move(actor_id_), &FileDownloadManager::on_ok_download, std::move(full_local), size, is_new);
     }
@@ -26,6 +26,7 @@
 #include "td/utils/port/Stat.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/UInt.h"
 
 #include <tuple>
@@ -34,7 +35,8 @@ namespace td {
 
 FileDownloader::FileDownloader(const FullRemoteFileLocation &remote, const LocalFileLocation &local, int64 size,
                                string name, const FileEncryptionKey &encryption_key, bool is_small,
-                               bool need_search_file, int64 offset, int64 limit, unique_ptr<Callback> callback)
+                               bool need_search_file, int64 offset, int64 limit, size_t preferred_part_size,
+                               unique_ptr<Callback> callback)
     : remote_(remote)
     , local_(local)
     , size_(size)
@@ -45,7 +47,8 @@ FileDownloader::FileDownloader(const FullRemoteFileLocation &remote, const Local
     , need_search_file_(need_search_file)
     , ordered_flag_(encryption_key_.is_secret())
     , offset_(offset)
-    , limit_(limit) {
+    , limit_(limit)
+    , preferred_part_size_(preferred_part_size) {
   if (!encryption_key.empty()) {
     CHECK(offset_ == 0);
   }
@@ -465,9 +468,11 @@ void FileDownloader::update_downloaded_part(int64 offset, int64 limit, int64 max
     auto end_part_id = begin_part_id + td::min(max_parts, new_end_part_id - begin_part_id);
     VLOG(file_loader) << "Protect parts " << begin_part_id << " ... " << end_part_id - 1;
     for (auto &it : part_map_) {
-      if (!it.second.second.empty() && !(begin_part_id <= it.second.first.id && it.second.first.id < end_part_id)) {
-        VLOG(file_loader) << "Cancel part " << it.second.first.id;
-        it.second.second.reset();  // cancel_query(it.second.second);
+      auto &part_query = it.second;
+      if (!part_query.cancel_slot.empty() &&
+          !(begin_part_id <= part_query.part.id && part_query.part.id < end_part_id)) {
+        VLOG(file_loader) << "Cancel part " << part_query.part.id;
+        part_query.cancel_slot.reset();  // cancel_query(part_query.cancel_slot);
       }
     }
   } else {
@@ -527,6 +532,9 @@ void FileDownloader::start_up() {
   try_release_fd();
 
   auto ready_parts = bitmask.as_vector();
+  if (!is_small_ && !remote_.is_web()) {
+    parts_manager_.set_preferred_part_size(preferred_part_size_);
+  }
   auto status = parts_manager_.init(size_, size_, true, part_size, ready_parts, false, false);
   LOG(DEBUG) << "Start downloading a file of size " << size_ << ", part size " << part_size << " and "
              << ready_parts.size() << " ready parts: " << status;
@@ -614,13 +622,17 @@ Status FileDownloader::do_loop() {
 
     TRY_RESULT(query, start_part(part, parts_manager_.get_part_count(), parts_manager_.get_streaming_offset()));
     uint64 unique_id = UniqueId::next();
-    part_map_[unique_id] = std::make_pair(part, query->cancel_slot_.get_signal_new());
+    auto &part_query = part_map_[unique_id];
+    part_query.part = part;
+    part_query.cancel_slot = query->cancel_slot_.get_signal_new();
+    part_query.start_time = Time::now();
 
     auto callback = actor_shared(this, unique_id);
     if (delay_dispatcher_.empty()) {
       G()->net_query_dispatcher().dispatch_with_callback(std::move(query), std::move(callback));
     } else {
       query->debug("sent to DelayDispatcher");
+      part_query.start_time += next_delay_;
       send_closure(delay_dispatcher_, &DelayDispatcher::send_with_callback_and_delay, std::move(query),
                    std::move(callback), next_delay_);
       next_delay_ = max(next_delay_ * 0.8, 0.003);
@@ -631,7 +643,7 @@ Status FileDownloader::do_loop() {
 
 void FileDownloader::tear_down() {
   for (auto &it : part_map_) {
-    it.second.second.reset();  // cancel_query(it.second.second);
+    it.second.cancel_slot.reset();  // cancel_query(it.second.cancel_slot);
   }
   ordered_parts_.clear([](auto &&part) { part.second->clear(); });
   if (!delay_dispatcher_.empty()) {
@@ -673,8 +685,9 @@ void FileDownloader::on_result(NetQueryPtr query) {
     return;
   }
 
-  Part part = it->second.first;
-  it->second.second.release();
+  Part part = it->second.part;
+  auto start_time = it->second.start_time;
+  it->second.cancel_slot.release();
   CHECK(query->is_ready());
   part_map_.erase(it);
 
@@ -690,6 +703,9 @@ void FileDownloader::on_result(NetQueryPtr query) {
       parts_manager_.on_part_failed(part.id);
     } else {
       next = true;
+      if (query->is_ok()) {
+        callback_->on_part_downloaded(static_cast<int64>(query->ok().size()), Time::now() - start_time);
+      }
     }
     return Status::OK();
   }();
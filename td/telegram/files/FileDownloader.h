@@ -39,6 +39,7 @@ class FileDownloader final : public FileLoaderActor {
     Callback &operator=(const Callback &) = delete;
     virtual void on_start_download() = 0;
     virtual void on_partial_download(PartialLocalFileLocation partial_local, int64 ready_size, int64 size) = 0;
+    virtual void on_part_downloaded(int64 size, double elapsed_time) = 0;
     virtual void on_ok(FullLocalFileLocation full_local, int64 size, bool is_new) = 0;
     virtual void on_error(Status status) = 0;
     virtual ~Callback() = default;
@@ -46,7 +47,7 @@ class FileDownloader final : public FileLoaderActor {
 
   FileDownloader(const FullRemoteFileLocation &remote, const LocalFileLocation &local, int64 size, string name,
                  const FileEncryptionKey &encryption_key, bool is_small, bool need_search_file, int64 offset,
-                 int64 limit, unique_ptr<Callback> callback);
+                 int64 limit, size_t preferred_part_size, unique_ptr<Callback> callback);
 
   void update_downloaded_part(int64 offset, int64 limit, int64 max_resource_limit);
 
@@ -73,6 +74,7 @@ class FileDownloader final : public FileLoaderActor {
   bool keep_fd_ = false;
   int64 offset_ = 0;
   int64 limit_ = 0;
+  size_t preferred_part_size_ = 0;
 
   bool use_cdn_ = false;
   DcId cdn_dc_id_;
@@ -100,7 +102,12 @@ class FileDownloader final : public FileLoaderActor {
   ActorShared<ResourceManager> resource_manager_;
   ResourceState resource_state_;
   PartsManager parts_manager_;
-  std::map<uint64, std::pair<Part, ActorShared<>>> part_map_;
+  struct PartQuery {
+    Part part;
+    ActorShared<> cancel_slot;
+    double start_time = 0.0;
+  };
+  std::map<uint64, PartQuery> part_map_;
   OrderedEventsProcessor<std::pair<Part, NetQueryPtr>> ordered_parts_;
   ActorOwn<DelayDispatcher> delay_dispatcher_;
   double next_delay_ = 0;
@@ -16,6 +16,7 @@
 #include "td/telegram/files/FileLocation.hpp"
 #include "td/telegram/Global.h"
 #include "td/telegram/logevent/LogEvent.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/misc.h"
 #include "td/telegram/SecureStorage.h"
 #include "td/telegram/TdDb.h"
@@ -3616,6 +3617,15 @@ vector<tl_object_ptr<telegram_api::InputDocument>> FileManager::get_input_docume
   return result;
 }
 
+void FileManager::get_memory_statistics(MemoryStatistics &statistics) const {
+  statistics.add("FileManager", "file_nodes", file_nodes_);
+  statistics.add("FileManager", "file_id_info", file_id_info_);
+  statistics.add("FileManager", "file_hash_to_file_id", file_hash_to_file_id_);
+  statistics.add("FileManager", "remote_location_to_file_id", remote_location_to_file_id_);
+  statistics.add("FileManager", "local_location_to_file_id", local_location_to_file_id_);
+  statistics.add("FileManager", "generate_location_to_file_id", generate_location_to_file_id_);
+}
+
 bool FileManager::extract_was_uploaded(const telegram_api::object_ptr<telegram_api::InputMedia> &input_media) {
   if (input_media == nullptr) {
     return false;
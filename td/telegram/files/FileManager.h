@@ -50,6 +50,7 @@ extern int VERBOSITY_NAME(update_file);
 
 class FileData;
 class FileDbInterface;
+class MemoryStatistics;
 
 enum class FileLocationSource : int8 { None, FromUser, FromBinlog, FromDatabase, FromServer };
 
@@ -560,6 +561,8 @@ class FileManager final : public Actor {
   template <class ParserT>
   FileId parse_file(ParserT &parser);
 
+  void get_memory_statistics(MemoryStatistics &statistics) const;
+
  private:
   class FileDownloadManagerCallback final : public FileDownloadManager::Callback {
    public:
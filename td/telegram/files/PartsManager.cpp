@@ -134,7 +134,8 @@ Status PartsManager::init(int64 size, int64 expected_size, bool is_size_final, s
     }
   } else {
     part_size_ = 64 << 10;
-    while (part_size_ < MAX_PART_SIZE && calc_part_count(expected_size_, part_size_) > MAX_PART_COUNT) {
+    while (part_size_ < MAX_PART_SIZE && (part_size_ < preferred_part_size_ ||
+                                          calc_part_count(expected_size_, part_size_) > MAX_PART_COUNT)) {
       part_size_ *= 2;
     }
   }
@@ -146,6 +147,10 @@ Status PartsManager::init(int64 size, int64 expected_size, bool is_size_final, s
   return init_common(ready_parts);
 }
 
+void PartsManager::set_preferred_part_size(size_t part_size) {
+  preferred_part_size_ = part_size;
+}
+
 bool PartsManager::unchecked_ready() {
   VLOG(file_loader) << "Check readiness. Ready size is " << ready_size_ << ", total size is " << size_
                     << ", unknown_size_flag = " << unknown_size_flag_ << ", need_check = " << need_check_
@@ -65,6 +65,15 @@ void ResourceManager::update_resources(const ResourceState &resource_state) {
   loop();
 }
 
+void ResourceManager::update_max_resource_limit(int64 max_resource_limit) {
+  if (stop_flag_) {
+    return;
+  }
+  // parts, which are already being loaded, aren't affected if the limit is decreased
+  max_resource_limit_ = max_resource_limit;
+  loop();
+}
+
 void ResourceManager::hangup_shared() {
   auto node_id = get_link_token();
   auto node_ptr = nodes_container_.get(node_id);
@@ -115,7 +124,7 @@ bool ResourceManager::satisfy_node(NodeId file_node_id) {
   give = min(need, give);
   give -= give % part_size;
   VLOG(file_loader) << tag("give", give);
-  if (give == 0) {
+  if (give <= 0) {
     return false;
   }
   resource_state_.start_use(give);
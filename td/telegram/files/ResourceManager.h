@@ -27,6 +27,7 @@ class ResourceManager final : public Actor {
   // use through ActorShared
   void update_priority(int8 priority);
   void update_resources(const ResourceState &resource_state);
+  void update_max_resource_limit(int64 max_resource_limit);
 
   void register_worker(ActorShared<FileLoaderActor> callback, int8 priority);
 
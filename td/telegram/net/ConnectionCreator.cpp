@@ -71,7 +71,7 @@ class StatsCallback final : public mtproto::RawConnection::StatsCallback {
 
   void on_pong() final {
     if (option_stat_) {
-      send_lambda(connection_creator_, [stat = option_stat_] { stat->on_ok(); });
+      send_lambda(connection_creator_, [stat = option_stat_] { stat->on_ok(G()->unix_time()); });
     }
     send_closure(connection_creator_, &ConnectionCreator::on_pong, hash_);
   }
@@ -93,6 +93,29 @@ class StatsCallback final : public mtproto::RawConnection::StatsCallback {
   DcOptionsSet::Stat *option_stat_;
 };
 
+struct CachedProxyIpAddress {
+  string server;
+  int32 port = 0;
+  string ip;
+  int32 expires_at = 0;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(server, storer);
+    td::store(port, storer);
+    td::store(ip, storer);
+    td::store(expires_at, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(server, parser);
+    td::parse(port, parser);
+    td::parse(ip, parser);
+    td::parse(expires_at, parser);
+  }
+};
+
 }  // namespace detail
 
 ConnectionCreator::ClientInfo::ClientInfo() {
@@ -454,6 +477,7 @@ void ConnectionCreator::on_proxy_changed(bool from_db) {
   resolve_proxy_query_token_ = 0;
   resolve_proxy_timestamp_ = Timestamp();
   proxy_ip_address_ = IPAddress();
+  load_proxy_ip_address();
 
   if (active_proxy_id_ == 0 || !from_db) {
     send_closure(G()->messages_manager(), &MessagesManager::remove_sponsored_dialog);
@@ -476,6 +500,52 @@ string ConnectionCreator::get_proxy_used_database_key(int32 proxy_id) {
   return PSTRING() << "proxy_used" << proxy_id;
 }
 
+void ConnectionCreator::load_proxy_ip_address() {
+  if (active_proxy_id_ == 0) {
+    return;
+  }
+
+  auto serialized_ip_address = G()->td_db()->get_binlog_pmc()->get("proxy_ip_address");
+  if (serialized_ip_address.empty()) {
+    return;
+  }
+  detail::CachedProxyIpAddress cached_ip_address;
+  if (unserialize(cached_ip_address, serialized_ip_address).is_error()) {
+    G()->td_db()->get_binlog_pmc()->erase("proxy_ip_address");
+    return;
+  }
+
+  const Proxy &proxy = proxies_[active_proxy_id_];
+  if (cached_ip_address.server != proxy.server() || cached_ip_address.port != proxy.port() ||
+      cached_ip_address.expires_at < G()->unix_time()) {
+    return;
+  }
+  auto r_ip_address = IPAddress::get_ip_address(cached_ip_address.ip);
+  if (r_ip_address.is_error()) {
+    return;
+  }
+
+  // use the cached IP address until the proxy server name is resolved again
+  proxy_ip_address_ = r_ip_address.move_as_ok();
+  proxy_ip_address_.set_port(proxy.port());
+  VLOG(connections) << "Use cached proxy IP address " << proxy_ip_address_;
+}
+
+void ConnectionCreator::save_proxy_ip_address() const {
+  if (active_proxy_id_ == 0 || !proxy_ip_address_.is_valid()) {
+    return;
+  }
+
+  auto it = proxies_.find(active_proxy_id_);
+  CHECK(it != proxies_.end());
+  detail::CachedProxyIpAddress cached_ip_address;
+  cached_ip_address.server = it->second.server().str();
+  cached_ip_address.port = it->second.port();
+  cached_ip_address.ip = proxy_ip_address_.get_ip_str().str();
+  cached_ip_address.expires_at = G()->unix_time() + PROXY_IP_ADDRESS_CACHE_TTL;
+  G()->td_db()->get_binlog_pmc()->set("proxy_ip_address", serialize(cached_ip_address));
+}
+
 void ConnectionCreator::save_proxy_last_used_date(int32 delay) {
   if (active_proxy_id_ == 0) {
     return;
@@ -916,10 +986,11 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
     auto promise = PromiseCreator::lambda(
         [actor_id = actor_id(this), check_mode, transport_type = extra.transport_type, hash = client.hash,
-         debug_str = extra.debug_str,
-         network_generation = network_generation_](Result<ConnectionData> r_connection_data) mutable {
+         debug_str = extra.debug_str, network_generation = network_generation_,
+         option_stat = extra.stat](Result<ConnectionData> r_connection_data) mutable {
           send_closure(actor_id, &ConnectionCreator::client_create_raw_connection, std::move(r_connection_data),
-                       check_mode, std::move(transport_type), hash, std::move(debug_str), network_generation);
+                       check_mode, std::move(transport_type), hash, std::move(debug_str), network_generation,
+                       option_stat);
         });
 
     auto stats_callback =
@@ -937,7 +1008,8 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
 void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                                      mtproto::TransportType transport_type, uint32 hash,
-                                                     string debug_str, uint32 network_generation) {
+                                                     string debug_str, uint32 network_generation,
+                                                     DcOptionsSet::Stat *option_stat) {
   unique_ptr<mtproto::AuthData> auth_data;
   uint64 auth_data_generation{0};
   uint64 session_id{0};
@@ -953,7 +1025,8 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
     }
   }
   auto promise = PromiseCreator::lambda([actor_id = actor_id(this), hash, check_mode, auth_data_generation, session_id,
-                                         debug_str](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
+                                         debug_str,
+                                         option_stat](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
     if (result.is_ok()) {
       VLOG(connections) << "Ready connection (" << (check_mode ? "" : "un") << "checked) " << result.ok().get() << ' '
                         << tag("rtt", format::as_time(result.ok()->extra().rtt)) << ' ' << debug_str;
@@ -962,7 +1035,7 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
                         << debug_str;
     }
     send_closure(actor_id, &ConnectionCreator::client_add_connection, hash, std::move(result), check_mode,
-                 auth_data_generation, session_id);
+                 auth_data_generation, session_id, option_stat);
   });
 
   if (r_connection_data.is_error()) {
@@ -998,7 +1071,8 @@ void ConnectionCreator::client_set_timeout_at(ClientInfo &client, double wakeup_
 }
 
 void ConnectionCreator::client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection,
-                                              bool check_flag, uint64 auth_data_generation, uint64 session_id) {
+                                              bool check_flag, uint64 auth_data_generation, uint64 session_id,
+                                              DcOptionsSet::Stat *option_stat) {
   auto &client = clients_[hash];
   client.add_session_id(session_id);
   CHECK(client.pending_connections > 0);
@@ -1011,6 +1085,9 @@ void ConnectionCreator::client_add_connection(uint32 hash, Result<unique_ptr<mtp
     VLOG(connections) << "Add ready connection " << r_raw_connection.ok().get() << " for "
                       << tag("client", format::as_hex(hash));
     client.backoff.clear();
+    if (check_flag && option_stat != nullptr) {
+      on_dc_endpoint_rtt(option_stat, r_raw_connection.ok()->extra().rtt);
+    }
     client.ready_connections.emplace_back(r_raw_connection.move_as_ok(), Time::now_cached());
   } else {
     if (r_raw_connection.error().code() == -404 && client.auth_data &&
@@ -1043,6 +1120,48 @@ void ConnectionCreator::add_dc_options(DcOptions &&new_dc_options) {
 #endif
 }
 
+void ConnectionCreator::load_dc_endpoint_stats() {
+  auto serialized_endpoint_stats = G()->td_db()->get_binlog_pmc()->get("dc_endpoint_stats");
+  if (serialized_endpoint_stats.empty()) {
+    return;
+  }
+  vector<DcOptionsSet::EndpointStat> endpoint_stats;
+  auto status = unserialize(endpoint_stats, serialized_endpoint_stats);
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to load DC endpoint statistics: " << status;
+    G()->td_db()->get_binlog_pmc()->erase("dc_endpoint_stats");
+    return;
+  }
+  auto min_ok_date = G()->unix_time() - DC_ENDPOINT_STATS_TTL;
+  td::remove_if(endpoint_stats, [min_ok_date](const auto &endpoint_stat) {
+    return endpoint_stat.ok_date < min_ok_date || endpoint_stat.rtt <= 0.0;
+  });
+  VLOG(connections) << "Load statistics for " << endpoint_stats.size() << " DC endpoints";
+  dc_options_set_.add_endpoint_stats(std::move(endpoint_stats));
+}
+
+void ConnectionCreator::save_dc_endpoint_stats() {
+  if (!need_save_dc_endpoint_stats_) {
+    return;
+  }
+  need_save_dc_endpoint_stats_ = false;
+  save_dc_endpoint_stats_timestamp_ = Timestamp();
+
+  auto endpoint_stats = dc_options_set_.get_endpoint_stats(G()->unix_time() - DC_ENDPOINT_STATS_TTL);
+  VLOG(connections) << "Save statistics for " << endpoint_stats.size() << " DC endpoints";
+  G()->td_db()->get_binlog_pmc()->set("dc_endpoint_stats", serialize(endpoint_stats));
+}
+
+void ConnectionCreator::on_dc_endpoint_rtt(DcOptionsSet::Stat *option_stat, double rtt) {
+  CHECK(option_stat != nullptr);
+  option_stat->on_rtt(rtt);
+  if (!need_save_dc_endpoint_stats_) {
+    need_save_dc_endpoint_stats_ = true;
+    save_dc_endpoint_stats_timestamp_ = Timestamp::in(DC_ENDPOINT_STATS_SAVE_DELAY);
+    loop();
+  }
+}
+
 void ConnectionCreator::on_dc_update(DcId dc_id, string ip_port, Promise<> promise) {
   if (!dc_id.is_exact()) {
     return promise.set_error(Status::Error("Invalid dc_id"));
@@ -1097,6 +1216,7 @@ void ConnectionCreator::start_up() {
   } else {
     add_dc_options(std::move(dc_options));
   }
+  load_dc_endpoint_stats();
 
   if (G()->td_db()->get_binlog_pmc()->get("proxy_max_id") != "2" ||
       !G()->td_db()->get_binlog_pmc()->get(get_proxy_database_key(1)).empty()) {
@@ -1189,6 +1309,7 @@ ActorShared<ConnectionCreator> ConnectionCreator::create_reference(int64 token)
 void ConnectionCreator::hangup() {
   close_flag_ = true;
   save_proxy_last_used_date(0);
+  save_dc_endpoint_stats();
   ref_cnt_guard_.reset();
   for (auto &child : children_) {
     child.second.second.reset();
@@ -1265,11 +1386,23 @@ void ConnectionCreator::loop() {
   if (!is_inited_) {
     return;
   }
+
+  Timestamp timeout;
+  if (need_save_dc_endpoint_stats_) {
+    if (save_dc_endpoint_stats_timestamp_.is_in_past()) {
+      save_dc_endpoint_stats();
+    } else {
+      timeout.relax(save_dc_endpoint_stats_timestamp_);
+    }
+  }
+
   if (!network_flag_) {
+    if (timeout) {
+      set_timeout_at(timeout.at());
+    }
     return;
   }
 
-  Timestamp timeout;
   if (active_proxy_id_ != 0) {
     if (resolve_proxy_timestamp_.is_in_past()) {
       if (resolve_proxy_query_token_ == 0) {
@@ -1314,6 +1447,7 @@ void ConnectionCreator::on_proxy_resolved(Result<IPAddress> r_ip_address, bool d
   proxy_ip_address_ = r_ip_address.move_as_ok();
   VLOG(connections) << "Set proxy IP address to " << proxy_ip_address_;
   resolve_proxy_timestamp_ = Timestamp::in(5 * 60);
+  save_proxy_ip_address();
   for (auto &client : clients_) {
     client_loop(client.second);
   }
@@ -117,6 +117,12 @@ class ConnectionCreator final : public NetQueryCallback {
   Timestamp resolve_proxy_timestamp_;
   uint64 resolve_proxy_query_token_{0};
 
+  static constexpr int32 PROXY_IP_ADDRESS_CACHE_TTL = 86400;
+  static constexpr int32 DC_ENDPOINT_STATS_TTL = 86400;
+  static constexpr double DC_ENDPOINT_STATS_SAVE_DELAY = 60.0;
+  bool need_save_dc_endpoint_stats_ = false;
+  Timestamp save_dc_endpoint_stats_timestamp_;
+
   struct ClientInfo {
     class Backoff {
 #if TD_ANDROID || TD_DARWIN_IOS || TD_DARWIN_VISION_OS || TD_DARWIN_WATCH_OS || TD_TIZEN
@@ -207,6 +213,11 @@ class ConnectionCreator final : public NetQueryCallback {
 
   void init_proxies();
   void add_dc_options(DcOptions &&new_dc_options);
+  void load_dc_endpoint_stats();
+  void save_dc_endpoint_stats();
+  void on_dc_endpoint_rtt(DcOptionsSet::Stat *option_stat, double rtt);
+  void load_proxy_ip_address();
+  void save_proxy_ip_address() const;
   Result<SocketFd> do_request_connection(DcId dc_id, bool allow_media_only);
   Result<std::pair<unique_ptr<mtproto::RawConnection>, bool>> do_request_raw_connection(DcId dc_id,
                                                                                         bool allow_media_only,
@@ -222,9 +233,9 @@ class ConnectionCreator final : public NetQueryCallback {
   void client_loop(ClientInfo &client);
   void client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                     mtproto::TransportType transport_type, uint32 hash, string debug_str,
-                                    uint32 network_generation);
+                                    uint32 network_generation, DcOptionsSet::Stat *option_stat);
   void client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection, bool check_flag,
-                             uint64 auth_data_generation, uint64 session_id);
+                             uint64 auth_data_generation, uint64 session_id, DcOptionsSet::Stat *option_stat);
   void client_set_timeout_at(ClientInfo &client, double wakeup_at);
 
   void on_proxy_resolved(Result<IPAddress> ip_address, bool dummy);
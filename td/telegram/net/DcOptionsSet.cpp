@@ -17,6 +17,8 @@
 #include "td/utils/SliceBuilder.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <set>
 #include <utility>
 
@@ -42,6 +44,57 @@ void DcOptionsSet::add_dc_options(DcOptions dc_options) {
   }
 }
 
+vector<DcOptionsSet::EndpointStat> DcOptionsSet::get_endpoint_stats(int32 min_ok_date) const {
+  vector<EndpointStat> result;
+  for (auto &option_stat : option_stats_) {
+    auto add_endpoint_stat = [&](const Stat &stat, bool use_http) {
+      if (stat.rtt <= 0.0 || stat.ok_date < min_ok_date) {
+        return;
+      }
+      EndpointStat endpoint_stat;
+      endpoint_stat.ip = option_stat.first.get_ip_str().str();
+      endpoint_stat.port = option_stat.first.get_port();
+      endpoint_stat.use_http = use_http;
+      endpoint_stat.rtt = stat.rtt;
+      endpoint_stat.ok_date = stat.ok_date;
+      result.push_back(std::move(endpoint_stat));
+    };
+    add_endpoint_stat(option_stat.second->tcp_stat, false);
+    add_endpoint_stat(option_stat.second->http_stat, true);
+  }
+  return result;
+}
+
+void DcOptionsSet::add_endpoint_stats(vector<EndpointStat> endpoint_stats) {
+  for (auto &option_stat : option_stats_) {
+    for (auto &endpoint_stat : endpoint_stats) {
+      apply_endpoint_stat(option_stat.first, option_stat.second.get(), endpoint_stat);
+    }
+  }
+  append(saved_endpoint_stats_, std::move(endpoint_stats));
+}
+
+void DcOptionsSet::apply_endpoint_stat(const IPAddress &ip_address, OptionStat *option_stat,
+                                       const EndpointStat &endpoint_stat) {
+  if (ip_address.get_port() != endpoint_stat.port || ip_address.get_ip_str() != endpoint_stat.ip) {
+    return;
+  }
+  auto &stat = endpoint_stat.use_http ? option_stat->http_stat : option_stat->tcp_stat;
+  if (stat.rtt == 0.0) {
+    // the restored round-trip time affects only the order in which options are tried
+    stat.rtt = endpoint_stat.rtt;
+    stat.ok_date = endpoint_stat.ok_date;
+  }
+}
+
+int32 DcOptionsSet::get_rtt_class(const Stat &stat) {
+  if (stat.rtt <= 0.0) {
+    return std::numeric_limits<int32>::max();
+  }
+  // options with round-trip time differing less than twice are considered equivalent
+  return max(static_cast<int32>(std::log2(stat.rtt * 100)), 0);
+}
+
 DcOptions DcOptionsSet::get_dc_options() const {
   DcOptions result;
   for (auto id : ordered_options_) {
@@ -151,7 +204,18 @@ Result<DcOptionsSet::ConnectionInfo> DcOptionsSet::find_connection(DcId dc_id, b
                          return a_option.stat->error_at > b_option.stat->error_at;
                        })->stat->error_at;
 
-  auto result = *std::min_element(options.begin(), options.end(), [](const auto &a_option, const auto &b_option) {
+  // if options of only one address family are being checked, then race them with an option of the other family
+  bool is_checking_ipv4 = false;
+  bool is_checking_ipv6 = false;
+  for (auto &option : options) {
+    if (option.stat->state() == Stat::State::Checking) {
+      (option.option->is_ipv6() ? is_checking_ipv6 : is_checking_ipv4) = true;
+    }
+  }
+  bool need_race_ipv4 = is_checking_ipv6 && !is_checking_ipv4;
+  bool need_race_ipv6 = is_checking_ipv4 && !is_checking_ipv6;
+
+  auto result = *std::min_element(options.begin(), options.end(), [&](const auto &a_option, const auto &b_option) {
     auto &a = *a_option.stat;
     auto &b = *b_option.stat;
     auto a_state = a.state();
@@ -160,12 +224,31 @@ Result<DcOptionsSet::ConnectionInfo> DcOptionsSet::find_connection(DcId dc_id, b
       return a_state < b_state;
     }
     if (a_state == Stat::State::Ok) {
+      auto a_rtt_class = get_rtt_class(a);
+      auto b_rtt_class = get_rtt_class(b);
+      if (a_rtt_class != b_rtt_class) {
+        return a_rtt_class < b_rtt_class;
+      }
       if (a_option.order == b_option.order) {
         return a_option.use_http < b_option.use_http;
       }
       return a_option.order < b_option.order;
     } else if (a_state == Stat::State::Error) {
-      return a.error_at < b.error_at;
+      if (need_race_ipv4 || need_race_ipv6) {
+        bool a_need_race = a_option.option->is_ipv6() == need_race_ipv6;
+        bool b_need_race = b_option.option->is_ipv6() == need_race_ipv6;
+        if (a_need_race != b_need_race) {
+          return a_need_race;
+        }
+      }
+      if (a.error_at != b.error_at) {
+        return a.error_at < b.error_at;
+      }
+      auto a_rtt_class = get_rtt_class(a);
+      auto b_rtt_class = get_rtt_class(b);
+      if (a_rtt_class != b_rtt_class) {
+        return a_rtt_class < b_rtt_class;
+      }
     }
     return a_option.order < b_option.order;
   });
@@ -194,7 +277,11 @@ void DcOptionsSet::init_option_stat(DcOptionInfo *option_info) {
       return;
     }
   }
-  option_stats_.emplace_back(ip_address, make_unique<OptionStat>());
+  auto option_stat = make_unique<OptionStat>();
+  for (auto &endpoint_stat : saved_endpoint_stats_) {
+    apply_endpoint_stat(ip_address, option_stat.get(), endpoint_stat);
+  }
+  option_stats_.emplace_back(ip_address, std::move(option_stat));
   option_info->stat_id = option_stats_.size() - 1;
 }
 
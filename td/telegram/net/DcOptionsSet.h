@@ -13,6 +13,7 @@
 #include "td/utils/port/IPAddress.h"
 #include "td/utils/Status.h"
 #include "td/utils/Time.h"
+#include "td/utils/tl_helpers.h"
 
 #include <utility>
 
@@ -28,10 +29,13 @@ class DcOptionsSet {
     double ok_at{-1000};
     double error_at{-1001};
     double check_at{-1002};
+    double rtt{0.0};
+    int32 ok_date{0};
     enum class State : int32 { Ok, Error, Checking };
 
-    void on_ok() {
+    void on_ok(int32 unix_time) {
       ok_at = Time::now_cached();
+      ok_date = unix_time;
     }
     void on_error() {
       error_at = Time::now_cached();
@@ -39,6 +43,12 @@ class DcOptionsSet {
     void on_check() {
       check_at = Time::now_cached();
     }
+    void on_rtt(double new_rtt) {
+      if (new_rtt <= 0.0) {
+        return;
+      }
+      rtt = rtt == 0.0 ? new_rtt : 0.7 * rtt + 0.3 * new_rtt;
+    }
     bool is_ok() const {
       return state() == State::Ok;
     }
@@ -61,6 +71,37 @@ class DcOptionsSet {
     Stat *stat{nullptr};
   };
 
+  // saved round-trip time of an IP address, which was successfully used
+  struct EndpointStat {
+    string ip;
+    int32 port = 0;
+    bool use_http = false;
+    double rtt = 0.0;
+    int32 ok_date = 0;
+
+    template <class StorerT>
+    void store(StorerT &storer) const {
+      td::store(ip, storer);
+      td::store(port, storer);
+      td::store(use_http, storer);
+      td::store(rtt, storer);
+      td::store(ok_date, storer);
+    }
+
+    template <class ParserT>
+    void parse(ParserT &parser) {
+      td::parse(ip, parser);
+      td::parse(port, parser);
+      td::parse(use_http, parser);
+      td::parse(rtt, parser);
+      td::parse(ok_date, parser);
+    }
+  };
+
+  vector<EndpointStat> get_endpoint_stats(int32 min_ok_date) const;
+
+  void add_endpoint_stats(vector<EndpointStat> endpoint_stats);
+
   vector<ConnectionInfo> find_all_connections(DcId dc_id, bool allow_media_only, bool use_static, bool prefer_ipv6,
                                               bool only_http);
 
@@ -106,6 +147,12 @@ class DcOptionsSet {
   vector<unique_ptr<DcOptionInfo>> options_;
   vector<DcOptionId> ordered_options_;
   vector<std::pair<IPAddress, unique_ptr<OptionStat>>> option_stats_;
+  vector<EndpointStat> saved_endpoint_stats_;
+
+  static int32 get_rtt_class(const Stat &stat);
+
+  static void apply_endpoint_stat(const IPAddress &ip_address, OptionStat *option_stat,
+                                  const EndpointStat &endpoint_stat);
 
   DcOptionInfo *register_dc_option(DcOption &&option);
   void init_option_stat(DcOptionInfo *option_info);
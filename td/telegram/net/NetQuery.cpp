@@ -12,6 +12,7 @@
 
 #include "td/utils/algorithm.h"
 #include "td/utils/as.h"
+#include "td/utils/AsyncBinaryLog.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
@@ -24,7 +25,7 @@ int VERBOSITY_NAME(net_query) = VERBOSITY_NAME(INFO);
 
 void NetQuery::debug(string state, bool may_be_lost) {
   may_be_lost_ = may_be_lost;
-  VLOG(net_query) << *this << " " << tag("state", state);
+  VLOG_DEFERRED(net_query) << *this << " " << tag("state", state);
   {
     auto guard = lock();
     auto &data = get_data_unsafe();
@@ -56,6 +57,7 @@ NetQuery::NetQuery(uint64 id, BufferSlice &&query, DcId dc_id, Type type, AuthFl
   LOG(INFO) << *this;
   if (stats) {
     nq_counter_ = stats->register_query(this);
+    stats_ = stats;
   }
 }
 
@@ -69,8 +71,18 @@ void NetQuery::clear() {
   *this = NetQuery();
 }
 
+void NetQuery::on_dequeued(double now) {
+  if (queued_at_ == 0.0) {
+    return;
+  }
+  if (stats_ != nullptr) {
+    stats_->on_query_dequeued(priority_, now - queued_at_);
+  }
+  queued_at_ = 0.0;
+}
+
 void NetQuery::resend(DcId new_dc_id) {
-  VLOG(net_query) << "Resend " << *this;
+  VLOG_DEFERRED(net_query) << "Resend " << *this;
   {
     auto guard = lock();
     get_data_unsafe().resend_count_++;
@@ -92,7 +104,7 @@ bool NetQuery::update_is_ready() {
 }
 
 void NetQuery::set_ok(BufferSlice slice) {
-  VLOG(net_query) << "Receive answer " << *this;
+  VLOG_DEFERRED(net_query) << "Receive answer " << *this;
   CHECK(state_ == State::Query);
   answer_ = std::move(slice);
   state_ = State::OK;
@@ -141,7 +153,7 @@ void NetQuery::set_error(Status status, string source) {
 }
 
 void NetQuery::set_error_impl(Status status, string source) {
-  VLOG(net_query) << "Receive error " << *this << " " << status;
+  VLOG_DEFERRED(net_query) << "Receive error " << *this << " " << status;
   status_ = std::move(status);
   state_ = State::Error;
   source_ = std::move(source);
@@ -13,6 +13,8 @@
 #include "td/actor/actor.h"
 #include "td/actor/SignalSlot.h"
 
+#include "td/tl/TlObjectArena.h"
+
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/format.h"
@@ -52,6 +54,13 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   NetQuery() = default;
 
   enum class Type : int8 { Common, Upload, Download, DownloadSmall };
+
+  // queries with bigger priority are sent first
+  // queries with negative priority are bulk background queries, which are sent only if there are free slots
+  static constexpr int8 PRIORITY_BULK = -1;
+  static constexpr int8 PRIORITY_DEFAULT = 0;
+  static constexpr int8 PRIORITY_INTERACTIVE = 1;
+
   enum class AuthFlag : int8 { Off, On };
   enum class GzipFlag : int8 { Off, On };
   enum Error : int32 { Resend = 202, Canceled = 203, ResendInvokeAfter = 204 };
@@ -226,6 +235,14 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   void set_priority(int8 priority) {
     priority_ = priority;
   }
+  bool is_bulk() const {
+    return priority_ < 0;
+  }
+
+  void on_queued(double now) {
+    queued_at_ = now;
+  }
+  void on_dequeued(double now);
 
   Span<uint64> get_chain_ids() const {
     return chain_ids_;
@@ -264,7 +281,10 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
 
   bool in_sequence_dispacher_ = false;
   bool may_be_lost_ = false;
-  int8 priority_{0};
+  int8 priority_{PRIORITY_DEFAULT};
+
+  NetQueryStats *stats_ = nullptr;
+  double queued_at_ = 0.0;
 
   template <class T>
   struct movable_atomic final : public std::atomic<T> {
@@ -320,9 +340,12 @@ inline void cancel_query(NetQueryRef &ref) {
   ref->cancel(ref.generation());
 }
 
+// if use_arena is true, then the result must be converted right away and must not be kept,
+// because any object from the result keeps all memory of its TlObjectArena alive
 template <class T>
-Result<typename T::ReturnType> fetch_result(const BufferSlice &message) {
+Result<typename T::ReturnType> fetch_result(const BufferSlice &message, bool use_arena = false) {
   TlBufferParser parser(&message);
+  TlObjectArena::Guard arena_guard(use_arena && message.size() >= TlObjectArena::MIN_INPUT_SIZE);
   auto result = T::fetch_result(parser);
   parser.fetch_end();
 
@@ -0,0 +1,72 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQueryPriorityQueue.h"
+
+#include "td/utils/logging.h"
+
+namespace td {
+
+void NetQueryPriorityQueue::push(NetQueryPtr query) {
+  auto priority = query->priority();
+  if (priority > NetQuery::PRIORITY_DEFAULT && has_unsent_invoke_after_queries(query)) {
+    // queries in the same lane are sent in order of their addition, and the lanes above are sent first
+    priority = NetQuery::PRIORITY_DEFAULT;
+  }
+  queries_[priority].push(std::move(query));
+}
+
+bool NetQueryPriorityQueue::has_unsent_invoke_after_queries(const NetQueryPtr &query) {
+  for (auto &ref : query->invoke_after()) {
+    if (ref->message_id() == 0 && ref.is_alive()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+NetQueryPtr NetQueryPriorityQueue::pop(uint64 max_inflight_bulk_queries) {
+  return do_pop(get_inflight_bulk_query_count() < max_inflight_bulk_queries);
+}
+
+NetQueryPtr NetQueryPriorityQueue::pop_any() {
+  return do_pop(true);
+}
+
+NetQueryPtr NetQueryPriorityQueue::do_pop(bool allow_bulk) {
+  CHECK(!empty());
+  auto it = queries_.begin();
+  if (it->first < 0) {
+    if (!allow_bulk) {
+      return NetQueryPtr();
+    }
+  } else if (allow_bulk && non_bulk_queries_in_row_ >= BULK_QUERY_WEIGHT) {
+    auto bulk_it = queries_.lower_bound(-1);
+    if (bulk_it != queries_.end()) {
+      it = bulk_it;
+    }
+  }
+  if (it->first < 0) {
+    non_bulk_queries_in_row_ = 0;
+  } else {
+    non_bulk_queries_in_row_++;
+  }
+  auto res = it->second.pop();
+  if (it->second.empty()) {
+    queries_.erase(it);
+  }
+  return res;
+}
+
+bool NetQueryPriorityQueue::empty() const {
+  return queries_.empty();
+}
+
+bool NetQueryPriorityQueue::has_bulk_queries() const {
+  return !queries_.empty() && queries_.rbegin()->first < 0;
+}
+
+}  // namespace td
@@ -0,0 +1,73 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCounter.h"
+
+#include "td/utils/common.h"
+#include "td/utils/VectorQueue.h"
+
+#include <functional>
+#include <map>
+#include <utility>
+
+namespace td {
+
+// queries are returned in order of their priority, but each BULK_QUERY_WEIGHT-th query is taken from the bulk lane
+// if bulk queries are allowed, so they aren't starved by a steady flow of interactive queries
+class NetQueryPriorityQueue {
+ public:
+  static constexpr size_t BULK_QUERY_WEIGHT = 8;
+
+  // a query, which must be invoked after queries that aren't sent yet, is never queued above PRIORITY_DEFAULT,
+  // so it can't overtake them
+  void push(NetQueryPtr query);
+
+  // returns empty NetQueryPtr if there are only bulk queries and max_inflight_bulk_queries of them are in flight
+  NetQueryPtr pop(uint64 max_inflight_bulk_queries);
+
+  // returns the next query regardless of the number of bulk queries in flight
+  NetQueryPtr pop_any();
+
+  // passes queries to send_query while can_send() returns true; stops if only bulk queries are left
+  // and max_inflight_bulk_queries of them are in flight
+  template <class CanSendT, class SendQueryT>
+  void send_queries(uint64 max_inflight_bulk_queries, CanSendT &&can_send, SendQueryT &&send_query) {
+    while (!empty() && can_send()) {
+      auto query = pop(max_inflight_bulk_queries);
+      if (query.empty()) {
+        break;
+      }
+      send_query(std::move(query));
+    }
+  }
+
+  bool empty() const;
+
+  bool has_bulk_queries() const;
+
+  // the returned counter must be kept while the popped bulk query is in flight
+  NetQueryCounter get_inflight_bulk_query_counter() {
+    return NetQueryCounter(&inflight_bulk_query_count_);
+  }
+
+  uint64 get_inflight_bulk_query_count() const {
+    return inflight_bulk_query_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::map<int8, VectorQueue<NetQueryPtr>, std::greater<>> queries_;
+  size_t non_bulk_queries_in_row_ = 0;
+  NetQueryCounter::Counter inflight_bulk_query_count_{0};
+
+  NetQueryPtr do_pop(bool allow_bulk);
+
+  static bool has_unsent_invoke_after_queries(const NetQueryPtr &query);
+};
+
+}  // namespace td
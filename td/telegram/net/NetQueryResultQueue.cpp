@@ -0,0 +1,66 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQueryResultQueue.h"
+
+namespace td {
+
+uint64 NetQueryResultQueue::add_decoding_result(NetQueryPtr net_query, BufferSlice packed_data) {
+  Result result;
+  result.result_id_ = ++last_result_id_;
+  result.net_query_ = std::move(net_query);
+  result.packet_ = std::move(packed_data);
+  result.need_set_ok_ = true;
+  results_.push_back(std::move(result));
+  return last_result_id_;
+}
+
+void NetQueryResultQueue::add_ok_result(NetQueryPtr net_query, BufferSlice packet) {
+  Result result;
+  result.net_query_ = std::move(net_query);
+  result.packet_ = std::move(packet);
+  result.is_ready_ = true;
+  result.need_set_ok_ = true;
+  results_.push_back(std::move(result));
+}
+
+void NetQueryResultQueue::add_result(NetQueryPtr net_query) {
+  Result result;
+  result.net_query_ = std::move(net_query);
+  result.is_ready_ = true;
+  results_.push_back(std::move(result));
+}
+
+void NetQueryResultQueue::add_resend(NetQueryPtr net_query) {
+  Result result;
+  result.net_query_ = std::move(net_query);
+  result.is_ready_ = true;
+  result.need_resend_ = true;
+  results_.push_back(std::move(result));
+}
+
+const NetQueryPtr *NetQueryResultQueue::on_result_decoded(uint64 result_id, BufferSlice packet) {
+  for (auto &result : results_) {
+    if (result.result_id_ == result_id && !result.is_ready_) {
+      result.packet_ = std::move(packet);
+      result.is_ready_ = true;
+      return &result.net_query_;
+    }
+  }
+  return nullptr;
+}
+
+vector<std::pair<uint64, BufferSlice>> NetQueryResultQueue::get_decoding_results() const {
+  vector<std::pair<uint64, BufferSlice>> decoding_results;
+  for (auto &result : results_) {
+    if (!result.is_ready_) {
+      decoding_results.emplace_back(result.result_id_, result.packet_.clone());
+    }
+  }
+  return decoding_results;
+}
+
+}  // namespace td
@@ -0,0 +1,71 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/net/NetQuery.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+
+#include <deque>
+#include <utility>
+
+namespace td {
+
+// keeps finished queries until results of all previously finished queries are decoded,
+// so queries are returned in the order in which their results were received
+class NetQueryResultQueue {
+ public:
+  bool empty() const {
+    return results_.empty();
+  }
+
+  // the query result is still being decoded; returns identifier to be passed to on_result_decoded
+  uint64 add_decoding_result(NetQueryPtr net_query, BufferSlice packed_data);
+
+  // the packet will be set as the query result when the query is returned
+  void add_ok_result(NetQueryPtr net_query, BufferSlice packet);
+
+  // the query already has its result
+  void add_result(NetQueryPtr net_query);
+
+  // the query will be returned for resending
+  void add_resend(NetQueryPtr net_query);
+
+  // returns the query, which result was decoded, or nullptr if the result isn't found
+  const NetQueryPtr *on_result_decoded(uint64 result_id, BufferSlice packet);
+
+  // returns identifiers and packed data of all results, which are still being decoded
+  vector<std::pair<uint64, BufferSlice>> get_decoding_results() const;
+
+  // calls f(net_query, need_resend) for all queries, which can be returned now
+  template <class F>
+  void flush(F &&f) {
+    while (!results_.empty() && results_.front().is_ready_) {
+      auto result = std::move(results_.front());
+      results_.pop_front();
+      if (result.need_set_ok_) {
+        result.net_query_->set_ok(std::move(result.packet_));
+      }
+      f(std::move(result.net_query_), result.need_resend_);
+    }
+  }
+
+ private:
+  struct Result {
+    uint64 result_id_ = 0;
+    NetQueryPtr net_query_;
+    BufferSlice packet_;
+    bool is_ready_ = false;
+    bool need_set_ok_ = false;
+    bool need_resend_ = false;
+  };
+  std::deque<Result> results_;
+  uint64 last_result_id_ = 0;
+};
+
+}  // namespace td
@@ -20,9 +20,48 @@ uint64 NetQueryStats::get_count() const {
   return count_.load(std::memory_order_relaxed);
 }
 
+size_t NetQueryStats::get_queue_delay_counter_id(int8 priority) {
+  if (priority < 0) {
+    return 0;
+  }
+  if (priority == 0) {
+    return 1;
+  }
+  return 2;
+}
+
+void NetQueryStats::on_query_dequeued(int8 priority, double queue_delay) {
+  auto &counter = queue_delay_counters_[get_queue_delay_counter_id(priority)];
+  auto delay_us = static_cast<uint64>(max(queue_delay, 0.0) * 1e6);
+  counter.query_count.fetch_add(1, std::memory_order_relaxed);
+  counter.total_delay_us.fetch_add(delay_us, std::memory_order_relaxed);
+  auto max_delay_us = counter.max_delay_us.load(std::memory_order_relaxed);
+  while (max_delay_us < delay_us &&
+         !counter.max_delay_us.compare_exchange_weak(max_delay_us, delay_us, std::memory_order_relaxed)) {
+  }
+}
+
+NetQueryStats::QueueDelay NetQueryStats::get_queue_delay(int8 priority) const {
+  auto &counter = queue_delay_counters_[get_queue_delay_counter_id(priority)];
+  QueueDelay result;
+  result.query_count = counter.query_count.load(std::memory_order_relaxed);
+  result.total_delay = static_cast<double>(counter.total_delay_us.load(std::memory_order_relaxed)) * 1e-6;
+  result.max_delay = static_cast<double>(counter.max_delay_us.load(std::memory_order_relaxed)) * 1e-6;
+  return result;
+}
+
 void NetQueryStats::dump_pending_network_queries() {
   auto n = get_count();
   LOG(WARNING) << tag("pending net queries", n);
+  for (int8 priority : {NetQuery::PRIORITY_INTERACTIVE, NetQuery::PRIORITY_DEFAULT, NetQuery::PRIORITY_BULK}) {
+    auto queue_delay = get_queue_delay(priority);
+    if (queue_delay.query_count != 0) {
+      LOG(WARNING) << tag("priority", static_cast<int32>(priority)) << tag("sent queries", queue_delay.query_count)
+                   << tag("average queue delay",
+                          format::as_time(queue_delay.total_delay / static_cast<double>(queue_delay.query_count)))
+                   << tag("max queue delay", format::as_time(queue_delay.max_delay));
+    }
+  }
 
   if (!use_list_) {
     return;
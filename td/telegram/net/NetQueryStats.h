@@ -38,9 +38,29 @@ class NetQueryStats {
 
   uint64 get_count() const;
 
+  void on_query_dequeued(int8 priority, double queue_delay);
+
+  struct QueueDelay {
+    uint64 query_count = 0;
+    double total_delay = 0.0;
+    double max_delay = 0.0;
+  };
+  // returns number of sent queries with the given priority, and their total and maximum time spent in Session queue
+  QueueDelay get_queue_delay(int8 priority) const;
+
   void dump_pending_network_queries();
 
  private:
+  struct QueueDelayCounter {
+    std::atomic<uint64> query_count{0};
+    std::atomic<uint64> total_delay_us{0};
+    std::atomic<uint64> max_delay_us{0};
+  };
+  static constexpr size_t QUEUE_DELAY_COUNTER_COUNT = 3;  // bulk, default and interactive queries
+  QueueDelayCounter queue_delay_counters_[QUEUE_DELAY_COUNTER_COUNT];
+
+  static size_t get_queue_delay_counter_id(int8 priority);
+
   NetQueryCounter::Counter count_{0};
   std::atomic<bool> use_list_{true};
   TsList<NetQueryDebug> list_;
@@ -0,0 +1,107 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/QueryResultDecoder.h"
+
+#include "td/utils/Gzip.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/config.h"
+#include "td/utils/port/thread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace td {
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED && !TD_PORT_WINDOWS
+
+namespace {
+
+class DecoderThreadPool {
+ public:
+  struct Job {
+    std::shared_ptr<QueryResultDecoder::ResultQueue> queue_;
+    uint64 result_id_ = 0;
+    BufferSlice packed_data_;
+  };
+
+  void add_job(Job &&job) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+    if (idle_thread_count_ == 0 && thread_count_ < QueryResultDecoder::MAX_THREAD_COUNT) {
+      // threads are created on first use and are never destroyed
+      thread_count_++;
+      thread([this] { run(); }).detach();
+      return;
+    }
+    lock.unlock();
+    condition_variable_.notify_one();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  std::deque<Job> jobs_;
+  int32 thread_count_ = 0;
+  int32 idle_thread_count_ = 0;
+
+  void run() {
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_thread_count_++;
+        condition_variable_.wait(lock, [this] { return !jobs_.empty(); });
+        idle_thread_count_--;
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+
+      QueryResultDecoder::DecodedResult result;
+      result.result_id_ = job.result_id_;
+      result.packet_ = gzdecode(job.packed_data_.as_slice());
+      job.queue_->writer_put(std::move(result));
+    }
+  }
+};
+
+DecoderThreadPool &get_decoder_thread_pool() {
+  // the pool is never destroyed, because its threads are never joined
+  static auto *pool = new DecoderThreadPool();
+  return *pool;
+}
+
+}  // namespace
+
+bool QueryResultDecoder::is_supported() {
+  return true;
+}
+
+void QueryResultDecoder::decode(std::shared_ptr<ResultQueue> queue, uint64 result_id, BufferSlice packed_data) {
+  DecoderThreadPool::Job job;
+  job.queue_ = std::move(queue);
+  job.result_id_ = result_id;
+  job.packed_data_ = std::move(packed_data);
+  get_decoder_thread_pool().add_job(std::move(job));
+}
+
+#else
+
+bool QueryResultDecoder::is_supported() {
+  return false;
+}
+
+void QueryResultDecoder::decode(std::shared_ptr<ResultQueue> queue, uint64 result_id, BufferSlice packed_data) {
+  UNREACHABLE();
+}
+
+#endif
+
+constexpr int32 QueryResultDecoder::MAX_THREAD_COUNT;
+
+}  // namespace td
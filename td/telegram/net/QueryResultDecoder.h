@@ -0,0 +1,36 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/MpscPollableQueue.h"
+
+#include <memory>
+
+namespace td {
+
+// decompresses big gzipped query results on worker threads, which are shared by all Td instances,
+// so neither Session schedulers nor other auxiliary schedulers are blocked by decompression
+class QueryResultDecoder {
+ public:
+  static constexpr int32 MAX_THREAD_COUNT = 2;
+
+  struct DecodedResult {
+    uint64 result_id_ = 0;
+    BufferSlice packet_;
+  };
+  using ResultQueue = MpscPollableQueue<DecodedResult>;
+
+  // returns false if results must be decompressed synchronously
+  static bool is_supported();
+
+  // the decompressed result will be put to the queue from a worker thread
+  static void decode(std::shared_ptr<ResultQueue> queue, uint64 result_id, BufferSlice packed_data);
+};
+
+}  // namespace td
@@ -14,6 +14,7 @@
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/net/NetType.h"
+#include "td/telegram/net/QueryResultDecoder.h"
 #include "td/telegram/StateManager.h"
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/UniqueId.h"
@@ -30,7 +31,9 @@
 
 #include "td/utils/algorithm.h"
 #include "td/utils/as.h"
+#include "td/utils/AsyncBinaryLog.h"
 #include "td/utils/format.h"
+#include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/thread_local.h"
@@ -212,25 +215,6 @@ TD_THREAD_LOCAL Semaphore *GenAuthKeyActor::semaphore_{};
 
 }  // namespace detail
 
-void Session::PriorityQueue::push(NetQueryPtr query) {
-  auto priority = query->priority();
-  queries_[priority].push(std::move(query));
-}
-
-NetQueryPtr Session::PriorityQueue::pop() {
-  CHECK(!empty());
-  auto it = queries_.begin();
-  auto res = it->second.pop();
-  if (it->second.empty()) {
-    queries_.erase(it);
-  }
-  return res;
-}
-
-bool Session::PriorityQueue::empty() const {
-  return queries_.empty();
-}
-
 Session::Session(unique_ptr<Callback> callback, std::shared_ptr<AuthDataShared> shared_auth_data, int32 raw_dc_id,
                  int32 dc_id, bool is_primary, bool is_main, bool use_pfs, bool persist_tmp_auth_key, bool is_cdn,
                  bool need_destroy_auth_key, const mtproto::AuthKey &tmp_auth_key,
@@ -375,7 +359,7 @@ void Session::send(NetQueryPtr &&query) {
 
   // query->debug(PSTRING() << get_name() << ": received from SessionProxy");
   query->set_session_id(auth_data_.get_session_id());
-  VLOG(net_query) << "Receive query " << query;
+  VLOG_DEFERRED(net_query) << "Receive query " << query;
   if (query->update_is_ready()) {
     return_query(std::move(query));
     return;
@@ -516,10 +500,20 @@ void Session::close() {
   sent_queries_.clear();
   sent_containers_.clear();
 
+  flush_decoded_results();
+  if (decoded_results_ != nullptr) {
+    Scheduler::unsubscribe(decoded_results_->reader_get_event_fd().get_poll_info().get_pollable_fd_ref());
+    decoded_results_ = nullptr;
+  }
+  for (auto &decoding_result : pending_results_.get_decoding_results()) {
+    set_decoded_result(decoding_result.first, gzdecode(decoding_result.second.as_slice()));
+  }
+  flush_pending_results();
+
   flush_pending_invoke_after_queries();
   CHECK(sent_queries_.empty());
   while (!pending_queries_.empty()) {
-    auto query = pending_queries_.pop();
+    auto query = pending_queries_.pop_any();
     query->set_error_resend();
     return_query(std::move(query));
   }
@@ -547,7 +541,7 @@ void Session::raw_event(const Event::Raw &event) {
   LOG(DEBUG) << "Drop answer for " << query;
   query->set_message_id(0);
   sent_queries_.erase(it);
-  return_query(std::move(query));
+  return_query_in_order(std::move(query));
 
   if (main_connection_.state_ == ConnectionInfo::State::Ready) {
     main_connection_.connection_->cancel_answer(message_id);
@@ -686,11 +680,11 @@ void Session::on_closed(Status status) {
         mark_as_known(it->first, &it->second);
 
         auto &query = it->second.net_query_;
-        VLOG(net_query) << "Resend query (on_disconnected, no ack) " << query;
+        VLOG_DEFERRED(net_query) << "Resend query (on_disconnected, no ack) " << query;
         query->set_message_id(0);
         query->set_error(Status::Error(500, PSLICE() << "Session failed: " << status.message()),
                          current_info_->connection_->get_name().str());
-        return_query(std::move(query));
+        return_query_in_order(std::move(query));
         it = sent_queries_.erase(it);
       } else {
         mark_as_unknown(it->first, &it->second);
@@ -730,12 +724,13 @@ void Session::on_new_session_created(uint64 unique_id, mtproto::MessageId first_
       // container vector leak otherwise
       cleanup_container(it->first, query_ptr);
       mark_as_known(it->first, query_ptr);
-      resend_query(std::move(query_ptr->net_query_));
+      pending_results_.add_resend(std::move(query_ptr->net_query_));
       it = sent_queries_.erase(it);
     } else {
       ++it;
     }
   }
+  flush_pending_results();
 }
 
 void Session::on_session_failed(Status status) {
@@ -791,7 +786,7 @@ void Session::on_message_ack_impl_inner(mtproto::MessageId message_id, int32 typ
   if (it == sent_queries_.end()) {
     return;
   }
-  VLOG(net_query) << "Ack " << it->second.net_query_;
+  VLOG_DEFERRED(net_query) << "Ack " << it->second.net_query_;
   it->second.is_acknowledged_ = true;
   {
     auto lock = it->second.net_query_->lock();
@@ -839,7 +834,7 @@ void Session::mark_as_known(mtproto::MessageId message_id, Query *query) {
   if (!query->is_unknown_) {
     return;
   }
-  VLOG(net_query) << "Mark as known " << query->net_query_;
+  VLOG_DEFERRED(net_query) << "Mark as known " << query->net_query_;
   query->is_unknown_ = false;
   unknown_queries_.erase(message_id);
   if (unknown_queries_.empty()) {
@@ -855,7 +850,7 @@ void Session::mark_as_unknown(mtproto::MessageId message_id, Query *query) {
   if (query->is_unknown_) {
     return;
   }
-  VLOG(net_query) << "Mark as unknown " << query->net_query_;
+  VLOG_DEFERRED(net_query) << "Mark as unknown " << query->net_query_;
   query->is_unknown_ = true;
   CHECK(message_id != mtproto::MessageId());
   unknown_queries_.insert(message_id);
@@ -882,50 +877,142 @@ Status Session::on_message_result_ok(mtproto::MessageId message_id, BufferSlice
 
   auto it = sent_queries_.find(message_id);
   if (it == sent_queries_.end()) {
-    LOG(DEBUG) << "Drop result to " << message_id << tag("original_size", original_size)
-               << tag("response_tl", format::as_hex(response_tl_id));
-
-    if (original_size > 16 * 1024) {
-      dropped_size_ += original_size;
-      if (dropped_size_ > (256 * 1024)) {
-        auto dropped_size = dropped_size_;
-        dropped_size_ = 0;
-        return Status::Error(
-            2, PSLICE() << "Too many dropped packets " << tag("total_size", format::as_size(dropped_size)));
-      }
-    }
-    return Status::OK();
+    return on_message_result_dropped(message_id, original_size, response_tl_id);
   }
 
   auth_data_.on_api_response();
   Query *query_ptr = &it->second;
-  VLOG(net_query) << "Return query result " << query_ptr->net_query_;
+  VLOG_DEFERRED(net_query) << "Return query result " << query_ptr->net_query_;
 
   if (!parser.get_error()) {
-    // Steal authorization information.
-    // It is a dirty hack, yep.
-    if (response_tl_id == telegram_api::auth_authorization::ID ||
-        response_tl_id == telegram_api::auth_loginTokenSuccess::ID ||
-        response_tl_id == telegram_api::auth_sentCodeSuccess::ID) {
-      if (query_ptr->net_query_->tl_constructor() != telegram_api::auth_importAuthorization::ID) {
-        G()->net_query_dispatcher().set_main_dc_id(raw_dc_id_);
-      }
-      auth_data_.set_auth_flag(true);
-      shared_auth_data_->set_auth_key(auth_data_.get_main_auth_key());
-    }
+    on_message_result_tl_id(query_ptr->net_query_, response_tl_id);
+  }
+
+  cleanup_container(message_id, query_ptr);
+  mark_as_known(message_id, query_ptr);
+  query_ptr->net_query_->on_net_read(original_size);
+  query_ptr->net_query_->set_message_id(0);
+  pending_results_.add_ok_result(std::move(query_ptr->net_query_), std::move(packet));
+  flush_pending_results();
+
+  sent_queries_.erase(it);
+  return Status::OK();
+}
+
+Status Session::on_message_result_gzip(mtproto::MessageId message_id, BufferSlice packed_data, size_t original_size) {
+  if (packed_data.size() < MIN_PARALLEL_DECODE_SIZE || !can_decode_results_in_parallel()) {
+    return on_message_result_ok(message_id, gzdecode(packed_data.as_slice()), original_size);
+  }
+
+  last_success_timestamp_ = Time::now();
+
+  auto it = sent_queries_.find(message_id);
+  if (it == sent_queries_.end()) {
+    return on_message_result_dropped(message_id, original_size, 0);
   }
 
+  auth_data_.on_api_response();
+  Query *query_ptr = &it->second;
+  VLOG_DEFERRED(net_query) << "Decompress query result " << query_ptr->net_query_;
+
   cleanup_container(message_id, query_ptr);
   mark_as_known(message_id, query_ptr);
   query_ptr->net_query_->on_net_read(original_size);
-  query_ptr->net_query_->set_ok(std::move(packet));
   query_ptr->net_query_->set_message_id(0);
-  return_query(std::move(query_ptr->net_query_));
+
+  // the packed data is kept to decompress it synchronously if the session is closed before the result is decoded
+  auto result_id = pending_results_.add_decoding_result(std::move(query_ptr->net_query_), packed_data.clone());
 
   sent_queries_.erase(it);
+
+  if (decoded_results_ == nullptr) {
+    // the session is woken up by the queue, when decoded results are put to it
+    decoded_results_ = std::make_shared<QueryResultDecoder::ResultQueue>();
+    decoded_results_->init();
+    Scheduler::subscribe(decoded_results_->reader_get_event_fd().get_poll_info().extract_pollable_fd(this),
+                         PollFlags::Read());
+  }
+  QueryResultDecoder::decode(decoded_results_, result_id, std::move(packed_data));
   return Status::OK();
 }
 
+Status Session::on_message_result_dropped(mtproto::MessageId message_id, size_t original_size, int32 response_tl_id) {
+  LOG(DEBUG) << "Drop result to " << message_id << tag("original_size", original_size)
+             << tag("response_tl", format::as_hex(response_tl_id));
+
+  if (original_size > 16 * 1024) {
+    dropped_size_ += original_size;
+    if (dropped_size_ > (256 * 1024)) {
+      auto dropped_size = dropped_size_;
+      dropped_size_ = 0;
+      return Status::Error(2,
+                           PSLICE() << "Too many dropped packets " << tag("total_size", format::as_size(dropped_size)));
+    }
+  }
+  return Status::OK();
+}
+
+void Session::on_message_result_tl_id(const NetQueryPtr &net_query, int32 response_tl_id) {
+  // Steal authorization information.
+  // It is a dirty hack, yep.
+  if (response_tl_id == telegram_api::auth_authorization::ID ||
+      response_tl_id == telegram_api::auth_loginTokenSuccess::ID ||
+      response_tl_id == telegram_api::auth_sentCodeSuccess::ID) {
+    if (net_query->tl_constructor() != telegram_api::auth_importAuthorization::ID) {
+      G()->net_query_dispatcher().set_main_dc_id(raw_dc_id_);
+    }
+    auth_data_.set_auth_flag(true);
+    shared_auth_data_->set_auth_key(auth_data_.get_main_auth_key());
+  }
+}
+
+void Session::flush_decoded_results() {
+  if (decoded_results_ == nullptr) {
+    return;
+  }
+  bool has_decoded_results = false;
+  int ready_count;
+  while ((ready_count = decoded_results_->reader_wait_nonblock()) > 0) {
+    while (ready_count-- > 0) {
+      auto decoded_result = decoded_results_->reader_get_unsafe();
+      set_decoded_result(decoded_result.result_id_, std::move(decoded_result.packet_));
+    }
+    has_decoded_results = true;
+  }
+  if (has_decoded_results) {
+    flush_pending_results();
+  }
+}
+
+void Session::set_decoded_result(uint64 result_id, BufferSlice packet) {
+  TlParser parser(packet.as_slice());
+  int32 response_tl_id = parser.fetch_int();
+  bool has_response_tl_id = !parser.get_error();
+  auto net_query = pending_results_.on_result_decoded(result_id, std::move(packet));
+  if (net_query != nullptr && has_response_tl_id) {
+    on_message_result_tl_id(*net_query, response_tl_id);
+  }
+}
+
+void Session::return_query_in_order(NetQueryPtr &&net_query) {
+  pending_results_.add_result(std::move(net_query));
+  flush_pending_results();
+}
+
+void Session::flush_pending_results() {
+  pending_results_.flush([this](NetQueryPtr &&net_query, bool need_resend) {
+    if (need_resend) {
+      resend_query(std::move(net_query));
+    } else {
+      return_query(std::move(net_query));
+    }
+  });
+}
+
+bool Session::can_decode_results_in_parallel() const {
+  return QueryResultDecoder::is_supported();
+}
+
 void Session::on_message_result_error(mtproto::MessageId message_id, int error_code, string message) {
   if (!check_utf8(message)) {
     LOG(ERROR) << "Receive invalid error message \"" << message << '"';
@@ -995,13 +1082,13 @@ void Session::on_message_result_error(mtproto::MessageId message_id, int error_c
   }
 
   Query *query_ptr = &it->second;
-  VLOG(net_query) << "Return query error " << query_ptr->net_query_;
+  VLOG_DEFERRED(net_query) << "Return query error " << query_ptr->net_query_;
 
   cleanup_container(message_id, query_ptr);
   mark_as_known(message_id, query_ptr);
   query_ptr->net_query_->set_error(Status::Error(error_code, message), current_info_->connection_->get_name().str());
   query_ptr->net_query_->set_message_id(0);
-  return_query(std::move(query_ptr->net_query_));
+  return_query_in_order(std::move(query_ptr->net_query_));
 
   sent_queries_.erase(it);
 }
@@ -1020,8 +1107,9 @@ void Session::on_message_failed_inner(mtproto::MessageId message_id, bool in_con
   mark_as_known(message_id, query_ptr);
 
   query_ptr->net_query_->debug_send_failed();
-  resend_query(std::move(query_ptr->net_query_));
+  pending_results_.add_resend(std::move(query_ptr->net_query_));
   sent_queries_.erase(it);
+  flush_pending_results();
 }
 
 void Session::on_message_failed(mtproto::MessageId message_id, Status status) {
@@ -1053,7 +1141,7 @@ void Session::on_message_info(mtproto::MessageId message_id, int32 state, mtprot
       auto query = std::move(it->second.net_query_);
       query->set_message_id(0);
       sent_queries_.erase(it);
-      return_query(std::move(query));
+      return_query_in_order(std::move(query));
       return;
     }
   }
@@ -1104,11 +1192,12 @@ Status Session::on_destroy_auth_key() {
 }
 
 bool Session::has_queries() const {
-  return !pending_invoke_after_queries_.empty() || !pending_queries_.empty() || !sent_queries_.empty();
+  return !pending_invoke_after_queries_.empty() || !pending_queries_.empty() || !sent_queries_.empty() ||
+         !pending_results_.empty();
 }
 
 void Session::resend_query(NetQueryPtr query) {
-  VLOG(net_query) << "Resend " << query;
+  VLOG_DEFERRED(net_query) << "Resend " << query;
   query->set_message_id(0);
 
   if (UniqueId::extract_type(query->id()) == UniqueId::BindKey) {
@@ -1122,6 +1211,7 @@ void Session::resend_query(NetQueryPtr query) {
 void Session::add_query(NetQueryPtr &&net_query) {
   CHECK(UniqueId::extract_type(net_query->id()) != UniqueId::BindKey);
   net_query->debug(PSTRING() << get_name() << ": pending");
+  net_query->on_queued(Time::now());
   pending_queries_.push(std::move(net_query));
 }
 
@@ -1130,16 +1220,19 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
   current_info_ = info;
 
   if (net_query->update_is_ready()) {
-    return return_query(std::move(net_query));
+    return return_query_in_order(std::move(net_query));
   }
 
+  auto now = Time::now();
+  net_query->on_dequeued(now);
+
   Span<NetQueryRef> invoke_after = net_query->invoke_after();
   vector<mtproto::MessageId> invoke_after_message_ids;
   for (auto &ref : invoke_after) {
     auto invoke_after_message_id = mtproto::MessageId(ref->message_id());
     if (ref->session_id() != auth_data_.get_session_id() || invoke_after_message_id == mtproto::MessageId()) {
       net_query->set_error_resend_invoke_after();
-      return return_query(std::move(net_query));
+      return return_query_in_order(std::move(net_query));
     }
     invoke_after_message_ids.push_back(invoke_after_message_id);
   }
@@ -1151,7 +1244,6 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
     }
   }
 
-  auto now = Time::now();
   bool immediately_fail_query = false;
   if (!immediately_fail_query) {
     net_query->debug(PSTRING() << get_name() << ": send to an MTProto connection");
@@ -1171,7 +1263,7 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
     }
   }
   net_query->set_message_id(message_id.get());
-  VLOG(net_query) << "Send query to connection " << net_query << tag("invoke_after", invoke_after_message_ids);
+  VLOG_DEFERRED(net_query) << "Send query to connection " << net_query << tag("invoke_after", invoke_after_message_ids);
   {
     auto lock = net_query->lock();
     net_query->get_data_unsafe().unknown_state_ = false;
@@ -1181,9 +1273,13 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
     LOG(DEBUG) << "Set event for net_query cancellation for " << message_id;
     net_query->cancel_slot_.set_event(EventCreator::raw(actor_id(), message_id.get()));
   }
+  bool is_bulk = net_query->is_bulk();
   auto status =
       sent_queries_.emplace(message_id, Query{message_id, std::move(net_query), main_connection_.connection_id_, now});
   LOG_CHECK(status.second) << message_id;
+  if (is_bulk) {
+    status.first->second.bulk_query_counter_ = pending_queries_.get_inflight_bulk_query_counter();
+  }
   sent_queries_list_.put(status.first->second.get_list_node());
   if (!status.second) {
     LOG(FATAL) << "Duplicate " << message_id;
@@ -1515,6 +1611,7 @@ void Session::timeout_expired() {
 }
 
 void Session::loop() {
+  flush_decoded_results();
   if (!was_on_network_) {
     return;
   }
@@ -1556,11 +1653,17 @@ void Session::loop() {
     while (main_connection_.state_ == ConnectionInfo::State::Ready) {
       if (auth_data_.is_ready(now)) {
         if (need_send_query()) {
-          while (!pending_queries_.empty() && sent_queries_.size() < MAX_INFLIGHT_QUERIES) {
-            auto query = pending_queries_.pop();
-            connection_send_query(&main_connection_, std::move(query));
-            need_flush = true;
+          uint64 max_inflight_bulk_queries = 0;
+          if (pending_queries_.has_bulk_queries()) {
+            max_inflight_bulk_queries = static_cast<uint64>(
+                G()->get_option_integer("bulk_query_inflight_count_max", DEFAULT_MAX_INFLIGHT_BULK_QUERIES));
           }
+          pending_queries_.send_queries(
+              max_inflight_bulk_queries, [&] { return sent_queries_.size() < MAX_INFLIGHT_QUERIES; },
+              [&](NetQueryPtr query) {
+                connection_send_query(&main_connection_, std::move(query));
+                need_flush = true;
+              });
         }
         if (need_send_bind_key()) {
           // send auth.bindTempAuthKey
@@ -8,6 +8,10 @@
 
 #include "td/telegram/net/AuthDataShared.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCounter.h"
+#include "td/telegram/net/NetQueryPriorityQueue.h"
+#include "td/telegram/net/NetQueryResultQueue.h"
+#include "td/telegram/net/QueryResultDecoder.h"
 #include "td/telegram/net/TempAuthKeyWatchdog.h"
 
 #include "td/mtproto/AuthData.h"
@@ -28,11 +32,9 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
-#include "td/utils/VectorQueue.h"
 
 #include <array>
 #include <deque>
-#include <functional>
 #include <map>
 #include <memory>
 #include <utility>
@@ -89,6 +91,8 @@ class Session final
     const int8 connection_id_;
     const double sent_at_;
 
+    NetQueryCounter bulk_query_counter_;
+
     Query(mtproto::MessageId message_id, NetQueryPtr &&net_query, int8 connection_id, double sent_at)
         : container_message_id_(message_id)
         , net_query_(std::move(net_query))
@@ -138,19 +142,16 @@ class Session final
 
   // Do not invalidate iterators of these two containers!
   // TODO: better data structures
-  struct PriorityQueue {
-    void push(NetQueryPtr query);
-    NetQueryPtr pop();
-    bool empty() const;
-
-   private:
-    std::map<int8, VectorQueue<NetQueryPtr>, std::greater<>> queries_;
-  };
-  PriorityQueue pending_queries_;
+  NetQueryPriorityQueue pending_queries_;
   std::map<mtproto::MessageId, Query> sent_queries_;
   std::deque<NetQueryPtr> pending_invoke_after_queries_;
   ListNode sent_queries_list_;
 
+  // finished queries, which are returned in the order of receiving of their results
+  // big gzipped results are decompressed by QueryResultDecoder and the queries are kept in the queue until then
+  NetQueryResultQueue pending_results_;
+  std::shared_ptr<QueryResultDecoder::ResultQueue> decoded_results_;
+
   struct ConnectionInfo {
     int8 connection_id_ = 0;
     Mode mode_ = Mode::Tcp;
@@ -179,6 +180,8 @@ class Session final
 
   static constexpr double ACTIVITY_TIMEOUT = 60 * 5;
   static constexpr size_t MAX_INFLIGHT_QUERIES = 1024;
+  static constexpr int64 DEFAULT_MAX_INFLIGHT_BULK_QUERIES = 16;
+  static constexpr size_t MIN_PARALLEL_DECODE_SIZE = 16 << 10;
 
   struct ContainerInfo {
     size_t ref_cnt;
@@ -229,6 +232,14 @@ class Session final
 
   void on_message_ack(mtproto::MessageId message_id) final;
   Status on_message_result_ok(mtproto::MessageId message_id, BufferSlice packet, size_t original_size) final;
+  Status on_message_result_gzip(mtproto::MessageId message_id, BufferSlice packed_data, size_t original_size) final;
+  Status on_message_result_dropped(mtproto::MessageId message_id, size_t original_size, int32 response_tl_id);
+  void on_message_result_tl_id(const NetQueryPtr &net_query, int32 response_tl_id);
+  void flush_decoded_results();
+  void set_decoded_result(uint64 result_id, BufferSlice packet);
+  void return_query_in_order(NetQueryPtr &&net_query);
+  void flush_pending_results();
+  bool can_decode_results_in_parallel() const;
   void on_message_result_error(mtproto::MessageId message_id, int error_code, string message) final;
   void on_message_failed(mtproto::MessageId message_id, Status status) final;
 
@@ -7,6 +7,7 @@
 #include "td/telegram/net/SessionProxy.h"
 
 #include "td/telegram/Global.h"
+#include "td/telegram/LazyUpdates.h"
 #include "td/telegram/net/AuthKeyState.h"
 #include "td/telegram/net/ConnectionCreator.h"
 #include "td/telegram/net/DcId.h"
@@ -14,12 +15,10 @@
 #include "td/telegram/net/Session.h"
 #include "td/telegram/Td.h"
 #include "td/telegram/TdDb.h"
-#include "td/telegram/telegram_api.h"
 #include "td/telegram/UniqueId.h"
 
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
-#include "td/utils/format.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
@@ -27,7 +26,6 @@
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
-#include "td/utils/tl_parsers.h"
 
 namespace td {
 
@@ -66,12 +64,10 @@ class SessionCallback final : public Session::Callback {
   }
 
   void on_update(BufferSlice &&update, uint64 auth_key_id) final {
-    TlBufferParser parser(&update);
-    auto updates = telegram_api::Updates::fetch(parser);
-    parser.fetch_end();
-    if (parser.get_error()) {
-      LOG(ERROR) << "Failed to fetch update: " << parser.get_error() << format::as_hex_dump<4>(update.as_slice());
-      updates = nullptr;
+    LazyUpdates updates(std::move(update));
+    if (updates.get_short_update_id() == 0) {
+      // short updates are small and can be ignored by Td, so they are parsed only if needed
+      updates.parse();
     }
     send_closure_later(G()->td(), &Td::on_update, std::move(updates), auth_key_id);
   }
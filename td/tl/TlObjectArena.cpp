@@ -0,0 +1,141 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/tl/TlObjectArena.h"
+
+#include "td/utils/logging.h"
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <new>
+
+namespace td {
+
+constexpr size_t TlObjectArena::MIN_INPUT_SIZE;
+constexpr size_t TlObjectArena::ALIGNMENT;
+constexpr size_t TlObjectArena::MIN_CHUNK_SIZE;
+constexpr size_t TlObjectArena::MAX_CHUNK_SIZE;
+
+TD_THREAD_LOCAL TlObjectArena *TlObjectArena::current_arena_;
+std::atomic<int32> TlObjectArena::arena_count_{0};
+
+namespace {
+
+struct ArenaChunk {
+  const char *begin;
+  TlObjectArena *arena;
+};
+
+// chunks of all existing arenas by their end
+std::mutex &get_arena_chunks_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<const char *, ArenaChunk> &get_arena_chunks() {
+  static std::map<const char *, ArenaChunk> chunks;
+  return chunks;
+}
+
+}  // namespace
+
+TlObjectArena::Guard::Guard(bool is_enabled) {
+  if (is_enabled) {
+    old_arena_ = current_arena_;
+    arena_ = new TlObjectArena();
+    current_arena_ = arena_;
+  }
+}
+
+TlObjectArena::Guard::~Guard() {
+  if (arena_ != nullptr) {
+    CHECK(current_arena_ == arena_);
+    current_arena_ = old_arena_;
+    arena_->dec_ref_cnt();
+  }
+}
+
+void *TlObjectArena::allocate(size_t size) {
+  auto *arena = current_arena_;
+  if (arena == nullptr) {
+    return ::operator new(size);
+  }
+  arena->ref_cnt_.fetch_add(1, std::memory_order_relaxed);
+  return arena->allocate_in_chunk(size);
+}
+
+void TlObjectArena::deallocate(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  // an object from an arena keeps the arena alive, so if there are no arenas, then the object isn't from an arena
+  if (arena_count_.load(std::memory_order_acquire) != 0) {
+    auto *arena = find_arena(ptr);
+    if (arena != nullptr) {
+      arena->dec_ref_cnt();
+      return;
+    }
+  }
+  ::operator delete(ptr);
+}
+
+TlObjectArena::TlObjectArena() {
+  arena_count_.fetch_add(1, std::memory_order_release);
+}
+
+TlObjectArena::~TlObjectArena() {
+  {
+    std::lock_guard<std::mutex> lock(get_arena_chunks_mutex());
+    auto &arena_chunks = get_arena_chunks();
+    for (auto *chunk : chunks_) {
+      auto it = arena_chunks.upper_bound(chunk);
+      CHECK(it != arena_chunks.end() && it->second.begin == chunk);
+      arena_chunks.erase(it);
+    }
+  }
+  for (auto *chunk : chunks_) {
+    ::operator delete(chunk);
+  }
+  arena_count_.fetch_sub(1, std::memory_order_release);
+}
+
+char *TlObjectArena::allocate_in_chunk(size_t size) {
+  static_assert(ALIGNMENT % alignof(std::max_align_t) == 0, "");
+  size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  if (static_cast<size_t>(end_ - begin_) < size) {
+    auto chunk_size = max(next_chunk_size_, size);
+    next_chunk_size_ = min(next_chunk_size_ * 2, MAX_CHUNK_SIZE);
+    begin_ = static_cast<char *>(::operator new(chunk_size));
+    end_ = begin_ + chunk_size;
+    chunks_.push_back(begin_);
+
+    std::lock_guard<std::mutex> lock(get_arena_chunks_mutex());
+    get_arena_chunks().emplace(end_, ArenaChunk{begin_, this});
+  }
+  auto *result = begin_;
+  begin_ += size;
+  return result;
+}
+
+TlObjectArena *TlObjectArena::find_arena(const void *ptr) {
+  auto *object = static_cast<const char *>(ptr);
+  std::lock_guard<std::mutex> lock(get_arena_chunks_mutex());
+  auto &arena_chunks = get_arena_chunks();
+  auto it = arena_chunks.upper_bound(object);
+  if (it == arena_chunks.end() || object < it->second.begin) {
+    return nullptr;
+  }
+  return it->second.arena;
+}
+
+void TlObjectArena::dec_ref_cnt() {
+  if (ref_cnt_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
+}  // namespace td
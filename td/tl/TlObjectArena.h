@@ -0,0 +1,75 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/thread_local.h"
+
+#include <atomic>
+
+namespace td {
+
+// Bump arena for TL objects, which are parsed from the same server response.
+// While a TlObjectArena::Guard exists, TL objects created on the current thread are allocated from its arena.
+// All memory of the arena is freed at once after the guard is destroyed and all objects from the arena are deleted,
+// so objects can be safely moved out of the response and deleted on any thread.
+// A single long-lived object keeps all chunks of its arena alive, so the arena must be used only for responses,
+// which are converted right after they are parsed.
+// Objects have no header; an object is found to be from an arena by its address, which is checked only while
+// at least one arena exists, so objects allocated without an arena have no overhead.
+class TlObjectArena {
+ public:
+  // arenas aren't worth using for smaller responses
+  static constexpr size_t MIN_INPUT_SIZE = 1 << 12;
+
+  class Guard {
+   public:
+    explicit Guard(bool is_enabled);
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+    Guard(Guard &&) = delete;
+    Guard &operator=(Guard &&) = delete;
+    ~Guard();
+
+   private:
+    TlObjectArena *arena_ = nullptr;
+    TlObjectArena *old_arena_ = nullptr;
+  };
+
+  static void *allocate(size_t size);
+
+  static void deallocate(void *ptr);
+
+ private:
+  static constexpr size_t ALIGNMENT = 16;  // keeps objects aligned as well as by ::operator new
+  static constexpr size_t MIN_CHUNK_SIZE = 1 << 14;
+  static constexpr size_t MAX_CHUNK_SIZE = 1 << 20;
+
+  std::atomic<size_t> ref_cnt_{1};  // number of live objects + 1 for the guard
+  vector<char *> chunks_;
+  char *begin_ = nullptr;
+  char *end_ = nullptr;
+  size_t next_chunk_size_ = MIN_CHUNK_SIZE;
+
+  static TD_THREAD_LOCAL TlObjectArena *current_arena_;
+  static std::atomic<int32> arena_count_;  // number of existing arenas
+
+  TlObjectArena();
+  TlObjectArena(const TlObjectArena &) = delete;
+  TlObjectArena &operator=(const TlObjectArena &) = delete;
+  TlObjectArena(TlObjectArena &&) = delete;
+  TlObjectArena &operator=(TlObjectArena &&) = delete;
+  ~TlObjectArena();
+
+  char *allocate_in_chunk(size_t size);
+
+  static TlObjectArena *find_arena(const void *ptr);
+
+  void dec_ref_cnt();
+};
+
+}  // namespace td
@@ -6,111 +6,241 @@
 //
 #include "td/actor/MultiTimeout.h"
 
+#include "td/utils/bits.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
 
 namespace td {
 
+constexpr int32 MultiTimeout::TICKS_PER_SECOND;
+constexpr int32 MultiTimeout::LEVEL_BITS;
+constexpr int32 MultiTimeout::LEVEL_COUNT;
+constexpr int32 MultiTimeout::SLOT_COUNT;
+constexpr int64 MultiTimeout::MAX_TICK_DELTA;
+
+// returns offset of the first occupied slot, starting from the slot with the given index
+static int32 get_occupied_slot_offset(uint64 occupied_slots, int32 index) {
+  CHECK(occupied_slots != 0);
+  auto rotated_slots = index == 0 ? occupied_slots : (occupied_slots >> index) | (occupied_slots << (64 - index));
+  return count_trailing_zeroes_non_zero64(rotated_slots);
+}
+
+int64 MultiTimeout::get_tick(double timeout) {
+  return static_cast<int64>(clamp(timeout, 0.0, 1e12) * TICKS_PER_SECOND);
+}
+
 bool MultiTimeout::has_timeout(int64 key) const {
-  return items_.count(Item(key)) > 0;
+  return items_.count(key) > 0;
+}
+
+void MultiTimeout::insert_item(Item *item) {
+  auto delta = clamp(item->tick - current_tick_, static_cast<int64>(0), MAX_TICK_DELTA);
+  auto tick = current_tick_ + delta;
+  int32 level = 0;
+  while (delta >= (static_cast<int64>(1) << (LEVEL_BITS * (level + 1)))) {
+    level++;
+  }
+  CHECK(level < LEVEL_COUNT);
+  item->level = level;
+  item->slot = static_cast<int32>((tick >> (LEVEL_BITS * level)) & (SLOT_COUNT - 1));
+  if (slots_[level] == nullptr) {
+    slots_[level] = make_unique<Slots>();
+  }
+  (*slots_[level])[item->slot].put(item);
+  occupied_slots_[level] |= static_cast<uint64>(1) << item->slot;
+}
+
+void MultiTimeout::remove_item(Item *item) {
+  auto &slot = (*slots_[item->level])[item->slot];
+  item->remove();
+  if (slot.empty()) {
+    occupied_slots_[item->level] &= ~(static_cast<uint64>(1) << item->slot);
+  }
+}
+
+void MultiTimeout::start_item(Item *item, double timeout) {
+  if (items_.size() == 1) {
+    // the wheel is empty, so it can be moved to the current time for free
+    current_tick_ = max(current_tick_, get_tick(Time::now()));
+  }
+  item->timeout = timeout;
+  item->tick = get_tick(timeout);
+  insert_item(item);
+  update_timeout();
 }
 
 void MultiTimeout::set_timeout_at(int64 key, double timeout) {
   LOG(DEBUG) << "Set " << get_name() << " for " << key << " in " << timeout - Time::now();
-  auto item = items_.emplace(key);
-  auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
-  if (heap_node->in_heap()) {
-    CHECK(!item.second);
-    bool need_update_timeout = heap_node->is_top();
-    timeout_queue_.fix(timeout, heap_node);
-    if (need_update_timeout || heap_node->is_top()) {
-      update_timeout("set_timeout");
-    }
-  } else {
-    CHECK(item.second);
-    timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout("set_timeout 2");
-    }
+  auto it = items_.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(key));
+  auto *item = &it.first->second;
+  if (!it.second) {
+    remove_item(item);
   }
+  start_item(item, timeout);
 }
 
 void MultiTimeout::add_timeout_at(int64 key, double timeout) {
   LOG(DEBUG) << "Add " << get_name() << " for " << key << " in " << timeout - Time::now();
-  auto item = items_.emplace(key);
-  auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
-  if (heap_node->in_heap()) {
-    CHECK(!item.second);
-  } else {
-    CHECK(item.second);
-    timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout("add_timeout");
-    }
+  auto it = items_.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(key));
+  if (it.second) {
+    start_item(&it.first->second, timeout);
   }
 }
 
 void MultiTimeout::cancel_timeout(int64 key, const char *source) {
-  LOG(DEBUG) << "Cancel " << get_name() << " for " << key;
-  auto item = items_.find(Item(key));
-  if (item != items_.end()) {
-    auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item));
-    CHECK(heap_node->in_heap());
-    bool need_update_timeout = heap_node->is_top();
-    timeout_queue_.erase(heap_node);
-    items_.erase(item);
-
-    if (need_update_timeout) {
-      update_timeout(source);
+  LOG(DEBUG) << "Cancel " << get_name() << " for " << key << " from " << source;
+  auto it = items_.find(key);
+  if (it != items_.end()) {
+    // the scheduled timeout is left as is; it will just find nothing to do
+    remove_item(&it->second);
+    items_.erase(it);
+  }
+}
+
+void MultiTimeout::cascade() {
+  for (int32 level = 1; level < LEVEL_COUNT; level++) {
+    auto index = static_cast<int32>((current_tick_ >> (LEVEL_BITS * level)) & (SLOT_COUNT - 1));
+    auto slot_mask = static_cast<uint64>(1) << index;
+    if ((occupied_slots_[level] & slot_mask) != 0) {
+      ListNode items = std::move((*slots_[level])[index]);
+      occupied_slots_[level] &= ~slot_mask;
+      while (auto *node = items.get()) {
+        insert_item(static_cast<Item *>(node));
+      }
+    }
+    if (index != 0) {
+      break;
     }
   }
 }
 
-void MultiTimeout::update_timeout(const char *source) {
-  if (items_.empty()) {
-    LOG(DEBUG) << "Cancel timeout of " << get_name();
-    LOG_CHECK(timeout_queue_.empty()) << get_name() << ' ' << source;
-    if (!Actor::has_timeout()) {
-      bool has_pending_timeout = false;
-      for (auto &event : get_info()->mailbox_) {
-        if (event.type == Event::Type::Timeout) {
-          has_pending_timeout = true;
+void MultiTimeout::advance(int64 now_tick, vector<Item *> &expired_items) {
+  while (current_tick_ < now_tick) {
+    int32 level = 0;
+    while (level < LEVEL_COUNT && occupied_slots_[level] == 0) {
+      level++;
+    }
+    if (level == LEVEL_COUNT) {
+      current_tick_ = now_tick;
+      break;
+    }
+
+    int64 next_tick;
+    if (level == 0) {
+      auto index = static_cast<int32>(current_tick_ & (SLOT_COUNT - 1));
+      auto current_rotation_slots = occupied_slots_[0] >> index;
+      if (current_rotation_slots != 0) {
+        auto tick = current_tick_ + count_trailing_zeroes_non_zero64(current_rotation_slots);
+        if (tick >= now_tick) {
+          current_tick_ = now_tick;
+          break;
+        }
+        auto slot_index = static_cast<int32>(tick & (SLOT_COUNT - 1));
+        auto &slot = (*slots_[0])[slot_index];
+        while (auto *node = slot.get()) {
+          expired_items.push_back(static_cast<Item *>(node));
         }
+        occupied_slots_[0] &= ~(static_cast<uint64>(1) << slot_index);
+        next_tick = tick + 1;
+      } else {
+        next_tick = current_tick_ - index + SLOT_COUNT;
       }
-      LOG_CHECK(has_pending_timeout) << get_name() << ' ' << get_info()->mailbox_.size() << ' ' << source;
     } else {
-      Actor::cancel_timeout();
+      // all lower levels are empty, so skip ticks up to the next change of the slot on the level
+      auto level_ticks = static_cast<int64>(1) << (LEVEL_BITS * level);
+      next_tick = (current_tick_ & ~(level_ticks - 1)) + level_ticks;
+    }
+    if (next_tick > now_tick) {
+      current_tick_ = now_tick;
+      break;
+    }
+    current_tick_ = next_tick;
+    if ((current_tick_ & (SLOT_COUNT - 1)) == 0) {
+      cascade();
+    }
+  }
+}
+
+int64 MultiTimeout::get_next_tick() const {
+  int64 result = -1;
+  for (int32 level = 0; level < LEVEL_COUNT; level++) {
+    if (occupied_slots_[level] == 0) {
+      continue;
+    }
+    int64 tick;
+    if (level == 0) {
+      auto index = static_cast<int32>(current_tick_ & (SLOT_COUNT - 1));
+      tick = current_tick_ + get_occupied_slot_offset(occupied_slots_[0], index);
+    } else {
+      // the slot with the current index contains only items for the next rotation,
+      // so the items will be moved to the lower levels when the next occupied slot is reached
+      auto shift = LEVEL_BITS * level;
+      auto index = static_cast<int32>((current_tick_ >> shift) & (SLOT_COUNT - 1));
+      auto offset = get_occupied_slot_offset(occupied_slots_[level], (index + 1) & (SLOT_COUNT - 1));
+      tick = ((current_tick_ >> shift) + 1 + offset) << shift;
+    }
+    if (result == -1 || tick < result) {
+      result = tick;
     }
-  } else {
-    LOG(DEBUG) << "Set timeout of " << get_name() << " in " << timeout_queue_.top_key() - Time::now_cached();
-    Actor::set_timeout_at(timeout_queue_.top_key());
   }
+  return result;
 }
 
-vector<int64> MultiTimeout::get_expired_keys(double now) {
+void MultiTimeout::update_timeout() {
+  auto next_tick = get_next_tick();
+  if (next_tick == -1) {
+    return;
+  }
+  if (wakeup_tick_ == -1 || next_tick < wakeup_tick_) {
+    wakeup_tick_ = next_tick;
+    // wake up in the middle of the next tick to be sure that the ticks up to next_tick inclusive have passed
+    LOG(DEBUG) << "Set timeout of " << get_name() << " in "
+               << (static_cast<double>(next_tick) + 1.5) / TICKS_PER_SECOND - Time::now_cached();
+    Actor::set_timeout_at((static_cast<double>(next_tick) + 1.5) / TICKS_PER_SECOND);
+  }
+}
+
+vector<int64> MultiTimeout::get_expired_keys(vector<Item *> &&expired_items) {
+  std::stable_sort(expired_items.begin(), expired_items.end(),
+                   [](const Item *lhs, const Item *rhs) { return lhs->timeout < rhs->timeout; });
   vector<int64> expired_keys;
-  while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
-    int64 key = static_cast<Item *>(timeout_queue_.pop())->key;
-    items_.erase(Item(key));
-    expired_keys.push_back(key);
+  expired_keys.reserve(expired_items.size());
+  for (auto *item : expired_items) {
+    expired_keys.push_back(item->key);
+    items_.erase(item->key);
   }
   return expired_keys;
 }
 
 void MultiTimeout::timeout_expired() {
-  vector<int64> expired_keys = get_expired_keys(Time::now_cached());
-  if (!items_.empty()) {
-    update_timeout("timeout_expired");
-  }
+  vector<Item *> expired_items;
+  advance(get_tick(Time::now_cached()), expired_items);
+  vector<int64> expired_keys = get_expired_keys(std::move(expired_items));
+  wakeup_tick_ = -1;
+  update_timeout();
   for (auto key : expired_keys) {
     callback_(data_, key);
   }
 }
 
 void MultiTimeout::run_all() {
-  vector<int64> expired_keys = get_expired_keys(Time::now_cached() + 1e10);
-  if (!expired_keys.empty()) {
-    update_timeout("run_all");
+  vector<Item *> expired_items;
+  for (int32 level = 0; level < LEVEL_COUNT; level++) {
+    if (slots_[level] == nullptr) {
+      continue;
+    }
+    for (auto &slot : *slots_[level]) {
+      while (auto *node = slot.get()) {
+        expired_items.push_back(static_cast<Item *>(node));
+      }
+    }
+    occupied_slots_[level] = 0;
   }
+  vector<int64> expired_keys = get_expired_keys(std::move(expired_items));
   for (auto key : expired_keys) {
     callback_(data_, key);
   }
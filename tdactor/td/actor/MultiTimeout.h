@@ -9,31 +9,40 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
-#include "td/utils/Heap.h"
+#include "td/utils/HashTableUtils.h"
+#include "td/utils/List.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Time.h"
 
-#include <set>
+#include <array>
+#include <unordered_map>
 
 namespace td {
 
-// TODO optimize
+// Timeouts are kept in a hierarchical timing wheel with millisecond ticks, so they can be set and cancelled
+// in constant time. Because of the tick granularity, callbacks can be called up to 2 milliseconds later than needed.
 class MultiTimeout final : public Actor {
-  struct Item final : public HeapNode {
+  struct Item final : public ListNode {
     int64 key;
+    double timeout = 0.0;
+    int64 tick = 0;
+    int32 level = 0;
+    int32 slot = 0;
 
     explicit Item(int64 key) : key(key) {
     }
-
-    bool operator<(const Item &other) const {
-      return key < other.key;
-    }
   };
 
+  static constexpr int32 TICKS_PER_SECOND = 1000;
+  static constexpr int32 LEVEL_BITS = 6;
+  static constexpr int32 LEVEL_COUNT = 4;
+  static constexpr int32 SLOT_COUNT = 1 << LEVEL_BITS;  // must be equal to the number of bits in occupied_slots_
+  static constexpr int64 MAX_TICK_DELTA = (static_cast<int64>(1) << (LEVEL_BITS * LEVEL_COUNT)) - 1;
+
  public:
   using Data = void *;
   using Callback = void (*)(Data, int64);
-  explicit MultiTimeout(Slice name) {
+  explicit MultiTimeout(Slice name) : current_tick_(get_tick(Time::now())) {
     register_actor(name, this).release();
   }
 
@@ -68,14 +77,34 @@ class MultiTimeout final : public Actor {
   Callback callback_;
   Data data_;
 
-  KHeap<double> timeout_queue_;
-  std::set<Item> items_;
+  // slots of a level are allocated on first use, because most instances have no or only short timeouts
+  using Slots = std::array<ListNode, SLOT_COUNT>;
+  std::array<unique_ptr<Slots>, LEVEL_COUNT> slots_;
+  std::array<uint64, LEVEL_COUNT> occupied_slots_{};
+  std::unordered_map<int64, Item, Hash<int64>> items_;
+
+  int64 current_tick_ = 0;  // the first tick, which wasn't processed yet
+  int64 wakeup_tick_ = -1;  // the tick after which timeout_expired is scheduled
+
+  static int64 get_tick(double timeout);
+
+  void insert_item(Item *item);
+
+  void remove_item(Item *item);
+
+  void start_item(Item *item, double timeout);
+
+  void cascade();
+
+  void advance(int64 now_tick, vector<Item *> &expired_items);
+
+  int64 get_next_tick() const;
 
-  void update_timeout(const char *source);
+  void update_timeout();
 
   void timeout_expired() final;
 
-  vector<int64> get_expired_keys(double now);
+  vector<int64> get_expired_keys(vector<Item *> &&expired_items);
 };
 
 }  // namespace td
@@ -12,6 +12,9 @@
 #include "td/utils/logging.h"
 #include "td/utils/Random.h"
 #include "td/utils/tests.h"
+#include "td/utils/Time.h"
+
+#include <map>
 
 TEST(MultiTimeout, bug) {
   td::ConcurrentScheduler sched(0, 0);
@@ -110,3 +113,95 @@ TEST(MultiTimeout, Destroy) {
   }
   sched.finish();
 }
+
+class MultiTimeoutStress final : public td::Actor {
+ public:
+  MultiTimeoutStress() {
+    test_timeout_.set_callback(on_test_timeout_callback);
+    test_timeout_.set_callback_data(static_cast<void *>(this));
+  }
+
+ private:
+  static void on_test_timeout_callback(void *stress_ptr, td::int64 key) {
+    auto stress = static_cast<MultiTimeoutStress *>(stress_ptr);
+    auto it = stress->timeouts_.find(key);
+    CHECK(it != stress->timeouts_.end());
+    CHECK(it->second < td::Time::now());
+    stress->timeouts_.erase(it);
+  }
+
+  void start_up() final {
+    loop();
+  }
+
+  void loop() final {
+    if (step_ == STEP_COUNT) {
+      // all timeouts, including the ones that don't fit in the timing wheel, must expire
+      td::Time::jump_in_future(td::Time::now() + 1e7);
+      step_++;
+    }
+    if (step_ > STEP_COUNT) {
+      if (timeouts_.empty()) {
+        td::Scheduler::instance()->finish();
+        return;
+      }
+      CHECK(step_++ < 2 * STEP_COUNT);
+      set_timeout_in(0.01);
+      return;
+    }
+
+    step_++;
+    for (int i = 0; i < 100; i++) {
+      td::int64 key = td::Random::fast(0, 999);
+      CHECK(test_timeout_.has_timeout(key) == (timeouts_.count(key) != 0));
+      auto timeout = td::Time::now();
+      switch (td::Random::fast(0, 2)) {
+        case 0:
+          timeout += td::Random::fast(0, 100) * 1e-3;
+          break;
+        case 1:
+          timeout += td::Random::fast(0, 100000) * 1e-3;
+          break;
+        case 2:
+          timeout += td::Random::fast(0, 1000000);
+          break;
+      }
+      switch (td::Random::fast(0, 3)) {
+        case 0:
+          test_timeout_.cancel_timeout(key);
+          timeouts_.erase(key);
+          break;
+        case 1:
+          test_timeout_.add_timeout_at(key, timeout);
+          timeouts_.emplace(key, timeout);
+          break;
+        default:
+          test_timeout_.set_timeout_at(key, timeout);
+          timeouts_[key] = timeout;
+          break;
+      }
+    }
+    if (td::Random::fast(0, 9) == 0) {
+      td::Time::jump_in_future(td::Time::now() + td::Random::fast(0, 100000) * 0.1);
+    }
+    set_timeout_in(0.001);
+  }
+
+  static constexpr int STEP_COUNT = 1000;
+
+  td::MultiTimeout test_timeout_{"StressTimeout"};
+  std::map<td::int64, double> timeouts_;
+  int step_ = 0;
+};
+
+constexpr int MultiTimeoutStress::STEP_COUNT;
+
+TEST(MultiTimeout, stress) {
+  td::ConcurrentScheduler sched(0, 0);
+  sched.create_actor_unsafe<MultiTimeoutStress>(0, "MultiTimeoutStress").release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+}
@@ -10,6 +10,8 @@
 #include "td/utils/logging.h"
 #include "td/utils/ScopeGuard.h"
 
+#include <utility>
+
 namespace td {
 
 Status SqliteKeyValue::init_with_connection(SqliteDb connection, string table_name) {
@@ -23,6 +25,12 @@ Status SqliteKeyValue::init_with_connection(SqliteDb connection, string table_na
   TRY_RESULT_ASSIGN(set_stmt_,
                     db_.get_statement(PSLICE() << "REPLACE INTO " << table_name_ << " (k, v) VALUES (?1, ?2)"));
   TRY_RESULT_ASSIGN(get_stmt_, db_.get_statement(PSLICE() << "SELECT v FROM " << table_name_ << " WHERE k = ?1"));
+  string get_batch_query = PSTRING() << "SELECT k, v FROM " << table_name_ << " WHERE k IN (?1";
+  for (int i = 2; i <= GET_BATCH_SIZE; i++) {
+    get_batch_query += PSTRING() << ", ?" << i;
+  }
+  get_batch_query += ')';
+  TRY_RESULT_ASSIGN(get_batch_stmt_, db_.get_statement(get_batch_query));
   TRY_RESULT_ASSIGN(erase_stmt_, db_.get_statement(PSLICE() << "DELETE FROM " << table_name_ << " WHERE k = ?1"));
   TRY_RESULT_ASSIGN(get_all_stmt_, db_.get_statement(PSLICE() << "SELECT k, v FROM " << table_name_));
 
@@ -82,6 +90,47 @@ string SqliteKeyValue::get(Slice key) {
   return data;
 }
 
+vector<string> SqliteKeyValue::get_batch(const vector<string> &keys) {
+  vector<string> result(keys.size());
+  FlatHashMap<Slice, size_t, SliceHash> key_to_pos;
+  vector<std::pair<size_t, size_t>> duplicate_keys;
+  vector<Slice> unique_keys;
+  for (size_t i = 0; i < keys.size(); i++) {
+    CHECK(!keys[i].empty());
+    auto it = key_to_pos.emplace(keys[i], i);
+    if (it.second) {
+      unique_keys.push_back(keys[i]);
+    } else {
+      duplicate_keys.emplace_back(i, it.first->second);
+    }
+  }
+
+  begin_read_transaction().ensure();
+  for (size_t offset = 0; offset < unique_keys.size(); offset += GET_BATCH_SIZE) {
+    auto guard = get_batch_stmt_.guard();
+    for (int i = 0; i < GET_BATCH_SIZE; i++) {
+      if (offset + i < unique_keys.size()) {
+        get_batch_stmt_.bind_blob(i + 1, unique_keys[offset + i]).ensure();
+      } else {
+        get_batch_stmt_.bind_null(i + 1).ensure();
+      }
+    }
+    get_batch_stmt_.step().ensure();
+    while (get_batch_stmt_.has_row()) {
+      auto it = key_to_pos.find(get_batch_stmt_.view_blob(0));
+      CHECK(it != key_to_pos.end());
+      result[it->second] = get_batch_stmt_.view_blob(1).str();
+      get_batch_stmt_.step().ensure();
+    }
+  }
+  commit_transaction().ensure();
+
+  for (auto &duplicate_key : duplicate_keys) {
+    result[duplicate_key.first] = result[duplicate_key.second];
+  }
+  return result;
+}
+
 void SqliteKeyValue::erase(Slice key) {
   erase_stmt_.bind_blob(1, key).ensure();
   erase_stmt_.step().ensure();
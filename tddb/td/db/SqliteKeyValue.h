@@ -45,6 +45,9 @@ class SqliteKeyValue {
 
   string get(Slice key);
 
+  // returns values in the order of the keys; an empty string is returned for a missing key
+  vector<string> get_batch(const vector<string> &keys);
+
   void erase(Slice key);
 
   void erase_batch(vector<string> keys);
@@ -117,9 +120,12 @@ class SqliteKeyValue {
     }
   }
 
+  static constexpr int GET_BATCH_SIZE = 32;
+
   string table_name_;
   SqliteDb db_;
   SqliteStatement get_stmt_;
+  SqliteStatement get_batch_stmt_;
   SqliteStatement set_stmt_;
   SqliteStatement erase_stmt_;
   SqliteStatement get_all_stmt_;
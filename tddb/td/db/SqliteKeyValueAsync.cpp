@@ -36,6 +36,9 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
   void get(string key, Promise<string> promise) final {
     send_closure_later(impl_, &Impl::get, std::move(key), std::move(promise));
   }
+  void get_batch(vector<string> keys, Promise<vector<string>> promise) final {
+    send_closure_later(impl_, &Impl::get_batch, std::move(keys), std::move(promise));
+  }
   void close(Promise<Unit> promise) final {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
@@ -96,6 +99,19 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       promise.set_value(kv_->get(key));
     }
 
+    void get_batch(const vector<string> &keys, Promise<vector<string>> promise) {
+      auto values = kv_->get_batch(keys);
+      if (!buffer_.empty()) {
+        for (size_t i = 0; i < keys.size(); i++) {
+          auto it = buffer_.find(keys[i]);
+          if (it != buffer_.end()) {
+            values[i] = it->second ? it->second.value() : string();
+          }
+        }
+      }
+      promise.set_value(std::move(values));
+    }
+
     void close(Promise<Unit> promise) {
       do_flush(true /*force*/);
       kv_safe_.reset();
@@ -30,6 +30,8 @@ class SqliteKeyValueAsyncInterface {
 
   virtual void get(string key, Promise<string> promise) = 0;
 
+  virtual void get_batch(vector<string> keys, Promise<vector<string>> promise) = 0;
+
   virtual void close(Promise<Unit> promise) = 0;
 };
 
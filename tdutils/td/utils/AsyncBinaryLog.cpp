@@ -0,0 +1,545 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/AsyncBinaryLog.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/ExitGuard.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Time.h"
+
+namespace td {
+
+namespace {
+
+// record header: time, file name, line number, thread identifier, log level and flags
+constexpr size_t RECORD_HEADER_SIZE = sizeof(double) + sizeof(const char *) + 4 * sizeof(int32);
+constexpr size_t RECORD_LOG_LEVEL_OFFSET = sizeof(double) + sizeof(const char *) + 2 * sizeof(int32);
+
+constexpr int32 RECORD_HAS_PREFIX = 1 << 0;    // the record has tags and needs a prefix
+constexpr int32 RECORD_IS_FORMATTED = 1 << 1;  // the record consists of already formatted text
+
+class RecordParser {
+ public:
+  explicit RecordParser(Slice record) : ptr_(record.begin()), end_(record.end()) {
+  }
+
+  bool empty() const {
+    return ptr_ == end_;
+  }
+
+  template <class T>
+  T fetch() {
+    T result;
+    CHECK(static_cast<size_t>(end_ - ptr_) >= sizeof(T));
+    std::memcpy(&result, ptr_, sizeof(T));
+    ptr_ += sizeof(T);
+    return result;
+  }
+
+  Slice fetch_string() {
+    auto size = fetch<uint32>();
+    CHECK(static_cast<size_t>(end_ - ptr_) >= size);
+    Slice result(ptr_, size);
+    ptr_ += size;
+    return result;
+  }
+
+ private:
+  const char *ptr_;
+  const char *end_;
+};
+
+}  // namespace
+
+DeferredLogRecord::DeferredLogRecord(int log_level, const char *file_name, int line_num, Slice comment)
+    : buffer_(StackAllocator::alloc(BUFFER_SIZE)), log_level_(log_level) {
+  auto slice = buffer_.as_slice();
+  begin_ = slice.begin();
+  ptr_ = begin_;
+  end_ = slice.end();
+
+  bool has_prefix = log_level != VERBOSITY_NAME(PLAIN) && log_options.add_info;
+  store_raw(Clocks::system());
+  store_raw(file_name);
+  store_raw(static_cast<int32>(line_num));
+  store_raw(get_thread_id());
+  store_raw(static_cast<int32>(log_level));
+  store_raw(has_prefix ? RECORD_HAS_PREFIX : 0);
+  if (has_prefix) {
+    store_string(Logger::tag_ == nullptr ? Slice() : Slice(Logger::tag_));
+    store_string(Logger::tag2_ == nullptr ? Slice() : Slice(Logger::tag2_));
+    store_string(comment);
+  }
+}
+
+DeferredLogRecord::~DeferredLogRecord() {
+  if (ExitGuard::is_exited()) {
+    return;
+  }
+  Slice record(begin_, ptr_);
+#if !TD_THREAD_UNSUPPORTED
+  if (log_level_ != VERBOSITY_NAME(FATAL) && AsyncBinaryLog::push_record(log_level_, record)) {
+    return;
+  }
+#endif
+
+  auto buffer = StackAllocator::alloc(BUFFER_SIZE * 2);
+  StringBuilder sb(buffer.as_slice());
+  log_interface->append(log_level_, format(record, sb));
+}
+
+void DeferredLogRecord::store_string(Slice slice) {
+  auto left = static_cast<size_t>(end_ - ptr_);
+  if (left < 1 + sizeof(uint32)) {
+    ptr_ = end_;
+    return;
+  }
+  slice.truncate(left - 1 - sizeof(uint32));
+  auto size = static_cast<uint32>(slice.size());
+  *ptr_++ = static_cast<char>(ArgType::String);
+  std::memcpy(ptr_, &size, sizeof(size));
+  ptr_ += sizeof(size);
+  std::memcpy(ptr_, slice.data(), size);
+  ptr_ += size;
+}
+
+Slice DeferredLogRecord::create_formatted_record_header(MutableSlice buffer, int log_level, size_t text_size) {
+  static_assert(FORMATTED_RECORD_HEADER_SIZE == RECORD_HEADER_SIZE + 1 + sizeof(uint32), "");
+  CHECK(buffer.size() >= FORMATTED_RECORD_HEADER_SIZE);
+  auto ptr = buffer.begin();
+  auto store = [&ptr](const auto &value) {
+    std::memcpy(ptr, &value, sizeof(value));
+    ptr += sizeof(value);
+  };
+  store(Clocks::system());
+  store(static_cast<const char *>(nullptr));
+  store(static_cast<int32>(0));
+  store(get_thread_id());
+  store(static_cast<int32>(log_level));
+  store(RECORD_IS_FORMATTED);
+  store(static_cast<char>(ArgType::String));
+  store(static_cast<uint32>(text_size));
+  return Slice(buffer.begin(), ptr);
+}
+
+MutableCSlice DeferredLogRecord::format(Slice record, StringBuilder &sb) {
+  RecordParser parser(record);
+  auto time = parser.fetch<double>();
+  auto file_name = parser.fetch<const char *>();
+  auto line_num = parser.fetch<int32>();
+  auto thread_id = parser.fetch<int32>();
+  auto log_level = parser.fetch<int32>();
+  auto flags = parser.fetch<int32>();
+  if ((flags & RECORD_HAS_PREFIX) != 0) {
+    CHECK(parser.fetch<char>() == static_cast<char>(ArgType::String));
+    auto tag = parser.fetch_string();
+    CHECK(parser.fetch<char>() == static_cast<char>(ArgType::String));
+    auto tag2 = parser.fetch_string();
+    CHECK(parser.fetch<char>() == static_cast<char>(ArgType::String));
+    auto comment = parser.fetch_string();
+    detail::append_log_prefix(sb, log_level, thread_id, time, file_name == nullptr ? Slice() : Slice(file_name),
+                              line_num, tag, tag2, comment);
+  }
+
+  while (!parser.empty()) {
+    auto type = static_cast<ArgType>(parser.fetch<char>());
+    switch (type) {
+      case ArgType::Int:
+        sb << parser.fetch<int64>();
+        break;
+      case ArgType::UInt:
+        sb << parser.fetch<uint64>();
+        break;
+      case ArgType::Double:
+        sb << parser.fetch<double>();
+        break;
+      case ArgType::Bool:
+        sb << parser.fetch<bool>();
+        break;
+      case ArgType::Char:
+        sb << parser.fetch<char>();
+        break;
+      case ArgType::String:
+        sb << parser.fetch_string();
+        break;
+      default:
+        UNREACHABLE();
+    }
+  }
+
+  if ((flags & RECORD_IS_FORMATTED) != 0) {
+    return sb.as_cslice();
+  }
+  return detail::finish_log_message(sb, log_options.fix_newlines);
+}
+
+double DeferredLogRecord::get_time(Slice record) {
+  CHECK(record.size() >= RECORD_HEADER_SIZE);
+  double time;
+  std::memcpy(&time, record.begin(), sizeof(time));
+  return time;
+}
+
+int DeferredLogRecord::get_log_level(Slice record) {
+  CHECK(record.size() >= RECORD_HEADER_SIZE);
+  int32 log_level;
+  std::memcpy(&log_level, record.begin() + RECORD_LOG_LEVEL_OFFSET, sizeof(log_level));
+  return log_level;
+}
+
+#if !TD_THREAD_UNSUPPORTED
+
+// single-producer single-consumer queue of records
+class AsyncBinaryLog::Ring {
+  static constexpr size_t MIN_SIZE = 1 << 14;
+  static constexpr size_t MAX_SIZE = MAX_RECORD_SIZE * 4;
+  static constexpr size_t FRAME_HEADER_SIZE = 8;  // payload size and frame type
+  static constexpr uint32 RECORD_FRAME = 0;
+  static constexpr uint32 PADDING_FRAME = 1;
+
+  static size_t get_frame_size(size_t payload_size) {
+    return (FRAME_HEADER_SIZE + payload_size + 7) & ~static_cast<size_t>(7);
+  }
+
+ public:
+  // returns the minimum size of a ring which can hold at least a few records of the given size
+  static size_t get_size(size_t payload_size) {
+    size_t size = MIN_SIZE;
+    while (size < MAX_SIZE && size < 4 * get_frame_size(payload_size)) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  Ring(uint64 log_id, size_t size) : log_id_(log_id), size_(size), data_(new char[size]) {
+    CHECK(size >= MIN_SIZE && size <= MAX_SIZE && (size & (size - 1)) == 0);
+  }
+
+  uint64 get_log_id() const {
+    return log_id_;
+  }
+
+  size_t get_size() const {
+    return size_;
+  }
+
+  void close() {
+    is_closed_.store(true, std::memory_order_release);
+  }
+
+  bool is_closed() const {
+    return is_closed_.load(std::memory_order_acquire);
+  }
+
+  bool is_empty() const {
+    return reader_.read_pos_.load(std::memory_order_acquire) == writer_.write_pos_.load(std::memory_order_acquire);
+  }
+
+  // can be called only by the writer
+  bool try_push(Slice header, Slice body) {
+    auto payload_size = header.size() + body.size();
+    CHECK(payload_size <= MAX_RECORD_SIZE);
+    auto frame_size = get_frame_size(payload_size);
+    auto write_pos = writer_.write_pos_.load(std::memory_order_relaxed);
+    auto offset = static_cast<size_t>(write_pos & (size_ - 1));
+    auto tail_size = size_ - offset;
+    auto need_size = frame_size <= tail_size ? frame_size : frame_size + tail_size;
+    CHECK(need_size <= size_);
+    if (write_pos + need_size - writer_.cached_read_pos_ > size_) {
+      writer_.cached_read_pos_ = reader_.read_pos_.load(std::memory_order_acquire);
+      if (write_pos + need_size - writer_.cached_read_pos_ > size_) {
+        return false;
+      }
+    }
+
+    if (frame_size > tail_size) {
+      store_frame_header(offset, tail_size - FRAME_HEADER_SIZE, PADDING_FRAME);
+      write_pos += tail_size;
+      offset = 0;
+    }
+    store_frame_header(offset, payload_size, RECORD_FRAME);
+    auto ptr = &data_[offset + FRAME_HEADER_SIZE];
+    std::memcpy(ptr, header.data(), header.size());
+    std::memcpy(ptr + header.size(), body.data(), body.size());
+    writer_.write_pos_.store(write_pos + frame_size, std::memory_order_release);
+    return true;
+  }
+
+  // can be called only by the reader; returns an empty slice if there are no records
+  Slice peek() {
+    auto read_pos = reader_.read_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      if (read_pos == reader_.cached_write_pos_) {
+        reader_.cached_write_pos_ = writer_.write_pos_.load(std::memory_order_acquire);
+        if (read_pos == reader_.cached_write_pos_) {
+          return Slice();
+        }
+      }
+      auto offset = static_cast<size_t>(read_pos & (size_ - 1));
+      uint32 frame_header[2];
+      std::memcpy(frame_header, &data_[offset], sizeof(frame_header));
+      auto frame_size = get_frame_size(frame_header[0]);
+      if (frame_header[1] == PADDING_FRAME) {
+        read_pos += frame_size;
+        reader_.read_pos_.store(read_pos, std::memory_order_release);
+        continue;
+      }
+      reader_.peeked_frame_size_ = frame_size;
+      return Slice(&data_[offset + FRAME_HEADER_SIZE], frame_header[0]);
+    }
+  }
+
+  // can be called only by the reader after a successful peek
+  void pop() {
+    CHECK(reader_.peeked_frame_size_ != 0);
+    reader_.read_pos_.store(reader_.read_pos_.load(std::memory_order_relaxed) + reader_.peeked_frame_size_,
+                            std::memory_order_release);
+    reader_.peeked_frame_size_ = 0;
+  }
+
+ private:
+  uint64 log_id_;
+  size_t size_;
+  std::unique_ptr<char[]> data_;
+  std::atomic<bool> is_closed_{false};
+
+  // positions are kept in different cache lines to avoid false sharing between the writer and the reader
+  struct Writer {
+    char pad[TD_CONCURRENCY_PAD];
+    std::atomic<uint64> write_pos_{0};
+    uint64 cached_read_pos_ = 0;
+  } writer_;
+
+  struct Reader {
+    char pad[TD_CONCURRENCY_PAD];
+    std::atomic<uint64> read_pos_{0};
+    uint64 cached_write_pos_ = 0;
+    size_t peeked_frame_size_ = 0;
+    char pad2[TD_CONCURRENCY_PAD];
+  } reader_;
+
+  void store_frame_header(size_t offset, size_t payload_size, uint32 type) {
+    uint32 frame_header[2] = {static_cast<uint32>(payload_size), type};
+    std::memcpy(&data_[offset], frame_header, sizeof(frame_header));
+  }
+};
+
+struct AsyncBinaryLog::ThreadRing {
+  std::shared_ptr<Ring> ring;
+
+  ThreadRing() = default;
+  ThreadRing(const ThreadRing &) = delete;
+  ThreadRing &operator=(const ThreadRing &) = delete;
+  ThreadRing(ThreadRing &&) = delete;
+  ThreadRing &operator=(ThreadRing &&) = delete;
+  ~ThreadRing() {
+    if (ring != nullptr) {
+      ring->close();
+    }
+    is_thread_ring_destroyed_ = true;
+  }
+};
+
+TD_THREAD_LOCAL AsyncBinaryLog::ThreadRing *AsyncBinaryLog::thread_ring_;  // static zero-initialized
+TD_THREAD_LOCAL bool AsyncBinaryLog::is_thread_ring_destroyed_;
+
+std::atomic<AsyncBinaryLog *> AsyncBinaryLog::active_log_{nullptr};
+std::atomic<int32> AsyncBinaryLog::push_record_count_{0};
+
+static std::atomic<uint64> next_async_binary_log_id{0};
+
+void AsyncBinaryLog::init(LogInterface *log) {
+  CHECK(log_ == nullptr);
+  CHECK(log != nullptr);
+  log_ = log;
+  id_ = ++next_async_binary_log_id;
+  shared_ring_ = std::make_shared<Ring>(id_, Ring::get_size(MAX_RECORD_SIZE));
+  rings_.push_back(shared_ring_);
+  logging_thread_ = td::thread([this] { run(); });
+  active_log_.store(this, std::memory_order_release);
+}
+
+AsyncBinaryLog::~AsyncBinaryLog() {
+  if (log_ == nullptr) {
+    return;
+  }
+  AsyncBinaryLog *log = this;
+  active_log_.compare_exchange_strong(log, nullptr);
+
+  // wait for threads, which could have loaded the pointer to the log before it was reset, and for other writers;
+  // all their records must be in the rings before the logging thread is asked to finish
+  while (push_record_count_.load() != 0 || producer_count_.load() != 0) {
+    usleep_for(100);
+  }
+
+  is_closed_.store(true, std::memory_order_release);
+  logging_thread_.join();
+}
+
+bool AsyncBinaryLog::push_record(int log_level, Slice record) {
+  // the counter must be increased before active_log_ is loaded, so the destructor waits for the push to finish
+  push_record_count_.fetch_add(1);
+  auto *log = active_log_.load();
+  bool is_pushed = false;
+  if (log != nullptr && log == log_interface) {
+    log->push(record, Slice());
+    is_pushed = true;
+  }
+  push_record_count_.fetch_sub(1, std::memory_order_release);
+  return is_pushed;
+}
+
+void AsyncBinaryLog::push(Slice header, Slice body) {
+  if (is_thread_ring_destroyed_) {
+    std::lock_guard<std::mutex> guard(shared_ring_mutex_);
+    push_to_ring(shared_ring_.get(), header, body);
+    return;
+  }
+
+  init_thread_local<ThreadRing>(thread_ring_);
+  auto &ring = thread_ring_->ring;
+  auto ring_size = Ring::get_size(header.size() + body.size());
+  if (ring == nullptr || ring->get_log_id() != id_ || ring->get_size() < ring_size) {
+    // rings are small by default and are replaced with bigger rings only if a thread writes a big record;
+    // records from the old ring are still read first, because they were created earlier
+    if (ring != nullptr) {
+      ring->close();
+    }
+    ring = std::make_shared<Ring>(id_, ring_size);
+    std::lock_guard<std::mutex> guard(mutex_);
+    rings_.push_back(ring);
+  }
+  push_to_ring(ring.get(), header, body);
+}
+
+void AsyncBinaryLog::push_to_ring(Ring *ring, Slice header, Slice body) {
+  while (!ring->try_push(header, body)) {
+    if (is_finished_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    usleep_for(100);
+  }
+}
+
+bool AsyncBinaryLog::is_empty() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto &ring : rings_) {
+    if (!ring->is_empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AsyncBinaryLog::run() {
+  static constexpr size_t MAX_BATCH_SIZE = 1 << 16;
+  auto buffer = std::make_unique<char[]>(MAX_RECORD_SIZE * 2);
+  string batch;
+  int batch_log_level = 0;
+  auto flush = [&] {
+    if (!batch.empty()) {
+      log_->do_append(batch_log_level, batch);
+      batch.clear();
+    }
+  };
+
+  vector<std::shared_ptr<Ring>> rings;
+  while (true) {
+    bool is_closed = is_closed_.load(std::memory_order_acquire);
+    if (need_rotation_.exchange(false)) {
+      flush();
+      log_->after_rotation();
+    }
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      td::remove_if(rings_, [](const auto &ring) { return ring->is_closed() && ring->is_empty(); });
+      rings = rings_;
+    }
+
+    // merge records from all threads in the order of their creation
+    bool has_records = false;
+    while (true) {
+      Ring *best_ring = nullptr;
+      Slice best_record;
+      double best_time = 0.0;
+      for (auto &ring : rings) {
+        auto record = ring->peek();
+        if (record.empty()) {
+          continue;
+        }
+        auto time = DeferredLogRecord::get_time(record);
+        if (best_ring == nullptr || time < best_time) {
+          best_ring = ring.get();
+          best_record = record;
+          best_time = time;
+        }
+      }
+      if (best_ring == nullptr) {
+        break;
+      }
+      has_records = true;
+
+      auto log_level = DeferredLogRecord::get_log_level(best_record);
+      StringBuilder sb(MutableSlice(buffer.get(), MAX_RECORD_SIZE * 2));
+      auto text = DeferredLogRecord::format(best_record, sb);
+      best_ring->pop();
+
+      if (log_level != batch_log_level || batch.size() + text.size() > MAX_BATCH_SIZE) {
+        flush();
+      }
+      batch_log_level = log_level;
+      batch.append(text.data(), text.size());
+    }
+    flush();
+
+    if (!has_records) {
+      if (is_closed) {
+        // all writers have finished before the log was closed, so there are no more records
+        break;
+      }
+      usleep_for(1000);
+    }
+  }
+  is_finished_.store(true, std::memory_order_relaxed);
+}
+
+vector<string> AsyncBinaryLog::get_file_paths() {
+  if (log_ == nullptr) {
+    return {};
+  }
+  return log_->get_file_paths();
+}
+
+void AsyncBinaryLog::after_rotation() {
+  need_rotation_.store(true);
+}
+
+void AsyncBinaryLog::do_append(int log_level, CSlice slice) {
+  if (log_ == nullptr) {
+    process_fatal_error("AsyncBinaryLog is not inited");
+  }
+  producer_count_.fetch_add(1);
+  Slice text = slice;
+  text.truncate(MAX_RECORD_SIZE - DeferredLogRecord::FORMATTED_RECORD_HEADER_SIZE);
+  char header[DeferredLogRecord::FORMATTED_RECORD_HEADER_SIZE];
+  push(DeferredLogRecord::create_formatted_record_header(MutableSlice(header, sizeof(header)), log_level, text.size()),
+       text);
+  producer_count_.fetch_sub(1, std::memory_order_release);
+  if (log_level == VERBOSITY_NAME(FATAL)) {
+    // wait for the log line to be printed
+    auto end_time = Time::now() + 1.0;
+    while (!is_empty() && Time::now() < end_time) {
+      usleep_for(1000);
+    }
+  }
+}
+
+#endif
+
+}  // namespace td
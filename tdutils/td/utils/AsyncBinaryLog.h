@@ -0,0 +1,225 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+/*
+ * Logging with deferred formatting.
+ *
+ * LOG_DEFERRED(INFO) << "Receive " << size << " bytes from " << dc_id;
+ * VLOG_DEFERRED(net_query) << "Send " << query_count << " queries";
+ *
+ * Works like LOG and VLOG, but if AsyncBinaryLog is the current log_interface, then the caller only stores the arguments
+ * in a compact binary form to a per-thread ring buffer, and the message is formatted and written by the logging thread.
+ * Integers, floating point numbers, booleans, characters and strings are stored as is, other arguments are formatted
+ * immediately. Log message callback isn't called for deferred log messages.
+ */
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Slice.h"
+#include "td/utils/StackAllocator.h"
+#include "td/utils/StringBuilder.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#define LOG_DEFERRED(level)                                                        \
+  LOG_IS_STRIPPED(level) || VERBOSITY_NAME(level) > ::td::log_options.get_level() \
+      ? (void)0                                                                    \
+      : ::td::detail::Voidify() & ::td::DeferredLogRecord(VERBOSITY_NAME(level), __FILE__, __LINE__)
+
+#define VLOG_DEFERRED(level)                                                       \
+  LOG_IS_STRIPPED(DEBUG) || VERBOSITY_NAME(level) > ::td::log_options.get_level() \
+      ? (void)0                                                                    \
+      : ::td::detail::Voidify() &                                                  \
+            ::td::DeferredLogRecord(VERBOSITY_NAME(level), __FILE__, __LINE__, TD_DEFINE_STR(level))
+
+namespace td {
+
+class DeferredLogRecord {
+  static const size_t BUFFER_SIZE = 64 * 1024;
+
+ public:
+  enum class ArgType : uint8 { Int, UInt, Double, Bool, Char, String };
+
+  DeferredLogRecord(int log_level, const char *file_name, int line_num, Slice comment = Slice());
+  DeferredLogRecord(const DeferredLogRecord &) = delete;
+  DeferredLogRecord &operator=(const DeferredLogRecord &) = delete;
+  DeferredLogRecord(DeferredLogRecord &&) = delete;
+  DeferredLogRecord &operator=(DeferredLogRecord &&) = delete;
+  ~DeferredLogRecord();
+
+  template <class T>
+  DeferredLogRecord &operator<<(const T &other) {
+    store(other);
+    return *this;
+  }
+
+  static constexpr size_t FORMATTED_RECORD_HEADER_SIZE = 37;
+
+  // returns header of a record, consisting of already formatted text, which must follow the header
+  static Slice create_formatted_record_header(MutableSlice buffer, int log_level, size_t text_size);
+
+  // formats a record created by a DeferredLogRecord
+  static MutableCSlice format(Slice record, StringBuilder &sb);
+
+  static double get_time(Slice record);
+
+  static int get_log_level(Slice record);
+
+ private:
+  decltype(StackAllocator::alloc(0)) buffer_;
+  char *begin_;
+  char *ptr_;
+  char *end_;
+  int log_level_;
+
+  template <class T>
+  void store_raw(const T &value) {
+    if (static_cast<size_t>(end_ - ptr_) < sizeof(T)) {
+      ptr_ = end_;
+      return;
+    }
+    std::memcpy(ptr_, &value, sizeof(T));
+    ptr_ += sizeof(T);
+  }
+
+  template <class T>
+  void store_arg(ArgType type, const T &value) {
+    if (static_cast<size_t>(end_ - ptr_) < sizeof(T) + 1) {
+      ptr_ = end_;
+      return;
+    }
+    *ptr_++ = static_cast<char>(type);
+    std::memcpy(ptr_, &value, sizeof(T));
+    ptr_ += sizeof(T);
+  }
+
+  void store_string(Slice slice);
+
+  void store(int x) {
+    store_arg(ArgType::Int, static_cast<int64>(x));
+  }
+  void store(long int x) {
+    store_arg(ArgType::Int, static_cast<int64>(x));
+  }
+  void store(long long int x) {
+    store_arg(ArgType::Int, static_cast<int64>(x));
+  }
+  void store(unsigned int x) {
+    store_arg(ArgType::UInt, static_cast<uint64>(x));
+  }
+  void store(long unsigned int x) {
+    store_arg(ArgType::UInt, static_cast<uint64>(x));
+  }
+  void store(long long unsigned int x) {
+    store_arg(ArgType::UInt, static_cast<uint64>(x));
+  }
+  void store(double x) {
+    store_arg(ArgType::Double, x);
+  }
+  void store(bool b) {
+    store_arg(ArgType::Bool, b);
+  }
+  void store(char c) {
+    store_arg(ArgType::Char, c);
+  }
+  void store(Slice slice) {
+    store_string(slice);
+  }
+  void store(const string &str) {
+    store_string(str);
+  }
+  void store(const char *str) {
+    store_string(Slice(str));
+  }
+
+  // all other values are formatted immediately
+  template <class T>
+  void store(const T &value) {
+    if (static_cast<size_t>(end_ - ptr_) < 1 + sizeof(uint32) + 1) {
+      ptr_ = end_;
+      return;
+    }
+    auto type_ptr = ptr_;
+    auto size_ptr = ptr_ + 1;
+    StringBuilder sb(MutableSlice(size_ptr + sizeof(uint32), end_));
+    sb << value;
+    auto size = static_cast<uint32>(sb.as_cslice().size());
+    *type_ptr = static_cast<char>(ArgType::String);
+    std::memcpy(size_ptr, &size, sizeof(size));
+    ptr_ = size_ptr + sizeof(uint32) + size;
+  }
+};
+
+#if !TD_THREAD_UNSUPPORTED
+
+class AsyncBinaryLog final : public LogInterface {
+ public:
+  AsyncBinaryLog() = default;
+  AsyncBinaryLog(const AsyncBinaryLog &) = delete;
+  AsyncBinaryLog &operator=(const AsyncBinaryLog &) = delete;
+  AsyncBinaryLog(AsyncBinaryLog &&) = delete;
+  AsyncBinaryLog &operator=(AsyncBinaryLog &&) = delete;
+  ~AsyncBinaryLog() final;
+
+  // all log messages will be written to the log from a separate thread, so the log doesn't need to be thread-safe
+  void init(LogInterface *log);
+
+  // returns false, if the current log_interface isn't an AsyncBinaryLog
+  static bool push_record(int log_level, Slice record);
+
+ private:
+  static constexpr size_t MAX_RECORD_SIZE = 1 << 18;
+
+  class Ring;
+  struct ThreadRing;
+
+  static TD_THREAD_LOCAL ThreadRing *thread_ring_;
+  static TD_THREAD_LOCAL bool is_thread_ring_destroyed_;
+
+  LogInterface *log_ = nullptr;
+  uint64 id_ = 0;
+
+  std::mutex mutex_;
+  vector<std::shared_ptr<Ring>> rings_;  // guarded by mutex_
+
+  std::mutex shared_ring_mutex_;
+  std::shared_ptr<Ring> shared_ring_;  // for threads without own ring
+
+  std::atomic<int32> producer_count_{0};  // number of threads in do_append
+
+  std::atomic<bool> need_rotation_{false};
+  std::atomic<bool> is_closed_{false};
+  std::atomic<bool> is_finished_{false};
+  thread logging_thread_;
+
+  static std::atomic<AsyncBinaryLog *> active_log_;
+  static std::atomic<int32> push_record_count_;  // number of threads in push_record
+
+  void push(Slice header, Slice body);
+
+  void push_to_ring(Ring *ring, Slice header, Slice body);
+
+  bool is_empty();
+
+  void run();
+
+  vector<string> get_file_paths() final;
+
+  void after_rotation() final;
+
+  void do_append(int log_level, CSlice slice) final;
+};
+
+#endif
+
+}  // namespace td
@@ -0,0 +1,526 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/bits.h"
+#include "td/utils/common.h"
+#include "td/utils/HashTableUtils.h"
+#include "td/utils/MapNode.h"
+#include "td/utils/SetNode.h"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+#if !defined(TD_SSE2) && (defined(__SSE2__) || (TD_MSVC && (defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2))))
+#define TD_SSE2 1
+#endif
+
+#if TD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace td {
+
+namespace detail {
+uint32 normalize_flat_hash_table_size(uint32 size);
+
+// control bytes of 16 consecutive buckets
+// 0x80 - empty bucket, 0xFE - deleted bucket, 0x00-0x7F - used bucket with the given 7 bits of the key hash
+class SwissGroup {
+ public:
+  static constexpr int SIZE = 16;
+  static constexpr uint8 EMPTY = 0x80;
+  static constexpr uint8 DELETED = 0xFE;
+
+  struct BitMask {
+    uint32 mask;
+
+    explicit operator bool() const {
+      return mask != 0;
+    }
+    int lowest() const {
+      return count_trailing_zeroes32(mask);
+    }
+    int leading_zeroes() const {
+      return count_leading_zeroes32(mask) - (32 - SIZE);
+    }
+    void next() {
+      mask &= mask - 1;
+    }
+  };
+
+#if TD_SSE2
+  explicit SwissGroup(const uint8 *ctrl) : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl))) {
+  }
+
+  BitMask match(uint8 small_hash) const {
+    auto match_mask = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(small_hash)), ctrl_);
+    return {static_cast<uint32>(_mm_movemask_epi8(match_mask))};
+  }
+
+  BitMask match_empty_or_deleted() const {
+    return {static_cast<uint32>(_mm_movemask_epi8(ctrl_))};
+  }
+
+ private:
+  __m128i ctrl_;
+#else
+  explicit SwissGroup(const uint8 *ctrl) {
+    std::memcpy(ctrl_, ctrl, SIZE);
+  }
+
+  BitMask match(uint8 small_hash) const {
+    uint32 res = 0;
+    for (int i = 0; i < SIZE; i++) {
+      res |= static_cast<uint32>(ctrl_[i] == small_hash) << i;
+    }
+    return {res};
+  }
+
+  BitMask match_empty_or_deleted() const {
+    uint32 res = 0;
+    for (int i = 0; i < SIZE; i++) {
+      res |= static_cast<uint32>(ctrl_[i] >> 7) << i;
+    }
+    return {res};
+  }
+
+ private:
+  uint8 ctrl_[SIZE];
+#endif
+
+ public:
+  BitMask match_empty() const {
+    return match(EMPTY);
+  }
+};
+}  // namespace detail
+
+// open addressing hash table with a separate array of control bytes, which are checked 16 at once
+// find is faster than in FlatHashTable for big tables with long probe sequences
+template <class NodeT, class HashT, class EqT>
+class FlatHashTableSwiss {
+  using Group = detail::SwissGroup;
+
+  static constexpr uint32 MIN_BUCKET_COUNT = Group::SIZE;
+
+ public:
+  using Self = FlatHashTableSwiss<NodeT, HashT, EqT>;
+  using Node = NodeT;
+
+  using KeyT = typename Node::public_key_type;
+  using key_type = typename Node::public_key_type;
+  using value_type = typename Node::public_type;
+
+  struct Iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = FlatHashTableSwiss::value_type;
+    using pointer = value_type *;
+    using reference = value_type &;
+
+    friend class FlatHashTableSwiss;
+    Iterator &operator++() {
+      do {
+        ++pos_;
+      } while (pos_ < map_->bucket_count_ && !is_used(map_->ctrl_[pos_]));
+      return *this;
+    }
+    reference operator*() {
+      return map_->nodes_[pos_].get_public();
+    }
+    pointer operator->() {
+      return &map_->nodes_[pos_].get_public();
+    }
+    bool operator==(const Iterator &other) const {
+      DCHECK(map_ == other.map_);
+      return pos_ == other.pos_;
+    }
+    bool operator!=(const Iterator &other) const {
+      DCHECK(map_ == other.map_);
+      return pos_ != other.pos_;
+    }
+
+    Iterator() = default;
+    Iterator(uint32 pos, Self *map) : pos_(pos), map_(map) {
+    }
+
+   private:
+    uint32 pos_ = 0;
+    Self *map_ = nullptr;
+  };
+
+  struct ConstIterator {
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = FlatHashTableSwiss::value_type;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    ConstIterator &operator++() {
+      ++it_;
+      return *this;
+    }
+    reference operator*() {
+      return *it_;
+    }
+    pointer operator->() {
+      return &*it_;
+    }
+    bool operator==(const ConstIterator &other) const {
+      return it_ == other.it_;
+    }
+    bool operator!=(const ConstIterator &other) const {
+      return it_ != other.it_;
+    }
+
+    ConstIterator() = default;
+    ConstIterator(Iterator it) : it_(std::move(it)) {
+    }
+
+   private:
+    Iterator it_;
+  };
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  FlatHashTableSwiss() = default;
+  FlatHashTableSwiss(const FlatHashTableSwiss &) = delete;
+  FlatHashTableSwiss &operator=(const FlatHashTableSwiss &) = delete;
+
+  FlatHashTableSwiss(std::initializer_list<Node> nodes) {
+    reserve(nodes.size());
+    for (auto &new_node : nodes) {
+      CHECK(!new_node.empty());
+      if (count(new_node.key()) > 0) {
+        continue;
+      }
+      Node node;
+      node.copy_from(new_node);
+      emplace_node(std::move(node));
+    }
+  }
+
+  template <class T>
+  FlatHashTableSwiss(std::initializer_list<T> keys) {
+    for (auto &key : keys) {
+      emplace(KeyT(key));
+    }
+  }
+
+  FlatHashTableSwiss(FlatHashTableSwiss &&other) noexcept {
+    swap(other);
+  }
+  FlatHashTableSwiss &operator=(FlatHashTableSwiss &&other) noexcept {
+    clear();
+    swap(other);
+    return *this;
+  }
+  ~FlatHashTableSwiss() {
+    clear_nodes(nodes_, ctrl_);
+  }
+
+  void swap(FlatHashTableSwiss &other) noexcept {
+    std::swap(nodes_, other.nodes_);
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(used_node_count_, other.used_node_count_);
+    std::swap(bucket_count_, other.bucket_count_);
+    std::swap(growth_left_, other.growth_left_);
+  }
+
+  uint32 bucket_count() const {
+    return bucket_count_;
+  }
+
+  Iterator find(const KeyT &key) {
+    return Iterator(find_pos(key), this);
+  }
+
+  ConstIterator find(const KeyT &key) const {
+    return ConstIterator(const_cast<Self *>(this)->find(key));
+  }
+
+  size_t size() const {
+    return used_node_count_;
+  }
+
+  bool empty() const {
+    return used_node_count_ == 0;
+  }
+
+  Iterator begin() {
+    if (empty()) {
+      return end();
+    }
+    uint32 pos = 0;
+    while (!is_used(ctrl_[pos])) {
+      pos++;
+    }
+    return Iterator(pos, this);
+  }
+  Iterator end() {
+    return Iterator(bucket_count_, this);
+  }
+
+  ConstIterator begin() const {
+    return ConstIterator(const_cast<Self *>(this)->begin());
+  }
+  ConstIterator end() const {
+    return ConstIterator(const_cast<Self *>(this)->end());
+  }
+
+  void reserve(size_t size) {
+    if (size == 0) {
+      return;
+    }
+    CHECK(size <= (1u << 28));
+    uint32 want_size = normalize(static_cast<uint32>(size) * 8 / 7 + 1);
+    if (want_size > bucket_count_) {
+      resize(want_size);
+    }
+  }
+
+  template <class... ArgsT>
+  std::pair<Iterator, bool> emplace(KeyT key, ArgsT &&...args) {
+    CHECK(!is_hash_table_key_empty<EqT>(key));
+    auto pos = find_pos(key);
+    if (pos != bucket_count_) {
+      return {Iterator(pos, this), false};
+    }
+
+    auto hash = HashT()(key);
+    pos = prepare_insert(hash);
+    nodes_[pos].emplace(std::move(key), std::forward<ArgsT>(args)...);
+    return {Iterator(pos, this), true};
+  }
+
+  std::pair<Iterator, bool> insert(KeyT key) {
+    return emplace(std::move(key));
+  }
+
+  template <class ItT>
+  void insert(ItT begin, ItT end) {
+    for (; begin != end; ++begin) {
+      emplace(*begin);
+    }
+  }
+
+  template <class T = typename Node::second_type>
+  T &operator[](const KeyT &key) {
+    return emplace(key).first->second;
+  }
+
+  size_t erase(const KeyT &key) {
+    auto pos = find_pos(key);
+    if (pos == bucket_count_) {
+      return 0;
+    }
+    erase_node(pos);
+    try_shrink();
+    return 1;
+  }
+
+  size_t count(const KeyT &key) const {
+    return const_cast<Self *>(this)->find_pos(key) != bucket_count_;
+  }
+
+  void clear() {
+    if (nodes_ != nullptr) {
+      clear_nodes(nodes_, ctrl_);
+      nodes_ = nullptr;
+      ctrl_ = nullptr;
+      used_node_count_ = 0;
+      bucket_count_ = 0;
+      growth_left_ = 0;
+    }
+  }
+
+  void erase(Iterator it) {
+    DCHECK(it != end());
+    erase_node(it.pos_);
+    try_shrink();
+  }
+
+  template <class F>
+  void remove_if(F &&f) {
+    for (uint32 pos = 0; pos < bucket_count_; pos++) {
+      if (is_used(ctrl_[pos]) && f(nodes_[pos].get_public())) {
+        erase_node(pos);
+      }
+    }
+    if (nodes_ != nullptr) {
+      try_shrink();
+    }
+  }
+
+ private:
+  NodeT *nodes_ = nullptr;
+  uint8 *ctrl_ = nullptr;  // bucket_count_ + Group::SIZE - 1 bytes; the last bytes duplicate the first ones
+  uint32 used_node_count_ = 0;
+  uint32 bucket_count_ = 0;
+  uint32 growth_left_ = 0;  // number of empty buckets, which can be used without resize
+
+  static bool is_used(uint8 ctrl) {
+    return (ctrl & 0x80) == 0;
+  }
+
+  static uint8 get_small_hash(uint32 hash) {
+    return static_cast<uint8>(hash >> 25);
+  }
+
+  static uint32 get_max_used_node_count(uint32 bucket_count) {
+    return bucket_count - bucket_count / 8;
+  }
+
+  static uint32 normalize(uint32 size) {
+    return td::max(detail::normalize_flat_hash_table_size(size), MIN_BUCKET_COUNT);
+  }
+
+  static void clear_nodes(NodeT *nodes, uint8 *ctrl) {
+    delete[] nodes;
+    delete[] ctrl;
+  }
+
+  void set_ctrl(uint32 pos, uint8 ctrl) {
+    ctrl_[pos] = ctrl;
+    if (pos < Group::SIZE - 1) {
+      ctrl_[bucket_count_ + pos] = ctrl;
+    }
+  }
+
+  uint32 find_pos(const KeyT &key) {
+    if (empty() || is_hash_table_key_empty<EqT>(key)) {
+      return bucket_count_;
+    }
+    auto hash = HashT()(key);
+    auto small_hash = get_small_hash(hash);
+    auto bucket_count_mask = bucket_count_ - 1;
+    auto pos = hash & bucket_count_mask;
+    for (uint32 step = Group::SIZE;; step += Group::SIZE) {
+      Group group(ctrl_ + pos);
+      for (auto match = group.match(small_hash); match; match.next()) {
+        auto node_pos = (pos + match.lowest()) & bucket_count_mask;
+        if (likely(EqT()(nodes_[node_pos].key(), key))) {
+          return node_pos;
+        }
+      }
+      if (group.match_empty()) {
+        return bucket_count_;
+      }
+      pos = (pos + step) & bucket_count_mask;
+    }
+  }
+
+  uint32 find_first_free_pos(uint32 hash) const {
+    auto bucket_count_mask = bucket_count_ - 1;
+    auto pos = hash & bucket_count_mask;
+    for (uint32 step = Group::SIZE;; step += Group::SIZE) {
+      auto match = Group(ctrl_ + pos).match_empty_or_deleted();
+      if (match) {
+        return (pos + match.lowest()) & bucket_count_mask;
+      }
+      pos = (pos + step) & bucket_count_mask;
+    }
+  }
+
+  // returns a free bucket for a new node with the given hash
+  uint32 prepare_insert(uint32 hash) {
+    if (unlikely(bucket_count_ == 0)) {
+      resize(MIN_BUCKET_COUNT);
+    }
+    auto pos = find_first_free_pos(hash);
+    if (unlikely(growth_left_ == 0 && ctrl_[pos] != Group::DELETED)) {
+      if (used_node_count_ * 2 <= get_max_used_node_count(bucket_count_)) {
+        // the table is full of deleted buckets
+        resize(bucket_count_);
+      } else {
+        resize(bucket_count_ * 2);
+      }
+      pos = find_first_free_pos(hash);
+    }
+    if (ctrl_[pos] == Group::EMPTY) {
+      growth_left_--;
+    }
+    set_ctrl(pos, get_small_hash(hash));
+    used_node_count_++;
+    return pos;
+  }
+
+  void emplace_node(Node &&node) {
+    DCHECK(!node.empty());
+    auto pos = prepare_insert(HashT()(node.key()));
+    nodes_[pos] = std::move(node);
+  }
+
+  void try_shrink() {
+    DCHECK(nodes_ != nullptr);
+    if (unlikely(used_node_count_ * 10 < bucket_count_ && bucket_count_ > MIN_BUCKET_COUNT)) {
+      resize(normalize((used_node_count_ + 1) * 8 / 7 + 1));
+    }
+  }
+
+  void resize(uint32 new_size) {
+    DCHECK(new_size >= MIN_BUCKET_COUNT);
+    DCHECK((new_size & (new_size - 1)) == 0);
+    CHECK(new_size <= min(static_cast<uint32>(1) << 29, static_cast<uint32>(0x7FFFFFFF / sizeof(NodeT))));
+    auto old_nodes = nodes_;
+    auto old_ctrl = ctrl_;
+    auto old_bucket_count = bucket_count_;
+
+    nodes_ = new NodeT[new_size];
+    ctrl_ = new uint8[new_size + Group::SIZE - 1];
+    std::memset(ctrl_, Group::EMPTY, new_size + Group::SIZE - 1);
+    used_node_count_ = 0;
+    bucket_count_ = new_size;
+    growth_left_ = get_max_used_node_count(new_size);
+
+    for (uint32 pos = 0; pos < old_bucket_count; pos++) {
+      if (is_used(old_ctrl[pos])) {
+        emplace_node(std::move(old_nodes[pos]));
+      }
+    }
+    clear_nodes(old_nodes, old_ctrl);
+  }
+
+  void erase_node(uint32 pos) {
+    DCHECK(pos < bucket_count_);
+    DCHECK(is_used(ctrl_[pos]));
+    nodes_[pos].clear();
+    used_node_count_--;
+
+    // the bucket can be marked as empty only if there was no group of 16 used buckets containing it,
+    // otherwise a probe sequence could have skipped the bucket and must not stop there
+    auto empty_before = Group(ctrl_ + ((pos - Group::SIZE) & (bucket_count_ - 1))).match_empty();
+    auto empty_after = Group(ctrl_ + pos).match_empty();
+    if (empty_before && empty_after && empty_after.lowest() + empty_before.leading_zeroes() < Group::SIZE) {
+      set_ctrl(pos, Group::EMPTY);
+      growth_left_++;
+    } else {
+      set_ctrl(pos, Group::DELETED);
+    }
+  }
+};
+
+template <class NodeT, class HashT, class EqT>
+constexpr uint32 FlatHashTableSwiss<NodeT, HashT, EqT>::MIN_BUCKET_COUNT;
+
+template <class KeyT, class ValueT, class HashT = Hash<KeyT>, class EqT = std::equal_to<KeyT>>
+using FlatHashMapSwiss = FlatHashTableSwiss<MapNode<KeyT, ValueT, EqT>, HashT, EqT>;
+
+template <class KeyT, class HashT = Hash<KeyT>, class EqT = std::equal_to<KeyT>>
+using FlatHashSetSwiss = FlatHashTableSwiss<SetNode<KeyT, EqT>, HashT, EqT>;
+
+template <class NodeT, class HashT, class EqT, class FuncT>
+void table_remove_if(FlatHashTableSwiss<NodeT, HashT, EqT> &table, FuncT &&func) {
+  table.remove_if(func);
+}
+
+}  // namespace td
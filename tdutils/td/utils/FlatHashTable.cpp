@@ -7,11 +7,16 @@
 #include "td/utils/FlatHashTable.h"
 
 #include "td/utils/bits.h"
+#include "td/utils/FlatHashMapSwiss.h"
 #include "td/utils/Random.h"
 
 namespace td {
 namespace detail {
 
+constexpr int SwissGroup::SIZE;
+constexpr uint8 SwissGroup::EMPTY;
+constexpr uint8 SwissGroup::DELETED;
+
 uint32 normalize_flat_hash_table_size(uint32 size) {
   return td::max(static_cast<uint32>(1) << (32 - count_leading_zeroes32(size)), static_cast<uint32>(8));
 }
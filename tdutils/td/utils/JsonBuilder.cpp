@@ -6,13 +6,63 @@
 //
 #include "td/utils/JsonBuilder.h"
 
+#include "td/utils/bits.h"
 #include "td/utils/misc.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/utf8.h"
 
+#if defined(__SSE2__) || (TD_MSVC && (defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2)))
+#define TD_JSON_SSE2 1
+#endif
+
+#if TD_JSON_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
+
 namespace td {
 
+// returns pointer to the first character in the range, which must be escaped in a JSON string, or end of the range
+template <bool escape_non_ascii>
+static const unsigned char *find_json_escaped_character(const unsigned char *begin, const unsigned char *end) {
+  auto is_plain = [](unsigned char c) {
+    return c >= 0x20 && c != '"' && c != '\\' && (!escape_non_ascii || c < 0x80);
+  };
+  // runs of plain characters are often short, so check first characters before vector processing
+  for (int i = 0; i < 8; i++, begin++) {
+    if (begin == end || !is_plain(*begin)) {
+      return begin;
+    }
+  }
+#if TD_JSON_SSE2
+  const auto quote_mask = _mm_set1_epi8('"');
+  const auto backslash_mask = _mm_set1_epi8('\\');
+  const auto control_mask = _mm_set1_epi8(0x1F);
+  const auto space_mask = _mm_set1_epi8(0x20);
+  while (end - begin >= 16) {
+    auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    auto match_mask = _mm_or_si128(_mm_cmpeq_epi8(input, quote_mask), _mm_cmpeq_epi8(input, backslash_mask));
+    if (escape_non_ascii) {
+      // signed comparison matches both control characters and bytes not less than 0x80
+      match_mask = _mm_or_si128(match_mask, _mm_cmplt_epi8(input, space_mask));
+    } else {
+      match_mask = _mm_or_si128(match_mask, _mm_cmpeq_epi8(_mm_min_epu8(input, control_mask), input));
+    }
+    auto match = static_cast<uint32>(_mm_movemask_epi8(match_mask));
+    if (match != 0) {
+      return begin + count_trailing_zeroes32(match);
+    }
+    begin += 16;
+  }
+#endif
+  while (begin != end && is_plain(*begin)) {
+    begin++;
+  }
+  return begin;
+}
+
 StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
   sb << '"';
   SCOPE_EXIT {
@@ -50,7 +100,19 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
           sb << JsonOneChar(s[pos]);
           break;
         }
-        sb << s[pos];
+        {
+          // append the whole run of characters, which don't need to be escaped
+          auto plain_end = find_json_escaped_character<false>(val.value_.ubegin() + pos + 1, val.value_.uend());
+          auto plain_length = static_cast<size_t>(plain_end - val.value_.ubegin()) - pos;
+          if (plain_length <= 8) {
+            for (size_t i = 0; i < plain_length; i++) {
+              sb << s[pos + i];
+            }
+          } else {
+            sb << Slice(s + pos, plain_length);
+          }
+          pos += plain_length - 1;
+        }
         break;
     }
   }
@@ -128,13 +190,50 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonString &val) {
           UNREACHABLE();
           break;
         }
-        sb << s[pos];
+        {
+          // append the whole run of characters, which don't need to be escaped
+          auto plain_end = find_json_escaped_character<true>(val.str_.ubegin() + pos + 1, val.str_.uend());
+          auto plain_length = static_cast<size_t>(plain_end - val.str_.ubegin()) - pos;
+          if (plain_length <= 8) {
+            for (size_t i = 0; i < plain_length; i++) {
+              sb << s[pos + i];
+            }
+          } else {
+            sb << Slice(s + pos, plain_length);
+          }
+          pos += plain_length - 1;
+        }
         break;
     }
   }
   return sb;
 }
 
+// returns pointer to the first '"' or '\\' in the range, or end of the range if there are none
+static const unsigned char *find_json_string_special_character(const unsigned char *begin, const unsigned char *end) {
+  // special characters are often adjacent, so check the first character before vector processing
+  if (begin == end || *begin == '"' || *begin == '\\') {
+    return begin;
+  }
+#if TD_JSON_SSE2
+  const auto quote_mask = _mm_set1_epi8('"');
+  const auto backslash_mask = _mm_set1_epi8('\\');
+  while (end - begin >= 16) {
+    auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    auto match_mask = _mm_or_si128(_mm_cmpeq_epi8(input, quote_mask), _mm_cmpeq_epi8(input, backslash_mask));
+    auto match = static_cast<uint32>(_mm_movemask_epi8(match_mask));
+    if (match != 0) {
+      return begin + count_trailing_zeroes32(match);
+    }
+    begin += 16;
+  }
+#endif
+  while (begin != end && *begin != '"' && *begin != '\\') {
+    begin++;
+  }
+  return begin;
+}
+
 Result<MutableSlice> json_string_decode(Parser &parser) {
   if (!parser.try_skip('"')) {
     return Status::Error("Opening '\"' expected");
@@ -153,7 +252,18 @@ Result<MutableSlice> json_string_decode(Parser &parser) {
       parser.advance(cur_src + 1 - result_start);
       return data.substr(0, cur_dest - result_start);
     }
-    if (*cur_src == '\\') {
+    if (*cur_src != '\\') {
+      *cur_dest++ = *cur_src++;
+      auto length = static_cast<size_t>(find_json_string_special_character(cur_src, end) - cur_src);
+      if (length == 0) {
+        continue;
+      }
+      if (cur_dest != cur_src) {
+        std::memmove(cur_dest, cur_src, length);
+      }
+      cur_src += length;
+      cur_dest += length;
+    } else {
       cur_src++;
       if (cur_src == end) {
         return Status::Error("Closing '\"' not found");
@@ -218,8 +328,6 @@ Result<MutableSlice> json_string_decode(Parser &parser) {
           *cur_dest++ = *cur_src++;
           break;
       }
-    } else {
-      *cur_dest++ = *cur_src++;
     }
   }
   UNREACHABLE();
@@ -231,8 +339,8 @@ Status json_string_skip(Parser &parser) {
     return Status::Error("Opening '\"' expected");
   }
   auto data = parser.data();
-  auto *cur_src = data.ubegin();
-  auto *end = data.uend();
+  const unsigned char *cur_src = data.ubegin();
+  const unsigned char *end = data.uend();
 
   while (true) {
     if (cur_src == end) {
@@ -242,7 +350,9 @@ Status json_string_skip(Parser &parser) {
       parser.advance(cur_src + 1 - data.ubegin());
       return Status::OK();
     }
-    if (*cur_src == '\\') {
+    if (*cur_src != '\\') {
+      cur_src = find_json_string_special_character(cur_src + 1, end);
+    } else {
       cur_src++;
       if (cur_src == end) {
         return Status::Error("Closing '\"' not found");
@@ -285,8 +395,6 @@ Status json_string_skip(Parser &parser) {
           cur_src++;
           break;
       }
-    } else {
-      cur_src++;
     }
   }
   UNREACHABLE();
@@ -410,7 +410,7 @@ class JsonObjectScope final : public JsonScope {
       is_first_ = true;
     }
     jb_->print_offset();
-    jb_->enter_value() << field;
+    *sb_ << JsonString(field);
     if (jb_->is_pretty()) {
       *sb_ << " : ";
     } else {
@@ -456,6 +456,15 @@ enum class JsonValueType { Null, Number, Boolean, String, Array, Object };
 
 using JsonArray = vector<JsonValue>;
 
+// hash of an object field name; generated code chooses the multiplier to have no collisions between known fields
+inline uint32 get_json_field_name_hash(Slice name, uint32 multiplier) {
+  auto hash = static_cast<uint32>(name.size());
+  for (auto c : name) {
+    hash = hash * multiplier + static_cast<unsigned char>(c);
+  }
+  return hash;
+}
+
 class JsonObject {
   const JsonValue *get_field(Slice name) const;
 
@@ -0,0 +1,24 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/MemoryProfiler.h"
+
+#include <atomic>
+
+namespace td {
+
+// the profiler can be registered during static initialization, so the variable must be constant-initialized
+static std::atomic<MemoryProfiler *> memory_profiler{nullptr};
+
+void set_memory_profiler(MemoryProfiler *new_memory_profiler) {
+  memory_profiler.store(new_memory_profiler, std::memory_order_release);
+}
+
+MemoryProfiler *get_memory_profiler() {
+  return memory_profiler.load(std::memory_order_acquire);
+}
+
+}  // namespace td
@@ -0,0 +1,37 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// Heap profiler, which is registered by a replacement of the memory allocator, for example, by memprof
+class MemoryProfiler {
+ public:
+  MemoryProfiler() = default;
+  MemoryProfiler(const MemoryProfiler &) = delete;
+  MemoryProfiler &operator=(const MemoryProfiler &) = delete;
+  MemoryProfiler(MemoryProfiler &&) = delete;
+  MemoryProfiler &operator=(MemoryProfiler &&) = delete;
+  virtual ~MemoryProfiler() = default;
+
+  // an allocation is sampled on average once per sampling_interval allocated bytes; 0 disables sampling
+  virtual void set_sampling_interval(size_t sampling_interval) = 0;
+
+  virtual size_t get_sampling_interval() const = 0;
+
+  // returns sampled allocations, which weren't freed yet, in the legacy pprof heap profile format
+  virtual string get_heap_profile() const = 0;
+};
+
+void set_memory_profiler(MemoryProfiler *memory_profiler);
+
+// returns nullptr if there is no registered memory profiler
+MemoryProfiler *get_memory_profiler();
+
+}  // namespace td
@@ -173,6 +173,18 @@ class WaitFreeHashMap {
     return result;
   }
 
+  size_t calc_bucket_count() const {
+    if (wait_free_storage_ == nullptr) {
+      return default_map_.bucket_count();
+    }
+
+    size_t result = 0;
+    for (size_t i = 0; i < MAX_STORAGE_COUNT; i++) {
+      result += wait_free_storage_->maps_[i].calc_bucket_count();
+    }
+    return result;
+  }
+
   bool empty() const {
     if (wait_free_storage_ == nullptr) {
       return default_map_.empty();
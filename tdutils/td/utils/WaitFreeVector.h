@@ -61,6 +61,14 @@ class WaitFreeVector {
     return (storage_.size() - 1) * MAX_VECTOR_SIZE + storage_.back().size();
   }
 
+  size_t calc_capacity() const {
+    size_t result = 0;
+    for (auto &storage : storage_) {
+      result += storage.capacity();
+    }
+    return result;
+  }
+
   bool empty() const {
     return storage_.empty();
   }
@@ -8,6 +8,7 @@
 
 #include "td/utils/logging.h"
 #include "td/utils/port/thread_local.h"
+#include "td/utils/SpinLock.h"
 
 #include <cstddef>
 #include <new>
@@ -25,6 +26,227 @@ TD_THREAD_LOCAL BufferAllocator::BufferRawTls *BufferAllocator::buffer_raw_tls;
 
 std::atomic<size_t> BufferAllocator::buffer_mem;
 
+namespace {
+
+// block sizes include BufferRaw header; bigger buffers are allocated directly
+constexpr size_t BUFFER_BLOCK_SIZES[] = {512,  768,   1024,  1536,  2048,  3072,  4096, 6144,
+                                         8192, 12288, 16384, 24576, 32768, 49152, 65536};
+constexpr size_t BUFFER_SIZE_CLASS_COUNT = sizeof(BUFFER_BLOCK_SIZES) / sizeof(BUFFER_BLOCK_SIZES[0]);
+
+constexpr size_t MAX_THREAD_CACHED_BYTES = 32 << 10;         // per size class
+constexpr size_t MAX_THREAD_CACHED_TOTAL_BYTES = 128 << 10;  // for all size classes
+constexpr size_t MAX_SHARED_CACHED_BYTES = 512 << 10;  // per size class
+
+struct FreeBufferBlock {
+  FreeBufferBlock *next;
+};
+
+struct FreeBufferBlockList {
+  FreeBufferBlock *head = nullptr;
+  size_t size = 0;
+
+  bool empty() const {
+    return head == nullptr;
+  }
+
+  void push(char *block) {
+    auto *free_block = new (block) FreeBufferBlock{head};
+    head = free_block;
+    size++;
+  }
+
+  char *pop() {
+    CHECK(head != nullptr);
+    auto *free_block = head;
+    head = free_block->next;
+    size--;
+    return reinterpret_cast<char *>(free_block);
+  }
+};
+
+struct BufferSizeClass {
+  SpinLock lock;
+  FreeBufferBlockList free_blocks;  // shared between threads, guarded by lock
+
+  std::atomic<size_t> live_count{0};
+  std::atomic<size_t> live_bytes{0};  // used only for buffers without a size class
+  std::atomic<size_t> cached_count{0};
+};
+
+// the last entry is used for buffers without a size class
+BufferSizeClass buffer_size_classes[BUFFER_SIZE_CLASS_COUNT + 1];
+
+// per-thread magazines of free blocks, which are returned to the shared lists when the thread exits
+// they are used only by threads created by td::thread, which destroy their thread locals on exit;
+// other threads use only the shared lists, so their exit can't leak cached blocks
+struct BufferBlockCache {
+  FreeBufferBlockList free_blocks[BUFFER_SIZE_CLASS_COUNT];
+  size_t cached_bytes = 0;
+
+  BufferBlockCache() = default;
+  BufferBlockCache(const BufferBlockCache &) = delete;
+  BufferBlockCache &operator=(const BufferBlockCache &) = delete;
+  BufferBlockCache(BufferBlockCache &&) = delete;
+  BufferBlockCache &operator=(BufferBlockCache &&) = delete;
+  ~BufferBlockCache();
+};
+
+TD_THREAD_LOCAL BufferBlockCache *buffer_block_cache;  // static zero-initialized
+
+size_t get_buffer_size_class(size_t buf_size) {
+  size_t size_class = 0;
+  while (size_class < BUFFER_SIZE_CLASS_COUNT && BUFFER_BLOCK_SIZES[size_class] < buf_size) {
+    size_class++;
+  }
+  return size_class;
+}
+
+size_t get_max_thread_cached_block_count(size_t size_class) {
+  return max(MAX_THREAD_CACHED_BYTES / BUFFER_BLOCK_SIZES[size_class], static_cast<size_t>(1));
+}
+
+BufferBlockCache *get_buffer_block_cache() {
+  if (get_thread_id() == 0) {
+    return nullptr;
+  }
+  init_thread_local<BufferBlockCache>(buffer_block_cache);
+  return buffer_block_cache;
+}
+
+size_t get_max_shared_cached_block_count(size_t size_class) {
+  return max(MAX_SHARED_CACHED_BYTES / BUFFER_BLOCK_SIZES[size_class], static_cast<size_t>(4));
+}
+
+// moves up to count blocks from the list to the shared list of the size class
+void release_buffer_blocks(size_t size_class, FreeBufferBlockList &blocks, size_t count) {
+  auto &info = buffer_size_classes[size_class];
+  auto max_count = get_max_shared_cached_block_count(size_class);
+  FreeBufferBlockList to_delete;
+  {
+    auto guard = info.lock.lock();
+    while (count > 0 && !blocks.empty()) {
+      auto *block = blocks.pop();
+      if (info.free_blocks.size < max_count) {
+        info.free_blocks.push(block);
+      } else {
+        to_delete.push(block);
+      }
+      count--;
+    }
+  }
+  if (to_delete.empty()) {
+    return;
+  }
+  info.cached_count.fetch_sub(to_delete.size, std::memory_order_relaxed);
+  while (!to_delete.empty()) {
+    delete[] to_delete.pop();
+  }
+}
+
+// moves up to count blocks from the per-thread cache to the shared list of the size class
+void release_cached_buffer_blocks(BufferBlockCache *cache, size_t size_class, size_t count) {
+  auto &blocks = cache->free_blocks[size_class];
+  auto old_size = blocks.size;
+  release_buffer_blocks(size_class, blocks, count);
+  cache->cached_bytes -= (old_size - blocks.size) * BUFFER_BLOCK_SIZES[size_class];
+}
+
+BufferBlockCache::~BufferBlockCache() {
+  for (size_t size_class = 0; size_class < BUFFER_SIZE_CLASS_COUNT; size_class++) {
+    release_cached_buffer_blocks(this, size_class, free_blocks[size_class].size);
+  }
+}
+
+char *allocate_buffer_block(size_t buf_size) {
+  auto size_class = get_buffer_size_class(buf_size);
+  auto &info = buffer_size_classes[size_class];
+  info.live_count.fetch_add(1, std::memory_order_relaxed);
+  if (size_class == BUFFER_SIZE_CLASS_COUNT) {
+    info.live_bytes.fetch_add(buf_size, std::memory_order_relaxed);
+    return new char[buf_size];
+  }
+
+  auto block_size = BUFFER_BLOCK_SIZES[size_class];
+  auto *cache = get_buffer_block_cache();
+  if (cache == nullptr) {
+    {
+      auto guard = info.lock.lock();
+      if (!info.free_blocks.empty()) {
+        info.cached_count.fetch_sub(1, std::memory_order_relaxed);
+        return info.free_blocks.pop();
+      }
+    }
+    return new char[block_size];
+  }
+
+  auto &blocks = cache->free_blocks[size_class];
+  if (blocks.empty()) {
+    auto count = max(get_max_thread_cached_block_count(size_class) / 2, static_cast<size_t>(1));
+    auto guard = info.lock.lock();
+    while (count > 0 && !info.free_blocks.empty()) {
+      blocks.push(info.free_blocks.pop());
+      cache->cached_bytes += block_size;
+      count--;
+    }
+  }
+  if (blocks.empty()) {
+    return new char[block_size];
+  }
+  info.cached_count.fetch_sub(1, std::memory_order_relaxed);
+  cache->cached_bytes -= block_size;
+  return blocks.pop();
+}
+
+void free_buffer_block(char *block, size_t buf_size) {
+  auto size_class = get_buffer_size_class(buf_size);
+  auto &info = buffer_size_classes[size_class];
+  info.live_count.fetch_sub(1, std::memory_order_relaxed);
+  if (size_class == BUFFER_SIZE_CLASS_COUNT) {
+    info.live_bytes.fetch_sub(buf_size, std::memory_order_relaxed);
+    delete[] block;
+    return;
+  }
+
+  info.cached_count.fetch_add(1, std::memory_order_relaxed);
+  auto block_size = BUFFER_BLOCK_SIZES[size_class];
+  auto *cache = get_thread_id() == 0 ? nullptr : buffer_block_cache;
+  if (cache == nullptr || cache->cached_bytes + block_size > MAX_THREAD_CACHED_TOTAL_BYTES) {
+    // the block is freed by a thread without cache, after the cache was destroyed, or the cache is full
+    FreeBufferBlockList blocks;
+    blocks.push(block);
+    release_buffer_blocks(size_class, blocks, 1);
+    return;
+  }
+
+  auto &blocks = cache->free_blocks[size_class];
+  auto max_count = get_max_thread_cached_block_count(size_class);
+  if (blocks.size >= max_count) {
+    release_cached_buffer_blocks(cache, size_class, (max_count + 1) / 2);
+  }
+  blocks.push(block);
+  cache->cached_bytes += block_size;
+}
+
+}  // namespace
+
+vector<BufferAllocator::SizeClassStats> BufferAllocator::get_size_class_stats() {
+  vector<SizeClassStats> result;
+  for (size_t size_class = 0; size_class <= BUFFER_SIZE_CLASS_COUNT; size_class++) {
+    auto &info = buffer_size_classes[size_class];
+    SizeClassStats stats;
+    stats.live_count = info.live_count.load(std::memory_order_relaxed);
+    if (size_class < BUFFER_SIZE_CLASS_COUNT) {
+      stats.block_size = BUFFER_BLOCK_SIZES[size_class];
+      stats.live_bytes = stats.live_count * stats.block_size;
+    } else {
+      stats.live_bytes = info.live_bytes.load(std::memory_order_relaxed);
+    }
+    stats.cached_count = info.cached_count.load(std::memory_order_relaxed);
+    result.push_back(stats);
+  }
+  return result;
+}
+
 int64 BufferAllocator::get_buffer_slice_size() {
   return 0;
 }
@@ -67,7 +289,8 @@ BufferAllocator::ReaderPtr BufferAllocator::create_reader_fast(size_t size) {
 
   auto buffer_raw = buffer_raw_tls->buffer_raw.get();
   if (buffer_raw == nullptr || buffer_raw->data_size_ - buffer_raw->end_.load(std::memory_order_relaxed) < size) {
-    buffer_raw = create_buffer_raw(4096 * 4);
+    // use all the space of the block
+    buffer_raw = create_buffer_raw(4096 * 4 - TD_OFFSETOF(BufferRaw, data_));
     buffer_raw_tls->buffer_raw = std::unique_ptr<BufferRaw, BufferAllocator::BufferRawDeleter>(buffer_raw);
   }
   buffer_raw->end_.fetch_add(size, std::memory_order_relaxed);
@@ -92,7 +315,7 @@ void BufferAllocator::dec_ref_cnt(BufferRaw *ptr) {
     auto buf_size = max(sizeof(BufferRaw), TD_OFFSETOF(BufferRaw, data_) + ptr->data_size_);
     buffer_mem -= buf_size;
     ptr->~BufferRaw();
-    delete[] ptr;
+    free_buffer_block(reinterpret_cast<char *>(ptr), buf_size);
   }
 }
 
@@ -110,7 +333,7 @@ BufferRaw *BufferAllocator::create_buffer_raw(size_t size) {
     buf_size = sizeof(BufferRaw);
   }
   buffer_mem += buf_size;
-  auto *buffer_raw = reinterpret_cast<BufferRaw *>(new char[buf_size]);
+  auto *buffer_raw = reinterpret_cast<BufferRaw *>(allocate_buffer_block(buf_size));
   return new (buffer_raw) BufferRaw(size);
 }
 
@@ -69,6 +69,14 @@ class BufferAllocator {
   static size_t get_buffer_mem();
   static int64 get_buffer_slice_size();
 
+  struct SizeClassStats {
+    size_t block_size = 0;  // 0 for buffers, which are too big to have a size class
+    size_t live_count = 0;
+    size_t live_bytes = 0;
+    size_t cached_count = 0;  // number of free blocks kept for reuse
+  };
+  static vector<SizeClassStats> get_size_class_stats();
+
   static void clear_thread_local();
 
  private:
@@ -71,36 +71,43 @@ Logger::Logger(LogInterface &log, const LogOptions &options, int log_level, Slic
     return;
   }
 
+  detail::append_log_prefix(sb_, log_level, get_thread_id(), Clocks::system(), file_name, line_num,
+                            tag_ == nullptr ? Slice() : Slice(tag_), tag2_ == nullptr ? Slice() : Slice(tag2_),
+                            comment);
+}
+
+namespace detail {
+
+void append_log_prefix(StringBuilder &sb, int log_level, int32 thread_id, double time, Slice file_name, int line_num,
+                       Slice tag, Slice tag2, Slice comment) {
   // log level
-  sb_ << '[';
+  sb << '[';
   if (static_cast<uint32>(log_level) < 10) {
-    sb_ << ' ' << static_cast<char>('0' + log_level);
+    sb << ' ' << static_cast<char>('0' + log_level);
   } else {
-    sb_ << log_level;
+    sb << log_level;
   }
-  sb_ << ']';
+  sb << ']';
 
   // thread identifier
-  auto thread_id = get_thread_id();
-  sb_ << "[t";
+  sb << "[t";
   if (static_cast<uint32>(thread_id) < 10) {
-    sb_ << ' ' << static_cast<char>('0' + thread_id);
+    sb << ' ' << static_cast<char>('0' + thread_id);
   } else {
-    sb_ << thread_id;
+    sb << thread_id;
   }
-  sb_ << ']';
+  sb << ']';
 
   // timestamp
-  auto time = Clocks::system();
   auto unix_time = static_cast<uint32>(time);
   auto nanoseconds = static_cast<uint32>((time - unix_time) * 1e9);
-  sb_ << '[' << unix_time << '.';
+  sb << '[' << unix_time << '.';
   uint32 limit = 100000000;
   while (nanoseconds < limit && limit > 1) {
-    sb_ << '0';
+    sb << '0';
     limit /= 10;
   }
-  sb_ << nanoseconds << ']';
+  sb << nanoseconds << ']';
 
   // file : line
   if (!file_name.empty()) {
@@ -109,45 +116,50 @@ Logger::Logger(LogInterface &log, const LogOptions &options, int log_level, Slic
       last_slash_--;
     }
     file_name = file_name.substr(last_slash_ + 1);
-    sb_ << '[' << file_name << ':' << static_cast<uint32>(line_num) << ']';
+    sb << '[' << file_name << ':' << static_cast<uint32>(line_num) << ']';
   }
 
   // context from tag_
-  if (tag_ != nullptr && *tag_) {
-    sb_ << "[#" << Slice(tag_) << ']';
+  if (!tag.empty()) {
+    sb << "[#" << tag << ']';
   }
 
   // context from tag2_
-  if (tag2_ != nullptr && *tag2_) {
-    sb_ << "[!" << Slice(tag2_) << ']';
+  if (!tag2.empty()) {
+    sb << "[!" << tag2 << ']';
   }
 
   // comment (e.g. condition in LOG_IF)
   if (!comment.empty()) {
-    sb_ << "[&" << comment << ']';
+    sb << "[&" << comment << ']';
   }
 
-  sb_ << '\t';
+  sb << '\t';
 }
 
+MutableCSlice finish_log_message(StringBuilder &sb, bool fix_newlines) {
+  if (!fix_newlines) {
+    return sb.as_cslice();
+  }
+  sb << '\n';
+  auto slice = sb.as_cslice();
+  if (slice.back() != '\n') {
+    slice.back() = '\n';
+  }
+  while (slice.size() > 1 && slice[slice.size() - 2] == '\n') {
+    slice.back() = '\0';
+    slice = MutableCSlice(slice.begin(), slice.begin() + slice.size() - 1);
+  }
+  return slice;
+}
+
+}  // namespace detail
+
 Logger::~Logger() {
   if (ExitGuard::is_exited()) {
     return;
   }
-  if (options_.fix_newlines) {
-    sb_ << '\n';
-    auto slice = as_cslice();
-    if (slice.back() != '\n') {
-      slice.back() = '\n';
-    }
-    while (slice.size() > 1 && slice[slice.size() - 2] == '\n') {
-      slice.back() = '\0';
-      slice = MutableCSlice(slice.begin(), slice.begin() + slice.size() - 1);
-    }
-    log_.append(log_level_, slice);
-  } else {
-    log_.append(log_level_, as_cslice());
-  }
+  log_.append(log_level_, detail::finish_log_message(sb_, options_.fix_newlines));
 }
 
 class DefaultLog final : public LogInterface {
@@ -250,6 +250,11 @@ class Voidify {
   void operator&(const T &) {
   }
 };
+
+void append_log_prefix(StringBuilder &sb, int log_level, int32 thread_id, double time, Slice file_name, int line_num,
+                       Slice tag, Slice tag2, Slice comment);
+
+MutableCSlice finish_log_message(StringBuilder &sb, bool fix_newlines);
 }  // namespace detail
 
 }  // namespace td
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/utils/config.h"
 #include "td/utils/port/platform.h"
 
 // clang-format off
@@ -44,6 +45,10 @@
   #error "Poll's implementation is not defined"
 #endif
 
+#if TD_POLL_EPOLL && TD_LINUX && TD_HAVE_IO_URING
+  #define TD_POLL_IO_URING 1
+#endif
+
 #if TD_EMSCRIPTEN
   #define TD_THREAD_UNSUPPORTED 1
 #elif TD_WINDOWS
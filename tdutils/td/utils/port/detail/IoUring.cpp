@@ -0,0 +1,398 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/port/detail/IoUring.h"
+
+char disable_linker_warning_about_empty_file_io_uring_cpp TD_UNUSED;
+
+#ifdef TD_POLL_IO_URING
+
+#include "td/utils/logging.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace td {
+namespace detail {
+
+namespace {
+
+constexpr uint32 IO_URING_SQ_ENTRIES = 256;
+constexpr uint32 IO_URING_CQ_ENTRIES = 4096;
+constexpr uint64 IO_URING_REMOVE_USER_DATA = static_cast<uint64>(-1);
+
+int io_uring_setup(uint32 entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_fd, uint32 to_submit, uint32 min_complete, uint32 flags, const void *arg,
+                   size_t arg_size) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+uint32 load_acquire(const uint32 *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+void store_release(uint32 *ptr, uint32 value) {
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+uint64 get_user_data(int native_fd, uint32 generation) {
+  return (static_cast<uint64>(generation) << 32) | static_cast<uint32>(native_fd);
+}
+
+template <class T>
+T *get_ring_field(void *ring_ptr, uint32 offset) {
+  return reinterpret_cast<T *>(static_cast<char *>(ring_ptr) + offset);
+}
+
+}  // namespace
+
+std::atomic<bool> IoUring::is_enabled_{true};
+
+void IoUring::set_enabled(bool is_enabled) {
+  is_enabled_.store(is_enabled, std::memory_order_relaxed);
+}
+
+bool IoUring::is_enabled() {
+  return is_enabled_.load(std::memory_order_relaxed);
+}
+
+IoUring::~IoUring() {
+  close_ring();
+}
+
+void IoUring::init() {
+  CHECK(!ring_fd_);
+  CHECK(!use_epoll_);
+  if (is_enabled()) {
+    auto status = init_ring();
+    if (status.is_ok()) {
+      return;
+    }
+    LOG(INFO) << "Use epoll instead of io_uring: " << status;
+    close_ring();
+  }
+  use_epoll_ = true;
+  epoll_.init();
+}
+
+Status IoUring::init_ring() {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = IO_URING_CQ_ENTRIES;
+  ring_fd_ = NativeFd(io_uring_setup(IO_URING_SQ_ENTRIES, &params));
+  if (!ring_fd_) {
+    return OS_ERROR("io_uring_setup failed");
+  }
+
+  // IORING_FEAT_RSRC_TAGS was added in the same Linux 5.13 as multishot poll requests
+  constexpr uint32 REQUIRED_FEATURES =
+      IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+  if ((params.features & REQUIRED_FEATURES) != REQUIRED_FEATURES) {
+    return Status::Error(PSLICE() << "Unsupported io_uring features " << params.features);
+  }
+
+  ring_size_ = max(static_cast<size_t>(params.sq_off.array) + params.sq_entries * sizeof(uint32),
+                   static_cast<size_t>(params.cq_off.cqes) + params.cq_entries * sizeof(io_uring_cqe));
+  auto ring_ptr =
+      mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_.fd(), IORING_OFF_SQ_RING);
+  if (ring_ptr == MAP_FAILED) {
+    return OS_ERROR("Failed to map io_uring rings");
+  }
+  ring_ptr_ = ring_ptr;
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  auto sqes_ptr =
+      mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_.fd(), IORING_OFF_SQES);
+  if (sqes_ptr == MAP_FAILED) {
+    return OS_ERROR("Failed to map io_uring submission queue entries");
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes_ptr);
+
+  sq_head_ = get_ring_field<uint32>(ring_ptr_, params.sq_off.head);
+  sq_tail_ = get_ring_field<uint32>(ring_ptr_, params.sq_off.tail);
+  sq_ring_mask_ = *get_ring_field<uint32>(ring_ptr_, params.sq_off.ring_mask);
+  sq_flags_ = get_ring_field<uint32>(ring_ptr_, params.sq_off.flags);
+  sq_entries_ = params.sq_entries;
+  sq_local_tail_ = *sq_tail_;
+  auto *sq_array = get_ring_field<uint32>(ring_ptr_, params.sq_off.array);
+  for (uint32 i = 0; i < sq_entries_; i++) {
+    sq_array[i] = i;
+  }
+
+  cq_head_ = get_ring_field<uint32>(ring_ptr_, params.cq_off.head);
+  cq_tail_ = get_ring_field<uint32>(ring_ptr_, params.cq_off.tail);
+  cq_ring_mask_ = *get_ring_field<uint32>(ring_ptr_, params.cq_off.ring_mask);
+  cqes_ = get_ring_field<io_uring_cqe>(ring_ptr_, params.cq_off.cqes);
+  return Status::OK();
+}
+
+void IoUring::close_ring() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (ring_ptr_ != nullptr) {
+    munmap(ring_ptr_, ring_size_);
+    ring_ptr_ = nullptr;
+  }
+  to_submit_ = 0;
+  reaped_cqes_.clear();
+  ring_fd_.close();
+}
+
+void IoUring::clear() {
+  if (use_epoll_) {
+    epoll_.clear();
+    use_epoll_ = false;
+    return;
+  }
+  if (!ring_fd_) {
+    return;
+  }
+
+  close_ring();
+  fds_.clear();
+
+  for (auto *list_node = list_root_.next; list_node != &list_root_;) {
+    auto pollable_fd = PollableFd::from_list_node(list_node);
+    list_node = list_node->next;
+  }
+}
+
+io_uring_sqe *IoUring::get_sqe() {
+  while (sq_local_tail_ - load_acquire(sq_head_) == sq_entries_) {
+    submit();
+  }
+  auto *sqe = &sqes_[sq_local_tail_ & sq_ring_mask_];
+  std::memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+void IoUring::add_poll(int native_fd) {
+  const auto &info = fds_[native_fd];
+  auto *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = native_fd;
+  sqe->len = IORING_POLL_ADD_MULTI;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  sqe->poll32_events = (info.poll_mask << 16) | (info.poll_mask >> 16);
+#else
+  sqe->poll32_events = info.poll_mask;
+#endif
+  sqe->user_data = get_user_data(native_fd, info.generation);
+  store_release(sq_tail_, ++sq_local_tail_);
+  to_submit_++;
+}
+
+void IoUring::remove_poll(int native_fd) {
+  CHECK(native_fd >= 0 && static_cast<size_t>(native_fd) < fds_.size());
+  auto &info = fds_[native_fd];
+  CHECK(info.list_node != nullptr);
+  auto *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = get_user_data(native_fd, info.generation);
+  sqe->user_data = IO_URING_REMOVE_USER_DATA;
+  store_release(sq_tail_, ++sq_local_tail_);
+  to_submit_++;
+
+  // completions, which are still in the completion queue, will be ignored because of the generation change
+  info.list_node = nullptr;
+  info.generation++;
+
+  // the poll request must be cancelled before the file descriptor is closed or reused
+  submit();
+}
+
+int IoUring::enter(uint32 min_complete, uint32 flags, const void *arg, size_t arg_size) {
+  int result = io_uring_enter(ring_fd_.fd(), to_submit_, min_complete, flags, arg, arg_size);
+  if (result < 0) {
+    auto io_uring_enter_errno = errno;
+    LOG_IF(FATAL, io_uring_enter_errno != EINTR && io_uring_enter_errno != ETIME && io_uring_enter_errno != EBUSY &&
+                      io_uring_enter_errno != EAGAIN)
+        << Status::PosixError(io_uring_enter_errno, "io_uring_enter failed");
+    return -io_uring_enter_errno;
+  }
+  CHECK(static_cast<uint32>(result) <= to_submit_);
+  to_submit_ -= static_cast<uint32>(result);
+  return result;
+}
+
+void IoUring::submit() {
+  if (to_submit_ == 0) {
+    return;
+  }
+  auto result = enter(0, 0, nullptr, 0);
+  if (result == -EBUSY || result == -EAGAIN) {
+    // the kernel has no space for new completions, so the completion queue must be drained before the next attempt
+    reap_completions();
+  }
+}
+
+void IoUring::reap_completions() {
+  auto head = *cq_head_;
+  auto tail = load_acquire(cq_tail_);
+  for (; head != tail; head++) {
+    reaped_cqes_.push_back(cqes_[head & cq_ring_mask_]);
+  }
+  store_release(cq_head_, head);
+}
+
+void IoUring::subscribe(PollableFd fd, PollFlags flags) {
+  if (use_epoll_) {
+    return epoll_.subscribe(std::move(fd), flags);
+  }
+
+  auto native_fd = fd.native_fd().fd();
+  CHECK(native_fd >= 0);
+  auto *list_node = fd.release_as_list_node();
+  list_root_.put(list_node);
+
+  if (static_cast<size_t>(native_fd) >= fds_.size()) {
+    fds_.resize(static_cast<size_t>(native_fd) + 1);
+  }
+  auto &info = fds_[native_fd];
+  CHECK(info.list_node == nullptr);
+  info.list_node = list_node;
+  info.poll_mask = POLLHUP | POLLERR | POLLRDHUP;
+  if (flags.can_read()) {
+    info.poll_mask |= POLLIN;
+  }
+  if (flags.can_write()) {
+    info.poll_mask |= POLLOUT;
+  }
+  add_poll(native_fd);
+}
+
+void IoUring::unsubscribe(PollableFdRef fd_ref) {
+  if (use_epoll_) {
+    return epoll_.unsubscribe(fd_ref);
+  }
+
+  auto fd = fd_ref.lock();
+  remove_poll(fd.native_fd().fd());
+}
+
+void IoUring::unsubscribe_before_close(PollableFdRef fd) {
+  unsubscribe(fd);
+}
+
+void IoUring::process_completion(const io_uring_cqe &cqe) {
+  if (cqe.user_data == IO_URING_REMOVE_USER_DATA) {
+    return;
+  }
+
+  auto native_fd = static_cast<int>(static_cast<uint32>(cqe.user_data));
+  auto generation = static_cast<uint32>(cqe.user_data >> 32);
+  if (static_cast<size_t>(native_fd) >= fds_.size()) {
+    return;
+  }
+  auto &info = fds_[native_fd];
+  if (info.list_node == nullptr || info.generation != generation) {
+    // the file descriptor was unsubscribed after the completion had been posted
+    return;
+  }
+
+  PollFlags flags;
+  if (cqe.res < 0) {
+    if (cqe.res != -ECANCELED) {
+      LOG(ERROR) << Status::PosixError(-cqe.res, "io_uring poll failed") << ", fd = " << native_fd;
+      flags = flags | PollFlags::Error();
+    }
+  } else {
+    auto events = static_cast<uint32>(cqe.res);
+    if (events & POLLIN) {
+      events &= ~POLLIN;
+      flags = flags | PollFlags::Read();
+    }
+    if (events & POLLOUT) {
+      events &= ~POLLOUT;
+      flags = flags | PollFlags::Write();
+    }
+    if (events & POLLRDHUP) {
+      events &= ~POLLRDHUP;
+      flags = flags | PollFlags::Close();
+    }
+    if (events & POLLHUP) {
+      events &= ~POLLHUP;
+      flags = flags | PollFlags::Close();
+    }
+    if (events & POLLERR) {
+      events &= ~POLLERR;
+      flags = flags | PollFlags::Error();
+    }
+    if (events) {
+      LOG(FATAL) << "Unsupported io_uring poll events: " << events;
+    }
+  }
+
+  if ((cqe.flags & IORING_CQE_F_MORE) == 0 && (cqe.res >= 0 || cqe.res == -ECANCELED)) {
+    // multishot request was terminated by the kernel, for example, because of completion queue overflow;
+    // a new request reports the current state of the file descriptor, so no events are lost
+    add_poll(native_fd);
+  }
+
+  if (!flags.empty()) {
+    auto pollable_fd = PollableFd::from_list_node(info.list_node);
+    pollable_fd.add_flags(flags);
+    pollable_fd.release_as_list_node();
+  }
+}
+
+void IoUring::run(int timeout_ms) {
+  if (use_epoll_) {
+    return epoll_.run(timeout_ms);
+  }
+
+  if (load_acquire(cq_tail_) == *cq_head_ && reaped_cqes_.empty()) {
+    __kernel_timespec timeout;
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    uint32 min_complete = 1;
+    if (timeout_ms == 0) {
+      min_complete = 0;
+    } else if (timeout_ms > 0) {
+      timeout.tv_sec = timeout_ms / 1000;
+      timeout.tv_nsec = timeout_ms % 1000 * 1000000;
+      arg.ts = reinterpret_cast<uint64>(&timeout);
+    }
+    enter(min_complete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+  } else {
+    submit();
+  }
+
+  // completions are moved out of the completion queue first, because their processing can submit new requests,
+  // which may require to drain the queue
+  reap_completions();
+  while ((__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) != 0) {
+    // the kernel keeps completions, which didn't fit in the completion queue, until it is drained
+    enter(0, IORING_ENTER_GETEVENTS, nullptr, 0);
+    reap_completions();
+  }
+  while (!reaped_cqes_.empty()) {
+    std::swap(reaped_cqes_, processed_cqes_);
+    for (auto &cqe : processed_cqes_) {
+      process_completion(cqe);
+    }
+    processed_cqes_.clear();
+  }
+}
+
+}  // namespace detail
+}  // namespace td
+
+#endif
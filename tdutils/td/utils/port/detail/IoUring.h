@@ -0,0 +1,124 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/port/config.h"
+
+#ifdef TD_POLL_IO_URING
+
+#include "td/utils/common.h"
+#include "td/utils/List.h"
+#include "td/utils/port/detail/Epoll.h"
+#include "td/utils/port/detail/NativeFd.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/PollBase.h"
+#include "td/utils/port/PollFlags.h"
+#include "td/utils/Status.h"
+
+#include <atomic>
+
+#include <linux/io_uring.h>
+
+namespace td {
+namespace detail {
+
+// Poll implementation based on multishot IORING_OP_POLL_ADD requests
+// all subscription changes are batched and submitted together with the wait for completions
+// falls back to Epoll if io_uring can't be used at runtime
+class IoUring final : public PollBase {
+ public:
+  IoUring() = default;
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+  IoUring(IoUring &&) = delete;
+  IoUring &operator=(IoUring &&) = delete;
+  ~IoUring() final;
+
+  void init() final;
+
+  void clear() final;
+
+  void subscribe(PollableFd fd, PollFlags flags) final;
+
+  void unsubscribe(PollableFdRef fd) final;
+
+  void unsubscribe_before_close(PollableFdRef fd) final;
+
+  void run(int timeout_ms) final;
+
+  static bool is_edge_triggered() {
+    return true;
+  }
+
+  // affects only subsequently initialized instances
+  static void set_enabled(bool is_enabled);
+
+  static bool is_enabled();
+
+  bool is_epoll_used() const {
+    return use_epoll_;
+  }
+
+ private:
+  struct FdInfo {
+    ListNode *list_node = nullptr;
+    uint32 generation = 0;
+    uint32 poll_mask = 0;
+  };
+
+  static std::atomic<bool> is_enabled_;
+
+  bool use_epoll_ = false;
+  Epoll epoll_;
+
+  NativeFd ring_fd_;
+  void *ring_ptr_ = nullptr;
+  size_t ring_size_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  uint32 *sq_head_ = nullptr;
+  uint32 *sq_tail_ = nullptr;
+  uint32 sq_ring_mask_ = 0;
+  uint32 *sq_flags_ = nullptr;
+  uint32 sq_entries_ = 0;
+  uint32 sq_local_tail_ = 0;
+  uint32 to_submit_ = 0;
+
+  uint32 *cq_head_ = nullptr;
+  uint32 *cq_tail_ = nullptr;
+  uint32 cq_ring_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+  vector<io_uring_cqe> reaped_cqes_;  // completions, which were moved out of the completion queue, but not processed
+  vector<io_uring_cqe> processed_cqes_;
+
+  vector<FdInfo> fds_;
+  ListNode list_root_;
+
+  Status init_ring();
+
+  void close_ring();
+
+  io_uring_sqe *get_sqe();
+
+  void add_poll(int native_fd);
+
+  void remove_poll(int native_fd);
+
+  int enter(uint32 min_complete, uint32 flags, const void *arg, size_t arg_size);
+
+  void submit();
+
+  void reap_completions();
+
+  void process_completion(const io_uring_cqe &cqe);
+};
+
+}  // namespace detail
+}  // namespace td
+
+#endif
@@ -27,6 +27,7 @@ TEST(WaitFreeHashMap, stress_test) {
   auto check = [&](bool check_size = false) {
     if (check_size) {
       ASSERT_EQ(reference.size(), map.calc_size());
+      ASSERT_TRUE(map.calc_size() <= map.calc_bucket_count());
     }
     ASSERT_EQ(reference.empty(), map.empty());
 
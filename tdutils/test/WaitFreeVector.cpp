@@ -40,6 +40,7 @@ TEST(WaitFreeVector, stress_test) {
   add_step(2000, [&] {
     ASSERT_EQ(reference.size(), vector.size());
     ASSERT_EQ(reference.empty(), vector.empty());
+    ASSERT_TRUE(vector.size() <= vector.calc_capacity());
     auto value = rnd();
     reference.emplace_back(value);
     if (rnd() & 1) {
@@ -7,6 +7,9 @@
 #include "td/utils/tests.h"
 
 #include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 
 TEST(Buffer, buffer_builder) {
@@ -54,3 +57,62 @@ TEST(Buffer, buffer_builder) {
     ASSERT_EQ(builder.extract().as_slice(), str);
   }
 }
+
+static size_t get_live_count(size_t block_size) {
+  for (auto &stats : td::BufferAllocator::get_size_class_stats()) {
+    if (stats.block_size == block_size) {
+      return stats.live_count;
+    }
+  }
+  UNREACHABLE();
+  return 0;
+}
+
+TEST(Buffer, size_classes) {
+  auto stats = td::BufferAllocator::get_size_class_stats();
+  ASSERT_TRUE(!stats.empty());
+  ASSERT_EQ(0u, stats.back().block_size);
+
+  auto start_mem = td::BufferAllocator::get_buffer_mem();
+  auto count_4096 = get_live_count(4096);
+  auto count_big = get_live_count(0);
+  {
+    td::vector<td::BufferSlice> slices;
+    for (int i = 0; i < 1000; i++) {
+      slices.emplace_back(td::rand_string('a', 'z', 4000));
+    }
+    slices.emplace_back(1 << 20);
+    ASSERT_EQ(count_4096 + 1000, get_live_count(4096));
+    ASSERT_EQ(count_big + 1, get_live_count(0));
+
+    // blocks must be reusable by other threads
+    td::thread thread([slices = std::move(slices)]() mutable {
+      slices.clear();
+      for (int i = 0; i < 100; i++) {
+        td::string str = td::rand_string('a', 'z', td::Random::fast(1, 100000));
+        td::BufferSlice slice(str);
+        ASSERT_EQ(str, slice.as_slice());
+      }
+    });
+    thread.join();
+  }
+  ASSERT_EQ(count_4096, get_live_count(4096));
+  ASSERT_EQ(count_big, get_live_count(0));
+  ASSERT_EQ(start_mem, td::BufferAllocator::get_buffer_mem());
+
+  td::vector<td::string> strings;
+  td::vector<td::BufferSlice> slices;
+  for (int i = 0; i < 1000; i++) {
+    strings.push_back(td::rand_string('a', 'z', td::Random::fast(1, 20000)));
+    slices.emplace_back(strings.back());
+    if (td::Random::fast_bool()) {
+      auto pos = td::Random::fast(0, static_cast<int>(slices.size()) - 1);
+      ASSERT_EQ(strings[pos], slices[pos].as_slice());
+      strings.erase(strings.begin() + pos);
+      slices.erase(slices.begin() + pos);
+    }
+  }
+  for (size_t i = 0; i < slices.size(); i++) {
+    ASSERT_EQ(strings[i], slices[i].as_slice());
+  }
+}
@@ -8,6 +8,7 @@
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashMapChunks.h"
+#include "td/utils/FlatHashMapSwiss.h"
 #include "td/utils/FlatHashTable.h"
 #include "td/utils/format.h"
 #include "td/utils/HashTableUtils.h"
@@ -595,6 +596,7 @@ using FlatHashMapImpl = td::FlatHashTable<td::MapNode<KeyT, ValueT, EqT>, HashT,
 #define FOR_EACH_TABLE(F)  \
   F(FlatHashMapImpl)       \
   F(td::FlatHashMapChunks) \
+  F(td::FlatHashMapSwiss)  \
   F(folly::F14FastMap)     \
   F(absl::flat_hash_map)   \
   F(std::unordered_map)    \
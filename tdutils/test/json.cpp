@@ -10,6 +10,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/Parser.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
 
@@ -297,4 +298,61 @@ TEST(JSON, string_decode) {
   test_string_decode_error("\"\\u 123\"");
   test_string_decode_error("\"\\uD800\\ug123\"");
   test_string_decode_error("\"\\uD800\\u123\"");
+
+  for (size_t prefix_length = 0; prefix_length < 40; prefix_length++) {
+    td::string prefix(prefix_length, 'a');
+    for (size_t suffix_length = 0; suffix_length < 40; suffix_length += 7) {
+      td::string suffix(suffix_length, 'b');
+      test_string_decode("\"" + prefix + "\\n" + suffix + "\"", prefix + "\n" + suffix);
+      test_string_decode("\"" + prefix + "\\\"" + suffix + "\\\\" + prefix + "\"",
+                         prefix + "\"" + suffix + "\\" + prefix);
+      test_string_decode("\"" + prefix + suffix + "\"", prefix + suffix);
+      test_string_decode_error("\"" + prefix + suffix);
+      test_string_decode_error("\"" + prefix + "\\" + suffix + "\\");
+    }
+  }
+}
+
+TEST(JSON, string_encode) {
+  for (size_t prefix_length = 0; prefix_length < 40; prefix_length++) {
+    td::string prefix(prefix_length, 'a');
+    for (size_t suffix_length = 0; suffix_length < 40; suffix_length += 7) {
+      td::string suffix(suffix_length, '~');
+      ASSERT_EQ("\"" + prefix + suffix + "\"", PSTRING() << td::JsonString(prefix + suffix));
+      ASSERT_EQ("\"" + prefix + "\\\"\\\\\\n\\u0001\\u00e9\\u20ac" + suffix + "\"",
+                PSTRING() << td::JsonString(prefix + "\"\\\n\x01\xC3\xA9\xE2\x82\xAC" + suffix));
+      ASSERT_EQ("\"" + prefix + "\\\"\\\\\\n\\u0001\xC3\xA9\xE2\x82\xAC" + suffix + "\"",
+                PSTRING() << td::JsonRawString(prefix + "\"\\\n\x01\xC3\xA9\xE2\x82\xAC" + suffix));
+    }
+  }
+}
+
+class JsonStringEncodeBenchmark final : public td::Benchmark {
+  td::string str_;
+
+ public:
+  explicit JsonStringEncodeBenchmark(td::string str) : str_(std::move(str)) {
+  }
+
+  td::string get_description() const final {
+    return td::string("JsonStringEncodeBenchmark") + str_.substr(0, 6);
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      auto str = td::json_encode<td::string>(td::JsonString(str_));
+      CHECK(str.size() >= str_.size() + 2);
+    }
+  }
+};
+
+TEST(JSON, bench_json_string_encode) {
+  td::bench(JsonStringEncodeBenchmark(td::string(1000, 'a')));
+  td::bench(JsonStringEncodeBenchmark(td::string(1000, '\\')));
+  td::string str;
+  for (int i = 32; i < 128; i++) {
+    str += "a\\";
+    str += static_cast<char>(i);
+  }
+  td::bench(JsonStringEncodeBenchmark(str));
 }
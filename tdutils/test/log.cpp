@@ -4,6 +4,7 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/utils/AsyncBinaryLog.h"
 #include "td/utils/AsyncFileLog.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/CombinedLog.h"
@@ -11,8 +12,10 @@
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/MemoryLog.h"
+#include "td/utils/misc.h"
 #include "td/utils/NullLog.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/sleep.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -22,10 +25,226 @@
 
 #include <functional>
 #include <limits>
+#include <mutex>
 
 char disable_linker_warning_about_empty_file_tdutils_test_log_cpp TD_UNUSED;
 
 #if !TD_THREAD_UNSUPPORTED
+class VectorLog final : public td::LogInterface {
+ public:
+  void do_append(int log_level, td::CSlice slice) final {
+    std::lock_guard<std::mutex> guard(mutex_);
+    data_ += slice.str();
+  }
+
+  td::vector<td::string> get_lines() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto lines = td::full_split(td::Slice(data_), '\n');
+    CHECK(!lines.empty() && lines.back().empty());
+    lines.pop_back();
+    td::vector<td::string> result;
+    for (auto line : lines) {
+      // remove log level, thread identifier, timestamp and source line
+      for (int i = 0; i < 4; i++) {
+        auto pos = line.find(']');
+        CHECK(pos != td::Slice::npos);
+        line.remove_prefix(pos + 1);
+      }
+      result.push_back(line.str());
+    }
+    return result;
+  }
+
+ private:
+  std::mutex mutex_;
+  td::string data_;
+};
+
+#define LOG_TEST_MESSAGE(LOG_MACRO, i)                                                                                \
+  LOG_MACRO(ERROR) << "Message " << i << ' ' << -i << ' ' << static_cast<td::uint64>(i) * 12345678901ull << ' ' \
+                   << i * 0.5 << ' ' << (i % 2 == 0) << ' ' << td::string("string") << ' ' << td::Slice("slice")  \
+                   << ' ' << td::tag("tag", i) << ' ' << static_cast<short>(i) << '\n'
+
+TEST(Log, AsyncBinaryLog) {
+  auto old_log_interface = td::log_interface;
+  auto old_verbosity_level = GET_VERBOSITY_LEVEL();
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  VectorLog expected_log;
+  td::log_interface = &expected_log;
+  for (int i = 0; i < 10; i++) {
+    LOG_TEST_MESSAGE(LOG, i);
+  }
+
+  const int threads_n = 4;
+  const int messages_n = 10000;
+  VectorLog log;
+  {
+    td::AsyncBinaryLog async_log;
+    async_log.init(&log);
+    td::log_interface = &async_log;
+    for (int i = 0; i < 10; i++) {
+      LOG_TEST_MESSAGE(LOG_DEFERRED, i);
+    }
+
+    td::vector<td::thread> threads(threads_n);
+    for (int i = 0; i < threads_n; i++) {
+      threads[i] = td::thread([i] {
+        for (int j = 0; j < messages_n; j++) {
+          if (j % 2 == 0) {
+            LOG_DEFERRED(ERROR) << "Thread " << i << " message " << j;
+          } else {
+            LOG(ERROR) << "Thread " << i << " message " << j;
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    td::log_interface = old_log_interface;
+  }
+  SET_VERBOSITY_LEVEL(old_verbosity_level);
+
+  auto expected_lines = expected_log.get_lines();
+  auto lines = log.get_lines();
+  ASSERT_EQ(10u, expected_lines.size());
+  ASSERT_EQ(10u + threads_n * messages_n, lines.size());
+  for (size_t i = 0; i < expected_lines.size(); i++) {
+    ASSERT_EQ(expected_lines[i], lines[i]);
+  }
+  td::vector<int> next_message(threads_n);
+  for (size_t i = expected_lines.size(); i < lines.size(); i++) {
+    auto pos = lines[i].find("Thread ");
+    ASSERT_TRUE(pos != td::string::npos);
+    auto words = td::full_split(td::Slice(lines[i]).substr(pos), ' ');
+    ASSERT_EQ(4u, words.size());
+    auto thread_id = td::to_integer<int>(words[1]);
+    ASSERT_EQ(next_message[thread_id]++, td::to_integer<int>(words[3]));
+  }
+}
+
+TEST(Log, AsyncBinaryLog_big_records) {
+  auto old_log_interface = td::log_interface;
+  auto old_verbosity_level = GET_VERBOSITY_LEVEL();
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+
+  const int threads_n = 4;
+  const int messages_n = 1000;
+  VectorLog log;
+  {
+    td::AsyncBinaryLog async_log;
+    async_log.init(&log);
+    td::log_interface = &async_log;
+
+    // thread rings must grow to fit big records without reordering records of the thread
+    td::vector<td::thread> threads(threads_n);
+    for (int i = 0; i < threads_n; i++) {
+      threads[i] = td::thread([i] {
+        for (int j = 0; j < messages_n; j++) {
+          td::string padding(j % 10 == 0 ? j * 50 : j % 100, 'a');
+          if (j % 2 == 0) {
+            LOG_DEFERRED(ERROR) << "Thread " << i << " message " << j << ' ' << padding;
+          } else {
+            LOG(ERROR) << "Thread " << i << " message " << j << ' ' << padding;
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    td::log_interface = old_log_interface;
+  }
+  SET_VERBOSITY_LEVEL(old_verbosity_level);
+
+  auto lines = log.get_lines();
+  ASSERT_EQ(static_cast<size_t>(threads_n * messages_n), lines.size());
+  td::vector<int> next_message(threads_n);
+  for (auto &line : lines) {
+    auto pos = line.find("Thread ");
+    ASSERT_TRUE(pos != td::string::npos);
+    auto words = td::full_split(td::Slice(line).substr(pos), ' ');
+    ASSERT_EQ(5u, words.size());
+    auto thread_id = td::to_integer<int>(words[1]);
+    auto message_id = td::to_integer<int>(words[3]);
+    ASSERT_EQ(next_message[thread_id]++, message_id);
+    ASSERT_EQ(static_cast<size_t>(message_id % 10 == 0 ? message_id * 50 : message_id % 100), words[4].size());
+  }
+}
+
+static int VERBOSITY_NAME(deferred_log_test) = VERBOSITY_NAME(ERROR);
+
+TEST(Log, AsyncBinaryLog_vlog) {
+  auto old_log_interface = td::log_interface;
+  auto old_verbosity_level = GET_VERBOSITY_LEVEL();
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  VectorLog expected_log;
+  td::log_interface = &expected_log;
+  VLOG(deferred_log_test) << "Message " << 1 << ' ' << td::tag("tag", 2);
+
+  VectorLog log;
+  {
+    td::AsyncBinaryLog async_log;
+    async_log.init(&log);
+    td::log_interface = &async_log;
+    VLOG_DEFERRED(deferred_log_test) << "Message " << 1 << ' ' << td::tag("tag", 2);
+    td::log_interface = old_log_interface;
+  }
+  SET_VERBOSITY_LEVEL(old_verbosity_level);
+
+  auto expected_lines = expected_log.get_lines();
+  ASSERT_EQ(1u, expected_lines.size());
+  ASSERT_TRUE(expected_lines[0].find("[&deferred_log_test]") != td::string::npos);
+  ASSERT_TRUE(expected_lines == log.get_lines());
+}
+
+TEST(Log, AsyncBinaryLog_close) {
+  auto old_log_interface = td::log_interface;
+  auto old_verbosity_level = GET_VERBOSITY_LEVEL();
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+
+  const int threads_n = 4;
+  const int messages_n = 100000;
+  VectorLog log;
+  VectorLog fallback_log;
+  td::vector<td::thread> threads(threads_n);
+  {
+    td::AsyncBinaryLog async_log;
+    async_log.init(&log);
+    td::log_interface = &async_log;
+
+    for (int i = 0; i < threads_n; i++) {
+      threads[i] = td::thread([i] {
+        for (int j = 0; j < messages_n; j++) {
+          LOG_DEFERRED(ERROR) << "Thread " << i << " message " << j;
+        }
+      });
+    }
+
+    // the log is closed while the threads are still logging; records pushed before that must not be lost
+    td::usleep_for(10000);
+    td::log_interface = &fallback_log;
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  td::log_interface = old_log_interface;
+  SET_VERBOSITY_LEVEL(old_verbosity_level);
+
+  auto lines = log.get_lines();
+  auto fallback_lines = fallback_log.get_lines();
+  ASSERT_EQ(static_cast<size_t>(threads_n * messages_n), lines.size() + fallback_lines.size());
+  td::vector<int> next_message(threads_n);
+  for (auto &line : lines) {
+    auto pos = line.find("Thread ");
+    ASSERT_TRUE(pos != td::string::npos);
+    auto words = td::full_split(td::Slice(line).substr(pos), ' ');
+    ASSERT_EQ(4u, words.size());
+    auto thread_id = td::to_integer<int>(words[1]);
+    ASSERT_EQ(next_message[thread_id]++, td::to_integer<int>(words[3]));
+  }
+}
+
 template <class Log>
 class LogBenchmark final : public td::Benchmark {
  public:
@@ -12,6 +12,7 @@
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/IoSlice.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Poll.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/Stat.h"
@@ -295,6 +296,87 @@ TEST(Port, EventFdAndSignals) {
 #endif
 #endif
 
+#if TD_POLL_IO_URING
+TEST(Port, IoUringPoll) {
+  SCOPE_EXIT {
+    td::detail::IoUring::set_enabled(true);
+  };
+  for (auto is_enabled : {true, false}) {
+    td::detail::IoUring::set_enabled(is_enabled);
+    td::Poll poll;
+    poll.init();
+    if (!is_enabled) {
+      ASSERT_TRUE(poll.is_epoll_used());
+    }
+
+    td::vector<td::EventFd> event_fds(10);
+    for (auto &event_fd : event_fds) {
+      event_fd.init();
+      poll.subscribe(event_fd.get_poll_info().extract_pollable_fd(nullptr), td::PollFlags::Read());
+    }
+    poll.run(0);
+    for (auto &event_fd : event_fds) {
+      event_fd.get_poll_info().sync_with_poll();
+      ASSERT_TRUE(!event_fd.get_poll_info().get_flags_local().can_read());
+    }
+
+    for (int t = 0; t < 3; t++) {
+      for (size_t i = 0; i < event_fds.size(); i += 2) {
+        event_fds[i].release();
+      }
+      poll.run(100);
+      poll.run(0);
+      for (size_t i = 0; i < event_fds.size(); i++) {
+        auto &event_fd = event_fds[i];
+        event_fd.get_poll_info().sync_with_poll();
+        ASSERT_EQ(i % 2 == 0, event_fd.get_poll_info().get_flags_local().can_read());
+        if (i % 2 == 0) {
+          event_fd.acquire();
+          ASSERT_TRUE(!event_fd.get_poll_info().get_flags_local().can_read());
+        }
+      }
+    }
+
+    for (size_t i = 0; i < event_fds.size(); i += 2) {
+      poll.unsubscribe(event_fds[i].get_poll_info().get_pollable_fd_ref());
+      event_fds[i].close();
+      event_fds[i + 1].release();
+    }
+    poll.run(100);
+    poll.run(0);
+    for (size_t i = 1; i < event_fds.size(); i += 2) {
+      event_fds[i].get_poll_info().sync_with_poll();
+      ASSERT_TRUE(event_fds[i].get_poll_info().get_flags_local().can_read());
+      poll.unsubscribe_before_close(event_fds[i].get_poll_info().get_pollable_fd_ref());
+      event_fds[i].close();
+    }
+    poll.clear();
+  }
+}
+
+TEST(Port, IoUringCompletionQueueOverflow) {
+  td::Poll poll;
+  poll.init();
+  td::EventFd event_fd;
+  event_fd.init();
+  event_fd.release();
+
+  // each subscription of a ready file descriptor and each unsubscription post completions, so the completion queue
+  // overflows without poll.run and new requests can't be submitted until it is drained
+  for (int i = 0; i < 10000; i++) {
+    poll.subscribe(event_fd.get_poll_info().extract_pollable_fd(nullptr), td::PollFlags::Read());
+    poll.unsubscribe(event_fd.get_poll_info().get_pollable_fd_ref());
+  }
+  poll.subscribe(event_fd.get_poll_info().extract_pollable_fd(nullptr), td::PollFlags::Read());
+  poll.run(0);
+  event_fd.get_poll_info().sync_with_poll();
+  ASSERT_TRUE(event_fd.get_poll_info().get_flags_local().can_read());
+  poll.unsubscribe_before_close(event_fd.get_poll_info().get_pollable_fd_ref());
+  event_fd.close();
+  poll.clear();
+}
+#endif
+
 #if TD_HAVE_THREAD_AFFINITY
 TEST(Port, ThreadAffinityMask) {
   auto thread_id = td::this_thread::get_id();
@@ -520,6 +520,12 @@ TEST(DB, key_value_set_all) {
     for (auto &key : keys) {
       CHECK(kv.get(key) == sqlite_kv.get(key));
     }
+
+    auto batch_values = sqlite_kv.get_batch(keys);
+    ASSERT_EQ(keys.size(), batch_values.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      CHECK(kv.get(keys[i]) == batch_values[i]);
+    }
   }
   td::SqliteDb::destroy(sqlite_kv_name).ignore();
 }
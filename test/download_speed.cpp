@@ -0,0 +1,102 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/DownloadSpeedEstimator.h"
+#include "td/telegram/files/PartsManager.h"
+
+#include "td/utils/common.h"
+#include "td/utils/misc.h"
+#include "td/utils/tests.h"
+
+// simulates a local download server, which answers every part query after rtt with the given throughput
+static td::DownloadSpeedEstimator simulate_download(double rtt, double speed, size_t part_size, int in_flight,
+                                                    int part_count) {
+  td::DownloadSpeedEstimator estimator;
+  double now = 0.0;
+  double link_free_time = 0.0;
+  td::vector<double> start_times(in_flight, 0.0);
+  for (int i = 0; i < part_count; i++) {
+    auto &start_time = start_times[i % in_flight];
+    link_free_time = td::max(link_free_time, start_time + rtt / 2) + static_cast<double>(part_size) / speed;
+    now = link_free_time + rtt / 2;
+    estimator.on_part_downloaded(static_cast<td::int64>(part_size), now - start_time, now);
+    start_time = now;
+  }
+  return estimator;
+}
+
+TEST(DownloadSpeed, estimator) {
+  td::DownloadSpeedEstimator empty;
+  ASSERT_TRUE(!empty.has_estimate());
+  ASSERT_EQ(0u, empty.get_preferred_part_size());
+  ASSERT_EQ(1 << 21, empty.get_resource_limit(1 << 21, 1 << 23));
+
+  for (auto rtt : {0.01, 0.05, 0.1, 0.3}) {
+    for (auto speed : {1e6, 1e7, 1e8}) {
+      size_t part_size = 64 << 10;
+      int in_flight = 16;
+      auto estimator = simulate_download(rtt, speed, part_size, in_flight, 1000);
+      ASSERT_TRUE(estimator.has_estimate());
+      ASSERT_TRUE(estimator.get_rtt() >= rtt);
+
+      // throughput is limited either by the link or by the number of simultaneously downloaded parts
+      auto part_time = rtt + static_cast<double>(part_size) / speed;
+      auto expected_speed = td::min(speed, static_cast<double>(part_size) * in_flight / part_time);
+      ASSERT_TRUE(estimator.get_speed() <= expected_speed * 1.01);
+      ASSERT_TRUE(estimator.get_speed() >= expected_speed * 0.8);
+
+      auto preferred_part_size = estimator.get_preferred_part_size();
+      ASSERT_TRUE(td::DownloadSpeedEstimator::MIN_PART_SIZE <= preferred_part_size);
+      ASSERT_TRUE(preferred_part_size <= td::DownloadSpeedEstimator::MAX_PART_SIZE);
+      ASSERT_EQ(0u, preferred_part_size & (preferred_part_size - 1));
+
+      auto resource_limit = estimator.get_resource_limit(1 << 21, 1 << 23);
+      ASSERT_TRUE(resource_limit >= (1 << 21));
+      ASSERT_TRUE(resource_limit <= (1 << 23));
+    }
+  }
+
+  auto slow = simulate_download(0.01, 1e6, 64 << 10, 16, 1000);
+  auto fast = simulate_download(0.3, 1e8, 512 << 10, 64, 1000);
+  ASSERT_EQ(static_cast<size_t>(64 << 10), slow.get_preferred_part_size());
+  ASSERT_EQ(static_cast<size_t>(512 << 10), fast.get_preferred_part_size());
+  ASSERT_EQ(1 << 21, slow.get_resource_limit(1 << 21, 1 << 23));
+  ASSERT_EQ(1 << 23, fast.get_resource_limit(1 << 21, 1 << 23));
+}
+
+TEST(DownloadSpeed, preferred_part_size) {
+  {
+    td::PartsManager parts_manager;
+    parts_manager.set_preferred_part_size(256 << 10);
+    parts_manager.init(10 << 20, 10 << 20, true, 0, {}, false, false).ensure();
+    ASSERT_EQ(static_cast<size_t>(256 << 10), parts_manager.get_part_size());
+    ASSERT_EQ(40, parts_manager.get_part_count());
+  }
+  {
+    // small files are downloaded in a single part
+    td::PartsManager parts_manager;
+    parts_manager.set_preferred_part_size(512 << 10);
+    parts_manager.init(100 << 10, 100 << 10, true, 0, {}, false, false).ensure();
+    ASSERT_EQ(1, parts_manager.get_part_count());
+    auto part = parts_manager.start_part().move_as_ok();
+    ASSERT_EQ(static_cast<size_t>(100 << 10), part.size);
+  }
+  {
+    // part count limit still applies
+    td::PartsManager parts_manager;
+    parts_manager.set_preferred_part_size(128 << 10);
+    td::int64 size = static_cast<td::int64>(1) << 30;
+    parts_manager.init(size, size, true, 0, {}, false, false).ensure();
+    ASSERT_EQ(static_cast<size_t>(512 << 10), parts_manager.get_part_size());
+  }
+  {
+    // part size of partially downloaded file is kept
+    td::PartsManager parts_manager;
+    parts_manager.set_preferred_part_size(512 << 10);
+    parts_manager.init(10 << 20, 10 << 20, true, 64 << 10, {0, 1, 2}, false, false).ensure();
+    ASSERT_EQ(static_cast<size_t>(64 << 10), parts_manager.get_part_size());
+  }
+}
@@ -0,0 +1,151 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/EmojiKeywordIndex.h"
+#include "td/telegram/EmojiKeywordIndex.hpp"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/Slice.h"
+#include "td/utils/tests.h"
+#include "td/utils/tl_helpers.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+static void check_index(const td::EmojiKeywordIndex &index, const std::map<td::string, td::vector<td::string>> &expected,
+                        td::Slice prefix) {
+  td::vector<std::pair<td::string, td::string>> expected_result;
+  for (auto &it : expected) {
+    if (td::begins_with(it.first, prefix)) {
+      for (auto &emoji : it.second) {
+        expected_result.emplace_back(emoji, it.first);
+      }
+    }
+  }
+  ASSERT_TRUE(index.search(prefix) == expected_result);
+}
+
+TEST(EmojiKeywordIndex, search) {
+  td::EmojiKeywordIndex index(3, {{"cat", "😺$🐈"}, {"car", "🚗"}, {"dog", "🐶"}, {"empty", ""}});
+  ASSERT_EQ(3, index.get_version());
+  ASSERT_EQ(3u, index.size());
+
+  ASSERT_TRUE(index.get_keyword_emojis("cat") == td::vector<td::string>({"😺", "🐈"}));
+  ASSERT_TRUE(index.get_keyword_emojis("ca").empty());
+  ASSERT_TRUE(index.get_keyword_emojis("empty").empty());
+
+  using Result = td::vector<std::pair<td::string, td::string>>;
+  ASSERT_TRUE(index.search("ca") == Result({{"🚗", "car"}, {"😺", "cat"}, {"🐈", "cat"}}));
+  ASSERT_TRUE(index.search("d") == Result({{"🐶", "dog"}}));
+  ASSERT_TRUE(index.search("x").empty());
+  ASSERT_EQ(4u, index.search("").size());
+
+  index.set_keyword_emojis("cab", {"🚕", "🚖"});
+  index.set_keyword_emojis("car", {});
+  index.set_keyword_emojis("dog", {"🐕"});
+  ASSERT_EQ(3u, index.size());
+  ASSERT_TRUE(index.search("ca") == Result({{"🚕", "cab"}, {"🚖", "cab"}, {"😺", "cat"}, {"🐈", "cat"}}));
+  ASSERT_TRUE(index.get_keyword_emojis("dog") == td::vector<td::string>{"🐕"});
+}
+
+TEST(EmojiKeywordIndex, random) {
+  std::map<td::string, td::vector<td::string>> expected;
+  auto random_keyword = [] {
+    td::string keyword;
+    for (int i = td::Random::fast(1, 4); i > 0; i--) {
+      keyword += static_cast<char>('a' + td::Random::fast(0, 3));
+    }
+    return keyword;
+  };
+  auto random_emojis = [] {
+    td::vector<td::string> emojis;
+    for (int i = td::Random::fast(1, 3); i > 0; i--) {
+      emojis.push_back(td::to_string(td::Random::fast(0, 100)));
+    }
+    return emojis;
+  };
+  for (int i = 0; i < 100; i++) {
+    expected[random_keyword()] = random_emojis();
+  }
+  td::vector<std::pair<td::string, td::string>> keyword_emojis;
+  for (auto &it : expected) {
+    keyword_emojis.emplace_back(it.first, td::implode(it.second, '$'));
+  }
+  td::Random::shuffle(keyword_emojis);
+  td::EmojiKeywordIndex index(1, std::move(keyword_emojis));
+
+  for (int i = 0; i < 1000; i++) {
+    auto keyword = random_keyword();
+    if (td::Random::fast(0, 3) == 0) {
+      index.set_keyword_emojis(keyword, {});
+      expected.erase(keyword);
+    } else {
+      auto emojis = random_emojis();
+      index.set_keyword_emojis(keyword, emojis);
+      expected[keyword] = std::move(emojis);
+    }
+    ASSERT_EQ(expected.size(), index.size());
+    check_index(index, expected, random_keyword().substr(0, td::Random::fast(0, 2)));
+  }
+
+  // the index must survive saving to the database
+  td::EmojiKeywordIndex parsed_index;
+  ASSERT_TRUE(td::unserialize(parsed_index, td::serialize(index)).is_ok());
+  ASSERT_EQ(index.get_version(), parsed_index.get_version());
+  for (auto prefix : {"", "a", "b", "ab", "dd", "abc"}) {
+    check_index(parsed_index, expected, td::Slice(prefix));
+  }
+}
+
+TEST(EmojiKeywordIndex, shared_between_instances) {
+  td::string language_code = "test-shared";
+  ASSERT_TRUE(td::EmojiKeywordIndex::get_shared(language_code, 1) == nullptr);
+
+  // the first instance builds the index, and the second instance reuses it
+  auto first_index =
+      td::EmojiKeywordIndex::add_shared(language_code, td::EmojiKeywordIndex(1, {{"cat", "😺"}, {"dog", "🐶"}}));
+  auto second_index = td::EmojiKeywordIndex::get_shared(language_code, 1);
+  ASSERT_TRUE(second_index == first_index);
+  ASSERT_TRUE(td::EmojiKeywordIndex::add_shared(language_code, td::EmojiKeywordIndex(1, {{"car", "🚗"}})) ==
+              first_index);
+  ASSERT_TRUE(td::EmojiKeywordIndex::get_shared("other", 1) == nullptr);
+  ASSERT_TRUE(td::EmojiKeywordIndex::get_shared(language_code, 2) == nullptr);
+
+  // the first instance applies a difference, which must not be visible to the second instance
+  td::FlatHashMap<td::string, td::vector<td::string>> changed_keywords;
+  changed_keywords["cat"] = {"😺", "🐈"};
+  changed_keywords["dog"] = {};
+  changed_keywords["cow"] = {"🐄"};
+  first_index = td::EmojiKeywordIndex::add_shared_changes(language_code, *first_index, 2, changed_keywords);
+  ASSERT_TRUE(first_index != second_index);
+  ASSERT_EQ(2, first_index->get_version());
+  ASSERT_EQ(2u, first_index->size());
+  ASSERT_TRUE(first_index->get_keyword_emojis("cat") == td::vector<td::string>({"😺", "🐈"}));
+  ASSERT_TRUE(first_index->get_keyword_emojis("dog").empty());
+  ASSERT_EQ(1, second_index->get_version());
+  ASSERT_EQ(2u, second_index->size());
+  ASSERT_TRUE(second_index->get_keyword_emojis("cat") == td::vector<td::string>{"😺"});
+  ASSERT_TRUE(second_index->get_keyword_emojis("dog") == td::vector<td::string>{"🐶"});
+  ASSERT_TRUE(second_index->get_keyword_emojis("cow").empty());
+
+  // the same difference applied by the second instance gives the already built index
+  auto old_index = second_index;
+  second_index = td::EmojiKeywordIndex::add_shared_changes(language_code, *second_index, 2, {});
+  ASSERT_TRUE(second_index == first_index);
+
+  // the old version is destroyed after the last instance stops using it
+  ASSERT_TRUE(td::EmojiKeywordIndex::get_shared(language_code, 1) == old_index);
+  old_index = nullptr;
+  ASSERT_TRUE(td::EmojiKeywordIndex::get_shared(language_code, 1) == nullptr);
+  first_index = nullptr;
+  second_index = nullptr;
+  ASSERT_TRUE(td::EmojiKeywordIndex::get_shared(language_code, 2) == nullptr);
+}
@@ -5,6 +5,9 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/telegram/ConfigManager.h"
+#include "td/telegram/net/DcId.h"
+#include "td/telegram/net/DcOptions.h"
+#include "td/telegram/net/DcOptionsSet.h"
 #include "td/telegram/net/PublicRsaKeySharedMain.h"
 #include "td/telegram/net/Session.h"
 #include "td/telegram/NotificationManager.h"
@@ -46,6 +49,7 @@
 #include "td/utils/Status.h"
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
+#include "td/utils/tl_helpers.h"
 
 #include <memory>
 
@@ -661,6 +665,65 @@ class Mtproto_FastPing final : public td::Test {
 };
 td::RegisterTest<Mtproto_FastPing> mtproto_fastping("Mtproto_FastPing");
 
+TEST(Mtproto, DcOptionsSet) {
+  auto dc_id = td::DcId::internal(2);
+  auto get_dc_options = [dc_id] {
+    td::DcOptions dc_options;
+    for (auto ip : {"127.0.0.1", "127.0.0.2", "::1"}) {
+      td::IPAddress ip_address;
+      ip_address.init_host_port(td::CSlice(ip), 443).ensure();
+      dc_options.dc_options.emplace_back(dc_id, ip_address);
+    }
+    return dc_options;
+  };
+  auto find_connection = [dc_id](td::DcOptionsSet &dc_options_set) {
+    return dc_options_set.find_connection(dc_id, false, false, false, false).move_as_ok();
+  };
+
+  td::DcOptionsSet dc_options_set;
+  dc_options_set.add_dc_options(get_dc_options());
+  auto info = find_connection(dc_options_set);
+  ASSERT_EQ("127.0.0.1", info.option->get_ip_address().get_ip_str());
+  ASSERT_TRUE(!info.should_check);
+
+  // working options are ordered by round-trip time
+  info.stat->on_ok();
+  info.stat->on_rtt(0.2);
+  for (auto &other_info : dc_options_set.find_all_connections(dc_id, false, false, false, false)) {
+    if (other_info.option->get_ip_address().is_ipv6()) {
+      other_info.stat->on_ok();
+      other_info.stat->on_rtt(0.02);
+    }
+  }
+  ASSERT_TRUE(find_connection(dc_options_set).option->get_ip_address().is_ipv6());
+
+  // saved statistics are applied to options added later
+  auto endpoint_stats = dc_options_set.get_endpoint_stats(0);
+  ASSERT_EQ(2u, endpoint_stats.size());
+  td::vector<td::DcOptionsSet::EndpointStat> saved_endpoint_stats;
+  td::unserialize(saved_endpoint_stats, td::serialize(endpoint_stats)).ensure();
+
+  td::DcOptionsSet new_dc_options_set;
+  new_dc_options_set.add_endpoint_stats(std::move(saved_endpoint_stats));
+  new_dc_options_set.add_dc_options(get_dc_options());
+  ASSERT_TRUE(find_connection(new_dc_options_set).option->get_ip_address().is_ipv6());
+  ASSERT_EQ(2u, new_dc_options_set.get_endpoint_stats(0).size());
+
+  // after all options failed, they are checked in parallel, racing both address families
+  for (auto &other_info : new_dc_options_set.find_all_connections(dc_id, false, false, false, false)) {
+    other_info.stat->on_error();
+  }
+  info = find_connection(new_dc_options_set);
+  ASSERT_TRUE(info.should_check);
+  ASSERT_EQ("127.0.0.1", info.option->get_ip_address().get_ip_str());
+  info.stat->on_check();
+  info = find_connection(new_dc_options_set);
+  ASSERT_TRUE(info.should_check);
+  ASSERT_TRUE(info.option->get_ip_address().is_ipv6());
+  info.stat->on_check();
+  ASSERT_EQ("127.0.0.2", find_connection(new_dc_options_set).option->get_ip_address().get_ip_str());
+}
+
 TEST(Mtproto, Grease) {
   td::string s(10000, '0');
   td::mtproto::Grease::init(s);
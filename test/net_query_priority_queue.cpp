@@ -0,0 +1,247 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCounter.h"
+#include "td/telegram/net/NetQueryCreator.h"
+#include "td/telegram/net/NetQueryPriorityQueue.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/Status.h"
+#include "td/utils/tests.h"
+
+#include <utility>
+
+namespace {
+
+// answers sent queries in a random order, like a server with queries of different duration
+class StandInServer {
+ public:
+  void send(td::NetQueryPtr query, td::NetQueryCounter bulk_query_counter) {
+    sent_queries_.emplace_back(std::move(query), std::move(bulk_query_counter));
+  }
+
+  void answer_random_query() {
+    CHECK(!sent_queries_.empty());
+    auto pos = td::Random::fast(0, static_cast<int>(sent_queries_.size()) - 1);
+    std::swap(sent_queries_[pos], sent_queries_.back());
+    auto &query = sent_queries_.back().first;
+    query->set_error(td::Status::Error(500, "STAND_IN_SERVER"));
+    query->clear();
+    sent_queries_.pop_back();
+  }
+
+  std::size_t get_sent_query_count() const {
+    return sent_queries_.size();
+  }
+
+ private:
+  td::vector<std::pair<td::NetQueryPtr, td::NetQueryCounter>> sent_queries_;
+};
+
+td::NetQueryPtr create_query(td::NetQueryCreator &creator, td::int8 priority) {
+  auto query = creator.create(td::telegram_api::help_getConfig());
+  query->set_priority(priority);
+  return query;
+}
+
+void finish_query(td::NetQueryPtr &query) {
+  query->set_error(td::Status::Error(500, "TEST"));
+  query->clear();
+}
+
+}  // namespace
+
+TEST(NetQueryPriorityQueue, lanes) {
+  td::NetQueryCreator creator{nullptr};
+  td::NetQueryPriorityQueue queue;
+  ASSERT_TRUE(queue.empty());
+
+  td::vector<td::uint64> bulk_query_ids;
+  for (int i = 0; i < 3; i++) {
+    auto query = create_query(creator, td::NetQuery::PRIORITY_BULK);
+    bulk_query_ids.push_back(query->id());
+    queue.push(std::move(query));
+  }
+  ASSERT_TRUE(queue.has_bulk_queries());
+
+  td::vector<td::uint64> interactive_query_ids;
+  td::vector<td::uint64> default_query_ids;
+  for (int i = 0; i < 20; i++) {
+    auto query = create_query(creator, td::NetQuery::PRIORITY_DEFAULT);
+    default_query_ids.push_back(query->id());
+    queue.push(std::move(query));
+
+    query = create_query(creator, td::NetQuery::PRIORITY_INTERACTIVE);
+    interactive_query_ids.push_back(query->id());
+    queue.push(std::move(query));
+  }
+
+  // interactive queries go first, but each BULK_QUERY_WEIGHT-th query is taken from the bulk lane
+  td::vector<td::uint64> popped_query_ids;
+  while (!queue.empty()) {
+    auto query = queue.pop(1000);
+    ASSERT_TRUE(!query.empty());
+    popped_query_ids.push_back(query->id());
+    finish_query(query);
+  }
+  ASSERT_EQ(popped_query_ids.size(), 43u);
+
+  td::vector<td::uint64> expected_query_ids;
+  std::size_t bulk_pos = 0;
+  std::size_t interactive_pos = 0;
+  std::size_t default_pos = 0;
+  std::size_t non_bulk_in_row = 0;
+  while (expected_query_ids.size() < popped_query_ids.size()) {
+    if (bulk_pos < bulk_query_ids.size() &&
+        (non_bulk_in_row == td::NetQueryPriorityQueue::BULK_QUERY_WEIGHT ||
+         (interactive_pos == interactive_query_ids.size() && default_pos == default_query_ids.size()))) {
+      expected_query_ids.push_back(bulk_query_ids[bulk_pos++]);
+      non_bulk_in_row = 0;
+    } else if (interactive_pos < interactive_query_ids.size()) {
+      expected_query_ids.push_back(interactive_query_ids[interactive_pos++]);
+      non_bulk_in_row++;
+    } else {
+      expected_query_ids.push_back(default_query_ids[default_pos++]);
+      non_bulk_in_row++;
+    }
+  }
+  ASSERT_TRUE(popped_query_ids == expected_query_ids);
+}
+
+TEST(NetQueryPriorityQueue, no_bulk_queries_allowed) {
+  td::NetQueryCreator creator{nullptr};
+  td::NetQueryPriorityQueue queue;
+
+  queue.push(create_query(creator, td::NetQuery::PRIORITY_BULK));
+  queue.push(create_query(creator, td::NetQuery::PRIORITY_DEFAULT));
+
+  auto query = queue.pop(0);
+  ASSERT_TRUE(!query.empty());
+  ASSERT_TRUE(!query->is_bulk());
+  finish_query(query);
+
+  // only a bulk query is left
+  ASSERT_TRUE(queue.pop(0).empty());
+  ASSERT_TRUE(!queue.empty());
+
+  query = queue.pop_any();
+  ASSERT_TRUE(!query.empty());
+  ASSERT_TRUE(query->is_bulk());
+  finish_query(query);
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST(NetQueryPriorityQueue, inflight_bulk_query_limit) {
+  constexpr td::uint64 MAX_INFLIGHT_BULK_QUERIES = 4;
+  constexpr std::size_t MAX_INFLIGHT_QUERIES = 16;
+
+  td::NetQueryCreator creator{nullptr};
+  td::NetQueryPriorityQueue queue;
+  StandInServer server;
+
+  int left_bulk_queries = 500;
+  int left_other_queries = 500;
+  int sent_bulk_queries = 0;
+  int sent_other_queries = 0;
+  while (sent_bulk_queries + sent_other_queries < 1000 || server.get_sent_query_count() > 0) {
+    // new queries arrive
+    for (int i = td::Random::fast(0, 3); i > 0; i--) {
+      if (left_bulk_queries > 0 && td::Random::fast_bool()) {
+        left_bulk_queries--;
+        queue.push(create_query(creator, td::NetQuery::PRIORITY_BULK));
+      } else if (left_other_queries > 0) {
+        left_other_queries--;
+        queue.push(create_query(creator, td::Random::fast_bool() ? td::NetQuery::PRIORITY_INTERACTIVE
+                                                                 : td::NetQuery::PRIORITY_DEFAULT));
+      }
+    }
+
+    // the sending loop used by Session::loop
+    queue.send_queries(
+        MAX_INFLIGHT_BULK_QUERIES, [&] { return server.get_sent_query_count() < MAX_INFLIGHT_QUERIES; },
+        [&](td::NetQueryPtr query) {
+          td::NetQueryCounter bulk_query_counter;
+          if (query->is_bulk()) {
+            bulk_query_counter = queue.get_inflight_bulk_query_counter();
+            sent_bulk_queries++;
+          } else {
+            sent_other_queries++;
+          }
+          ASSERT_TRUE(queue.get_inflight_bulk_query_count() <= MAX_INFLIGHT_BULK_QUERIES);
+          server.send(std::move(query), std::move(bulk_query_counter));
+        });
+    if (!queue.empty() && server.get_sent_query_count() < MAX_INFLIGHT_QUERIES) {
+      // only bulk queries are left, and the limit on them is reached
+      ASSERT_TRUE(queue.has_bulk_queries());
+      ASSERT_EQ(queue.get_inflight_bulk_query_count(), MAX_INFLIGHT_BULK_QUERIES);
+    }
+
+    if (server.get_sent_query_count() > 0) {
+      server.answer_random_query();
+    }
+  }
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(sent_bulk_queries, 500);
+  ASSERT_EQ(sent_other_queries, 500);
+  ASSERT_EQ(queue.get_inflight_bulk_query_count(), 0u);
+}
+
+TEST(NetQueryPriorityQueue, invoke_after) {
+  td::NetQueryCreator creator{nullptr};
+  td::NetQueryPriorityQueue queue;
+
+  auto first_query = create_query(creator, td::NetQuery::PRIORITY_DEFAULT);
+  auto first_query_id = first_query->id();
+  auto first_query_ref = first_query.get_weak();
+  queue.push(std::move(first_query));
+
+  // an interactive query, which must be invoked after a pending query, must not overtake it
+  auto chained_query = create_query(creator, td::NetQuery::PRIORITY_INTERACTIVE);
+  auto chained_query_id = chained_query->id();
+  chained_query->set_invoke_after({first_query_ref});
+  queue.push(std::move(chained_query));
+
+  auto other_query = create_query(creator, td::NetQuery::PRIORITY_INTERACTIVE);
+  auto other_query_id = other_query->id();
+  queue.push(std::move(other_query));
+
+  td::vector<td::uint64> sent_query_ids;
+  td::vector<td::NetQueryPtr> sent_queries;
+  td::uint64 last_message_id = 0;
+  queue.send_queries(
+      0, [] { return true; },
+      [&](td::NetQueryPtr query) {
+        for (auto &ref : query->invoke_after()) {
+          ASSERT_TRUE(ref->message_id() != 0);
+        }
+        query->set_message_id(++last_message_id);
+        sent_query_ids.push_back(query->id());
+        sent_queries.push_back(std::move(query));
+      });
+  ASSERT_TRUE(queue.empty());
+  ASSERT_TRUE(sent_query_ids == td::vector<td::uint64>({other_query_id, first_query_id, chained_query_id}));
+
+  // the query, after which the chained query must be invoked, is already sent
+  chained_query = create_query(creator, td::NetQuery::PRIORITY_INTERACTIVE);
+  chained_query_id = chained_query->id();
+  chained_query->set_invoke_after({first_query_ref});
+  queue.push(create_query(creator, td::NetQuery::PRIORITY_DEFAULT));
+  queue.push(std::move(chained_query));
+
+  auto query = queue.pop(0);
+  ASSERT_EQ(query->id(), chained_query_id);
+  finish_query(query);
+  query = queue.pop(0);
+  finish_query(query);
+  ASSERT_TRUE(queue.empty());
+
+  for (auto &sent_query : sent_queries) {
+    finish_query(sent_query);
+  }
+}
@@ -0,0 +1,158 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCreator.h"
+#include "td/telegram/net/NetQueryResultQueue.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/Status.h"
+#include "td/utils/tests.h"
+
+#include <utility>
+
+namespace {
+
+struct ReturnedQuery {
+  td::uint64 query_id;
+  bool is_ok;
+  bool need_resend;
+};
+
+class ResultCollector {
+ public:
+  void flush(td::NetQueryResultQueue &queue) {
+    queue.flush([this](td::NetQueryPtr &&net_query, bool need_resend) {
+      returned_queries_.push_back(ReturnedQuery{net_query->id(), net_query->is_ok(), need_resend});
+      if (net_query->is_ok()) {
+        ASSERT_EQ(net_query->ok().as_slice(), td::Slice("result"));
+      }
+      if (need_resend) {
+        net_query->set_error_resend();
+      }
+      net_query->clear();
+    });
+  }
+
+  const td::vector<ReturnedQuery> &get_returned_queries() const {
+    return returned_queries_;
+  }
+
+ private:
+  td::vector<ReturnedQuery> returned_queries_;
+};
+
+td::NetQueryPtr create_query(td::NetQueryCreator &creator) {
+  return creator.create(td::telegram_api::help_getConfig());
+}
+
+}  // namespace
+
+TEST(NetQueryResultQueue, order) {
+  td::NetQueryCreator creator{nullptr};
+  td::NetQueryResultQueue queue;
+  ResultCollector collector;
+
+  auto ok_query = create_query(creator);
+  auto ok_query_id = ok_query->id();
+  queue.add_ok_result(std::move(ok_query), td::BufferSlice("result"));
+  collector.flush(queue);
+  ASSERT_EQ(collector.get_returned_queries().size(), 1u);
+  ASSERT_TRUE(queue.empty());
+
+  // a big result is being decoded, so everything received after it must wait
+  auto decoding_query = create_query(creator);
+  auto decoding_query_id = decoding_query->id();
+  auto result_id = queue.add_decoding_result(std::move(decoding_query), td::BufferSlice("packed"));
+
+  auto error_query = create_query(creator);
+  auto error_query_id = error_query->id();
+  error_query->set_error(td::Status::Error(400, "ERROR"));
+  queue.add_result(std::move(error_query));
+
+  auto resend_query = create_query(creator);
+  auto resend_query_id = resend_query->id();
+  queue.add_resend(std::move(resend_query));
+
+  auto second_ok_query = create_query(creator);
+  auto second_ok_query_id = second_ok_query->id();
+  queue.add_ok_result(std::move(second_ok_query), td::BufferSlice("result"));
+
+  collector.flush(queue);
+  ASSERT_EQ(collector.get_returned_queries().size(), 1u);
+  ASSERT_TRUE(!queue.empty());
+
+  auto decoding_results = queue.get_decoding_results();
+  ASSERT_EQ(decoding_results.size(), 1u);
+  ASSERT_EQ(decoding_results[0].first, result_id);
+  ASSERT_EQ(decoding_results[0].second.as_slice(), td::Slice("packed"));
+
+  ASSERT_TRUE(queue.on_result_decoded(result_id + 1, td::BufferSlice("result")) == nullptr);
+  auto decoded_query = queue.on_result_decoded(result_id, td::BufferSlice("result"));
+  ASSERT_TRUE(decoded_query != nullptr);
+  ASSERT_EQ((*decoded_query)->id(), decoding_query_id);
+  ASSERT_TRUE(queue.on_result_decoded(result_id, td::BufferSlice("result")) == nullptr);
+
+  collector.flush(queue);
+  ASSERT_TRUE(queue.empty());
+
+  auto &returned_queries = collector.get_returned_queries();
+  ASSERT_EQ(returned_queries.size(), 5u);
+  ASSERT_EQ(returned_queries[0].query_id, ok_query_id);
+  ASSERT_TRUE(returned_queries[0].is_ok);
+  ASSERT_EQ(returned_queries[1].query_id, decoding_query_id);
+  ASSERT_TRUE(returned_queries[1].is_ok);
+  ASSERT_EQ(returned_queries[2].query_id, error_query_id);
+  ASSERT_TRUE(!returned_queries[2].is_ok);
+  ASSERT_TRUE(!returned_queries[2].need_resend);
+  ASSERT_EQ(returned_queries[3].query_id, resend_query_id);
+  ASSERT_TRUE(returned_queries[3].need_resend);
+  ASSERT_EQ(returned_queries[4].query_id, second_ok_query_id);
+  ASSERT_TRUE(returned_queries[4].is_ok);
+}
+
+TEST(NetQueryResultQueue, decoded_out_of_order) {
+  td::NetQueryCreator creator{nullptr};
+  td::NetQueryResultQueue queue;
+  ResultCollector collector;
+
+  td::vector<td::uint64> query_ids;
+  td::vector<td::uint64> result_ids;
+  for (int i = 0; i < 100; i++) {
+    auto query = create_query(creator);
+    query_ids.push_back(query->id());
+    switch (td::Random::fast(0, 2)) {
+      case 0:
+        result_ids.push_back(queue.add_decoding_result(std::move(query), td::BufferSlice("packed")));
+        break;
+      case 1:
+        queue.add_ok_result(std::move(query), td::BufferSlice("result"));
+        break;
+      case 2:
+        query->set_error(td::Status::Error(500, "ERROR"));
+        queue.add_result(std::move(query));
+        break;
+    }
+  }
+
+  // results are decoded on another thread in an arbitrary order
+  td::Random::shuffle(result_ids);
+  for (auto result_id : result_ids) {
+    ASSERT_TRUE(queue.on_result_decoded(result_id, td::BufferSlice("result")) != nullptr);
+    collector.flush(queue);
+  }
+  collector.flush(queue);
+  ASSERT_TRUE(queue.empty());
+
+  auto &returned_queries = collector.get_returned_queries();
+  ASSERT_EQ(returned_queries.size(), query_ids.size());
+  for (std::size_t i = 0; i < query_ids.size(); i++) {
+    ASSERT_EQ(returned_queries[i].query_id, query_ids[i]);
+  }
+}
@@ -0,0 +1,108 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/NotificationGroupFlushQueue.h"
+#include "td/telegram/NotificationGroupId.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/optional.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <algorithm>
+
+static td::vector<td::int32> get_group_ids(const td::vector<td::NotificationGroupId> &group_ids) {
+  td::vector<td::int32> result;
+  for (auto group_id : group_ids) {
+    result.push_back(group_id.get());
+  }
+  return result;
+}
+
+TEST(NotificationGroupFlushQueue, order) {
+  td::NotificationGroupFlushQueue queue(100);
+  ASSERT_TRUE(queue.empty());
+
+  // only the first group needs to schedule flush of the batch
+  ASSERT_TRUE(queue.add_group(td::NotificationGroupId(1)));
+  for (td::int32 group_id = 2; group_id <= 6; group_id++) {
+    ASSERT_TRUE(!queue.add_group(td::NotificationGroupId(group_id)));
+  }
+
+  td::FlatHashMap<td::int32, td::int32> dates;
+  dates[1] = 30;
+  dates[2] = 10;
+  dates[3] = 20;
+  dates[5] = 10;
+  dates[6] = 40;
+  auto get_date = [&dates](td::NotificationGroupId group_id) -> td::optional<td::int32> {
+    auto it = dates.find(group_id.get());
+    if (it == dates.end()) {
+      return {};
+    }
+    return it->second;
+  };
+  // the group without pending notifications is dropped, groups with the same date are flushed in the order of expiration
+  ASSERT_TRUE(get_group_ids(queue.get_batch<td::int32>(get_date)) == td::vector<td::int32>({2, 5, 3, 1, 6}));
+  ASSERT_TRUE(queue.empty());
+  ASSERT_TRUE(queue.get_batch<td::int32>(get_date).empty());
+
+  // pending updates are flushed in reverse order
+  ASSERT_TRUE(queue.add_group(td::NotificationGroupId(3)));
+  queue.add_group(td::NotificationGroupId(6));
+  queue.add_group(td::NotificationGroupId(2));
+  auto batch = queue.get_batch<td::int32>(get_date, [](td::int32 lhs, td::int32 rhs) { return lhs > rhs; });
+  ASSERT_TRUE(get_group_ids(batch) == td::vector<td::int32>({6, 3, 2}));
+}
+
+TEST(NotificationGroupFlushQueue, max_batch_size) {
+  const size_t MAX_BATCH_SIZE = 10;
+  td::NotificationGroupFlushQueue queue(MAX_BATCH_SIZE);
+  td::FlatHashMap<td::int32, td::int32> dates;
+  td::vector<std::pair<td::int32, td::int32>> expected;
+  for (td::int32 group_id = 1; group_id <= 35; group_id++) {
+    auto date = td::Random::fast(1, 1000);
+    dates[group_id] = date;
+    expected.emplace_back(date, group_id);
+    queue.add_group(td::NotificationGroupId(group_id));
+  }
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const std::pair<td::int32, td::int32> &lhs, const std::pair<td::int32, td::int32> &rhs) {
+                     return lhs.first < rhs.first;
+                   });
+  auto get_date = [&dates](td::NotificationGroupId group_id) -> td::optional<td::int32> {
+    auto it = dates.find(group_id.get());
+    if (it == dates.end()) {
+      return {};
+    }
+    return it->second;
+  };
+
+  // the earliest groups are flushed first, the other groups are deferred to the next batch
+  td::vector<td::int32> flushed_group_ids;
+  for (size_t i = 0; i < 3; i++) {
+    auto batch = get_group_ids(queue.get_batch<td::int32>(get_date));
+    ASSERT_EQ(MAX_BATCH_SIZE, batch.size());
+    ASSERT_TRUE(!queue.empty());
+    // a new group must not schedule another flush while deferred groups are waiting
+    ASSERT_TRUE(!queue.add_group(td::NotificationGroupId(1000 + static_cast<td::int32>(i))));
+    flushed_group_ids.insert(flushed_group_ids.end(), batch.begin(), batch.end());
+  }
+  for (size_t i = 0; i < flushed_group_ids.size(); i++) {
+    ASSERT_EQ(expected[i].second, flushed_group_ids[i]);
+  }
+
+  // deferred groups are checked again, so the groups flushed in the meantime are dropped
+  dates.erase(expected[30].second);
+  auto batch = get_group_ids(queue.get_batch<td::int32>(get_date));
+  ASSERT_TRUE(queue.empty());
+  td::vector<td::int32> expected_batch;
+  for (size_t i = 31; i < expected.size(); i++) {
+    expected_batch.push_back(expected[i].second);
+  }
+  ASSERT_TRUE(batch == expected_batch);
+}
@@ -24,6 +24,7 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Random.h"
 #include "td/utils/tests.h"
+#include "td/utils/Time.h"
 
 #include <iostream>
 #include <map>
@@ -463,6 +464,71 @@ class TestDownloadFile : public Task {
   }
 };
 
+class TestChatFolder : public Task {
+ public:
+  TestChatFolder(int64 chat_id, Promise<Unit> promise) : chat_id_(chat_id), promise_(std::move(promise)) {
+  }
+  void start_up() override {
+    send_query(td::make_tl_object<td::td_api::createChatFolder>(get_folder("Folder")),
+               [this](td::Result<td::td_api::object_ptr<td::td_api::chatFolderInfo>> res) {
+                 with_chat_folder_id(res.move_as_ok()->id_);
+               });
+  }
+
+ private:
+  int64 chat_id_;
+  Promise<Unit> promise_;
+  int32 chat_folder_id_{0};
+  double get_chats_start_time_{0};
+
+  td::tl_object_ptr<td_api::chatFolder> get_folder(string title) const {
+    return td::make_tl_object<td::td_api::chatFolder>(std::move(title), nullptr, -1, false, td::Auto(),
+                                                      vector<int64>{chat_id_}, td::Auto(), false, false, false, false,
+                                                      false, false, false, false);
+  }
+
+  void with_chat_folder_id(int32 chat_folder_id) {
+    chat_folder_id_ = chat_folder_id;
+    // the list of the folder is rebuilt after the edit
+    send_query(td::make_tl_object<td::td_api::editChatFolder>(chat_folder_id_, get_folder("Edited folder")),
+               [this](td::Result<td::td_api::object_ptr<td::td_api::chatFolderInfo>> res) {
+                 res.ensure();
+                 change_chat_order();
+               });
+  }
+
+  void change_chat_order() {
+    // a new last message changes order of the chat in the rebuilt list
+    send_query(td::make_tl_object<td::td_api::sendMessage>(
+                   chat_id_, 0, nullptr, nullptr, nullptr,
+                   td::make_tl_object<td::td_api::inputMessageText>(
+                       td::make_tl_object<td::td_api::formattedText>("folder", td::Auto()), nullptr, true)),
+               [this](td::Result<td::td_api::object_ptr<td::td_api::message>> res) {
+                 res.ensure();
+                 get_chats();
+               });
+  }
+
+  void get_chats() {
+    get_chats_start_time_ = Time::now();
+    send_query(td::make_tl_object<td::td_api::getChats>(
+                   td::make_tl_object<td::td_api::chatListFolder>(chat_folder_id_), 100),
+               [this](td::Result<td::td_api::object_ptr<td::td_api::chats>> res) { with_chats(res.move_as_ok()); });
+  }
+
+  void with_chats(td::tl_object_ptr<td_api::chats> chats) {
+    LOG(ERROR) << "Receive " << chats->chat_ids_.size() << " chats from the folder in "
+               << (Time::now() - get_chats_start_time_) * 1e6 << "us";
+    CHECK(chats->chat_ids_ == vector<int64>{chat_id_});
+    send_query(td::make_tl_object<td::td_api::deleteChatFolder>(chat_folder_id_, td::Auto()),
+               [this](td::Result<td::td_api::object_ptr<td::td_api::ok>> res) {
+                 res.ensure();
+                 promise_.set_value(Unit());
+                 stop();
+               });
+  }
+};
+
 static std::string gen_readable_file(size_t block_size, size_t block_count) {
   std::string content;
   for (size_t block_id = 0; block_id < block_count; block_id++) {
@@ -539,6 +605,11 @@ class TestTd : public Actor {
                                           promise_send_closure(actor_id(this), &TestTd::after_test_download_file)));
   }
   void after_test_download_file(Result<Unit>) {
+    send_closure(alice_, &TestClient::add_listener,
+                 td::make_unique<TestChatFolder>(
+                     alice_id_.chat_id, promise_send_closure(actor_id(this), &TestTd::after_test_chat_folder)));
+  }
+  void after_test_chat_folder(Result<Unit>) {
     close();
   }
 
@@ -0,0 +1,107 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/QueryResultCache.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/StringBuilder.h"
+#include "td/utils/tests.h"
+#include "td/utils/Time.h"
+
+static constexpr td::int32 CACHED_FUNCTION_ID = 1;
+static constexpr td::int32 UNCACHED_FUNCTION_ID = 2;
+
+TEST(QueryResultCache, hit_and_miss) {
+  td::QueryResultCache cache;
+  cache.enable_function_cache(CACHED_FUNCTION_ID, "test", 10.0, 1 << 20);
+
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "query").empty());
+  cache.add(CACHED_FUNCTION_ID, "query", "result");
+  ASSERT_EQ("result", cache.get(CACHED_FUNCTION_ID, "query").as_slice());
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "other query").empty());
+
+  // the first result is kept
+  cache.add(CACHED_FUNCTION_ID, "query", "new result");
+  ASSERT_EQ("result", cache.get(CACHED_FUNCTION_ID, "query").as_slice());
+
+  cache.add(UNCACHED_FUNCTION_ID, "query", "result");
+  ASSERT_TRUE(cache.get(UNCACHED_FUNCTION_ID, "query").empty());
+
+  auto statistics = cache.get_statistics(CACHED_FUNCTION_ID);
+  ASSERT_EQ(2u, statistics.hit_count);
+  ASSERT_EQ(2u, statistics.miss_count);
+  ASSERT_EQ(1u, statistics.result_count);
+  ASSERT_EQ(0u, cache.get_statistics(UNCACHED_FUNCTION_ID).miss_count);
+
+  cache.invalidate(CACHED_FUNCTION_ID);
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "query").empty());
+  ASSERT_EQ(0u, cache.get_statistics(CACHED_FUNCTION_ID).memory_size);
+}
+
+TEST(QueryResultCache, ttl) {
+  td::QueryResultCache cache;
+  cache.enable_function_cache(CACHED_FUNCTION_ID, "test", 10.0, 1 << 20);
+
+  cache.add(CACHED_FUNCTION_ID, "query", "result");
+  td::Time::jump_in_future(td::Time::now() + 5.0);
+  cache.add(CACHED_FUNCTION_ID, "other query", "other result");
+  ASSERT_EQ("result", cache.get(CACHED_FUNCTION_ID, "query").as_slice());
+
+  td::Time::jump_in_future(td::Time::now() + 6.0);
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "query").empty());
+  ASSERT_EQ("other result", cache.get(CACHED_FUNCTION_ID, "other query").as_slice());
+  ASSERT_EQ(1u, cache.get_statistics(CACHED_FUNCTION_ID).result_count);
+
+  td::Time::jump_in_future(td::Time::now() + 6.0);
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "other query").empty());
+  ASSERT_EQ(0u, cache.get_statistics(CACHED_FUNCTION_ID).memory_size);
+}
+
+TEST(QueryResultCache, memory_limit) {
+  td::QueryResultCache cache;
+  cache.enable_function_cache(CACHED_FUNCTION_ID, "test", 1000.0, 100000);
+
+  // too big results aren't cached at all
+  cache.add(CACHED_FUNCTION_ID, "big query", td::string(50000, 'a'));
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "big query").empty());
+
+  for (int i = 0; i < 100; i++) {
+    cache.add(CACHED_FUNCTION_ID, td::to_string(i), td::string(10000, 'a'));
+    auto statistics = cache.get_statistics(CACHED_FUNCTION_ID);
+    ASSERT_TRUE(statistics.memory_size <= 100000);
+    ASSERT_TRUE(!cache.get(CACHED_FUNCTION_ID, td::to_string(i)).empty());
+  }
+  // the oldest results are evicted first
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "0").empty());
+  ASSERT_TRUE(!cache.get(CACHED_FUNCTION_ID, "99").empty());
+  ASSERT_EQ(9u, cache.get_statistics(CACHED_FUNCTION_ID).result_count);
+}
+
+TEST(QueryResultCache, partial_invalidation) {
+  td::QueryResultCache cache;
+  cache.enable_function_cache(CACHED_FUNCTION_ID, "test", 10.0, 1 << 20);
+
+  for (int i = 0; i < 10; i++) {
+    cache.add(CACHED_FUNCTION_ID, td::to_string(i), PSLICE() << "result " << i % 3);
+  }
+  auto memory_size = cache.get_statistics(CACHED_FUNCTION_ID).memory_size;
+
+  cache.invalidate(CACHED_FUNCTION_ID, [](td::Slice result) { return result == "result 1"; });
+  ASSERT_EQ(7u, cache.get_statistics(CACHED_FUNCTION_ID).result_count);
+  ASSERT_TRUE(cache.get_statistics(CACHED_FUNCTION_ID).memory_size < memory_size);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(i % 3 == 1, cache.get(CACHED_FUNCTION_ID, td::to_string(i)).empty());
+  }
+
+  // the remaining results still expire in order
+  cache.add(CACHED_FUNCTION_ID, "1", "new result");
+  td::Time::jump_in_future(td::Time::now() + 11.0);
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "0").empty());
+  ASSERT_TRUE(cache.get(CACHED_FUNCTION_ID, "1").empty());
+  ASSERT_EQ(0u, cache.get_statistics(CACHED_FUNCTION_ID).memory_size);
+}
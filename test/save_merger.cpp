@@ -0,0 +1,90 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/SaveMerger.h"
+
+#include "td/actor/actor.h"
+#include "td/actor/ConcurrentScheduler.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/logging.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+#include "td/utils/Time.h"
+
+class TestSaveMerger final : public td::Actor {
+  void start_up() final {
+    save_merger_.set_save_function([this](td::vector<td::int64> object_ids) {
+      ASSERT_TRUE(!object_ids.empty());
+      auto now = td::Time::now();
+      for (auto object_id : object_ids) {
+        auto it = pending_objects_.find(object_id);
+        ASSERT_TRUE(it != pending_objects_.end());
+        ASSERT_TRUE(now <= it->second + MAX_DELAY + 0.5);
+        pending_objects_.erase(it);
+      }
+      saved_object_count_ += object_ids.size();
+    });
+    loop();
+  }
+
+  void loop() final {
+    if (added_object_count_ == MAX_ADDED_OBJECT_COUNT) {
+      if (pending_objects_.empty()) {
+        auto statistics = save_merger_.get_statistics();
+        ASSERT_EQ(statistics.first, static_cast<td::uint64>(MAX_ADDED_OBJECT_COUNT));
+        ASSERT_EQ(statistics.second, static_cast<td::uint64>(saved_object_count_));
+        ASSERT_TRUE(saved_object_count_ < added_object_count_);
+        LOG(INFO) << "Saved " << saved_object_count_ << " out of " << added_object_count_ << " objects";
+        td::Scheduler::instance()->finish();
+        return;
+      }
+      ASSERT_TRUE(save_merger_.has_object(pending_objects_.begin()->first));
+      set_timeout_in(0.01);
+      return;
+    }
+
+    std::size_t added_objects = td::Random::fast(1, 3);
+    while (added_objects-- > 0 && added_object_count_ < MAX_ADDED_OBJECT_COUNT) {
+      td::int64 object_id = td::Random::fast(1, 20);
+      pending_objects_.emplace(object_id, td::Time::now());
+      save_merger_.add_object(object_id);
+      added_object_count_++;
+      if (added_object_count_ % 100 == 0) {
+        save_merger_.flush();
+        ASSERT_TRUE(pending_objects_.empty());
+      }
+    }
+    set_timeout_in(0.001);
+  }
+
+  void timeout_expired() final {
+    loop();
+  }
+
+  static constexpr double MAX_DELAY = 0.02;
+  static constexpr std::size_t MAX_ADDED_OBJECT_COUNT = 1000;
+
+  td::SaveMerger save_merger_{"SaveMerger", MAX_DELAY};
+  std::size_t added_object_count_ = 0;
+  std::size_t saved_object_count_ = 0;
+
+  td::FlatHashMap<td::int64, double> pending_objects_;  // object_id -> first time the object was added
+};
+
+constexpr double TestSaveMerger::MAX_DELAY;
+constexpr std::size_t TestSaveMerger::MAX_ADDED_OBJECT_COUNT;
+
+TEST(SaveMerger, stress) {
+  td::ConcurrentScheduler sched(0, 0);
+  sched.create_actor_unsafe<TestSaveMerger>(0, "TestSaveMerger").release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+}
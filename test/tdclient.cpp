@@ -891,6 +891,44 @@ TEST(Client, SimpleMulti) {
   }
 }
 
+TEST(Client, RequestHandlers) {
+  // the request handler table is shared by all instances and filled on first use of each request
+  std::vector<td::Client> clients(3);
+  for (size_t i = 0; i < clients.size(); i++) {
+    auto base_id = 10 * (i + 1);
+    clients[i].send({base_id + 1, td::make_tl_object<td::td_api::testSquareInt>(static_cast<td::int32>(i))});
+    clients[i].send({base_id + 2, td::make_tl_object<td::td_api::testCallString>("string")});
+    clients[i].send({base_id + 3, td::make_tl_object<td::td_api::testCallVectorInt>(td::vector<td::int32>{1, 2})});
+  }
+
+  for (size_t i = 0; i < clients.size(); i++) {
+    auto base_id = 10 * (i + 1);
+    size_t received_count = 0;
+    while (received_count < 3) {
+      auto result = clients[i].receive(10);
+      if (result.id == 0) {
+        continue;
+      }
+      ASSERT_TRUE(result.object != nullptr);
+      received_count++;
+      if (result.id == base_id + 1) {
+        ASSERT_EQ(td::td_api::testInt::ID, result.object->get_id());
+        auto test_int = td::td_api::move_object_as<td::td_api::testInt>(result.object);
+        ASSERT_EQ(static_cast<td::int32>(i * i), test_int->value_);
+      } else if (result.id == base_id + 2) {
+        ASSERT_EQ(td::td_api::testString::ID, result.object->get_id());
+        auto test_string = td::td_api::move_object_as<td::td_api::testString>(result.object);
+        ASSERT_EQ("string", test_string->value_);
+      } else {
+        ASSERT_EQ(base_id + 3, result.id);
+        ASSERT_EQ(td::td_api::testVectorInt::ID, result.object->get_id());
+        auto test_vector = td::td_api::move_object_as<td::td_api::testVectorInt>(result.object);
+        ASSERT_TRUE(test_vector->value_ == td::vector<td::int32>({1, 2}));
+      }
+    }
+  }
+}
+
 #if !TD_THREAD_UNSUPPORTED
 TEST(Client, Multi) {
   td::vector<td::thread> threads;
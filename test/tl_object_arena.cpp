@@ -0,0 +1,84 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/telegram_api.h"
+
+#include "td/tl/TlObjectArena.h"
+
+#include "td/utils/common.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/tests.h"
+
+#include <cstddef>
+#include <cstdint>
+
+static bool is_aligned(const void *ptr) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignof(std::max_align_t) == 0;
+}
+
+TEST(TlObjectArena, alignment) {
+  td::vector<void *> pointers;
+  for (int use_arena = 0; use_arena < 2; use_arena++) {
+    td::TlObjectArena::Guard arena_guard(use_arena != 0);
+    for (std::size_t size = 1; size <= 100; size++) {
+      auto *ptr = td::TlObjectArena::allocate(size);
+      ASSERT_TRUE(is_aligned(ptr));
+      pointers.push_back(ptr);
+    }
+  }
+  for (auto *ptr : pointers) {
+    td::TlObjectArena::deallocate(ptr);
+  }
+}
+
+TEST(TlObjectArena, bump_allocation) {
+  td::TlObjectArena::Guard arena_guard(true);
+  auto *first = static_cast<char *>(td::TlObjectArena::allocate(24));
+  auto *second = static_cast<char *>(td::TlObjectArena::allocate(24));
+  // both objects are in the same chunk one after another without any header
+  ASSERT_EQ(32, second - first);
+  td::TlObjectArena::deallocate(second);
+  td::TlObjectArena::deallocate(first);
+}
+
+TEST(TlObjectArena, mixed_deallocation) {
+  auto *heap_object = td::TlObjectArena::allocate(24);
+  td::TlObjectArena::Guard arena_guard(true);
+  auto *arena_object = td::TlObjectArena::allocate(24);
+  // objects allocated before the arena was created must be freed by ::operator delete
+  td::TlObjectArena::deallocate(heap_object);
+  td::TlObjectArena::deallocate(arena_object);
+}
+
+TEST(TlObjectArena, lifetime) {
+  td::vector<td::telegram_api::object_ptr<td::telegram_api::inputPeerUser>> peers;
+  td::telegram_api::object_ptr<td::telegram_api::inputPeerUser> nested_peer;
+  {
+    td::TlObjectArena::Guard arena_guard(true);
+    for (int i = 0; i < 10000; i++) {
+      peers.push_back(td::telegram_api::make_object<td::telegram_api::inputPeerUser>(i, i * 2));
+      ASSERT_TRUE(is_aligned(peers.back().get()));
+    }
+    {
+      td::TlObjectArena::Guard nested_arena_guard(true);
+      nested_peer = td::telegram_api::make_object<td::telegram_api::inputPeerUser>(-1, -2);
+    }
+    // the nested arena must be freed only after its last object is deleted
+    ASSERT_EQ(-1, nested_peer->user_id_);
+    peers.push_back(td::telegram_api::make_object<td::telegram_api::inputPeerUser>(10000, 20000));
+  }
+  nested_peer = nullptr;
+
+  // the objects outlive the guard and can be deleted on another thread
+  td::thread thread([peers = std::move(peers)]() mutable {
+    for (std::size_t i = 0; i < peers.size(); i++) {
+      CHECK(peers[i]->user_id_ == static_cast<td::int64>(i));
+      CHECK(peers[i]->access_hash_ == static_cast<td::int64>(i * 2));
+    }
+    peers.clear();
+  });
+  thread.join();
+}